@@ -0,0 +1,298 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "domain.h"
+#include "grid.h"
+#include "input.h"
+#include "method.h"
+#include "modify.h"
+#include "mpm.h"
+#include "scheme.h"
+#include "solid.h"
+#include "universe.h"
+#include "update.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <mpi.h>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*! Micro-benchmarks of the kernels of the updated Lagrangian MPM time step.
+ *
+ * A block of particles filling a square (or cube) of cells is created from a
+ * generated input file, then each kernel of the MUSL scheme is called repeatedly
+ * and timed on its own. The throughput of each kernel is reported in items
+ * (particles, nodes, or particles and nodes exchanged) per second, and in bytes per
+ * second. For the kernels looping over particles or nodes, the bytes are the memory
+ * footprint of all the particle or node vectors, which is an upper bound of the data
+ * they stream. For the communications, they are the bytes sent.
+ */
+
+struct Options {
+  int dimension = 2;
+  double np = 1e5;                  ///< Number of particles, rounded to fill whole cells
+  int ppc = 2;                      ///< Particles per cell in each direction
+  string shape = "cubic-spline";
+  string material = "neo-hookean, rho, E, nu";
+  vector<string> commands;          ///< Extra commands run before the material is defined
+  int repeat = 20;
+  string deck = "karamelo_bench.mpm";
+};
+
+static void usage() {
+  cout << "Usage: karamelo_bench [options]\n"
+       << "  -dim d           dimension of the problem (1, 2 or 3, default 2)\n"
+       << "  -np N            number of particles (default 1e5)\n"
+       << "  -ppc n           particles per cell in each direction (default 2)\n"
+       << "  -shape s         linear, cubic-spline, quadratic-spline or Bernstein-quadratic (default cubic-spline)\n"
+       << "  -material args   arguments of material() after its ID (default \"neo-hookean, rho, E, nu\")\n"
+       << "  -command cmd     command run before the material is defined, e.g. eos() or strength() (repeatable)\n"
+       << "  -repeat R        number of calls of each kernel (default 20)\n"
+       << "  -deck file       name of the generated input file (default karamelo_bench.mpm)\n"
+       << "Variables rho, E, nu, K and G are defined for use in the material arguments.\n";
+}
+
+static bool parse(int argc, char **argv, Options &o) {
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) return false;
+    string key = argv[i];
+    string value = argv[++i];
+    if (key == "-dim") o.dimension = stoi(value);
+    else if (key == "-np") o.np = stod(value);
+    else if (key == "-ppc") o.ppc = stoi(value);
+    else if (key == "-shape") o.shape = value;
+    else if (key == "-material") o.material = value;
+    else if (key == "-command") o.commands.push_back(value);
+    else if (key == "-repeat") o.repeat = stoi(value);
+    else if (key == "-deck") o.deck = value;
+    else return false;
+  }
+  return o.dimension >= 1 && o.dimension <= 3 && o.np > 0 && o.ppc > 0 && o.repeat > 0;
+}
+
+/*! The block of particles spans n cells in each direction, surrounded by two empty
+ * cells on each side. The cell size is 1.
+ */
+static void write_deck(const Options &o) {
+  int n = MAX(1, (int) ceil(pow(o.np / pow(o.ppc, o.dimension), 1.0 / o.dimension)));
+  string L = to_string(n + 4), lo = "2", hi = to_string(n + 2);
+
+  ofstream deck(o.deck);
+  deck << "E = 1e+6\nnu = 0.3\nrho = 1000\n"
+       << "K = E / (3 * (1 - 2 * nu))\nG = E / (2 * (1 + nu))\n"
+       << "method(ulmpm, FLIP, " << o.shape << ", 0.99)\n";
+
+  deck << "dimension(" << o.dimension;
+  for (int d = 0; d < o.dimension; d++) deck << ", 0, " << L;
+  deck << ", 1)\n";
+
+  deck << "region(box, block";
+  for (int d = 0; d < o.dimension; d++) deck << ", " << lo << ", " << hi;
+  deck << ")\n";
+
+  for (const string &c: o.commands) deck << c << "\n";
+  deck << "material(mat1, " << o.material << ")\n"
+       << "solid(s1, region, box, " << o.ppc << ", mat1, 1, 0)\n";
+}
+
+class Kernel {
+ public:
+  string name;
+  double t = 0;       ///< Time spent in the kernel by this CPU
+  double items = 0;   ///< Items processed by this CPU
+  double bytes = 0;   ///< Bytes streamed or sent by this CPU
+  int calls = 0;      ///< Number of calls of the kernel
+
+  Kernel(string n) : name(n) {}
+
+  double start() {
+    MPI_Barrier(MPI_COMM_WORLD);
+    return MPI_Wtime();
+  }
+  void stop(double t0, double n, double b) {
+    t += MPI_Wtime() - t0;
+    calls++;
+    items += n;
+    bytes += b;
+  }
+};
+
+static double grid_bytes_per_node() {
+  return 6 * sizeof(Eigen::Vector3d) + 5 * sizeof(double) + 2 * sizeof(int)
+    + sizeof(tagint) + sizeof(array<int, 3>) + sizeof(bool);
+}
+
+int main(int argc, char **argv) {
+  // Only the main thread calls MPI, the OpenMP and writer threads do not:
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+  if (provided < MPI_THREAD_FUNNELED) {
+    fprintf(stderr, "ERROR: the MPI library does not support MPI_THREAD_FUNNELED\n");
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  int me;
+  MPI_Comm_rank(MPI_COMM_WORLD, &me);
+
+  Options o;
+  if (!parse(argc, argv, o)) {
+    if (me == 0) usage();
+    MPI_Finalize();
+    return 1;
+  }
+
+  if (me == 0) write_deck(o);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  char *mpm_argv[] = {argv[0], (char *) "-i", (char *) o.deck.c_str(), nullptr};
+  MPM *mpm = new MPM(3, mpm_argv, MPI_COMM_WORLD);
+  mpm->input->file();
+
+  mpm->init();
+  mpm->update->scheme->setup();
+
+  Method *method = mpm->update->method;
+  Domain *domain = mpm->domain;
+  Grid *grid = domain->grid;
+  Solid *s = domain->solids[0];
+
+  double particle_bytes = 0;
+  for (auto &field: s->fields)
+    particle_bytes += field->bytes();
+
+  vector<Kernel> kernels = {Kernel("weights"), Kernel("reset"), Kernel("P2G"),
+			    Kernel("grid update"), Kernel("G2P"), Kernel("advance"),
+			    Kernel("V2G"), Kernel("stress"), Kernel("ghost reduce"),
+			    Kernel("exchange")};
+
+  // One full step so that the time step and all the fields are set:
+  method->compute_grid_weight_functions_and_gradients();
+  method->reset();
+  method->particles_to_grid();
+  method->update_grid_state();
+  method->grid_to_points();
+  method->advance_particles();
+  method->velocities_to_grid();
+  method->compute_rate_deformation_gradient(true);
+  method->update_deformation_gradient();
+  method->update_stress(true);
+  method->adjust_dt();
+
+  for (int r = 0; r < o.repeat; r++) {
+    double np = s->np_local;
+    double nn = grid->nnodes_local + grid->nnodes_ghost;
+    double t0;
+
+    t0 = kernels[0].start();
+    method->compute_grid_weight_functions_and_gradients();
+    kernels[0].stop(t0, np, np * particle_bytes);
+
+    t0 = kernels[1].start();
+    method->reset();
+    kernels[1].stop(t0, np, np * particle_bytes);
+
+    t0 = kernels[2].start();
+    method->particles_to_grid();
+    kernels[2].stop(t0, np, np * particle_bytes);
+
+    t0 = kernels[3].start();
+    method->update_grid_state();
+    kernels[3].stop(t0, nn, nn * grid_bytes_per_node());
+
+    t0 = kernels[4].start();
+    method->grid_to_points();
+    kernels[4].stop(t0, np, np * particle_bytes);
+
+    t0 = kernels[5].start();
+    method->advance_particles();
+    kernels[5].stop(t0, np, np * particle_bytes);
+
+    t0 = kernels[6].start();
+    method->velocities_to_grid();
+    kernels[6].stop(t0, np, np * particle_bytes);
+
+    t0 = kernels[7].start();
+    method->compute_rate_deformation_gradient(true);
+    method->update_deformation_gradient();
+    method->update_stress(true);
+    kernels[7].stop(t0, np, np * particle_bytes);
+
+    // Velocities and forces (9 doubles per node) go to the owner of each ghost node
+    // and come back:
+    double nexchanged = 0;
+    for (auto &p: grid->dest_nshared) nexchanged += p.second.size();
+    for (auto &p: grid->origin_nshared) nexchanged += p.second.size();
+
+    t0 = kernels[8].start();
+    grid->reduce_ghost_nodes(true, true);
+    kernels[8].stop(t0, nexchanged, nexchanged * 9 * sizeof(double));
+
+    // Move all the particles by one cell back and forth along every direction,
+    // so that those within one cell of a sub-domain boundary migrate:
+    for (double dx: {1.0, -1.0}) {
+      double nsent = 0;
+      for (int ip = 0; ip < s->np_local; ip++) {
+	for (int d = 0; d < o.dimension; d++)
+	  s->x[ip][d] += dx;
+	if (!domain->inside_subdomain(s->x[ip][0], s->x[ip][1], s->x[ip][2]))
+	  nsent++;
+      }
+
+      t0 = kernels[9].start();
+      method->exchange_particles();
+      kernels[9].stop(t0, nsent, nsent * s->comm_n * sizeof(double));
+    }
+
+    method->adjust_dt();
+  }
+
+  double np_total = 0, np_local = s->np_local;
+  MPI_Allreduce(&np_local, &np_total, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  stringstream out;
+  if (me == 0) {
+    out << "\nkaramelo_bench: " << np_total << " particles, dimension " << o.dimension
+        << ", " << o.ppc << " particles per cell per direction, " << o.shape << ", "
+        << mpm->universe->nprocs << " procs, " << o.repeat << " repetitions\n"
+        << left << setw(16) << "Kernel" << right << setw(14) << "ms/call"
+        << setw(16) << "Mitems/s" << setw(14) << "MB/s" << "\n";
+  }
+
+  for (Kernel &k: kernels) {
+    double local[3] = {k.t, k.items, k.bytes}, tmax, sum[3];
+    MPI_Reduce(&k.t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(local, sum, 3, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (me == 0) {
+      out << left << setw(16) << k.name << right << fixed << setprecision(3)
+	  << setw(14) << (k.calls > 0 ? 1000 * tmax / k.calls : 0)
+	  << setw(16) << (tmax > 0 ? sum[1] / tmax / 1e6 : 0)
+	  << setw(14) << (tmax > 0 ? sum[2] / tmax / 1e6 : 0) << "\n";
+    }
+  }
+
+  if (me == 0) cout << out.str();
+
+  delete mpm;
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Finalize();
+  return 0;
+}
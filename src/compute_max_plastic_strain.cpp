@@ -76,21 +76,25 @@ void ComputeMaxPlasticStrain::compute_value() {
   if (solid == -1) {
     for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
       s = domain->solids[isolid];
+      bool has_T = s->has_field("T");
 
       for (int in = 0; in < s->np_local; in++) {
         if (s->mask[in] & groupbit) {
           Epmax = max(Epmax, s->eff_plastic_strain[in]);
-          Tmax = max(Tmax, s->T[in]);
+          if (has_T)
+            Tmax = max(Tmax, s->T[in]);
         }
       }
     }
   } else {
     s = domain->solids[solid];
+    bool has_T = s->has_field("T");
 
     for (int in = 0; in < s->np_local; in++) {
       if (s->mask[in] & groupbit) {
 	Epmax = max(Epmax, s->eff_plastic_strain[in]);
-	Tmax = max(Tmax, s->T[in]);
+	if (has_T)
+	  Tmax = max(Tmax, s->T[in]);
       }
     }
 
@@ -0,0 +1,129 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "contact_neighbours.h"
+#include "domain.h"
+#include "solid.h"
+#include <Eigen/Eigen>
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+using namespace Eigen;
+
+ContactNeighbours::ContactNeighbours(MPM *mpm) : Pointers(mpm) {}
+
+void ContactNeighbours::build(Solid *s1, Solid *s2, double cutoff) {
+  const int dim = domain->dimension;
+  const int n1 = s1->np_local;
+  const int n2 = s2->np_local + s2->np_ghost;
+
+  offset.assign(n1 + 1, 0);
+  partners.clear();
+
+  if (n1 == 0 || n2 == 0)
+    return;
+
+  // Bins cover the bounding box of the particles of the second solid:
+  Vector3d lo = s2->x[0];
+  Vector3d hi = s2->x[0];
+  for (int ip2 = 1; ip2 < n2; ip2++) {
+    lo = lo.cwiseMin(s2->x[ip2]);
+    hi = hi.cwiseMax(s2->x[ip2]);
+  }
+
+  // Bins smaller than the cutoff would miss candidates. Larger bins are used when
+  // the particles are so sparse that most bins would be empty:
+  double binsize = cutoff;
+  int nbins[3] = {1, 1, 1};
+  size_t nbins_total;
+  while (true) {
+    nbins_total = 1;
+    for (int d = 0; d < dim; d++) {
+      nbins[d] = (int) ((hi[d] - lo[d]) / binsize) + 1;
+      nbins_total *= nbins[d];
+    }
+    if (nbins_total <= 2 * (size_t) n2 + 1)
+      break;
+    binsize *= 2;
+  }
+  double inv_binsize = 1.0 / binsize;
+
+  // Counting sort of the particles of the second solid by bin. Particles
+  // keep their relative order within each bin:
+  particle_bin.resize(n2);
+  bin_offset.assign(nbins_total + 1, 0);
+  for (int ip2 = 0; ip2 < n2; ip2++) {
+    int b = 0;
+    for (int d = dim - 1; d >= 0; d--)
+      b = b * nbins[d] + MIN((int) ((s2->x[ip2][d] - lo[d]) * inv_binsize), nbins[d] - 1);
+    particle_bin[ip2] = b;
+    bin_offset[b + 1]++;
+  }
+
+  for (size_t b = 0; b < nbins_total; b++)
+    bin_offset[b + 1] += bin_offset[b];
+
+  bin_particles.resize(n2);
+  vector<int> next(bin_offset.begin(), bin_offset.end() - 1);
+  for (int ip2 = 0; ip2 < n2; ip2++)
+    bin_particles[next[particle_bin[ip2]]++] = ip2;
+
+  // Candidates of each particle of the first solid among the particles of the bin
+  // it lies in and of the neighbouring bins:
+  int bmin[3], bmax[3];
+  for (int ip1 = 0; ip1 < n1; ip1++) {
+    const Vector3d &x1 = s1->x[ip1];
+    bool outside = false;
+
+    for (int d = 0; d < 3; d++) {
+      if (d >= dim) {
+	bmin[d] = bmax[d] = 0;
+	continue;
+      }
+      double c = floor((x1[d] - lo[d]) * inv_binsize);
+      if (c < -1 || c > nbins[d]) {
+	outside = true;
+	break;
+      }
+      bmin[d] = MAX((int) c - 1, 0);
+      bmax[d] = MIN((int) c + 1, nbins[d] - 1);
+    }
+
+    if (!outside) {
+      for (int k = bmin[2]; k <= bmax[2]; k++) {
+	for (int j = bmin[1]; j <= bmax[1]; j++) {
+	  for (int i = bmin[0]; i <= bmax[0]; i++) {
+	    int b = (k * nbins[1] + j) * nbins[0] + i;
+	    for (int ib = bin_offset[b]; ib < bin_offset[b + 1]; ib++) {
+	      int ip2 = bin_particles[ib];
+	      bool close = true;
+	      for (int d = 0; d < dim; d++) {
+		double dx = s2->x[ip2][d] - x1[d];
+		if (!(dx < cutoff && dx > -cutoff)) {
+		  close = false;
+		  break;
+		}
+	      }
+	      if (close)
+		partners.push_back(ip2);
+	    }
+	  }
+	}
+      }
+      sort(partners.begin() + offset[ip1], partners.end());
+    }
+
+    offset[ip1 + 1] = partners.size();
+  }
+}
@@ -0,0 +1,51 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_CONTACT_NEIGHBOURS_H
+#define MPM_CONTACT_NEIGHBOURS_H
+
+#include "pointers.h"
+#include <vector>
+
+/*! Broad phase of the particle to particle contact detection between two solids.
+ *
+ * The particles of the second solid are sorted in cubic bins whose size is at least
+ * the cutoff distance. The candidates of a particle of the first solid are then only
+ * searched for in the bin it lies in and in its direct neighbours, which makes the
+ * search linear in the number of particles instead of quadratic.
+ *
+ * Contact fixes call build() once per step and loop over the candidates of each
+ * particle of the first solid. The candidates are the particles of the second solid
+ * whose distance to it along every axis is smaller than the cutoff. They are listed in
+ * increasing order, so that the forces are accumulated in the same order as with a
+ * double loop over all pairs of particles.
+ *
+ * Ghost particles of the second solid (indices np_local to np_local + np_ghost - 1) are
+ * candidates too, so that each pair of particles in contact is found by the CPU owning
+ * the particle of the first solid.
+ */
+class ContactNeighbours : protected Pointers {
+ public:
+  vector<int> offset;   ///< Candidates of particle ip1 are partners[offset[ip1]] to partners[offset[ip1 + 1] - 1]
+  vector<int> partners; ///< Indices in the second solid of the candidates of all particles of the first solid
+
+  ContactNeighbours(class MPM *);
+  void build(class Solid *, class Solid *, double); ///< Find the candidates of the particles of the first solid among the particles of the second within the cutoff distance.
+
+ private:
+  vector<int> bin_offset;    ///< Particles in bin b are bin_particles[bin_offset[b]] to bin_particles[bin_offset[b + 1] - 1]
+  vector<int> bin_particles; ///< Particles of the second solid sorted by bin
+  vector<int> particle_bin;  ///< Bin of each particle of the second solid
+};
+
+#endif
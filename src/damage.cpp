@@ -52,3 +52,22 @@ void Damage::options(vector<string> *args, vector<string>::iterator it)
   }
 }
 
+
+/*! Default implementation calling compute_damage() for each particle.
+ */
+void Damage::compute_damage(int n, double *damage_init, double *damage,
+                            const double *pH, const Eigen::Matrix3d *Sdev,
+                            const double *epsdot,
+                            const double *plastic_strain_increment,
+                            const double *T)
+{
+  if (T != nullptr) {
+    for (int i = 0; i < n; i++)
+      compute_damage(damage_init[i], damage[i], pH[i], Sdev[i], epsdot[i],
+                     plastic_strain_increment[i], T[i]);
+  } else {
+    for (int i = 0; i < n; i++)
+      compute_damage(damage_init[i], damage[i], pH[i], Sdev[i], epsdot[i],
+                     plastic_strain_increment[i]);
+  }
+}
@@ -35,10 +35,18 @@ class Damage : protected Pointers {
   virtual void compute_damage(double &damage_init,
 			      double &damage,
 			      const double pH,
-			      const Eigen::Matrix3d Sdev,
+			      const Eigen::Matrix3d &Sdev,
 			      const double epsdot,
 			      const double plastic_strain_increment,
 			      const double temperature = 0) = 0;
+  virtual void compute_damage(int n,
+			      double *damage_init,
+			      double *damage,
+			      const double *pH,
+			      const Eigen::Matrix3d *Sdev,
+			      const double *epsdot,
+			      const double *plastic_strain_increment,
+			      const double *temperature = nullptr); ///< Computes the damage of n consecutive particles.
 };
 
 #endif
@@ -90,7 +90,7 @@ DamageJohnsonCook::DamageJohnsonCook(MPM *mpm, vector<string> args)
 
 void DamageJohnsonCook::compute_damage(double &damage_init, double &damage,
                                        const double pH,
-                                       const Eigen::Matrix3d Sdev,
+                                       const Eigen::Matrix3d &Sdev,
                                        const double epsdot,
                                        const double plastic_strain_increment,
                                        const double T) {
@@ -36,7 +36,7 @@ public:
   void compute_damage(double &damage_init,
 			      double &damage,
 			      const double pH,
-			      const Eigen::Matrix3d Sdev,
+			      const Eigen::Matrix3d &Sdev,
 			      const double epsdot,
 			      const double plastic_strain_increment,
 			      const double temperature = 0);
@@ -13,14 +13,18 @@
 
 #include "domain.h"
 #include "error.h"
+#include "grid.h"
+#include "group.h"
 #include "input.h"
 #include "memory.h"
 #include "method.h"
 #include "region.h"
 #include "style_region.h"
+#include "timer.h"
 #include "universe.h"
 #include "update.h"
 #include <Eigen/Eigen>
+#include <algorithm>
 
 using namespace std;
 
@@ -35,6 +39,9 @@ Domain::Domain(MPM *mpm) : Pointers(mpm)
   np_total     = 0;
   np_local     = 0;
 
+  balance_every     = 0;
+  balance_threshold = 1.1;
+
   boxlo[0] = boxlo[1] = boxlo[2] = 0;
   boxhi[0] = boxhi[1] = boxhi[2] = 0;
 
@@ -194,156 +201,23 @@ bool Domain::inside_subdomain(double x, double y, double z) {
   return true;
 }
 
-/*! Determine the CPU owning the particle with x, y, z coordinates.
+/*! Determine the CPU owning the particle with x, y, z coordinates, among this CPU and
+ * its neighbours (diagonal ones included): the particle is assumed to have moved by less
+ * than the size of a sub-domain. A particle out of the simulation box stays with the CPU
+ * whose sub-domain is on that side of the box.
  */
 int Domain::which_CPU_owns_me(double x, double y, double z) {
-  if (x < sublo[0]) {
-    // target[0] = -1;
-    if (y < sublo[1]) {
-      // target[1] = -1;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {-1, -1, -1};
-	return universe->procneigh[2][0] - 1 - universe->procgrid[1];
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {-1, -1, 1};
-	return universe->procneigh[2][1] - 1 - universe->procgrid[1];
-      } else {
-        // target[2] = 0;
-	// target = {-1, -1, 0};
-	return universe->procneigh[1][0] - 1;
-      }
-    } else if (y > subhi[1]) {
-      // target[1] = 1;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {-1, 1, -1};
-	return universe->procneigh[2][1] - 1 + universe->procgrid[1];
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {-1, 1, 1};
-	return universe->procneigh[2][1] - 1 + universe->procgrid[1];
-      } else {
-        // target[2] = 0;
-	// target = {-1, 1, 0};
-	return universe->procneigh[1][1] - 1;
-      }
-    } else {
-      // target[1] = 0;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {-1, 0, -1};
-	return universe->procneigh[2][0] - 1;
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {-1, 0, 1};
-	return universe->procneigh[2][1] - 1;
-      } else {
-        // target[2] = 0;
-	// target = {-1, 0, 0};
-	return universe->procneigh[0][0];
-      }
-    }
-  } else if (x > subhi[0]) {
-    // target[0] = 1;
-    if (y < sublo[1]) {
-      // target[1] = -1;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {1, -1, -1};
-	return universe->procneigh[2][0] + 1 - universe->procgrid[1];
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {1, -1, 1};
-	return universe->procneigh[2][1] + 1 - universe->procgrid[1];
-      } else {
-        // target[2] = 0;
-	// target = {1, -1, 0};
-	return universe->procneigh[1][0] + 1;
-      }
-    } else if (y > subhi[1]) {
-      // target[1] = 1;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {1, 1, -1};
-	return universe->procneigh[2][0] + 1 + universe->procgrid[1];
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {1, 1, 1};
-	return universe->procneigh[2][1] + 1 + universe->procgrid[1];
-      } else {
-        // target[2] = 0;
-	// target = {1, 1, 0};
-	return universe->procneigh[1][1] + 1;
-      }
-    } else {
-      // target[1] = 0;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {1, 0, -1};
-	return universe->procneigh[2][0] + 1;
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {1, 0, 1};
-	return universe->procneigh[2][1] + 1;
-      } else {
-        // target[2] = 0;
-	// target = {1, 0, 0};
-	return universe->procneigh[0][1];
-      }
-    }
-  } else {
-    // target[0] = 0;
-    if (y < sublo[1]) {
-      // target[1] = -1;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {0, -1, -1};
-	return universe->procneigh[2][0] - universe->procgrid[1];
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {0, -1, 1};
-	return universe->procneigh[2][1] - universe->procgrid[1];
-      } else {
-        // target[2] = 0;
-	// target = {0, -1, 0};
-	return universe->procneigh[1][0];
-      }
-    } else if (y > subhi[1]) {
-      // target[1] = 1;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {0, 1, -1};
-	return universe->procneigh[2][0] + universe->procgrid[1];
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {0, 1, 1};
-	return universe->procneigh[2][1] + universe->procgrid[1];
-      } else {
-        // target[2] = 0;
-	// target = {0, 1, 0};
-	return universe->procneigh[1][1];
-      }
-    } else {
-      // target[1] = 0;
-      if (z < sublo[2]) {
-        // target[2] = -1;
-	// target = {0, 0, -1};
-	return universe->procneigh[2][0];
-      } else if (z > subhi[2]) {
-        // target[2] = 1;
-	// target = {0, 0, 1};
-	return universe->procneigh[2][1];
-      } else {
-        // target[2] = 0;
-	// target = {0, 0, 0};
-	return universe->me;
-      }
-    }
+  double xp[3] = {x, y, z};
+  int loc[3];
+
+  for (int d = 0; d < 3; d++) {
+    loc[d] = universe->myloc[d];
+    if (d >= dimension) continue;
+    if (xp[d] < sublo[d] && loc[d] > 0) loc[d]--;
+    else if (xp[d] > subhi[d] && loc[d] < universe->procgrid[d] - 1) loc[d]++;
   }
 
-  return -1;
+  return loc[0] + universe->procgrid[0] * (loc[1] + universe->procgrid[1] * loc[2]);
 }
 
 
@@ -364,8 +238,27 @@ bool Domain::inside_subdomain_extended(double x, double y, double z, double h) {
  * Domain::sublo and Domain::subhi variables.
  */
 void Domain::set_local_box() {
+  subdomain_bounds(universe->myloc, sublo, subhi);
+}
+
+/*! Every proc computes the boundaries of any subdomain the same way, so that they
+ * all agree on them without communicating.
+ */
+void Domain::subdomain_bounds(const int *loc, double *lo, double *hi) {
   int *procgrid = universe->procgrid;
-  int *myloc = universe->myloc;
+
+  if (!subcuts[0].empty()) {
+    // The boundaries were moved by balance():
+    for (int d = 0; d < 3; d++) {
+      if (d < dimension) {
+	lo[d] = subcuts[d][loc[d]];
+	hi[d] = subcuts[d][loc[d] + 1];
+      } else {
+	lo[d] = hi[d] = 0;
+      }
+    }
+    return;
+  }
 
   double l[3] = {boxhi[0] - boxlo[0],
 		 boxhi[1] - boxlo[1],
@@ -373,24 +266,64 @@ void Domain::set_local_box() {
 
   double h[3];
   h[0] = l[0]/procgrid[0];
-  sublo[0] = myloc[0]*h[0] + boxlo[0];
-  subhi[0] = sublo[0] + h[0];
+  lo[0] = loc[0]*h[0] + boxlo[0];
+  hi[0] = lo[0] + h[0];
 
   if (dimension >= 2) {
     h[1] = l[1]/procgrid[1];
-    sublo[1] = myloc[1]*h[1] + boxlo[1];
-    subhi[1] = sublo[1] + h[1];
+    lo[1] = loc[1]*h[1] + boxlo[1];
+    hi[1] = lo[1] + h[1];
   } else {
-    sublo[1] = subhi[1] = 0;
+    lo[1] = hi[1] = 0;
   }
 
   if (dimension == 3) {
     h[2] = l[2]/procgrid[2];
-    sublo[2] = myloc[2]*h[2] + boxlo[2];
-    subhi[2] = sublo[2] + h[2];
+    lo[2] = loc[2]*h[2] + boxlo[2];
+    hi[2] = lo[2] + h[2];
   } else {
-    sublo[2] = subhi[2] = 0;
+    lo[2] = hi[2] = 0;
+  }
+}
+
+/*! Two procs are neighbours if their subdomains, both extended by d on all sides,
+ * overlap. The test is written the same way from both sides, so that the relation is
+ * symmetric despite rounding errors. Since the subdomains are aligned on the CPU grid,
+ * the neighbours are found direction by direction. The list is sorted by rank and
+ * excludes this proc.
+ */
+vector<int> Domain::neighbour_procs(double d) {
+  int *procgrid = universe->procgrid;
+  int *myloc = universe->myloc;
+  int locmin[3], locmax[3];
+
+  for (int dim = 0; dim < 3; dim++) {
+    locmin[dim] = procgrid[dim];
+    locmax[dim] = -1;
+
+    int loc[3] = {myloc[0], myloc[1], myloc[2]};
+    double lo[3], hi[3];
+
+    for (loc[dim] = 0; loc[dim] < procgrid[dim]; loc[dim]++) {
+      subdomain_bounds(loc, lo, hi);
+      if (dim >= dimension ||
+	  (lo[dim] - d <= subhi[dim] + d && sublo[dim] - d <= hi[dim] + d)) {
+	locmin[dim] = MIN(locmin[dim], loc[dim]);
+	locmax[dim] = MAX(locmax[dim], loc[dim]);
+      }
+    }
   }
+
+  vector<int> procs;
+  for (int k = locmin[2]; k <= locmax[2]; k++)
+    for (int j = locmin[1]; j <= locmax[1]; j++)
+      for (int i = locmin[0]; i <= locmax[0]; i++) {
+	int proc = i + procgrid[0] * (j + procgrid[1] * k);
+	if (proc != universe->me)
+	  procs.push_back(proc);
+      }
+
+  return procs;
 }
 
 void Domain::create_domain(vector<string> args) {
@@ -569,6 +502,274 @@ void Domain::set_axisymmetric(vector<string> args) {
   }
 }
 
+/*! This function is the C++ equivalent to the balance() user function.\n
+ * Syntax: balance(N, threshold)\n
+ * Only updated Lagrangian methods can be balanced: the particles of total Lagrangian
+ * methods never leave the CPU they were created on.
+ */
+void Domain::set_balance(vector<string> args) {
+  if (args.size() < 2) {
+    error->all(FLERR, "Error: not enough arguments.\n" + usage_balance);
+  } else if (args.size() > 2) {
+    error->all(FLERR, "Error: too many arguments.\n" + usage_balance);
+  }
+
+  if (update->method == nullptr)
+    error->all(FLERR, "Error: a method should be defined before calling balance()!\n");
+  if (update->method->is_TL)
+    error->all(FLERR, "Error: balance() is only available with updated Lagrangian methods.\n");
+
+  balance_every = (int) input->parsev(args[0]).result(mpm);
+  balance_threshold = input->parsev(args[1]).result(mpm);
+
+  if (balance_every < 0)
+    error->all(FLERR, "Error: the interval given to balance() must be positive or 0.\n");
+  if (balance_threshold < 1)
+    error->all(FLERR, "Error: the threshold given to balance() must be larger than or equal to 1.\n");
+}
+
+/*! The sub-boxes stay aligned on the CPU grid (Universe::procgrid): along each direction,
+ * the boundaries between the slabs of CPUs are moved so that every slab holds the same
+ * number of particles. The neighbours of every CPU are thus unchanged, only the size of
+ * their sub-boxes. The boundaries are placed on grid lines, and every sub-box spans at
+ * least two grid cells along each direction.
+ *
+ * Once the boundaries are moved, the particles are sent to their new owner and the grid
+ * nodes of each CPU, the shared and ghost nodes included, are created again.
+ * Must be called after the particles were exchanged and before the weight functions are computed.
+ */
+void Domain::balance() {
+  if (balance_every == 0 || update->ntimestep % balance_every != 0
+      || update->method->is_TL || universe->nprocs == 1)
+    return;
+
+  timer->start(Timer::BALANCE);
+
+  double imbalance_old = imbalance();
+  if (imbalance_old < balance_threshold) {
+    timer->stop();
+    return;
+  }
+
+  vector<double> cuts[3];
+  bool moved = false;
+
+  for (int d = 0; d < 3; d++) {
+    if (d < dimension && universe->procgrid[d] > 1 && balance_cuts(d, cuts[d])) {
+      moved = true;
+    } else if (!subcuts[d].empty()) {
+      cuts[d] = subcuts[d];
+    } else {
+      // Uniform decomposition, computed as in set_local_box():
+      int P = universe->procgrid[d];
+      double h = (boxhi[d] - boxlo[d]) / P;
+      cuts[d].resize(P + 1);
+      for (int i = 0; i < P; i++)
+	cuts[d][i] = i * h + boxlo[d];
+      cuts[d][P] = cuts[d][P - 1] + h;
+    }
+  }
+
+  if (!moved) {
+    timer->stop();
+    return;
+  }
+
+  // Boundaries are balanced one direction at a time, which does not always even out
+  // the particles (e.g. two solids on a diagonal of a 2x2 CPU grid). Nothing is done if
+  // the new boundaries would not improve the balance:
+  vector<double> subcuts_old[3];
+  for (int d = 0; d < 3; d++) {
+    subcuts_old[d] = subcuts[d];
+    subcuts[d] = cuts[d];
+  }
+
+  vector<double> n(universe->nprocs, 0), n_all(universe->nprocs);
+  for (Solid *s: solids)
+    for (int ip = 0; ip < s->np_local; ip++)
+      n[which_CPU_owns_me_balanced(s->x[ip])]++;
+  MPI_Allreduce(n.data(), n_all.data(), universe->nprocs, MPI_DOUBLE, MPI_SUM, universe->uworld);
+
+  double nmax = 0, nsum = 0;
+  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
+    nmax = MAX(nmax, n_all[iproc]);
+    nsum += n_all[iproc];
+  }
+
+  if (nmax * universe->nprocs >= imbalance_old * nsum) {
+    for (int d = 0; d < 3; d++)
+      subcuts[d] = subcuts_old[d];
+    timer->stop();
+    return;
+  }
+
+  set_local_box();
+
+  migrate_particles();
+
+  grid->rebuild(boxlo, boxhi);
+  group->update_node_masks(grid);
+
+  double imbalance_new = imbalance();
+
+  if (universe->me == 0) {
+    cout << "Balance at step " << update->ntimestep
+         << ": particle imbalance " << imbalance_old
+         << " -> " << imbalance_new << endl;
+  }
+
+  timer->stop();
+}
+
+/*! Equal to 1 when all the CPUs hold the same number of particles.
+ */
+double Domain::imbalance() {
+  double n = 0;
+  for (Solid *s: solids)
+    n += s->np_local;
+
+  double nmax, nsum;
+  MPI_Allreduce(&n, &nmax, 1, MPI_DOUBLE, MPI_MAX, universe->uworld);
+  MPI_Allreduce(&n, &nsum, 1, MPI_DOUBLE, MPI_SUM, universe->uworld);
+
+  if (nsum == 0) return 1;
+  return nmax * universe->nprocs / nsum;
+}
+
+/*! The particles are counted in each layer of grid cells along direction d. The i-th
+ * boundary is placed on the grid line closest to the point where the cumulated count
+ * reaches i/P of the total. Returns false if the boundaries stay where they are.
+ */
+bool Domain::balance_cuts(int d, vector<double> &cuts) {
+  const int P = universe->procgrid[d];
+  const double h = grid->cellsize;
+  const int min_cells = 2;
+
+  int nc = (int) ((boxhi[d] - boxlo[d]) / h);
+  if (boxlo[d] + nc * h < boxhi[d]) nc++;
+  if (nc < P * min_cells) return false;
+
+  vector<double> count(nc, 0), count_all(nc);
+  for (Solid *s: solids) {
+    for (int ip = 0; ip < s->np_local; ip++) {
+      int c = (int) ((s->x[ip][d] - boxlo[d]) / h);
+      count[MAX(0, MIN(c, nc - 1))]++;
+    }
+  }
+  MPI_Allreduce(count.data(), count_all.data(), nc, MPI_DOUBLE, MPI_SUM, universe->uworld);
+
+  double total = 0;
+  for (int c = 0; c < nc; c++)
+    total += count_all[c];
+  if (total == 0) return false;
+
+  cuts.resize(P + 1);
+  cuts[0] = boxlo[d];
+  cuts[P] = boxhi[d];
+
+  int c = 0;          // Number of layers below the current boundary
+  double below = 0;   // Number of particles in these layers
+  int k_prev = 0;
+
+  for (int i = 1; i < P; i++) {
+    double target = total * i / P;
+    while (c < nc && below + count_all[c] <= target) {
+      below += count_all[c];
+      c++;
+    }
+
+    int k = c;
+    if (c < nc && target - below > below + count_all[c] - target) k++;
+    k = MAX(k, k_prev + min_cells);
+    k = MIN(k, nc - (P - i) * min_cells);
+
+    cuts[i] = boxlo[d] + k * h;
+    k_prev = k;
+  }
+
+  const vector<double> &current = subcuts[d];
+  if (current.empty()) {
+    double hd = (boxhi[d] - boxlo[d]) / P;
+    for (int i = 1; i < P; i++)
+      if (abs(cuts[i] - (i * hd + boxlo[d])) > 1.0e-12) return true;
+    return false;
+  }
+
+  for (int i = 1; i < P; i++)
+    if (cuts[i] != current[i]) return true;
+  return false;
+}
+
+/*! Same as which_CPU_owns_me() but valid wherever the particle lies, since the particles
+ * may be far from the new sub-box of the CPU holding them after a balance.
+ */
+int Domain::which_CPU_owns_me_balanced(const Eigen::Vector3d &x) {
+  int loc[3] = {0, 0, 0};
+
+  for (int d = 0; d < dimension; d++) {
+    const vector<double> &cuts = subcuts[d];
+    loc[d] = upper_bound(cuts.begin() + 1, cuts.end() - 1, x[d]) - (cuts.begin() + 1);
+  }
+
+  return loc[0] + universe->procgrid[0] * (loc[1] + universe->procgrid[1] * loc[2]);
+}
+
+/*! Unlike Method::exchange_particles(), particles may be sent to any CPU.
+ */
+void Domain::migrate_particles() {
+  const int nprocs = universe->nprocs;
+  vector<vector<double>> buf_send_vect(nprocs);
+  vector<double> buf_send, buf_recv;
+  vector<int> size_s(nprocs), size_r(nprocs), offset_s(nprocs), offset_r(nprocs);
+  vector<int> unpack_list;
+
+  for (Solid *s: solids) {
+    for (int iproc = 0; iproc < nprocs; iproc++)
+      buf_send_vect[iproc].clear();
+
+    int ip = 0;
+    while (ip < s->np_local) {
+      int owner = which_CPU_owns_me_balanced(s->x[ip]);
+      if (owner != universe->me) {
+	s->pack_particle(ip, buf_send_vect[owner]);
+	s->copy_particle(s->np_local - 1, ip);
+	s->np_local--;
+      } else {
+	ip++;
+      }
+    }
+
+    buf_send.clear();
+    for (int iproc = 0; iproc < nprocs; iproc++) {
+      offset_s[iproc] = buf_send.size();
+      size_s[iproc] = buf_send_vect[iproc].size();
+      buf_send.insert(buf_send.end(), buf_send_vect[iproc].begin(), buf_send_vect[iproc].end());
+    }
+
+    MPI_Alltoall(size_s.data(), 1, MPI_INT, size_r.data(), 1, MPI_INT, universe->uworld);
+
+    int n = 0;
+    for (int iproc = 0; iproc < nprocs; iproc++) {
+      offset_r[iproc] = n;
+      n += size_r[iproc];
+    }
+    buf_recv.resize(n);
+
+    MPI_Alltoallv(buf_send.data(), size_s.data(), offset_s.data(), MPI_DOUBLE,
+		  buf_recv.data(), size_r.data(), offset_r.data(), MPI_DOUBLE,
+		  universe->uworld);
+
+    unpack_list.clear();
+    for (int i = 0; i < n; i += s->comm_n)
+      unpack_list.push_back(i);
+
+    if (unpack_list.size() > 0) {
+      s->grow(s->np_local + unpack_list.size());
+      s->unpack_particle(s->np_local, unpack_list, buf_recv);
+    }
+  }
+}
+
 /*! Write box bounds, list of regions and solids to restart file
  */
 void Domain::write_restart(ofstream* of){
@@ -591,6 +792,13 @@ void Domain::write_restart(ofstream* of){
   // Write  np_total:
   of->write(reinterpret_cast<const char *>(&np_total), sizeof(tagint));
   // cout << "np_total=" << np_total << endl;
+
+  // Write the boundaries between the sub-boxes moved by balance() (none if uniform):
+  for (int d = 0; d < 3; d++) {
+    size_t Nc = subcuts[d].size();
+    of->write(reinterpret_cast<const char *>(&Nc), sizeof(size_t));
+    of->write(reinterpret_cast<const char *>(subcuts[d].data()), Nc*sizeof(double));
+  }
   
   if (!update->method->is_TL) {
     of->write(reinterpret_cast<const char *>(&grid->cellsize), sizeof(double));
@@ -656,6 +864,15 @@ void Domain::read_restart(ifstream *ifr) {
   // Write  np_total:
   ifr->read(reinterpret_cast<char *>(&np_total), sizeof(tagint));
   // cout << "np_total=" << np_total << endl;
+
+  // Read the boundaries between the sub-boxes, so that every proc knows the
+  // sub-boxes of the others before the grid is created:
+  for (int d = 0; d < 3; d++) {
+    size_t Nc = 0;
+    ifr->read(reinterpret_cast<char *>(&Nc), sizeof(size_t));
+    subcuts[d].resize(Nc);
+    ifr->read(reinterpret_cast<char *>(subcuts[d].data()), Nc*sizeof(double));
+  }
   
   universe->set_proc_grid();
   if (!update->method->is_TL) {
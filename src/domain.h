@@ -45,6 +45,10 @@ class Domain : protected Pointers {
   double boxhi[3];                       ///< Higher orthogonal box global bounds
   double sublo[3];                       ///< Lower sub-box bounds on this proc
   double subhi[3];                       ///< Higher sub-box bounds on this proc
+  vector<double> subcuts[3];             ///< Boundaries between the sub-boxes along each direction once balanced (empty if uniform)
+
+  int balance_every;                     ///< The sub-box boundaries are moved every balance_every steps (never if 0)
+  double balance_threshold;              ///< Only balance if the largest number of particles per proc exceeds the average by this factor
 
   vector<class Region *> regions;        ///< list of defined Regions
   vector<class Solid *> solids;          ///< list of defined Solids
@@ -61,6 +65,10 @@ class Domain : protected Pointers {
   int which_CPU_owns_me(double, double, double); ///< Determine in which CPU a particle belongs.
   bool inside_subdomain_extended(double, double, double, double); ///< Checks if the set of coordinates lies in this proc sub-domain.
   void set_local_box();                  ///< Determine the boundaries of this proc subdomain
+  void subdomain_bounds(const int *, double *, double *); ///< Determine the boundaries of the subdomain of the proc at this location of the CPU grid
+  vector<int> neighbour_procs(double);   ///< List the procs whose subdomain lies within a distance of that of this proc
+  void set_balance(vector<string>);      ///< Called when user calls balance()
+  void balance();                        ///< Move the sub-box boundaries to even out the number of particles per proc if due at this step
   void add_region(vector<string>);       ///< Create a new region
   int find_region(string);               ///< Finds the ID of a region
   void add_solid(vector<string>);        ///< Create a new solid
@@ -81,6 +89,12 @@ class Domain : protected Pointers {
 
 private:
   template <typename T> static Region *region_creator(MPM *, vector<string>);
+
+  double imbalance();                    ///< Ratio between the largest and the average number of particles per proc
+  bool balance_cuts(int, vector<double> &); ///< Compute the boundaries along one direction that share the particles evenly
+  int which_CPU_owns_me_balanced(const Eigen::Vector3d &); ///< Determine in which CPU a particle belongs from Domain::subcuts
+  void migrate_particles();              ///< Send every particle to the CPU whose sub-box holds it, wherever it is
+
   // template <typename T> static Solid *solid_creator(MPM *,vector<string>);
 
   const map<string, string> usage_dimension = {
@@ -94,6 +108,7 @@ private:
       {"1", 4}, {"2", 6}, {"2_axis", 7}, {"3", 8}};
 
   string usage_axisymmetric = "axisymmetric(true) or axisymmetric(false)\n";
+  string usage_balance = "Usage: balance(N, threshold)\n";
 };
 
 #endif
@@ -134,3 +149,29 @@ dimension(3, 0, Lx, 0, Ly, 0, Lz, h)
 Set the dimensionality of the simulation alongside the size of its domain and the background grid cell size (if using Updated Lagrangian MPM or Updated Lagrangian CPDI). The background grid cell size argument is however not optional if using Total Lagrangian.
 
 */
+
+/*! \defgroup balance balance
+
+\section Syntax Syntax
+\code
+balance(N, threshold)
+\endcode
+
+<ul>
+<li>N: number of steps between two balancing attempts (0 disables balancing).</li>
+<li>threshold: the sub-domains are only balanced if the largest number of particles held by a CPU exceeds the average by this factor.</li>
+</ul>
+
+\section Examples Examples
+\code
+balance(100, 1.1)
+\endcode
+Every 100 steps, balance the sub-domains if one CPU holds more than 10% more particles than the average.
+
+\section Description Description
+
+Moves the boundaries between the sub-domains of the CPUs so that they hold about the same number of particles. The CPUs stay arranged in the same grid, and the boundaries of each slab of CPUs are moved to a grid line along each direction. The particles are then sent to their new CPU and the background grid is created again.
+
+Only available with updated Lagrangian methods. Balancing has no effect on a single CPU.
+
+*/
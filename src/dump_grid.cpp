@@ -20,6 +20,8 @@
 #include "mpmtype.h"
 #include "error.h"
 #include "universe.h"
+#include "writer.h"
+#include <sstream>
 
 using namespace std;
 
@@ -68,72 +70,67 @@ void DumpGrid::write()
 
   // cout << "Filemame for dump: " << fdump << endl;
 
-  // Open the file fdump:
-  ofstream dumpstream;
-  dumpstream.open(fdump, ios_base::out);
+  // Format the snapshot in memory, it is written by Output::writer:
+  ostringstream dumpstream;
 
-  if (dumpstream.is_open()) {
-    dumpstream << "ITEM: TIMESTEP\n0\nITEM: NUMBER OF ATOMS\n";
+  dumpstream << "ITEM: TIMESTEP\n0\nITEM: NUMBER OF ATOMS\n";
 
-    // Check how many different grids we have:
-    vector<class Grid *> grids; // We will store the different pointers to grids here.
+  // Check how many different grids we have:
+  vector<class Grid *> grids; // We will store the different pointers to grids here.
 
-    for (int isolid=0; isolid < domain->solids.size(); isolid++) {
-      if (grids.size()==0) {
+  for (int isolid=0; isolid < domain->solids.size(); isolid++) {
+    if (grids.size()==0) {
+      grids.push_back(domain->solids[isolid]->grid);
+    } else {
+      // If the grid pointer is not present into grids, add it, otherwise continue:
+      if ( find(grids.begin(), grids.end(), domain->solids[isolid]->grid) == grids.end() )
 	grids.push_back(domain->solids[isolid]->grid);
-      } else {
-	// If the grid pointer is not present into grids, add it, otherwise continue:
-	if ( find(grids.begin(), grids.end(), domain->solids[isolid]->grid) == grids.end() )
-	  grids.push_back(domain->solids[isolid]->grid);
-      }
     }
+  }
     
-    // Now loop over the grids to find how many elements there are in total:
-    bigint total_nn = 0;
-    for (auto g: grids) {
-      total_nn += g->nnodes_local + g->nnodes_ghost;
-    }
+  // Now loop over the grids to find how many elements there are in total:
+  bigint total_nn = 0;
+  for (auto g: grids) {
+    total_nn += g->nnodes_local + g->nnodes_ghost;
+  }
 
-    dumpstream << total_nn << endl;
-    dumpstream << "ITEM: BOX BOUNDS sm sm sm\n";
-    dumpstream << domain->boxlo[0] << " " << domain->boxhi[0] << endl;
-    dumpstream << domain->boxlo[1] << " " << domain->boxhi[1] << endl;
-    dumpstream << domain->boxlo[2] << " " << domain->boxhi[2] << endl;
-    dumpstream << "ITEM: ATOMS id type tag ";
-    for (auto v: output_var) {
-      dumpstream << v << " ";
-    }
-    dumpstream << endl;
-
-    int igrid = 0;
-    for (auto g: grids) {
-      for (bigint i=0; i<g->nnodes_local + g->nnodes_ghost;i++) {
-	dumpstream << g->ntag[i] << " "
-		   << igrid+1 << " "
-		   << g->ntag[i] << " ";
-	for (auto v: output_var) {
-	  if (v.compare("x")==0) dumpstream << g->x[i][0] << " ";
-	  else if (v.compare("y")==0) dumpstream << g->x[i][1] << " ";
-	  else if (v.compare("z")==0) dumpstream << g->x[i][2] << " ";
-	  else if (v.compare("vx")==0) dumpstream << g->v[i][0] << " ";
-	  else if (v.compare("vy")==0) dumpstream << g->v[i][1] << " ";
-	  else if (v.compare("vz")==0) dumpstream << g->v[i][2] << " ";
-	  else if (v.compare("bx")==0) dumpstream << g->mb[i][0] << " ";
-	  else if (v.compare("by")==0) dumpstream << g->mb[i][1] << " ";
-	  else if (v.compare("bz")==0) dumpstream << g->mb[i][2] << " ";
-	  else if (v.compare("mass")==0) dumpstream << g->mass[i] << " ";
-	  else if (v.compare("mask")==0) dumpstream << g->mask[i] << " ";
-	  else if (v.compare("ntypex")==0) dumpstream << g->ntype[i][0] << " ";
-	  else if (v.compare("ntypey")==0) dumpstream << g->ntype[i][1] << " ";
-	  else if (v.compare("ntypez")==0) dumpstream << g->ntype[i][2] << " ";
-	  else if (v.compare("rigid")==0) dumpstream << g->rigid[i] << " ";
-	  else if (v.compare("T")==0) dumpstream << g->T[i] << " ";
-	}
-	dumpstream << endl;
+  dumpstream << total_nn << endl;
+  dumpstream << "ITEM: BOX BOUNDS sm sm sm\n";
+  dumpstream << domain->boxlo[0] << " " << domain->boxhi[0] << endl;
+  dumpstream << domain->boxlo[1] << " " << domain->boxhi[1] << endl;
+  dumpstream << domain->boxlo[2] << " " << domain->boxhi[2] << endl;
+  dumpstream << "ITEM: ATOMS id type tag ";
+  for (auto v: output_var) {
+    dumpstream << v << " ";
+  }
+  dumpstream << endl;
+
+  int igrid = 0;
+  for (auto g: grids) {
+    for (bigint i=0; i<g->nnodes_local + g->nnodes_ghost;i++) {
+      dumpstream << g->ntag[i] << " "
+		 << igrid+1 << " "
+		 << g->ntag[i] << " ";
+      for (auto v: output_var) {
+	if (v.compare("x")==0) dumpstream << g->x[i][0] << " ";
+	else if (v.compare("y")==0) dumpstream << g->x[i][1] << " ";
+	else if (v.compare("z")==0) dumpstream << g->x[i][2] << " ";
+	else if (v.compare("vx")==0) dumpstream << g->v[i][0] << " ";
+	else if (v.compare("vy")==0) dumpstream << g->v[i][1] << " ";
+	else if (v.compare("vz")==0) dumpstream << g->v[i][2] << " ";
+	else if (v.compare("bx")==0) dumpstream << g->mb[i][0] << " ";
+	else if (v.compare("by")==0) dumpstream << g->mb[i][1] << " ";
+	else if (v.compare("bz")==0) dumpstream << g->mb[i][2] << " ";
+	else if (v.compare("mass")==0) dumpstream << g->mass[i] << " ";
+	else if (v.compare("mask")==0) dumpstream << g->mask[i] << " ";
+	else if (v.compare("ntypex")==0) dumpstream << g->ntype[i][0] << " ";
+	else if (v.compare("ntypey")==0) dumpstream << g->ntype[i][1] << " ";
+	else if (v.compare("ntypez")==0) dumpstream << g->ntype[i][2] << " ";
+	else if (v.compare("rigid")==0) dumpstream << g->rigid[i] << " ";
+	else if (v.compare("T")==0) dumpstream << g->T[i] << " ";
       }
+      dumpstream << endl;
     }
-    dumpstream.close();
-  } else {
-    error->all(FLERR, "Error: cannot write in file: " + fdump + ".\n");
   }
+  output->writer->submit(fdump, dumpstream.str());
 }
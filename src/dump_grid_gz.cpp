@@ -19,9 +19,10 @@
 #include "solid.h"
 #include "universe.h"
 #include "update.h"
+#include "writer.h"
 #include <algorithm>
-#include <gzstream.h>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 
@@ -64,8 +65,8 @@ void DumpGridGz::write() {
 
   // cout << "Filemame for dump: " << fdump << endl;
 
-  // Open the file fdump:
-  ogzstream dumpstream(fdump.c_str());
+  // Format the snapshot in memory, it is compressed and written by Output::writer:
+  ostringstream dumpstream;
 
   dumpstream << "ITEM: TIMESTEP\n0\nITEM: NUMBER OF ATOMS\n";
 
@@ -143,5 +144,5 @@ void DumpGridGz::write() {
       dumpstream << endl;
     }
   }
-  dumpstream.close();
+  output->writer->submit(fdump, dumpstream.str(), true);
 }
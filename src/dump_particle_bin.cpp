@@ -0,0 +1,239 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "dump_particle_bin.h"
+#include "domain.h"
+#include "error.h"
+#include "method.h"
+#include "mpm_math.h"
+#include "mpmtype.h"
+#include "solid.h"
+#include "universe.h"
+#include "update.h"
+#include <Eigen/Eigen>
+#include <iostream>
+#include <mpi.h>
+#include <string.h>
+
+using namespace std;
+using namespace MPM_Math;
+
+#define NAME_LENGTH 16
+
+DumpParticleBin::DumpParticleBin(MPM *mpm, vector<string> args) : Dump(mpm, args) {
+  need_sigma = false;
+
+  for (size_t i = 5; i < args.size(); i++) {
+    auto it = find(known_var.begin(), known_var.end(), args[i]);
+    if (it != known_var.end()) {
+      output_var.push_back(args[i]);
+      columns.push_back(it - known_var.begin());
+      if (args[i][0] == 's') need_sigma = true;
+    } else {
+      string error_str = "Error: output variable \033[1;31m" + args[i] +
+                         "\033[0m is unknown!\n";
+      error_str += "Availabe output variables: ";
+      for (auto v : known_var) {
+        error_str += v + ", ";
+      }
+      error->all(FLERR, error_str);
+    }
+  }
+}
+
+DumpParticleBin::~DumpParticleBin()
+{
+}
+
+/*! Variables not computed by the method, such as the temperature without thermal
+ * coupling, are written as 0.
+ */
+void DumpParticleBin::fill(int var, Solid *s, double *out, int offset)
+{
+  const int np = s->np_local;
+  const bool temp = update->method->temp;
+
+  switch (var) {
+  case 0: case 1: case 2:
+    for (int i = 0; i < np; i++) out[i] = s->x[i][var];
+    break;
+  case 3: case 4: case 5:
+    for (int i = 0; i < np; i++) out[i] = s->x0[i][var - 3];
+    break;
+  case 6: case 7: case 8:
+    for (int i = 0; i < np; i++) out[i] = s->v[i][var - 6];
+    break;
+  case 9: case 10: case 11:
+    for (int i = 0; i < np; i++) out[i] = sigma[offset + i](var - 9, var - 9);
+    break;
+  case 12:
+    for (int i = 0; i < np; i++) out[i] = sigma[offset + i](0, 1);
+    break;
+  case 13:
+    for (int i = 0; i < np; i++) out[i] = sigma[offset + i](0, 2);
+    break;
+  case 14:
+    for (int i = 0; i < np; i++) out[i] = sigma[offset + i](1, 2);
+    break;
+  case 15: case 16: case 17:
+    for (int i = 0; i < np; i++) out[i] = s->strain_el[i](var - 15, var - 15);
+    break;
+  case 18:
+    for (int i = 0; i < np; i++) out[i] = s->strain_el[i](0, 1);
+    break;
+  case 19:
+    for (int i = 0; i < np; i++) out[i] = s->strain_el[i](0, 2);
+    break;
+  case 20:
+    for (int i = 0; i < np; i++) out[i] = s->strain_el[i](1, 2);
+    break;
+  case 21:
+    for (int i = 0; i < np; i++) out[i] = sqrt(3. / 2.) * Deviator(sigma[offset + i]).norm();
+    break;
+  case 22:
+    for (int i = 0; i < np; i++) out[i] = s->vol[i];
+    break;
+  case 23:
+    for (int i = 0; i < np; i++) out[i] = s->mass[i];
+    break;
+  case 24:
+    for (int i = 0; i < np; i++) out[i] = s->damage[i];
+    break;
+  case 25:
+    if (s->has_field("damage_init"))
+      for (int i = 0; i < np; i++) out[i] = s->damage_init[i];
+    else
+      for (int i = 0; i < np; i++) out[i] = 0;
+    break;
+  case 26: case 27: case 28:
+    for (int i = 0; i < np; i++) out[i] = s->mbp[i][var - 26];
+    break;
+  case 29:
+    for (int i = 0; i < np; i++) out[i] = s->eff_plastic_strain[i];
+    break;
+  case 30:
+    for (int i = 0; i < np; i++) out[i] = s->eff_plastic_strain_rate[i];
+    break;
+  case 31:
+    for (int i = 0; i < np; i++) out[i] = temp ? s->T[i] : 0;
+    break;
+  case 32:
+    for (int i = 0; i < np; i++) out[i] = s->ienergy[i];
+    break;
+  case 33:
+    for (int i = 0; i < np; i++) out[i] = temp ? s->gamma[i] : 0;
+    break;
+  }
+}
+
+void DumpParticleBin::write()
+{
+  // Replace the asterisk by ntimestep, all CPUs write in the same file:
+  size_t pos_asterisk = filename.find('*');
+  string fdump;
+
+  if (pos_asterisk != string::npos) {
+    fdump = filename.substr(0, pos_asterisk) + to_string(update->ntimestep)
+      + filename.substr(pos_asterisk + 1);
+  } else {
+    fdump = filename;
+  }
+
+  // Position of the particles of this CPU in each column:
+  bigint np_local = 0;
+  for (Solid *s: domain->solids)
+    np_local += s->np_local;
+
+  bigint np_total, np_before = 0;
+  MPI_Allreduce(&np_local, &np_total, 1, MPI_MPM_BIGINT, MPI_SUM, universe->uworld);
+  MPI_Exscan(&np_local, &np_before, 1, MPI_MPM_BIGINT, MPI_SUM, universe->uworld);
+  if (universe->me == 0) np_before = 0;
+
+  const int ncolumns = 2 + columns.size();
+  const MPI_Offset header_size = 2 * sizeof(int) + sizeof(bigint) + sizeof(double)
+    + sizeof(bigint) + 6 * sizeof(double) + 8 + ncolumns * NAME_LENGTH;
+
+  MPI_File fh;
+  if (MPI_File_open(universe->uworld, fdump.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+		    MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+    error->all(FLERR, "Error: cannot write in file: " + fdump + ".\n");
+  }
+
+  // Discard a longer file written before:
+  MPI_File_set_size(fh, header_size + ncolumns * np_total * 8);
+
+  if (universe->me == 0) {
+    header.assign(header_size, 0);
+    char *h = header.data();
+    int version = 1;
+    bigint ntimestep = update->ntimestep;
+    double time = update->atime;
+
+    memcpy(h, "KMPMPBIN", 8);                            h += 8;
+    memcpy(h, &version, sizeof(int));                    h += sizeof(int);
+    memcpy(h, &ncolumns, sizeof(int));                   h += sizeof(int);
+    memcpy(h, &ntimestep, sizeof(bigint));               h += sizeof(bigint);
+    memcpy(h, &time, sizeof(double));                    h += sizeof(double);
+    memcpy(h, &np_total, sizeof(bigint));                h += sizeof(bigint);
+    memcpy(h, domain->boxlo, 3 * sizeof(double));        h += 3 * sizeof(double);
+    memcpy(h, domain->boxhi, 3 * sizeof(double));        h += 3 * sizeof(double);
+
+    vector<string> names = {"id", "type"};
+    names.insert(names.end(), output_var.begin(), output_var.end());
+    for (const string &name: names) {
+      strncpy(h, name.c_str(), NAME_LENGTH - 1);
+      h += NAME_LENGTH;
+    }
+
+    MPI_File_write_at(fh, 0, header.data(), header_size, MPI_BYTE, MPI_STATUS_IGNORE);
+  }
+
+  // Stress in the current configuration:
+  if (need_sigma) {
+    sigma.resize(np_local);
+    int k = 0;
+    bool tl = update->method_type.compare("tlmpm") == 0 || update->method_type.compare("tlcpdi") == 0;
+    for (Solid *s: domain->solids) {
+      for (int i = 0; i < s->np_local; i++, k++) {
+	if (tl) sigma[k] = s->R[i] * s->sigma[i].matrix() * s->R[i].transpose();
+	else sigma[k] = s->sigma[i];
+      }
+    }
+  }
+
+  // Columns are written one after the other, collectively:
+  tags.resize(np_local);
+  buf.resize(np_local);
+
+  for (int c = 0; c < ncolumns; c++) {
+    MPI_Offset offset = header_size + (c * np_total + np_before) * 8;
+    int k = 0;
+
+    if (c < 2) {
+      for (size_t isolid = 0; isolid < domain->solids.size(); isolid++) {
+	Solid *s = domain->solids[isolid];
+	for (int i = 0; i < s->np_local; i++, k++)
+	  tags[k] = c == 0 ? s->ptag[i] : isolid + 1;
+      }
+      MPI_File_write_at_all(fh, offset, tags.data(), np_local, MPI_MPM_TAGINT, MPI_STATUS_IGNORE);
+    } else {
+      for (Solid *s: domain->solids) {
+	fill(columns[c - 2], s, buf.data() + k, k);
+	k += s->np_local;
+      }
+      MPI_File_write_at_all(fh, offset, buf.data(), np_local, MPI_DOUBLE, MPI_STATUS_IGNORE);
+    }
+  }
+
+  MPI_File_close(&fh);
+}
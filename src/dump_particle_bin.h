@@ -0,0 +1,82 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifdef DUMP_CLASS
+
+DumpStyle(particle/bin,DumpParticleBin)
+
+#else
+
+#ifndef MPM_DUMP_PARTICLE_BIN_H
+#define MPM_DUMP_PARTICLE_BIN_H
+
+#include "dump.h"
+#include <Eigen/Eigen>
+
+/*! Binary particle dump, written by all the CPUs into a single file per snapshot with MPI-IO.
+ *
+ * The file starts with a header, followed by one contiguous array per column holding the
+ * values of all the particles, the particles of CPU 0 first. All values are 8 bytes long
+ * and stored in the byte order of the machine that wrote the file:
+ *
+ * | Header field | Type          | Content                                             |
+ * |--------------|---------------|-----------------------------------------------------|
+ * | magic        | char[8]       | "KMPMPBIN"                                          |
+ * | version      | int32         | 1                                                   |
+ * | ncolumns     | int32         | number of columns, id and type included             |
+ * | ntimestep    | int64         | time step of the snapshot                           |
+ * | time         | double        | time of the snapshot                                |
+ * | np           | int64         | number of particles                                 |
+ * | boxlo, boxhi | double[3] x 2 | domain bounds                                       |
+ * | names        | char[16] x ncolumns | names of the columns, padded with '\0'        |
+ *
+ * The first two columns are the particle tag (id) and the solid number starting from 1 (type),
+ * both int64, and the others are the requested variables as doubles.
+ *
+ * tools/dump_particle_bin2txt.py converts the files to the text format of the particle dump.
+ */
+class DumpParticleBin : public Dump {
+ public:
+  DumpParticleBin(MPM *, vector<string>);
+  ~DumpParticleBin();
+
+  void write();
+
+ protected:
+  vector<string> known_var = {"x", "y", "z",
+			      "x0", "y0", "z0",
+			      "vx", "vy", "vz",
+			      "s11", "s22", "s33",
+			      "s12", "s13", "s23",
+			      "e11", "e22", "e33",
+			      "e12", "e13", "e23",
+			      "seq", "volume", "mass",
+			      "damage", "damage_init",
+			      "bx", "by", "bz",
+			      "ep", "epdot", "T",
+			      "ienergy", "gamma"};
+
+  vector<int> columns;                 ///< Index in known_var of each output variable
+  bool need_sigma;                     ///< Is any of the stress columns output?
+
+ private:
+  vector<char> header;                 ///< Header of the file, built on CPU 0
+  vector<double> buf;                  ///< Values of one column for the local particles
+  vector<tagint> tags;                 ///< Tags or solid numbers of the local particles
+  vector<Eigen::Matrix3d> sigma;       ///< Stress of the local particles in the current configuration
+
+  void fill(int, class Solid *, double *, int); ///< Copy one variable of the particles of a solid in a buffer
+};
+
+#endif
+#endif
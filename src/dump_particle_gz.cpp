@@ -21,9 +21,10 @@
 #include "solid.h"
 #include "universe.h"
 #include "update.h"
+#include "writer.h"
 #include <Eigen/Eigen>
-#include <gzstream.h>
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 using namespace MPM_Math;
@@ -67,8 +68,8 @@ void DumpParticleGz::write() {
 
   // cout << "Filemame for dump: " << fdump << endl;
 
-  // Open the file fdump:
-  ogzstream dumpstream(fdump.c_str());
+  // Format the snapshot in memory, it is compressed and written by Output::writer:
+  ostringstream dumpstream;
 
   dumpstream << "ITEM: TIMESTEP\n0\nITEM: NUMBER OF ATOMS\n";
 
@@ -92,10 +93,11 @@ void DumpParticleGz::write() {
 
   for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
     Solid *s = domain->solids[isolid];
+    bool has_damage_init = s->has_field("damage_init");
     for (bigint i = 0; i < s->np_local; i++) {
       if (update->method_type.compare("tlmpm") == 0 ||
 	  update->method_type.compare("tlcpdi") == 0)
-	sigma_ = s->R[i] * s->sigma[i] * s->R[i].transpose();
+	sigma_ = s->R[i] * s->sigma[i].matrix() * s->R[i].transpose();
       else
 	sigma_ = s->sigma[i];
       dumpstream << s->ptag[i] << " ";
@@ -149,7 +151,7 @@ void DumpParticleGz::write() {
         else if (v.compare("damage") == 0)
           dumpstream << s->damage[i] << " ";
         else if (v.compare("damage_init") == 0)
-          dumpstream << s->damage_init[i] << " ";
+          dumpstream << (has_damage_init ? s->damage_init[i] : 0) << " ";
         else if (v.compare("volume") == 0)
           dumpstream << s->vol[i] << " ";
         else if (v.compare("mass") == 0)
@@ -183,5 +185,5 @@ void DumpParticleGz::write() {
       dumpstream << endl;
     }
   }
-  dumpstream.close();
+  output->writer->submit(fdump, dumpstream.str(), true);
 }
@@ -57,3 +57,20 @@ void EOS::options(vector<string> *args, vector<string>::iterator it)
   }
 }
 
+
+/*! Default implementation calling compute_pressure() for each particle.
+ * Models override it where a loop over the arrays pays off, see EOSShock.
+ */
+void EOS::compute_pressure(int n, double *pH, double *e, const double *J,
+                           const double *rho, const double *damage,
+                           const SymmetricMatrixColumns &D, const double cellsize,
+                           const double *T)
+{
+  if (T != nullptr) {
+    for (int i = 0; i < n; i++)
+      compute_pressure(pH[i], e[i], J[i], rho[i], damage[i], D[i], cellsize, T[i]);
+  } else {
+    for (int i = 0; i < n; i++)
+      compute_pressure(pH[i], e[i], J[i], rho[i], damage[i], D[i], cellsize);
+  }
+}
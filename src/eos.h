@@ -15,6 +15,7 @@
 #define MPM_EOS_H
 
 #include "pointers.h"
+#include "particle_field.h"
 #include <vector>
 #include <Eigen/Eigen>
 
@@ -37,7 +38,9 @@ class EOS : protected Pointers {
   //virtual compute_pressure()
   virtual double rho0() = 0;
   virtual double K() = 0;
-  virtual void compute_pressure(double &, double &, const double, const double, const double, const Eigen::Matrix3d, const double, const double T = 0) = 0;
+  virtual void compute_pressure(double &, double &, const double, const double, const double, const Eigen::Matrix3d &, const double, const double T = 0) = 0;
+  virtual void compute_pressure(int, double *, double *, const double *, const double *, const double *,
+                                const SymmetricMatrixColumns &, const double, const double *T = nullptr); ///< Computes the pressure of n consecutive particles.
 
   virtual void write_restart(ofstream*) = 0;
   virtual void read_restart(ifstream*) = 0;
@@ -74,7 +74,9 @@ public:
   double rho0();
   double K();
   double G();
-  void compute_pressure(double &, double &, const double, const double, const double, const Eigen::Matrix3d, const double, const double T = 0);
+  void compute_pressure(double &, double &, const double, const double, const double, const Eigen::Matrix3d &, const double, const double T = 0);
+  void compute_pressure(int, double *, double *, const double *, const double *, const double *,
+                        const SymmetricMatrixColumns &, const double, const double *T = nullptr);
   void write_restart(ofstream *);
   void read_restart(ifstream *);
 
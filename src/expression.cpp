@@ -0,0 +1,480 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "expression.h"
+#include "input.h"
+#include "mpm.h"
+#include <math.h>
+
+using namespace std;
+using namespace Eigen;
+
+static const char *coordinate_names[3] = {"x", "y", "z"};
+static const char *initial_coordinate_names[3] = {"x0", "y0", "z0"};
+
+Expression::Expression(MPM *mpm, const Var &v)
+{
+  compile(mpm, v);
+}
+
+/*! Compiles the equation of v into a postfix program.\n
+ * The grammar and precedences follow those of Input::parsev(): comparisons, then + and -,
+ * then * and /, then ^ and **, all left associative, with unary - and ! binding to the
+ * following operand. Numbers are read with stof() as in Input::parsev().\n
+ * If the equation cannot be compiled, compiled is set to false and evaluate() will
+ * use Var::result() instead.
+ */
+void Expression::compile(MPM *ptr, const Var &v)
+{
+  mpm = ptr;
+  var = v;
+  code.clear();
+  depth = 0;
+  compiled = false;
+  uniform = true;
+
+  if (var.is_constant()) {
+    emit({CONSTANT, var.result(), nullptr, 0});
+    depth = 1;
+    compiled = true;
+    return;
+  }
+
+  str.clear();
+  for (char c: var.eq()) {
+    if (c != ' ') str.push_back(c);
+  }
+  pos = 0;
+
+  if (!parse_comparison() || pos != str.size()) {
+    code.clear();
+    return;
+  }
+
+  // Determine the depth of the stack:
+  int d = 0;
+  for (const Instruction &ins: code) {
+    if (ins.op <= SLOT_X0) d++;
+    else if (ins.op >= ADD && ins.op <= NE) d--;
+    else if (ins.op == ATAN2) d--;
+    depth = MAX(depth, d);
+
+    if (ins.op == SLOT_X || ins.op == SLOT_X0) uniform = false;
+  }
+
+  compiled = true;
+}
+
+bool Expression::accept(const string &token)
+{
+  if (str.compare(pos, token.size(), token) == 0) {
+    pos += token.size();
+    return true;
+  }
+  return false;
+}
+
+void Expression::emit(Instruction ins)
+{
+  code.push_back(ins);
+}
+
+/*! Appends an operator to the program, folding it if all its operands are constants.
+ */
+void Expression::emit_op(OpCode op)
+{
+  int nargs = (op == NEG || op == NOT || (op >= EXP && op <= LOG)) ? 1 : 2;
+
+  if ((int) code.size() >= nargs) {
+    bool constant = true;
+    for (int i = 1; i <= nargs; i++)
+      constant = constant && code[code.size() - i].op == CONSTANT;
+
+    if (constant) {
+      double b = code.back().value;
+      double a = nargs == 2 ? code[code.size() - 2].value : b;
+      double r = 0;
+
+      switch (op) {
+      case NEG:   r = -a; break;
+      case NOT:   r = !a; break;
+      case ADD:   r = a + b; break;
+      case SUB:   r = a - b; break;
+      case MUL:   r = a * b; break;
+      case DIV:   r = a / b; break;
+      case POW:   r = pow(a, b); break;
+      case GT:    r = a > b; break;
+      case GE:    r = a >= b; break;
+      case LT:    r = a < b; break;
+      case LE:    r = a <= b; break;
+      case EQ:    r = a == b; break;
+      case NE:    r = a != b; break;
+      case EXP:   r = exp(a); break;
+      case SQRT:  r = sqrt(a); break;
+      case COS:   r = cos(a); break;
+      case SIN:   r = sin(a); break;
+      case TAN:   r = tan(a); break;
+      case LOG:   r = log(a); break;
+      case ATAN2: r = atan2(a, b); break;
+      default: break;
+      }
+
+      code.resize(code.size() - nargs);
+      emit({CONSTANT, r, nullptr, 0});
+      return;
+    }
+  }
+
+  emit({op, 0, nullptr, 0});
+}
+
+bool Expression::parse_comparison()
+{
+  if (!parse_additive()) return false;
+
+  while (pos < str.size()) {
+    OpCode op;
+    if (accept(">=")) op = GE;
+    else if (accept("<=")) op = LE;
+    else if (accept("==")) op = EQ;
+    else if (accept("!=")) op = NE;
+    else if (accept(">")) op = GT;
+    else if (accept("<")) op = LT;
+    else break;
+
+    if (!parse_additive()) return false;
+    emit_op(op);
+  }
+  return true;
+}
+
+bool Expression::parse_additive()
+{
+  if (!parse_term()) return false;
+
+  while (pos < str.size()) {
+    OpCode op;
+    if (accept("+")) op = ADD;
+    else if (accept("-")) op = SUB;
+    else break;
+
+    if (!parse_term()) return false;
+    emit_op(op);
+  }
+  return true;
+}
+
+bool Expression::parse_term()
+{
+  if (!parse_power()) return false;
+
+  while (pos < str.size()) {
+    OpCode op;
+    if (str.compare(pos, 2, "**") == 0) break;
+    else if (accept("*")) op = MUL;
+    else if (accept("/")) op = DIV;
+    else break;
+
+    if (!parse_power()) return false;
+    emit_op(op);
+  }
+  return true;
+}
+
+bool Expression::parse_power()
+{
+  if (!parse_unary()) return false;
+
+  while (pos < str.size()) {
+    if (!accept("^") && !accept("**")) break;
+
+    if (!parse_unary()) return false;
+    emit_op(POW);
+  }
+  return true;
+}
+
+bool Expression::parse_unary()
+{
+  if (pos >= str.size()) return false;
+
+  if (str[pos] == '-') {
+    pos++;
+    if (!parse_unary()) return false;
+    emit_op(NEG);
+    return true;
+  }
+
+  if (str[pos] == '!' && str.compare(pos, 2, "!=") != 0) {
+    pos++;
+    if (!parse_unary()) return false;
+    emit_op(NOT);
+    return true;
+  }
+
+  if (str[pos] == '+') {
+    pos++;
+    return parse_unary();
+  }
+
+  return parse_primary();
+}
+
+/*! Reads a number. As in Input::parsev(), 'e' or 'E' followed by a sign multiplies
+ * the mantissa by the corresponding power of 10.
+ */
+bool Expression::parse_number()
+{
+  size_t start = pos;
+  while (pos < str.size() && (isdigit(str[pos]) || str[pos] == '.')) pos++;
+  double value = stof(str.substr(start, pos - start));
+
+  if (pos + 2 < str.size() && (str[pos] == 'e' || str[pos] == 'E') &&
+      (str[pos + 1] == '+' || str[pos + 1] == '-') && isdigit(str[pos + 2])) {
+    double sign = str[pos + 1] == '-' ? -1 : 1;
+    pos += 2;
+    start = pos;
+    while (pos < str.size() && (isdigit(str[pos]) || str[pos] == '.')) pos++;
+    value *= pow(10, sign * stof(str.substr(start, pos - start)));
+  }
+
+  emit({CONSTANT, value, nullptr, 0});
+  return true;
+}
+
+bool Expression::parse_primary()
+{
+  if (pos >= str.size()) return false;
+
+  if (isdigit(str[pos])) return parse_number();
+
+  if (str[pos] == '(') {
+    pos++;
+    if (!parse_comparison()) return false;
+    return accept(")");
+  }
+
+  // Read a word up to the next mathematical character:
+  size_t start = pos;
+  while (pos < str.size() && string("+-*/^<>!=(),").find(str[pos]) == string::npos) pos++;
+  if (pos == start) return false;
+  string word = str.substr(start, pos - start);
+
+  if (pos < str.size() && str[pos] == '(') {
+    pos++;
+    return parse_function(word);
+  }
+
+  map<string, Var> *vars = mpm->input->vars;
+
+  for (int i = 0; i < 3; i++) {
+    if (word == coordinate_names[i]) {
+      emit({SLOT_X, 0, &(*vars)[word], i});
+      return true;
+    }
+    if (word == initial_coordinate_names[i]) {
+      emit({SLOT_X0, 0, &(*vars)[word], i});
+      return true;
+    }
+  }
+
+  map<string, Var>::iterator it = vars->find(word);
+  if (it == vars->end()) return false;
+
+  if (it->second.is_constant()) emit({CONSTANT, it->second.result(), nullptr, 0});
+  else emit({VARIABLE, 0, &it->second, 0});
+  return true;
+}
+
+/*! Compiles the arguments of the function word, the opening parenthesis having already been read.
+ * Only the mathematical functions known to Input::evaluate_function() are supported.
+ */
+bool Expression::parse_function(const string &word)
+{
+  OpCode op;
+  int nargs = 1;
+
+  if (word == "exp") op = EXP;
+  else if (word == "sqrt") op = SQRT;
+  else if (word == "cos") op = COS;
+  else if (word == "sin") op = SIN;
+  else if (word == "tan") op = TAN;
+  else if (word == "log") op = LOG;
+  else if (word == "atan2") {
+    op = ATAN2;
+    nargs = 2;
+  }
+  else if (word == "evaluate") {
+    if (!parse_comparison()) return false;
+    return accept(")");
+  }
+  else return false;
+
+  for (int i = 0; i < nargs; i++) {
+    if (i > 0 && !accept(",")) return false;
+    if (!parse_comparison()) return false;
+  }
+  if (!accept(")")) return false;
+
+  emit_op(op);
+  return true;
+}
+
+double Expression::evaluate(const Vector3d *x, const Vector3d *x0)
+{
+  const double *xc[3], *x0c[3];
+  for (int j = 0; j < 3; j++) {
+    if (x) xc[j] = x->data() + j;
+    if (x0) x0c[j] = x0->data() + j;
+  }
+
+  double result;
+  evaluate(1, nullptr, x ? xc : nullptr, x0 ? x0c : nullptr, &result);
+  return result;
+}
+
+void Expression::evaluate(int n, const int *index, const ParticleVectors *x,
+			  const ParticleVectors *x0, double *out)
+{
+  const double *xc[3], *x0c[3];
+  for (int j = 0; j < 3; j++) {
+    if (x) xc[j] = x->column(j);
+    if (x0) x0c[j] = x0->column(j);
+  }
+
+  evaluate(n, index, x ? xc : nullptr, x0 ? x0c : nullptr, out);
+}
+
+/*! The nodes' coordinates are read in place, as columns of stride 3.
+ */
+void Expression::evaluate(int n, const int *index, const vector<Vector3d> *x,
+			  const vector<Vector3d> *x0, double *out)
+{
+  const double *xc[3], *x0c[3];
+  for (int j = 0; j < 3; j++) {
+    if (x) xc[j] = reinterpret_cast<const double *>(x->data()) + j;
+    if (x0) x0c[j] = reinterpret_cast<const double *>(x0->data()) + j;
+  }
+
+  evaluate(n, index, x ? xc : nullptr, x0 ? x0c : nullptr, out, 3);
+}
+
+/*! Evaluates the expression at n points and stores the results in out[0] to out[n - 1].\n
+ * x[j] and x0[j] are the columns of the j-th current and initial coordinates: those of point k
+ * are x[j][i * stride] and x0[j][i * stride], with i = index[k], or i = k if index is a nullptr.
+ * If x or x0 is a nullptr, the corresponding variables are read from Input::vars.\n
+ * The points are processed in blocks of EXPRESSION_BLOCK: each instruction of the program
+ * is applied to a whole column of values at once, so that the inner loops can be vectorized.
+ * If the expression does not depend on the coordinates, it is evaluated only once.
+ */
+void Expression::evaluate(int n, const int *index, const double *const *x,
+			  const double *const *x0, double *out, int stride)
+{
+  if (!compiled) {
+    map<string, Var> *vars = mpm->input->vars;
+
+    for (int k = 0; k < n; k++) {
+      int i = (index ? index[k] : k) * stride;
+      for (int j = 0; j < 3; j++) {
+	if (x) (*vars)[coordinate_names[j]] = Var(coordinate_names[j], x[j][i]);
+	if (x0) (*vars)[initial_coordinate_names[j]] = Var(initial_coordinate_names[j], x0[j][i]);
+      }
+      out[k] = var.result(mpm);
+    }
+    return;
+  }
+
+  if (n <= 0) return;
+
+  stack.resize(depth * EXPRESSION_BLOCK);
+
+  for (int start = 0; start < n; start += EXPRESSION_BLOCK) {
+    int m = uniform ? 1 : MIN(EXPRESSION_BLOCK, n - start);
+
+    // Top of the stack. Each entry of the stack is a column of EXPRESSION_BLOCK values:
+    double *t = stack.data() - EXPRESSION_BLOCK;
+    double *a;
+
+    for (const Instruction &ins: code) {
+      switch (ins.op) {
+      case CONSTANT:
+	t += EXPRESSION_BLOCK;
+	for (int k = 0; k < m; k++) t[k] = ins.value;
+	break;
+      case VARIABLE: {
+	t += EXPRESSION_BLOCK;
+	double value = ins.var->result();
+	for (int k = 0; k < m; k++) t[k] = value;
+	break;
+      }
+      case SLOT_X:
+      case SLOT_X0: {
+	t += EXPRESSION_BLOCK;
+	const double *const *p = ins.op == SLOT_X ? x : x0;
+	if (p) {
+	  const double *c = p[ins.index];
+	  if (index) {
+	    const int *ik = index + start;
+	    for (int k = 0; k < m; k++) t[k] = c[ik[k] * stride];
+	  } else if (stride == 1) {
+	    c += start;
+	    for (int k = 0; k < m; k++) t[k] = c[k];
+	  } else {
+	    c += start * stride;
+	    for (int k = 0; k < m; k++) t[k] = c[k * stride];
+	  }
+	} else {
+	  double value = ins.var->result();
+	  for (int k = 0; k < m; k++) t[k] = value;
+	}
+	break;
+      }
+      case NEG:   for (int k = 0; k < m; k++) t[k] = -t[k]; break;
+      case NOT:   for (int k = 0; k < m; k++) t[k] = !t[k]; break;
+      case EXP:   for (int k = 0; k < m; k++) t[k] = exp(t[k]); break;
+      case SQRT:  for (int k = 0; k < m; k++) t[k] = sqrt(t[k]); break;
+      case COS:   for (int k = 0; k < m; k++) t[k] = cos(t[k]); break;
+      case SIN:   for (int k = 0; k < m; k++) t[k] = sin(t[k]); break;
+      case TAN:   for (int k = 0; k < m; k++) t[k] = tan(t[k]); break;
+      case LOG:   for (int k = 0; k < m; k++) t[k] = log(t[k]); break;
+      default:
+	// Binary operators: the result is stored in the column below the top.
+	a = t - EXPRESSION_BLOCK;
+	switch (ins.op) {
+	case ADD:   for (int k = 0; k < m; k++) a[k] = a[k] + t[k]; break;
+	case SUB:   for (int k = 0; k < m; k++) a[k] = a[k] - t[k]; break;
+	case MUL:   for (int k = 0; k < m; k++) a[k] = a[k] * t[k]; break;
+	case DIV:   for (int k = 0; k < m; k++) a[k] = a[k] / t[k]; break;
+	case POW:   for (int k = 0; k < m; k++) a[k] = pow(a[k], t[k]); break;
+	case GT:    for (int k = 0; k < m; k++) a[k] = a[k] > t[k]; break;
+	case GE:    for (int k = 0; k < m; k++) a[k] = a[k] >= t[k]; break;
+	case LT:    for (int k = 0; k < m; k++) a[k] = a[k] < t[k]; break;
+	case LE:    for (int k = 0; k < m; k++) a[k] = a[k] <= t[k]; break;
+	case EQ:    for (int k = 0; k < m; k++) a[k] = a[k] == t[k]; break;
+	case NE:    for (int k = 0; k < m; k++) a[k] = a[k] != t[k]; break;
+	case ATAN2: for (int k = 0; k < m; k++) a[k] = atan2(a[k], t[k]); break;
+	default: break;
+	}
+	t = a;
+	break;
+      }
+    }
+
+    if (uniform) {
+      for (int i = 0; i < n; i++) out[i] = stack[0];
+      return;
+    }
+
+    for (int k = 0; k < m; k++) out[start + k] = stack[k];
+  }
+}
@@ -0,0 +1,88 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_EXPRESSION_H
+#define MPM_EXPRESSION_H
+
+#include "particle_field.h"
+#include "pointers.h"
+#include "var.h"
+#include <Eigen/Eigen>
+#include <vector>
+
+#define EXPRESSION_BLOCK 128   ///< Number of points evaluated together by Expression::evaluate()
+
+/*! Compiled form of the equation of a Var.
+ *
+ * Var::result() re-parses the equation string with Input::parsev() every time it is called.
+ * An Expression parses it only once into a postfix program. The coordinates x, y, z, x0, y0 and z0
+ * are slots filled from the columns of coordinates given to evaluate(), and all other variables
+ * (time, dt, fix and compute outputs, ...) are read directly from their entry in Input::vars.\n
+ * Equations that cannot be compiled (unknown functions, ...) are evaluated with Var::result() instead.
+ */
+class Expression {
+ public:
+  Expression() {};
+  Expression(class MPM *, const Var &);
+
+  void compile(class MPM *, const Var &);             ///< Compiles the equation of a Var.
+  bool is_compiled() const {return compiled;};        ///< False if evaluate() falls back on Var::result().
+  bool is_uniform() const {return uniform;};          ///< True if the expression does not depend on the coordinates.
+  double evaluate(const Eigen::Vector3d *x = nullptr,
+                  const Eigen::Vector3d *x0 = nullptr); ///< Evaluates the expression at one point.
+  void evaluate(int, const int *, const double *const *, const double *const *,
+                double *, int stride = 1);            ///< Evaluates the expression at n points given by columns of coordinates.
+  void evaluate(int, const int *, const ParticleVectors *, const ParticleVectors *,
+                double *);                            ///< Evaluates the expression at n particles.
+  void evaluate(int, const int *, const vector<Eigen::Vector3d> *,
+                const vector<Eigen::Vector3d> *, double *); ///< Evaluates the expression at n nodes.
+
+ private:
+  enum OpCode {CONSTANT, VARIABLE, SLOT_X, SLOT_X0,
+	       NEG, NOT, ADD, SUB, MUL, DIV, POW,
+	       GT, GE, LT, LE, EQ, NE,
+	       EXP, SQRT, COS, SIN, TAN, LOG, ATAN2};
+
+  struct Instruction {
+    OpCode op;
+    double value;                // Value of a CONSTANT
+    const Var *var;              // Variable read by VARIABLE, or by SLOT_* when no array is given
+    int index;                   // Component read by SLOT_*
+  };
+
+  class MPM *mpm = nullptr;
+  Var var;                       ///< Copy of the compiled Var, used as fallback
+  bool compiled = false;         ///< Was the equation successfully compiled?
+  bool uniform = true;           ///< True if the equation does not depend on the coordinates
+  vector<Instruction> code;      ///< Postfix program
+  int depth = 0;                 ///< Maximum stack depth required by code
+  vector<double> stack;          ///< Evaluation stack, made of depth columns of EXPRESSION_BLOCK values
+
+  // Parser state:
+  string str;                    ///< Equation stripped of white spaces
+  size_t pos;                    ///< Current position in str
+
+  bool parse_comparison();
+  bool parse_additive();
+  bool parse_term();
+  bool parse_power();
+  bool parse_unary();
+  bool parse_primary();
+  bool parse_number();
+  bool parse_function(const string &);
+  bool accept(const string &);
+  void emit(Instruction);
+  void emit_op(OpCode);
+};
+
+#endif
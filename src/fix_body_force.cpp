@@ -83,6 +83,10 @@ FixBodyforce::FixBodyforce(MPM *mpm, vector<string> args) : Fix(mpm, args)
       zset = true;
     }
   }
+
+  if (xset) xexpr.compile(mpm, xvalue);
+  if (yset) yexpr.compile(mpm, yvalue);
+  if (zset) zexpr.compile(mpm, zvalue);
 }
 
 FixBodyforce::~FixBodyforce()
@@ -106,64 +110,41 @@ void FixBodyforce::setmask() {
 void FixBodyforce::post_particles_to_grid() {
   // cout << "In FixBodyforce::post_particles_to_grid()\n";
 
-  // Go through all the nodes in the group and set b to the right value:
-  Eigen::Vector3d f;
-
+  // Go through the active nodes in the group (those near particles) and set b to the right value:
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Grid *g;
 
   Eigen::Vector3d ftot, ftot_reduced;
 
+  bool set[3] = {xset, yset, zset};
+  Expression *expr[3] = {&xexpr, &yexpr, &zexpr};
+
   // double mtot = 0;
   ftot.setZero();
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
-
-      for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-	if (g->mass[in] > 0) {
-	  if (g->mask[in] & groupbit) {
-	      (*input->vars)["x0"] = Var("x0", g->x0[in][0]);
-	      (*input->vars)["y0"] = Var("y0", g->x0[in][1]);
-	      (*input->vars)["z0"] = Var("z0", g->x0[in][2]);
-              f.setZero();
-	      if (xset) f[0] = xvalue.result(mpm);
-	      if (yset) f[1] = yvalue.result(mpm);
-	      if (zset) f[2] = zvalue.result(mpm);
-
-	      f *= g->mass[in];
-	      g->mb[in] += f;
-	      if (in < g->nnodes_local) {
-		ftot += f;
-		// mtot += g->mass[in];
-	      }
-	  }
-	}
-      }
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    g = domain->solids[solid == -1 ? isolid : solid]->grid;
+
+    ilist.clear();
+    for (int in: g->active_nodes) {
+      if (g->mass[in] > 0 && (g->mask[in] & groupbit)) ilist.push_back(in);
     }
-  } else {
-    g = domain->solids[solid]->grid;
-
-    for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-      if (g->mass[in] > 0) {
-	if (g->mask[in] & groupbit) {
-	  (*input->vars)["x0"] = Var("x0", g->x0[in][0]);
-	  (*input->vars)["y0"] = Var("y0", g->x0[in][1]);
-	  (*input->vars)["z0"] = Var("z0", g->x0[in][2]);
-
-	  f.setZero();
-	  if (xset) f[0] = xvalue.result(mpm);
-	  if (yset) f[1] = yvalue.result(mpm);
-	  if (zset) f[2] = zvalue.result(mpm);
-
-	  f *= g->mass[in];
-	  g->mb[in] += f;
-
-	  if (in < g->nnodes_local) {
-	    ftot += f;
-	    // mtot += g->mass[in];
-	  }
+
+    int n = ilist.size();
+    values.resize(n);
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
+
+      expr[dim]->evaluate(n, ilist.data(), nullptr, &g->x0, values.data());
+
+      for (int i = 0; i < n; i++) {
+	int in = ilist[i];
+	double f = g->mass[in] * values[i];
+	g->mb[in][dim] += f;
+	if (in < g->nnodes_local) {
+	  ftot[dim] += f;
 	}
       }
     }
@@ -202,4 +183,8 @@ void FixBodyforce::read_restart(ifstream *ifr) {
     yvalue.read_from_restart(ifr);
   if (zset)
     zvalue.read_from_restart(ifr);
+
+  if (xset) xexpr.compile(mpm, xvalue);
+  if (yset) yexpr.compile(mpm, yvalue);
+  if (zset) zexpr.compile(mpm, zvalue);
 }
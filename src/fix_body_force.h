@@ -20,6 +20,7 @@ FixStyle(body_force,FixBodyforce)
 #ifndef MPM_FIX_BODY_FORCE_H
 #define MPM_FIX_BODY_FORCE_H
 
+#include "expression.h"
 #include "fix.h"
 #include "var.h"
 #include <vector>
@@ -79,7 +80,11 @@ class FixBodyforce : public Fix {
 
 private:
   class Var xvalue, yvalue, zvalue;    // Set force in x, y, and z directions.
+  class Expression xexpr, yexpr, zexpr; // Compiled forms of xvalue, yvalue, and zvalue.
   bool xset, yset, zset;               // Does the fix set the x, y, and z forces of the group?
+
+  vector<int> ilist;                   // Nodes of the group, work array
+  vector<double> values;               // Values of the body force at these nodes, work array
 };
 
 #endif
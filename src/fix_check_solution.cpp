@@ -26,6 +26,7 @@
 #include "universe.h"
 #include "solid.h"
 #include "error.h"
+#include "expression.h"
 
 using namespace std;
 using namespace FixConst;
@@ -111,10 +112,9 @@ void FixChecksolution::final_integrate() {
   if (update->ntimestep != output->next && update->ntimestep != update->nsteps) return;
   // cout << "In FixChecksolution::post_particles_to_grid()\n";
 
-  // Go through all the nodes in the group and set b to the right value:
-  double ux, uy, uz;
-    
+  // Go through all the particles in the group and compute the error:
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
 
   Solid *s;
 
@@ -124,64 +124,37 @@ void FixChecksolution::final_integrate() {
   error.setZero();
   u_th.setZero();
 
-  double vtot;
-
-  if (solid == -1) {
-    vtot = 0;
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      s = domain->solids[isolid];
-      vtot += s->vtot;
-
-      for (int in = 0; in < s->np_local; in++) {
-	if (s->mask[in] & groupbit) {
-	  (*input->vars)["x0"] = Var("x0", s->x0[in][0]);
-	  (*input->vars)["y0"] = Var("y0", s->x0[in][1]);
-	  (*input->vars)["z0"] = Var("z0", s->x0[in][2]);
-	  if (xset) {
-	    ux = xvalue.result(mpm);
-	    error[0] += s->vol0[in]*square(ux-(s->x[in][0]-s->x0[in][0]));
-	    u_th[0] += s->vol0[in]*ux*ux;
-	  }
-	  if (yset) {
-	    uy = yvalue.result(mpm);
-	    error[1] += s->vol0[in]*square(uy-(s->x[in][1]-s->x0[in][1]));
-	    u_th[1] += s->vol0[in]*uy*uy;
-	  }
-	  if (zset) {
-	    uz = zvalue.result(mpm);
-	    error[2] += s->vol0[in]*square(uz-(s->x[in][2]-s->x0[in][2]));
-	    u_th[2] += s->vol0[in]*uz*uz;
-	  }
-	}
-      }
-    }
-  } else {
-    s = domain->solids[solid];
+  Expression expr[3];
+  bool set[3] = {xset, yset, zset};
+  if (xset) expr[0].compile(mpm, xvalue);
+  if (yset) expr[1].compile(mpm, yvalue);
+  if (zset) expr[2].compile(mpm, zvalue);
+
+  double vtot = 0;
+
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    s = domain->solids[solid == -1 ? isolid : solid];
     vtot += s->vtot;
 
-    for (int in = 0; in < s->np_local; in++) {
-      if (s->mask[in] & groupbit) {
-	(*input->vars)["x0"] = Var("x0", s->x0[in][0]);
-	(*input->vars)["y0"] = Var("y0", s->x0[in][1]);
-	(*input->vars)["z0"] = Var("z0", s->x0[in][2]);
-	if (xset) {
-	  ux = xvalue.result(mpm);
-	  error[0] += s->vol0[in]*square(ux-(s->x[in][0]-s->x0[in][0]));
-	  u_th[0] += s->vol0[in]*ux*ux;
-	}
-	if (yset) {
-	  uy = yvalue.result(mpm);
-	  error[1] += s->vol0[in]*square(uy-(s->x[in][1]-s->x0[in][1]));
-	  u_th[1] += s->vol0[in]*uy*uy;
-	}
-	if (zset) {
-	  uz = zvalue.result(mpm);
-	  error[2] += s->vol0[in]*square(uz-(s->x[in][2]-s->x0[in][2]));
-	  u_th[2] += s->vol0[in]*uz*uz;
-	}
-      }
+    ilist.clear();
+    for (int ip = 0; ip < s->np_local; ip++) {
+      if (s->mask[ip] & groupbit) ilist.push_back(ip);
     }
 
+    int n = ilist.size();
+    values.resize(n);
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
+
+      expr[dim].evaluate(n, ilist.data(), nullptr, &s->x0, values.data());
+
+      for (int i = 0; i < n; i++) {
+	int ip = ilist[i];
+	error[dim] += s->vol0[ip]*square(values[i]-(s->x[ip][dim]-s->x0[ip][dim]));
+	u_th[dim] += s->vol0[ip]*values[i]*values[i];
+      }
+    }
   }
 
   // Reduce error:
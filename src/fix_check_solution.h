@@ -100,6 +100,9 @@ class FixChecksolution : public Fix {
 private:
   class Var xvalue, yvalue, zvalue;    // Set force in x, y, and z directions.
   bool xset, yset, zset;               // Does the fix set the x, y, and z forces of the group?
+
+  vector<int> ilist;                   // Particles of the group, work array
+  vector<double> values;               // Values of the solution at these particles, work array
 };
 
 #endif
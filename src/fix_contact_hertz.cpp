@@ -31,7 +31,7 @@ using namespace Eigen;
 #define four_thirds 1.333333333
 
 FixContactHertz::FixContactHertz(MPM *mpm, vector<string> args)
-    : Fix(mpm, args) {
+    : Fix(mpm, args), neigh(mpm) {
   if (args.size() < 3) {
     error->all(FLERR, "Error: not enough arguments.\n");
   }
@@ -72,7 +72,12 @@ FixContactHertz::FixContactHertz(MPM *mpm, vector<string> args)
 
 FixContactHertz::~FixContactHertz() {}
 
-void FixContactHertz::init() {}
+void FixContactHertz::init() {
+  // Particles of solid2 owned by other CPUs are needed as ghosts:
+  Solid *s1 = domain->solids[solid1];
+  Solid *s2 = domain->solids[solid2];
+  s2->ghost_cutoff = MAX(s2->ghost_cutoff, MAX(s1->grid->cellsize, s2->grid->cellsize));
+}
 
 void FixContactHertz::setup() {}
 
@@ -102,91 +107,70 @@ void FixContactHertz::initial_integrate() {
 
   max_cellsize = MAX(s1->grid->cellsize, s2->grid->cellsize);
 
+  neigh.build(s1, s2, max_cellsize);
+
   if (domain->dimension == 2) {
     for (int ip1 = 0; ip1 < s1->np_local; ip1++) {
-      for (int ip2 = 0; ip2 < s2->np_local; ip2++) {
+      for (int k = neigh.offset[ip1]; k < neigh.offset[ip1 + 1]; k++) {
+	int ip2 = neigh.partners[k];
         dx = s2->x[ip2] - s1->x[ip1];
 
-	// Extremely gross screening:
-	if ((dx[0] < max_cellsize) && (dx[1] < max_cellsize) &&
-	    (dx[2] < max_cellsize) && (dx[0] > -max_cellsize) &&
-            (dx[1] > -max_cellsize) && (dx[2] > -max_cellsize)) {
-	  Rp1 = 0.5 * sqrt(s1->vol[ip1]);
-	  Rp2 = 0.5 * sqrt(s2->vol[ip2]);
-	  Rp = Rp1 + Rp2;
-
-	  // Gross screening:
-	  if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[2] < Rp) && (dx[0] > -Rp) &&
-	      (dx[1] > -Rp) && (dx[2] > -Rp)) {
-
-	    r = dx.norm();
-
-	    // Finer screening:
-	    if (r < Rp) {
-
-              p = Rp - r; // penetration
-
-              fmag = 0.25 * M_PI * Estar *
-                     sqrt(Rp1 * Rp2 / (Rp1 + Rp2) * p * p * p);
-
-              f = fmag * dx / r;
-              ftot += f;
-	      s1->mbp[ip1] -= f;
-	      s2->mbp[ip2] += f;
-              // vtemp1 = -update->dt * f / s1->mass[ip1];
-              // s1->v[ip1] += vtemp1;
-              // s1->x[ip1] += update->dt * vtemp1;
-
-              // vtemp2 = update->dt * f / s2->mass[ip2];
-              // s2->v[ip2] += vtemp2;
-              // s2->x[ip2] += update->dt * vtemp2;
-            }
-          }
-        }
+	Rp1 = 0.5 * sqrt(s1->vol[ip1]);
+	Rp2 = 0.5 * sqrt(s2->vol[ip2]);
+	Rp = Rp1 + Rp2;
+
+	// Gross screening:
+	if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[2] < Rp) && (dx[0] > -Rp) &&
+	    (dx[1] > -Rp) && (dx[2] > -Rp)) {
+
+	  r = dx.norm();
+
+	  // Finer screening:
+	  if (r < Rp) {
+
+	    p = Rp - r; // penetration
+
+	    fmag = 0.25 * M_PI * Estar *
+	           sqrt(Rp1 * Rp2 / (Rp1 + Rp2) * p * p * p);
+
+	    f = fmag * dx / r;
+	    ftot += f;
+	    s1->mbp[ip1] -= f;
+	    s2->mbp[ip2] += f;
+	  }
+	}
       }
     }
   }
   else if (domain->dimension == 3) {
     for (int ip1 = 0; ip1 < s1->np_local; ip1++) {
-      for (int ip2 = 0; ip2 < s2->np_local; ip2++) {
+      for (int k = neigh.offset[ip1]; k < neigh.offset[ip1 + 1]; k++) {
+	int ip2 = neigh.partners[k];
         dx = s2->x[ip2] - s1->x[ip1];
 
-	// Extremely gross screening:
-	if ((dx[0] < max_cellsize) && (dx[1] < max_cellsize) &&
-	    (dx[2] < max_cellsize) && (dx[0] > -max_cellsize) &&
-            (dx[1] > -max_cellsize) && (dx[2] > -max_cellsize)) {
-	  Rp1 = 0.5 * pow(s1->vol[ip1], 0.333333333);
-	  Rp2 = 0.5 * pow(s2->vol[ip2], 0.333333333);
-	  Rp = Rp1 + Rp2;
-
-
-	  // Gross screening:
-	  if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[2] < Rp) && (dx[0] > -Rp) &&
-	      (dx[1] > -Rp) && (dx[2] > -Rp)) {
-
-	    r = dx.norm();
-
-	    // Finer screening:
-	    if (r < Rp) {
-              p = Rp - r; // penetration
-
-              fmag = four_thirds * Estar *
-                     sqrt(Rp1 * Rp2 / (Rp1 + Rp2) * p * p * p);
-
-              f = fmag * dx / r;
-	      s1->mbp[ip1] -= f;
-	      s2->mbp[ip2] += f;
-              ftot += f;
-              // vtemp1 = -update->dt * f / s1->mass[ip1];
-              // s1->v[ip1] += vtemp1;
-              // s1->x[ip1] += update->dt * vtemp1;
-
-              // vtemp2 = update->dt * f / s2->mass[ip2];
-              // s2->v[ip2] += vtemp2;
-              // s2->x[ip2] += update->dt * vtemp2;
-            }
-          }
-        }
+	Rp1 = 0.5 * pow(s1->vol[ip1], 0.333333333);
+	Rp2 = 0.5 * pow(s2->vol[ip2], 0.333333333);
+	Rp = Rp1 + Rp2;
+
+	// Gross screening:
+	if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[2] < Rp) && (dx[0] > -Rp) &&
+	    (dx[1] > -Rp) && (dx[2] > -Rp)) {
+
+	  r = dx.norm();
+
+	  // Finer screening:
+	  if (r < Rp) {
+	    p = Rp - r; // penetration
+
+	    fmag = four_thirds * Estar *
+	           sqrt(Rp1 * Rp2 / (Rp1 + Rp2) * p * p * p);
+
+	    f = fmag * dx / r;
+	    s1->mbp[ip1] -= f;
+	    s2->mbp[ip2] += f;
+	    ftot += f;
+	  }
+	}
       }
     }
   }
@@ -20,6 +20,7 @@ FixStyle(contact/hertz, FixContactHertz)
 #ifndef MPM_FIX_CONTACT_HERTZ_H
 #define MPM_FIX_CONTACT_HERTZ_H
 
+#include "contact_neighbours.h"
 #include "fix.h"
 #include "var.h"
 #include <vector>
@@ -47,6 +48,7 @@ private:
   string usage = "Usage: fix(fix-ID, contact/hertz, solid1, solid2)\n";
   int Nargs = 4;
   int solid1, solid2;
+  ContactNeighbours neigh;  // Candidate pairs of particles in contact
 };
 
 #endif
@@ -32,7 +32,7 @@ using namespace Eigen;
 #define four_thirds 1.333333333
 
 FixContactMinPenetration::FixContactMinPenetration(MPM *mpm, vector<string> args)
-    : Fix(mpm, args) {
+    : Fix(mpm, args), neigh(mpm) {
   if (args.size() < 3) {
     error->all(FLERR, "Error: not enough arguments.\n");
   }
@@ -76,7 +76,12 @@ FixContactMinPenetration::FixContactMinPenetration(MPM *mpm, vector<string> args
 
 FixContactMinPenetration::~FixContactMinPenetration() {}
 
-void FixContactMinPenetration::init() {}
+void FixContactMinPenetration::init() {
+  // Particles of solid2 owned by other CPUs are needed as ghosts:
+  Solid *s1 = domain->solids[solid1];
+  Solid *s2 = domain->solids[solid2];
+  s2->ghost_cutoff = MAX(s2->ghost_cutoff, MAX(s1->grid->cellsize, s2->grid->cellsize));
+}
 
 void FixContactMinPenetration::setup() {}
 
@@ -108,131 +113,104 @@ void FixContactMinPenetration::initial_integrate() {
 
   max_cellsize = MAX(s1->grid->cellsize, s2->grid->cellsize);
 
+  neigh.build(s1, s2, max_cellsize);
+
   if (domain->dimension == 2) {
     for (int ip1 = 0; ip1 < s1->np_local; ip1++) {
-      for (int ip2 = 0; ip2 < s2->np_local; ip2++) {
+      for (int k = neigh.offset[ip1]; k < neigh.offset[ip1 + 1]; k++) {
+	int ip2 = neigh.partners[k];
         dx = s2->x[ip2] - s1->x[ip1];
 
-        // Extremely gross screening:
-        if ((dx[0] < max_cellsize) && (dx[1] < max_cellsize) &&
-	    (dx[0] > -max_cellsize) && (dx[1] > -max_cellsize) ) {
-	  if (domain->axisymmetric) {
-	    Rp1 = 0.5 * sqrt(s1->vol[ip1]/s1->x[ip1][0]);
-	    Rp2 = 0.5 * sqrt(s2->vol[ip2]/s2->x[ip2][0]);
-	  } else {
-	    Rp1 = 0.5 * sqrt(s1->vol[ip1]);
-	    Rp2 = 0.5 * sqrt(s2->vol[ip2]);
-	  }
-          Rp = Rp1 + Rp2;
-
-
-          // Gross screening:
-          if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[0] > -Rp)
-	      && (dx[1] > -Rp)) {
-
-            r = dx.norm();
-
-	    // Finer screening:
-            if (r < Rp) {
-	      inv_r = 1.0/r;
-              fmag =
-                  s1->mass[ip1] * s2->mass[ip2] /
-                  ((s1->mass[ip1] + s2->mass[ip2]) * update->dt * update->dt) *
-                  (1 - Rp * inv_r);
-              f = fmag * dx;
-
-	      if (mu != 0) {
-                dv = s2->v[ip2] - s1->v[ip1];
-                vt = dv - dv.dot(dx) * inv_r * inv_r* dx;
-		vtnorm = vt.norm();
-                if (vtnorm != 0) {
-		  vt /= vtnorm;
-		  ffric = mu * fmag * r;
-		  f -= ffric * vt;
-		  if (update->method->temp) {
-                    gamma = ffric * vtnorm * update->dt;
-                    s1->gamma[ip1] += alpha * s1->vol0[ip1] * s1->mat->invcp * gamma;
-                    s2->gamma[ip2] += (1.0 - alpha) * s2->vol0[ip2] * s2->mat->invcp * gamma;
-                  }
-		}
+	if (domain->axisymmetric) {
+	  Rp1 = 0.5 * sqrt(s1->vol[ip1]/s1->x[ip1][0]);
+	  Rp2 = 0.5 * sqrt(s2->vol[ip2]/s2->x[ip2][0]);
+	} else {
+	  Rp1 = 0.5 * sqrt(s1->vol[ip1]);
+	  Rp2 = 0.5 * sqrt(s2->vol[ip2]);
+	}
+        Rp = Rp1 + Rp2;
+
+        // Gross screening:
+        if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[0] > -Rp)
+	    && (dx[1] > -Rp)) {
+
+          r = dx.norm();
+
+	  // Finer screening:
+          if (r < Rp) {
+	    inv_r = 1.0/r;
+            fmag =
+                s1->mass[ip1] * s2->mass[ip2] /
+                ((s1->mass[ip1] + s2->mass[ip2]) * update->dt * update->dt) *
+                (1 - Rp * inv_r);
+            f = fmag * dx;
+
+	    if (mu != 0) {
+              dv = s2->v[ip2] - s1->v[ip1];
+              vt = dv - dv.dot(dx) * inv_r * inv_r* dx;
+	      vtnorm = vt.norm();
+              if (vtnorm != 0) {
+		vt /= vtnorm;
+		ffric = mu * fmag * r;
+		f -= ffric * vt;
+		if (update->method->temp) {
+                  gamma = ffric * vtnorm * update->dt;
+                  s1->gamma[ip1] += alpha * s1->vol0[ip1] * s1->mat->invcp * gamma;
+                  s2->gamma[ip2] += (1.0 - alpha) * s2->vol0[ip2] * s2->mat->invcp * gamma;
+                }
 	      }
+	    }
 
-	      s1->mbp[ip1] += f;
-	      s2->mbp[ip2] -= f;
-              ftot += f;
-
-              // if ((s1->ptag[ip1] == 12862 && s2->ptag[ip2] == 12902) ||
-              //     (s1->ptag[ip1] == 12835 && s2->ptag[ip2] == 12875)) {
-              //   cout << "dx[" << s1->ptag[ip1] << "," << s2->ptag[ip2] << "]= ["
-              //        << dx[0] << "\t" << dx[1] << "\t" << dx[2] << "]\n";
-              //   cout << "f[" << s1->ptag[ip1] << "," << s2->ptag[ip2] << "]= ["
-              //        << f[0] << "\t" << f[1] << "\t" << f[2] << "]\n";
-              // }
-            }
+	    s1->mbp[ip1] += f;
+	    s2->mbp[ip2] -= f;
+            ftot += f;
           }
         }
       }
     }
   } else if (domain->dimension == 3) {
     for (int ip1 = 0; ip1 < s1->np_local; ip1++) {
-      for (int ip2 = 0; ip2 < s2->np_local; ip2++) {
+      for (int k = neigh.offset[ip1]; k < neigh.offset[ip1 + 1]; k++) {
+	int ip2 = neigh.partners[k];
         dx = s2->x[ip2] - s1->x[ip1];
 
-        // Extremely gross screening:
-        if ((dx[0] < max_cellsize) && (dx[1] < max_cellsize) &&
-            (dx[2] < max_cellsize) && (dx[0] > -max_cellsize) &&
-            (dx[1] > -max_cellsize) && (dx[2] > -max_cellsize)) {
-          Rp1 = 0.5 * cbrt(s1->vol[ip1]);
-          Rp2 = 0.5 * cbrt(s2->vol[ip2]);
-          Rp = Rp1 + Rp2;
-
-          // Gross screening:
-          if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[2] < Rp) && (dx[0] > -Rp) &&
-              (dx[1] > -Rp) && (dx[2] > -Rp)) {
-
-            r = dx.norm();
-
-	    // Finer screening:
-            if (r < Rp) {
-	      inv_r = 1.0/r;
-              fmag =
-                  s1->mass[ip1] * s2->mass[ip2] /
-                  ((s1->mass[ip1] + s2->mass[ip2]) * update->dt * update->dt) *
-                  (1 - Rp * inv_r);
-              f = fmag * dx;
-
-	      if (mu != 0) {
-                dv = s2->v[ip2] - s1->v[ip1];
-                vt = dv - dv.dot(dx) * inv_r * inv_r* dx;
-		vtnorm = vt.norm();
-                if (vtnorm != 0) {
-		  vt /= vtnorm;
-		  ffric = mu * fmag * r;
-		  f -= ffric * vt;
-		  if (update->method->temp) {
-                    gamma = alpha * ffric * vtnorm * update->dt;
-                    s1->gamma[ip1] += s1->vol0[ip1] * s1->mat->invcp * gamma;
-                    s2->gamma[ip2] += s2->vol0[ip2] * s2->mat->invcp * gamma;
-                    // cout << "gamma_1[" << s1->ptag[ip1]
-                    //      << "]=" << s1->gamma[ip1] << "gamma_2["
-                    //      << s2->ptag[ip2] << "]=" << s2->gamma[ip2] << endl;
-                  }
-		}
+        Rp1 = 0.5 * cbrt(s1->vol[ip1]);
+        Rp2 = 0.5 * cbrt(s2->vol[ip2]);
+        Rp = Rp1 + Rp2;
+
+        // Gross screening:
+        if ((dx[0] < Rp) && (dx[1] < Rp) && (dx[2] < Rp) && (dx[0] > -Rp) &&
+            (dx[1] > -Rp) && (dx[2] > -Rp)) {
+
+          r = dx.norm();
+
+	  // Finer screening:
+          if (r < Rp) {
+	    inv_r = 1.0/r;
+            fmag =
+                s1->mass[ip1] * s2->mass[ip2] /
+                ((s1->mass[ip1] + s2->mass[ip2]) * update->dt * update->dt) *
+                (1 - Rp * inv_r);
+            f = fmag * dx;
+
+	    if (mu != 0) {
+              dv = s2->v[ip2] - s1->v[ip1];
+              vt = dv - dv.dot(dx) * inv_r * inv_r* dx;
+	      vtnorm = vt.norm();
+              if (vtnorm != 0) {
+		vt /= vtnorm;
+		ffric = mu * fmag * r;
+		f -= ffric * vt;
+		if (update->method->temp) {
+                  gamma = alpha * ffric * vtnorm * update->dt;
+                  s1->gamma[ip1] += s1->vol0[ip1] * s1->mat->invcp * gamma;
+                  s2->gamma[ip2] += s2->vol0[ip2] * s2->mat->invcp * gamma;
+                }
 	      }
-	      s1->mbp[ip1] += f;
-	      s2->mbp[ip2] -= f;
-              ftot += f;
-              // if ((s1->ptag[ip1] == 12862 && s2->ptag[ip2] == 12902) ||
-              //     (s1->ptag[ip1] == 12835 && s2->ptag[ip2] == 12875)) {
-	      // cout << "dx[" << s1->ptag[ip1] << "," << s2->ptag[ip2] << "]= ["
-	      // 	   << dx[0] << "\t" << dx[1] << "\t" << dx[2] << "]\n";
-	      // cout << "(v2 - v1)[" << s1->ptag[ip1] << "," << s2->ptag[ip2] << "]= ["
-	      // 	   << dv[0] << "\t" << dv[1] << "\t" << dv[2] << "]\n";
-	      // cout << "f1[" << s1->ptag[ip1] << "," << s2->ptag[ip2] << "]= ["
-	      // 	   << f[0] << "\t" << f[1] << "\t" << f[2] << "]\n";
-	      // cout << "fmag = " << fmag << endl;
-              // }
-            }
+	    }
+	    s1->mbp[ip1] += f;
+	    s2->mbp[ip2] -= f;
+            ftot += f;
           }
         }
       }
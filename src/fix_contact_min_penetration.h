@@ -20,6 +20,7 @@ FixStyle(contact/minimize_penetration, FixContactMinPenetration)
 #ifndef MPM_FIX_CONTACT_MIN_PENETRATION_H
 #define MPM_FIX_CONTACT_MIN_PENETRATION_H
 
+#include "contact_neighbours.h"
 #include "fix.h"
 #include "var.h"
 #include <vector>
@@ -47,6 +48,7 @@ private:
   string usage = "Usage: fix(fix-ID, contact/minimize_penetration, solid1, solid2, mu)\n";
   int Nargs = 5;
   int solid1, solid2;
+  ContactNeighbours neigh;  // Candidate pairs of particles in contact
   double mu;    // Friction coefficient
 };
 
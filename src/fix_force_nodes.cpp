@@ -75,6 +75,10 @@ FixForceNodes::FixForceNodes(MPM *mpm, vector<string> args) : Fix(mpm, args)
     zvalue = input->parsev(args[5]);
     zset = true;
   }
+
+  if (xset) xexpr.compile(mpm, xvalue);
+  if (yset) yexpr.compile(mpm, yvalue);
+  if (zset) zexpr.compile(mpm, zvalue);
 }
 
 FixForceNodes::~FixForceNodes()
@@ -98,92 +102,38 @@ void FixForceNodes::setmask() {
 void FixForceNodes::post_particles_to_grid() {
   // cout << "In FixForceNodes::post_particles_to_grid()\n";
 
-  // Go through all the nodes in the group and set b to the right value:
-  double fx, fy, fz;
-
-  if (xset) {
-    fx = xvalue.result(mpm);
-    // cout << "Set v_update[0] to " << xvalue.eq() << "=" << fx << endl;
-  }
-
-  if (yset) {
-    fy = yvalue.result(mpm);
-    // cout << "Set v_update[1] to " << "=" <<  fy << endl;
-  }
-
-  if (zset) {
-    fz = zvalue.result(mpm);
-    // cout << "Set v_update[2] to " << "=" <<  fz << endl;
-  }
-    
+  // Go through the active nodes in the group (those near particles) and set b to the right value:
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Grid *g;
 
-  int n = 0;
+  bool set[3] = {xset, yset, zset};
+  Expression *expr[3] = {&xexpr, &yexpr, &zexpr};
+
   Eigen::Vector3d ftot, ftot_reduced;
   ftot.setZero();
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
-      n = 0;
-
-      for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-	if (g->mass[in] > 0) {
-	  if (g->mask[in] & groupbit) {
-	    n++;
-	  }
-	}
-      }
-	    
-      for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-	if (g->mass[in] > 0) {
-	  if (g->mask[in] & groupbit) {
-	    if (xset) {
-	      g->mb[in][0] += fx/((double) n);
-	      if(in < g->nnodes_local) ftot[0] += fx/((double) n);
-	    }
-	    if (yset) {
-	      g->mb[in][1] += fy/((double) n);
-	      if(in < g->nnodes_local) ftot[1] += fy/((double) n);
-	    }
-	    if (zset) {
-	      g->mb[in][2] += fz/((double) n);
-	      if(in < g->nnodes_local) ftot[2] += fz/((double) n);
-	    }
-	  }
-	}
-      }
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    g = domain->solids[solid == -1 ? isolid : solid]->grid;
+
+    ilist.clear();
+    for (int in: g->active_nodes) {
+      if (g->mass[in] > 0 && (g->mask[in] & groupbit)) ilist.push_back(in);
     }
-  } else {
 
-    g = domain->solids[solid]->grid;
-    n = 0;
+    // The force is shared equally between the n nodes of the group:
+    int n = ilist.size();
+    values.resize(n);
 
-    for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-      if (g->mass[in] > 0) {
-	if (g->mask[in] & groupbit) {
-	  n++;
-	}
-      }
-    }
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
 
-    for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-      if (g->mass[in] > 0) {
-	if (g->mask[in] & groupbit) {
-	  if (xset) {
-	    g->mb[in][0] += fx/((double) n);
-	    if(in < g->nnodes_local) ftot[0] += fx/((double) n);
-	  }
-	  if (yset) {
-	    g->mb[in][1] += fy/((double) n);
-	    if(in < g->nnodes_local) ftot[1] += fy/((double) n);
-	  }
-	  if (zset) {
-	    g->mb[in][2] += fz/((double) n);
-	    if(in < g->nnodes_local) ftot[2] += fz/((double) n);
-	  }
-	}
+      expr[dim]->evaluate(n, ilist.data(), &g->x, &g->x0, values.data());
+
+      for (int i = 0; i < n; i++) {
+	int in = ilist[i];
+	g->mb[in][dim] += values[i]/((double) n);
+	if(in < g->nnodes_local) ftot[dim] += values[i]/((double) n);
       }
     }
   }
@@ -286,4 +236,8 @@ void FixForceNodes::read_restart(ifstream *ifr) {
     ifr->read(reinterpret_cast<char *>(&cst), sizeof(bool));
     zvalue = Var(eq, value, cst);
   }
+
+  if (xset) xexpr.compile(mpm, xvalue);
+  if (yset) yexpr.compile(mpm, yvalue);
+  if (zset) zexpr.compile(mpm, zvalue);
 }
@@ -14,6 +14,7 @@
 #include "fix_initial_stress.h"
 #include "domain.h"
 #include "error.h"
+#include "expression.h"
 #include "group.h"
 #include "input.h"
 #include "solid.h"
@@ -108,55 +109,35 @@ void FixInitialStress::initial_integrate() {
   else
     tl = false;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      s = domain->solids[isolid];
-
-      for (int ip = 0; ip < s->np_local; ip++) {
-	if (s->mask[ip] & groupbit) {
-	  (*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	  (*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	  (*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-	  (*input->vars)["x"] = Var("x", s->x[ip][0]);
-	  (*input->vars)["y"] = Var("y", s->x[ip][1]);
-	  (*input->vars)["z"] = Var("z", s->x[ip][2]);
-	  
-	  if (s_set[0])  s->sigma[ip](0,0) = s_value[0].result(mpm);
-	  if (s_set[1])  s->sigma[ip](1,1) = s_value[1].result(mpm);
-	  if (s_set[2])  s->sigma[ip](2,2) = s_value[2].result(mpm);
-	  if (s_set[3])  s->sigma[ip](1,2) = s->sigma[ip](2,1) = s_value[3].result(mpm);
-	  if (s_set[4])  s->sigma[ip](0,2) = s->sigma[ip](2,0) = s_value[4].result(mpm);
-	  if (s_set[5])  s->sigma[ip](0,1) = s->sigma[ip](1,0) = s_value[5].result(mpm);
-
-	  if (tl) {
-	    s->vol0PK1[ip] = s->vol0[ip] * s->sigma[ip];
-	  }
-	}
-      }
-    }
-  } else {
-    s = domain->solids[solid];
+  // Voigt index to matrix indices:
+  const int row[6] = {0, 1, 2, 1, 0, 0};
+  const int col[6] = {0, 1, 2, 2, 2, 1};
+
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
+
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    s = domain->solids[solid == -1 ? isolid : solid];
 
+    ilist.clear();
     for (int ip = 0; ip < s->np_local; ip++) {
-      if (s->mask[ip] & groupbit) {
-	(*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	(*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	(*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-	(*input->vars)["x"] = Var("x", s->x[ip][0]);
-	(*input->vars)["y"] = Var("y", s->x[ip][1]);
-	(*input->vars)["z"] = Var("z", s->x[ip][2]);
-	  
-	if (s_set[0])  s->sigma[ip](0,0) = s_value[0].result(mpm);
-	if (s_set[1])  s->sigma[ip](1,1) = s_value[1].result(mpm);
-	if (s_set[2])  s->sigma[ip](2,2) = s_value[2].result(mpm);
-	if (s_set[3])  s->sigma[ip](1,2) = s->sigma[ip](2,1) = s_value[3].result(mpm);
-	if (s_set[4])  s->sigma[ip](0,2) = s->sigma[ip](2,0) = s_value[4].result(mpm);
-	if (s_set[5])  s->sigma[ip](0,1) = s->sigma[ip](1,0) = s_value[5].result(mpm);
-
-	if (tl) {
-	  s->vol0PK1[ip] = s->vol0[ip] * s->sigma[ip];
-	}
-      }
+      if (s->mask[ip] & groupbit) ilist.push_back(ip);
+    }
+
+    int n = ilist.size();
+    values.resize(n);
+
+    for (int j = 0; j < 6; j++) {
+      if (!s_set[j]) continue;
+
+      Expression(mpm, s_value[j]).evaluate(n, ilist.data(), &s->x, &s->x0, values.data());
+
+      for (int i = 0; i < n; i++)
+	s->sigma[ilist[i]](row[j], col[j]) = s->sigma[ilist[i]](col[j], row[j]) = values[i];
+    }
+
+    if (tl) {
+      for (int i = 0; i < n; i++)
+	s->vol0PK1[ilist[i]] = s->vol0[ilist[i]] * s->sigma[ilist[i]].matrix();
     }
   }
 }
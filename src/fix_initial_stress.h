@@ -49,6 +49,9 @@ private:
 
   class Var s_value[6];
   bool s_set[6];
+
+  vector<int> ilist;                   // Particles of the group, work array
+  vector<double> values;               // Values of a stress component at these particles, work array
 };
 
 #endif
@@ -14,6 +14,7 @@
 #include "fix_initial_velocity_nodes.h"
 #include "domain.h"
 #include "error.h"
+#include "expression.h"
 #include "grid.h"
 #include "group.h"
 #include "input.h"
@@ -107,120 +108,47 @@ void FixInitialVelocityNodes::post_update_grid_state() {
   if (update->ntimestep !=1) return;
   // cout << "In FixInitialVelocityNodes::post_update_grid_state()" << endl;
 
-  // Go through all the nodes in the group and set v_update to the right value:
-  double vx, vy, vz;
-  
-  int solid = group->solid[igroup];
-  Grid *g;
-
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
-
-      for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-	if (g->mask[in] & groupbit) {
-	  (*input->vars)["x0"] = Var("x0", g->x0[in][0]);
-	  (*input->vars)["y0"] = Var("y0", g->x0[in][1]);
-	  (*input->vars)["z0"] = Var("z0", g->x0[in][2]);
-	  if (xset) {
-	    vx = xvalue.result(mpm);
-	    g->v_update[in][0] = vx;
-	  }
-	  if (yset) {
-	    vy = yvalue.result(mpm);
-	    g->v_update[in][1] = vy;
-	  }
-	  if (zset) {
-	    vz = zvalue.result(mpm);
-	    g->v_update[in][2] = vz;
-	  }
-	}
-      }
-      // cout << "g->v_update for " << n << " nodes from solid " << domain->solids[isolid]->id << " set." << endl;
-    }
-  } else {
-    g = domain->solids[solid]->grid;
-
-    for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-      if (g->mask[in] & groupbit) {
-	(*input->vars)["x0"] = Var("x0", g->x0[in][0]);
-	(*input->vars)["y0"] = Var("y0", g->x0[in][1]);
-	(*input->vars)["z0"] = Var("z0", g->x0[in][2]);
-	if (xset) {
-	  vx = xvalue.result(mpm);
-	  g->v_update[in][0] = vx;
-	}
-	if (yset) {
-	  vy = yvalue.result(mpm);
-	  g->v_update[in][1] = vy;
-	}
-	if (zset) {
-	  vz = zvalue.result(mpm);
-	  g->v_update[in][2] = vz;
-	}
-      }
-    }
-    // cout << "g->v_update for " << n << " nodes from solid " << domain->solids[solid]->id << " set." << endl;
-  }
+  set_velocity(true);
 }
 
 void FixInitialVelocityNodes::post_velocities_to_grid() {
   if (update->ntimestep !=1) return;
   // cout << "In FixInitialVelocityNodes::post_velocities_to_grid()" << endl;
 
-  // Go through all the particles in the group and set v to the right value:
-  double vx, vy, vz;
-  
+  set_velocity(false);
+}
+
+/*! Go through the active nodes in the group (see Grid::active_nodes) and set v_update
+ * (if update_velocity is true) or v (if false) to the right value:
+ */
+void FixInitialVelocityNodes::set_velocity(bool update_velocity) {
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Grid *g;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
-
-      for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-	if (g->mask[in] & groupbit) {
-	  (*input->vars)["x0"] = Var("x0", g->x0[in][0]);
-	  (*input->vars)["y0"] = Var("y0", g->x0[in][1]);
-	  (*input->vars)["z0"] = Var("z0", g->x0[in][2]);
-	  if (xset) {
-	    vx = xvalue.result(mpm);
-	    g->v[in][0] = vx;
-	  }
-	  if (yset) {
-	    vy = yvalue.result(mpm);
-	    g->v[in][1] = vy;
-	  }
-	  if (zset) {
-	    vz = zvalue.result(mpm);
-	    g->v[in][2] = vz;
-	  }
-	}
-      }
-      // cout << "v for " << n << " nodes from solid " << domain->solids[isolid]->id << " set." << endl;
+  Expression expr[3];
+  bool set[3] = {xset, yset, zset};
+  if (xset) expr[0].compile(mpm, xvalue);
+  if (yset) expr[1].compile(mpm, yvalue);
+  if (zset) expr[2].compile(mpm, zvalue);
+
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    g = domain->solids[solid == -1 ? isolid : solid]->grid;
+    vector<Vector3d> &v = update_velocity ? g->v_update : g->v;
+
+    ilist.clear();
+    for (int in: g->active_nodes) {
+      if (g->mask[in] & groupbit) ilist.push_back(in);
     }
-  } else {
-      g = domain->solids[solid]->grid;
-
-      for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
-	if (g->mask[in] & groupbit) {
-	(*input->vars)["x0"] = Var("x0", g->x0[in][0]);
-	(*input->vars)["y0"] = Var("y0", g->x0[in][1]);
-	(*input->vars)["z0"] = Var("z0", g->x0[in][2]);
-	if (xset) {
-	  vx = xvalue.result(mpm);
-	  g->v[in][0] = vx;
-	}
-	if (yset) {
-	  vy = yvalue.result(mpm);
-	  g->v[in][1] = vy;
-	}
-	if (zset) {
-	  vz = zvalue.result(mpm);
-	  g->v[in][2] = vz;
-	}
-      }
+
+    int n = ilist.size();
+    values.resize(n);
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
+
+      expr[dim].evaluate(n, ilist.data(), &g->x, &g->x0, values.data());
+      for (int i = 0; i < n; i++) v[ilist[i]][dim] = values[i];
     }
-    // cout << "v for " << n << " nodes from solid " << domain->solids[solid]->id << " set." << endl;
   }
 }
@@ -46,6 +46,11 @@ class FixInitialVelocityNodes : public Fix {
 private:
   class Var xvalue, yvalue, zvalue;    // Set velocities in x, y, and z directions.
   bool xset, yset, zset;               // Does the fix set the x, y, and z velocities of the group?
+
+  vector<int> ilist;                   // Nodes of the group, work array
+  vector<double> values;               // Values of the velocity at these nodes, work array
+
+  void set_velocity(bool);
 };
 
 #endif
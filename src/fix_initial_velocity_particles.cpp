@@ -14,6 +14,7 @@
 #include "fix_initial_velocity_particles.h"
 #include "domain.h"
 #include "error.h"
+#include "expression.h"
 #include "group.h"
 #include "input.h"
 #include "solid.h"
@@ -101,63 +102,38 @@ void FixInitialVelocityParticles::initial_integrate() {
   // cout << "In FixInitialVelocityParticles::initial_integrate()" << endl;
 
   // Go through all the particles in the group and set v to the right value:
-  double vx, vy, vz;
-  
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
+
+  Expression xexpr, yexpr, zexpr;
+  if (xset) xexpr.compile(mpm, xvalue);
+  if (yset) yexpr.compile(mpm, yvalue);
+  if (zset) zexpr.compile(mpm, zvalue);
 
   Solid *s;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      s = domain->solids[isolid];
-
-      for (int ip = 0; ip < s->np_local; ip++) {
-	if (s->mask[ip] & groupbit) {
-	  (*input->vars)["x"] = Var("x", s->x[ip][0]);
-	  (*input->vars)["y"] = Var("y", s->x[ip][1]);
-	  (*input->vars)["z"] = Var("z", s->x[ip][2]);
-	  (*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	  (*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	  (*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-	  if (xset) {
-	    vx = xvalue.result(mpm);
-	    s->v[ip][0] = vx;
-	  }
-	  if (yset) {
-	    vy = yvalue.result(mpm);
-	    s->v[ip][1] = vy;
-	  }
-	  if (zset) {
-	    vz = zvalue.result(mpm);
-	    s->v[ip][2] = vz;
-	  }
-	}
-      }
-    }
-  } else {
-    s = domain->solids[solid];
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    s = domain->solids[solid == -1 ? isolid : solid];
 
+    ilist.clear();
     for (int ip = 0; ip < s->np_local; ip++) {
-      if (s->mask[ip] & groupbit) {
-	(*input->vars)["x"] = Var("x", s->x[ip][0]);
-	(*input->vars)["y"] = Var("y", s->x[ip][1]);
-	(*input->vars)["z"] = Var("z", s->x[ip][2]);
-	(*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	(*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	(*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-	if (xset) {
-	  vx = xvalue.result(mpm);
-	  s->v[ip][0] = vx;
-	}
-	if (yset) {
-	  vy = yvalue.result(mpm);
-	  s->v[ip][1] = vy;
-	}
-	if (zset) {
-	  vz = zvalue.result(mpm);
-	  s->v[ip][2] = vz;
-	}
-      }
+      if (s->mask[ip] & groupbit) ilist.push_back(ip);
+    }
+
+    int n = ilist.size();
+    values.resize(n);
+
+    if (xset) {
+      xexpr.evaluate(n, ilist.data(), &s->x, &s->x0, values.data());
+      for (int i = 0; i < n; i++) s->v[ilist[i]][0] = values[i];
+    }
+    if (yset) {
+      yexpr.evaluate(n, ilist.data(), &s->x, &s->x0, values.data());
+      for (int i = 0; i < n; i++) s->v[ilist[i]][1] = values[i];
+    }
+    if (zset) {
+      zexpr.evaluate(n, ilist.data(), &s->x, &s->x0, values.data());
+      for (int i = 0; i < n; i++) s->v[ilist[i]][2] = values[i];
     }
   }
 }
@@ -48,6 +48,9 @@ private:
   int Nargs = 6;
   class Var xvalue, yvalue, zvalue;    // Set velocities in x, y, and z directions.
   bool xset, yset, zset;               // Does the fix set the x, y, and z velocities of the group?
+
+  vector<int> ilist;                   // Particles of the group, work array
+  vector<double> values;               // Values of the velocity at these particles, work array
 };
 
 #endif
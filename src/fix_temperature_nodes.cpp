@@ -51,6 +51,9 @@ FixTemperatureNodes::FixTemperatureNodes(MPM *mpm, vector<string> args) : Fix(mp
   // Replace "time" by "time - dt" in the x argument:
   previous = SpecialFunc::replace_all(input->parsev(previous).str(), "time", "(time - dt)");
   Tprevvalue = input->parsev(previous);
+
+  Texpr.compile(mpm, Tvalue);
+  Tprevexpr.compile(mpm, Tprevvalue);
 }
 
 FixTemperatureNodes::~FixTemperatureNodes()
@@ -75,81 +78,55 @@ void FixTemperatureNodes::setmask() {
 void FixTemperatureNodes::post_update_grid_state() {
   // cout << "In FixTemperatureNodes::post_update_grid_state()" << endl;
 
-  // Go through all the nodes in the group and set v_update to the right value:
-  double T;
-  double T_old;
-
-  T = Tvalue.result(mpm);
-  T_old = Tprevvalue.result(mpm);
-
+  // Go through the active nodes in the group (see Grid::active_nodes) and set T_update to the right value:
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Grid *g;
 
-  double DT;
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    g = domain->solids[solid == -1 ? isolid : solid]->grid;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
-
-      for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-	if (g->mask[ip] & groupbit) {
-	  DT = 0;
-	  DT = T - g->T_update[ip];
-	  g->T_update[ip] = T;
-	  g->T[ip] = T_old;
-	}
-      }
+    ilist.clear();
+    for (int ip: g->active_nodes) {
+      if (g->mask[ip] & groupbit) ilist.push_back(ip);
     }
-  } else {
 
-    g = domain->solids[solid]->grid;
+    int n = ilist.size();
+    values.resize(n);
+    prevvalues.resize(n);
+
+    Texpr.evaluate(n, ilist.data(), &g->x, &g->x0, values.data());
+    Tprevexpr.evaluate(n, ilist.data(), &g->x, &g->x0, prevvalues.data());
 
-    for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-      if (g->mask[ip] & groupbit) {
-	DT = 0;
-	DT = T - g->T_update[ip];
-	g->T_update[ip] = T;
-	g->T[ip] = T_old;
-      }
+    for (int i = 0; i < n; i++) {
+      g->T_update[ilist[i]] = values[i];
+      g->T[ilist[i]] = prevvalues[i];
     }
   }
-
-  // // Reduce ftot:
-  // MPI_Allreduce(ftot.data(), ftot_reduced.data(), 3, MPI_DOUBLE, MPI_SUM,
-  //               universe->uworld);
-
-  // (*input->vars)[id + "_x"] = Var(id + "_x", ftot_reduced[0]);
-  // (*input->vars)[id + "_y"] = Var(id + "_y", ftot_reduced[1]);
-  // (*input->vars)[id + "_z"] = Var(id + "_z", ftot_reduced[2]);
 }
 
 void FixTemperatureNodes::post_velocities_to_grid() {
   // cout << "In FixTemperatureNodes::post_velocities_to_grid()" << endl;
 
-  // Go through all the particles in the group and set v to the right value:
-  double T = input->parsev(args[3]).result(mpm);
-
+  // Go through the active nodes in the group and set T to the right value:
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Grid *g;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    g = domain->solids[solid == -1 ? isolid : solid]->grid;
 
-      for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-	if (g->mask[ip] & groupbit) {
-	  g->T[ip] = T;
-	}
-      }
+    ilist.clear();
+    for (int ip: g->active_nodes) {
+      if (g->mask[ip] & groupbit) ilist.push_back(ip);
     }
-  } else {
-    g = domain->solids[solid]->grid;
 
-    for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-      if (g->mask[ip] & groupbit) {
-	g->T[ip] = T;
-      }
-    }
+    int n = ilist.size();
+    values.resize(n);
+
+    Texpr.evaluate(n, ilist.data(), &g->x, &g->x0, values.data());
+
+    for (int i = 0; i < n; i++) g->T[ilist[i]] = values[i];
   }
 }
 
@@ -161,4 +138,7 @@ void FixTemperatureNodes::write_restart(ofstream *of) {
 void FixTemperatureNodes::read_restart(ifstream *ifr) {
   Tvalue.read_from_restart(ifr);
   Tprevvalue.read_from_restart(ifr);
+
+  Texpr.compile(mpm, Tvalue);
+  Tprevexpr.compile(mpm, Tprevvalue);
 }
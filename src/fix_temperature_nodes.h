@@ -20,6 +20,7 @@ FixStyle(temperature_nodes,FixTemperatureNodes)
 #ifndef MPM_FIX_TEMPERATURE_NODES_H
 #define MPM_FIX_TEMPERATURE_NODES_H
 
+#include "expression.h"
 #include "fix.h"
 #include "var.h"
 #include <vector>
@@ -49,6 +50,9 @@ private:
 
   class Var Tvalue;                      //< Temperature variable.
   class Var Tprevvalue;                  //< Temperature variable from previous time step.
+  class Expression Texpr, Tprevexpr;     //< Compiled forms of Tvalue and Tprevvalue.
+  vector<int> ilist;                     //< Nodes of the group, work array.
+  vector<double> values, prevvalues;     //< Temperatures of these nodes, work arrays.
 };
 
 #endif
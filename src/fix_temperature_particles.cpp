@@ -72,6 +72,9 @@ FixTemperatureParticles::FixTemperatureParticles(MPM *mpm, vector<string> args)
   // Replace "time" by "time - dt" in the x argument:
   previous = SpecialFunc::replace_all(input->parsev(previous).str(), "time", "(time - dt)");
   Tprevvalue = input->parsev(previous);
+
+  Texpr.compile(mpm, Tvalue);
+  Tprevexpr.compile(mpm, Tprevvalue);
 }
 
 FixTemperatureParticles::~FixTemperatureParticles()
@@ -80,6 +83,15 @@ FixTemperatureParticles::~FixTemperatureParticles()
 
 void FixTemperatureParticles::init()
 {
+  int solid = group->solid[igroup];
+
+  for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
+    if (solid != -1 && isolid != solid) continue;
+
+    if (!domain->solids[isolid]->has_field("T"))
+      error->all(FLERR, "Error: fix_temperature_particles " + id + " needs the temperature of the particles of solid "
+		 + domain->solids[isolid]->id + ", which is only allocated by thermal methods or materials with a heat capacity.\n");
+  }
 }
 
 void FixTemperatureParticles::setup()
@@ -94,113 +106,34 @@ void FixTemperatureParticles::setmask() {
 
 
 void FixTemperatureParticles::initial_integrate() {
-  // Go through all the particles in the group and set v_update to the right value:
-  int solid = group->solid[igroup];
-  Solid *s;
-
-  int n = 0;
-
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      s = domain->solids[isolid];
-      n = 0;
-
-      for (int ip = 0; ip < s->np_local; ip++) {
-	if (s->mask[ip] & groupbit) {
-	  (*input->vars)["x"] = Var("x", s->x[ip][0]);
-	  (*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	  (*input->vars)["y"] = Var("y", s->x[ip][1]);
-	  (*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	  (*input->vars)["z"] = Var("z", s->x[ip][2]);
-	  (*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-	  //s->T_update[ip] = Tvalue.result(mpm);
-	  s->T[ip] = Tprevvalue.result(mpm);
-	  n++;
-	}
-      }
-      // cout << "v_update for " << n << " particles from solid " << domain->solids[isolid]->id << " set." << endl;
-    }
-  } else {
-    s = domain->solids[solid];
-
-    for (int ip = 0; ip < s->np_local; ip++) {
-      if (s->mask[ip] & groupbit) {
-	(*input->vars)["x"] = Var("x", s->x[ip][0]);
-	(*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	(*input->vars)["y"] = Var("y", s->x[ip][1]);
-	(*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	(*input->vars)["z"] = Var("z", s->x[ip][2]);
-	(*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-
-	//s->T_update[ip] = Tvalue.result(mpm);
-	s->T[ip] = Tprevvalue.result(mpm);
-	n++;
-      }
-    }
-    // cout << "v_update for " << n << " particles from solid " << domain->solids[solid]->id << " set." << endl;
-  }
+  set_temperature(Tprevexpr);
 }
 
 void FixTemperatureParticles::post_advance_particles() {
-  // Go through all the particles in the group and set v to the right value:
+  set_temperature(Texpr);
+}
+
+/*! Go through all the particles in the group and set T to the value of the expression:
+ */
+void FixTemperatureParticles::set_temperature(Expression &expr) {
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Solid *s;
-  // Eigen::Vector3d ftot, ftot_reduced;
-
-  int n = 0;
-  //ftot.setZero();
-  double inv_dt = 1.0/update->dt;
-
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      s = domain->solids[isolid];
-      n = 0;
-
-      for (int ip = 0; ip < s->np_local; ip++) {
-        if (s->mask[ip] & groupbit) {
-	  (*input->vars)["x"] = Var("x", s->x[ip][0]);
-	  (*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	  (*input->vars)["y"] = Var("y", s->x[ip][1]);
-	  (*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	  (*input->vars)["z"] = Var("z", s->x[ip][2]);
-	  (*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-	  s->T[ip] = Tvalue.result(mpm);
-          n++;
-        }
-      }
-      // cout << "v for " << n << " particles from solid " <<
-      // domain->solids[isolid]->id << " set." << endl;
-    }
-  } else {
-    s = domain->solids[solid];
-    n = 0;
+
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    s = domain->solids[solid == -1 ? isolid : solid];
+
+    ilist.clear();
     for (int ip = 0; ip < s->np_local; ip++) {
-      if (s->mask[ip] & groupbit) {
-	(*input->vars)["x"] = Var("x", s->x[ip][0]);
-	(*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	(*input->vars)["y"] = Var("y", s->x[ip][1]);
-	(*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	(*input->vars)["z"] = Var("z", s->x[ip][2]);
-	(*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-	s->T[ip] = Tvalue.result(mpm);
-        n++;
-      }
+      if (s->mask[ip] & groupbit) ilist.push_back(ip);
     }
-    // cout << "v for " << n << " particles from solid " <<
-    // domain->solids[solid]->id << " set." << endl;
-  }
 
-  // Reduce ftot:
-  //MPI_Allreduce(ftot.data(), ftot_reduced.data(), 3, MPI_DOUBLE, MPI_SUM,
-  //              universe->uworld);
+    int n = ilist.size();
+    values.resize(n);
+    expr.evaluate(n, ilist.data(), &s->x, &s->x0, values.data());
 
-  // (*input->vars)[id + "_x"] = Var(id + "_x", ftot_reduced[0]);
-  // (*input->vars)[id + "_y"] = Var(id + "_y", ftot_reduced[1]);
-  // (*input->vars)[id + "_z"] = Var(id + "_z", ftot_reduced[2]);
+    for (int i = 0; i < n; i++) s->T[ilist[i]] = values[i];
+  }
 }
 
 void FixTemperatureParticles::write_restart(ofstream *of) {
@@ -211,4 +144,7 @@ void FixTemperatureParticles::write_restart(ofstream *of) {
 void FixTemperatureParticles::read_restart(ifstream *ifr) {
   Tvalue.read_from_restart(ifr);
   Tprevvalue.read_from_restart(ifr);
+
+  Texpr.compile(mpm, Tvalue);
+  Tprevexpr.compile(mpm, Tprevvalue);
 }
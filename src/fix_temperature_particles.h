@@ -9,6 +9,7 @@ FixStyle(temperature_particles,FixTemperatureParticles)
 #ifndef MPM_FIX_TEMPERATURE_PARTICLES_H
 #define MPM_FIX_TEMPERATURE_PARTICLES_H
 
+#include "expression.h"
 #include "fix.h"
 #include "var.h"
 #include <Eigen/Eigen>
@@ -39,6 +40,11 @@ private:
 
   class Var Tvalue;                      //< Temperature variable.
   class Var Tprevvalue;                  //< Temperature variable from previous time step.
+  class Expression Texpr, Tprevexpr;     //< Compiled forms of Tvalue and Tprevvalue.
+  vector<int> ilist;                     //< Particles of the group, work array.
+  vector<double> values;                 //< Temperatures of these particles, work array.
+
+  void set_temperature(class Expression &);
 };
 
 #endif
@@ -75,6 +75,9 @@ FixVelocityNodes::FixVelocityNodes(MPM *mpm, vector<string> args) : Fix(mpm, arg
       previous.replace(previous.find(time),time.length(),"time - dt");
     }
     xprevvalue = input->parsev(previous);
+
+    xexpr.compile(mpm, xvalue);
+    xprevexpr.compile(mpm, xprevvalue);
   }
 
   if (domain->dimension >= 2) {
@@ -89,6 +92,9 @@ FixVelocityNodes::FixVelocityNodes(MPM *mpm, vector<string> args) : Fix(mpm, arg
 	previous.replace(previous.find(time),time.length(),"time - dt");
       }
       yprevvalue = input->parsev(previous);
+
+      yexpr.compile(mpm, yvalue);
+      yprevexpr.compile(mpm, yprevvalue);
     }
   }
 
@@ -104,6 +110,9 @@ FixVelocityNodes::FixVelocityNodes(MPM *mpm, vector<string> args) : Fix(mpm, arg
 	previous.replace(previous.find(time),time.length(),"time - dt");
       }
       zprevvalue = input->parsev(previous);
+
+      zexpr.compile(mpm, zvalue);
+      zprevexpr.compile(mpm, zprevvalue);
     }
   }
 }
@@ -130,87 +139,42 @@ void FixVelocityNodes::setmask() {
 void FixVelocityNodes::post_update_grid_state() {
   // cout << "In FixVelocityNodes::post_update_grid_state()" << endl;
 
-  // Go through all the nodes in the group and set v_update to the right value:
-  double vx, vy, vz;
-  double vx_old, vy_old, vz_old;
-
-  if (xset) {
-    vx = xvalue.result(mpm);
-    vx_old = xprevvalue.result(mpm);
-    // cout << "Set v_update[0] to " << xvalue.eq() << "=" << vx << endl;
-    // cout << "Set v[0] to " << vx_old << endl;
-  }
-
-  if (yset) {
-    vy = yvalue.result(mpm);
-    vy_old = yprevvalue.result(mpm);
-    // cout << "Set v_update[1] to " << "=" <<  vy << endl;
-    // cout << "Set v[1] to " << "=" <<  vy_old << endl;
-  }
-
-  if (zset) {
-    vz = zvalue.result(mpm);
-    vz_old = zprevvalue.result(mpm);
-    // cout << "Set v_update[2] to " << "=" <<  vz << endl;
-    // cout << "Set v[2] to " << "=" <<  vz_old << endl;
-  }
-
+  // Go through the active nodes in the group (see Grid::active_nodes) and set v_update to the right value:
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Grid *g;
 
-  Eigen::Vector3d Dv, ftot, ftot_reduced;
+  bool set[3] = {xset, yset, zset};
+  Expression *expr[3] = {&xexpr, &yexpr, &zexpr};
+  Expression *prevexpr[3] = {&xprevexpr, &yprevexpr, &zprevexpr};
+
+  Eigen::Vector3d ftot, ftot_reduced;
   ftot.setZero();
   double inv_dt = 1.0/update->dt;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
-
-      for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-	if (g->mask[ip] & groupbit) {
-	  Dv.setZero();
-	  if (xset) {
-	    Dv[0] = vx - g->v_update[ip][0];
-	    g->v_update[ip][0] = vx;
-	    g->v[ip][0] = vx_old;
-	  }
-	  if (yset) {
-	    Dv[1] = vy - g->v_update[ip][1];
-	    g->v_update[ip][1] = vy;
-	    g->v[ip][1] = vy_old;
-	  }
-	  if (zset) {
-	    Dv[2] = vz - g->v_update[ip][2];
-	    g->v_update[ip][2] = vz;
-	    g->v[ip][2] = vz_old;
-	  }
-          ftot += (inv_dt * g->mass[ip]) * Dv;
-	}
-      }
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    g = domain->solids[solid == -1 ? isolid : solid]->grid;
+
+    ilist.clear();
+    for (int ip: g->active_nodes) {
+      if (g->mask[ip] & groupbit) ilist.push_back(ip);
     }
-  } else {
-
-    g = domain->solids[solid]->grid;
-
-    for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-      if (g->mask[ip] & groupbit) {
-	Dv.setZero();
-	if (xset) {
-	  Dv[0] = vx - g->v_update[ip][0];
-	  g->v_update[ip][0] = vx;
-	  g->v[ip][0] = vx_old;
-	}
-	if (yset) {
-	  Dv[1] = vy - g->v_update[ip][1];
-	  g->v_update[ip][1] = vy;
-	  g->v[ip][1] = vy_old;
-	}
-	if (zset) {
-	  Dv[2] = vz - g->v_update[ip][2];
-	  g->v_update[ip][2] = vz;
-	  g->v[ip][2] = vz_old;
-	}
-	ftot += (inv_dt * g->mass[ip]) * Dv;
+
+    int n = ilist.size();
+    values.resize(n);
+    prevvalues.resize(n);
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
+
+      expr[dim]->evaluate(n, ilist.data(), &g->x, &g->x0, values.data());
+      prevexpr[dim]->evaluate(n, ilist.data(), &g->x, &g->x0, prevvalues.data());
+
+      for (int i = 0; i < n; i++) {
+	int ip = ilist[i];
+	ftot[dim] += inv_dt * g->mass[ip] * (values[i] - g->v_update[ip][dim]);
+	g->v_update[ip][dim] = values[i];
+	g->v[ip][dim] = prevvalues[i];
       }
     }
   }
@@ -227,45 +191,30 @@ void FixVelocityNodes::post_update_grid_state() {
 void FixVelocityNodes::post_velocities_to_grid() {
   // cout << "In FixVelocityNodes::post_velocities_to_grid()" << endl;
 
-  // Go through all the particles in the group and set v to the right value:
-  double vx, vy, vz;
-
-  if (xset) {
-    vx = xvalue.result(mpm);
-  }
-
-  if (yset) {
-    vy = yvalue.result(mpm);
-  }
-
-  if (zset) {
-    vz = zvalue.result(mpm);
-  }
-  
+  // Go through the active nodes in the group and set v to the right value:
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Grid *g;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      g = domain->solids[isolid]->grid;
+  bool set[3] = {xset, yset, zset};
+  Expression *expr[3] = {&xexpr, &yexpr, &zexpr};
 
-      for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-	if (g->mask[ip] & groupbit) {
-	  if (xset) g->v[ip][0] = vx;
-	  if (yset) g->v[ip][1] = vy;
-	  if (zset) g->v[ip][2] = vz;
-	}
-      }
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    g = domain->solids[solid == -1 ? isolid : solid]->grid;
+
+    ilist.clear();
+    for (int ip: g->active_nodes) {
+      if (g->mask[ip] & groupbit) ilist.push_back(ip);
     }
-  } else {
-    g = domain->solids[solid]->grid;
-
-    for (int ip = 0; ip < g->nnodes_local + g->nnodes_ghost; ip++) {
-      if (g->mask[ip] & groupbit) {
-	if (xset) g->v[ip][0] = vx;
-	if (yset) g->v[ip][1] = vy;
-	if (zset) g->v[ip][2] = vz;
-      }
+
+    int n = ilist.size();
+    values.resize(n);
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
+
+      expr[dim]->evaluate(n, ilist.data(), &g->x, &g->x0, values.data());
+      for (int i = 0; i < n; i++) g->v[ilist[i]][dim] = values[i];
     }
   }
 }
@@ -297,13 +246,19 @@ void FixVelocityNodes::read_restart(ifstream *ifr) {
   if (xset) {
     xvalue.read_from_restart(ifr);
     xprevvalue.read_from_restart(ifr);
+    xexpr.compile(mpm, xvalue);
+    xprevexpr.compile(mpm, xprevvalue);
   }
   if (yset) {
     yvalue.read_from_restart(ifr);
     yprevvalue.read_from_restart(ifr);
+    yexpr.compile(mpm, yvalue);
+    yprevexpr.compile(mpm, yprevvalue);
   }
   if (zset) {
     zvalue.read_from_restart(ifr);
     zprevvalue.read_from_restart(ifr);
+    zexpr.compile(mpm, zvalue);
+    zprevexpr.compile(mpm, zprevvalue);
   }
 }
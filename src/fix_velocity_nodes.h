@@ -20,6 +20,7 @@ FixStyle(velocity_nodes,FixVelocityNodes)
 #ifndef MPM_FIX_VELOCITY_NODES_H
 #define MPM_FIX_VELOCITY_NODES_H
 
+#include "expression.h"
 #include "fix.h"
 #include "var.h"
 #include <vector>
@@ -52,7 +53,12 @@ private:
 
   class Var xvalue, yvalue, zvalue;                  //< Velocities in x, y, and z directions.
   class Var xprevvalue, yprevvalue, zprevvalue;      //< Velocities in x, y, and z directions from previous time step.
+  class Expression xexpr, yexpr, zexpr;              //< Compiled forms of xvalue, yvalue, and zvalue.
+  class Expression xprevexpr, yprevexpr, zprevexpr;  //< Compiled forms of xprevvalue, yprevvalue, and zprevvalue.
   bool xset, yset, zset;                             //< Does the fix set the x, y, and z velocities of the group?
+
+  vector<int> ilist;                                 //< Nodes of the group, work array.
+  vector<double> values, prevvalues;                 //< Velocities of these nodes, work arrays.
 };
 
 #endif
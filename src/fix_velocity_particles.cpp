@@ -78,6 +78,9 @@ FixVelocityParticles::FixVelocityParticles(MPM *mpm, vector<string> args) : Fix(
     // Replace "time" by "time - dt" in the x argument:
     previous = SpecialFunc::replace_all(input->parsev(previous).str(), "time", "(time - dt)");
     xprevvalue = input->parsev(previous);
+
+    xexpr.compile(mpm, xvalue);
+    xprevexpr.compile(mpm, xprevvalue);
   }
 
   if (domain->dimension >= 2) {
@@ -90,6 +93,9 @@ FixVelocityParticles::FixVelocityParticles(MPM *mpm, vector<string> args) : Fix(
       // Replace "time" by "time - dt" in the y argument:
       previous = SpecialFunc::replace_all(input->parsev(previous).str(), "time", "(time - dt)");
       yprevvalue = input->parsev(previous);
+
+      yexpr.compile(mpm, yvalue);
+      yprevexpr.compile(mpm, yprevvalue);
     }
   }
 
@@ -103,6 +109,9 @@ FixVelocityParticles::FixVelocityParticles(MPM *mpm, vector<string> args) : Fix(
       // Replace "time" by "time - dt" in the z argument:
       previous = SpecialFunc::replace_all(input->parsev(previous).str(), "time", "(time - dt)");
       zprevvalue = input->parsev(previous);
+
+      zexpr.compile(mpm, zvalue);
+      zprevexpr.compile(mpm, zprevvalue);
     }
   }
 }
@@ -128,175 +137,83 @@ void FixVelocityParticles::setmask() {
 
 void FixVelocityParticles::initial_integrate() {
   // Go through all the particles in the group and set v_update to the right value:
-  Vector3d xtemp;
-
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Solid *s;
 
-  int n = 0;
-  xold.clear();
-
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      s = domain->solids[isolid];
-      n = 0;
-
-      for (int ip = 0; ip < s->np_local; ip++) {
-	if (s->mask[ip] & groupbit) {
-	  xtemp = s->x[ip];
-	  (*input->vars)["x"] = Var("x", s->x[ip][0]);
-	  (*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	  (*input->vars)["y"] = Var("y", s->x[ip][1]);
-	  (*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	  (*input->vars)["z"] = Var("z", s->x[ip][2]);
-	  (*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-	  if (xset) {
-	    s->v_update[ip][0] = xvalue.result(mpm);
-	    s->v[ip][0] = xprevvalue.result(mpm);
-	  }
-	  if (yset) {
-	    s->v_update[ip][1] = yvalue.result(mpm);
-	    s->v[ip][1] = yprevvalue.result(mpm);
-	  }
-	  if (zset) {
-	    s->v_update[ip][2] = zvalue.result(mpm);
-	    s->v[ip][2] = zprevvalue.result(mpm);
-	  }
-	  // if (s->ptag[ip] == 4371) {
-	  //   printf("fix: v=[%4.3e %4.3e %4.3e]\tv_update=[%4.3e %4.3e %4.3e]\ta=[%4.3e %4.3e %4.3e]\n", s->v[ip][0], s->v[ip][1], s->v[ip][2], s->v_update[ip][0], s->v_update[ip][1], s->v_update[ip][2], s->a[ip][0], s->a[ip][1], s->a[ip][2]);
-	  // }
-	  xold.push_back(xtemp);
-	  n++;
-	}
-      }
-      // cout << "v_update for " << n << " particles from solid " << domain->solids[isolid]->id << " set." << endl;
-    }
-  } else {
-    s = domain->solids[solid];
+  bool set[3] = {xset, yset, zset};
+  Expression *expr[3] = {&xexpr, &yexpr, &zexpr};
+  Expression *prevexpr[3] = {&xprevexpr, &yprevexpr, &zprevexpr};
+
+  xold.resize(nsolids);
+
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    s = domain->solids[solid == -1 ? isolid : solid];
+
+    ilist.clear();
+    xold[isolid].resize(s->np_local);
 
     for (int ip = 0; ip < s->np_local; ip++) {
       if (s->mask[ip] & groupbit) {
-	xtemp = s->x[ip];
-	(*input->vars)["x"] = Var("x", s->x[ip][0]);
-	(*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	(*input->vars)["y"] = Var("y", s->x[ip][1]);
-	(*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	(*input->vars)["z"] = Var("z", s->x[ip][2]);
-	(*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-	if (xset) {
-	  s->v_update[ip][0] = xvalue.result(mpm);
-	  s->v[ip][0] = xprevvalue.result(mpm);
-	}
-	if (yset) {
-	  s->v_update[ip][1] = yvalue.result(mpm);
-	  s->v[ip][1] = yprevvalue.result(mpm);
-	}
-	if (zset) {
-	  s->v_update[ip][2] = zvalue.result(mpm);
-	  s->v[ip][2] = zprevvalue.result(mpm);
-	}
-	// if (s->ptag[ip] == 4371) {
-	//   printf("fix: v=[%4.3e %4.3e %4.3e]\tv_update=[%4.3e %4.3e %4.3e]\ta=[%4.3e %4.3e %4.3e]\n", s->v[ip][0], s->v[ip][1], s->v[ip][2], s->v_update[ip][0], s->v_update[ip][1], s->v_update[ip][2], s->a[ip][0], s->a[ip][1], s->a[ip][2]);
-	// }
-	xold.push_back(xtemp);
-	n++;
+	ilist.push_back(ip);
+	xold[isolid][ip] = s->x[ip];
+      }
+    }
+
+    int n = ilist.size();
+    values.resize(n);
+    prevvalues.resize(n);
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
+
+      expr[dim]->evaluate(n, ilist.data(), &s->x, &s->x0, values.data());
+      prevexpr[dim]->evaluate(n, ilist.data(), &s->x, &s->x0, prevvalues.data());
+
+      for (int i = 0; i < n; i++) {
+	s->v_update[ilist[i]][dim] = values[i];
+	s->v[ilist[i]][dim] = prevvalues[i];
       }
     }
-    // cout << "v_update for " << n << " particles from solid " << domain->solids[solid]->id << " set." << endl;
   }
 }
 
 void FixVelocityParticles::post_advance_particles() {
   // Go through all the particles in the group and set v to the right value:
-  double vx, vy, vz;
-  
   int solid = group->solid[igroup];
+  int nsolids = solid == -1 ? domain->solids.size() : 1;
   Solid *s;
-  Eigen::Vector3d Dv, ftot, ftot_reduced;
+  Eigen::Vector3d ftot, ftot_reduced;
+
+  bool set[3] = {xset, yset, zset};
+  Expression *expr[3] = {&xexpr, &yexpr, &zexpr};
 
-  int n = 0;
   ftot.setZero();
   double inv_dt = 1.0/update->dt;
 
-  if (solid == -1) {
-    for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-      s = domain->solids[isolid];
-      n = 0;
-
-      for (int ip = 0; ip < s->np_local; ip++) {
-        if (s->mask[ip] & groupbit) {
-          Dv.setZero();
-	  (*input->vars)["x"] = Var("x", xold[n][0]);
-	  (*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	  (*input->vars)["y"] = Var("y", xold[n][1]);
-	  (*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	  (*input->vars)["z"] = Var("z", xold[n][2]);
-	  (*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-          if (xset) {
-            vx = xvalue.result(mpm);
-            Dv[0] = vx - s->v[ip][0];
-            s->v[ip][0] = vx;
-            s->x[ip][0] = xold[n][0] + update->dt * vx;
-          }
-          if (yset) {
-            vy = yvalue.result(mpm);
-            Dv[1] = vy - s->v[ip][1];
-            s->v[ip][1] = vy;
-            s->x[ip][1] = xold[n][1] + update->dt * vy;
-          }
-          if (zset) {
-            vz = zvalue.result(mpm);
-            Dv[2] = vz - s->v[ip][2];
-            s->v[ip][2] = vz;
-            s->x[ip][2] = xold[n][2] + update->dt * vz;
-          }
-          ftot += (inv_dt * s->mass[ip]) * Dv;
-          n++;
-        }
-      }
-      // cout << "v for " << n << " particles from solid " <<
-      // domain->solids[isolid]->id << " set." << endl;
-    }
-  } else {
-    s = domain->solids[solid];
-    n = 0;
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    s = domain->solids[solid == -1 ? isolid : solid];
+
+    ilist.clear();
     for (int ip = 0; ip < s->np_local; ip++) {
-      if (s->mask[ip] & groupbit) {
-        Dv.setZero();
-	(*input->vars)["x"] = Var("x", xold[n][0]);
-	(*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-	(*input->vars)["y"] = Var("y", xold[n][1]);
-	(*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-	(*input->vars)["z"] = Var("z", xold[n][2]);
-	(*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-        if (xset) {
-          vx = xvalue.result(mpm);
-          Dv[0] = vx - s->v[ip][0];
-          s->v[ip][0] = vx;
-          s->x[ip][0] = xold[n][0] + update->dt * vx;
-        }
-        if (yset) {
-          vy = yvalue.result(mpm);
-          Dv[1] = vy - s->v[ip][1];
-          s->v[ip][1] = vy;
-          s->x[ip][1] = xold[n][1] + update->dt * vy;
-        }
-        if (zset) {
-          vz = zvalue.result(mpm);
-          Dv[2] = vz - s->v[ip][2];
-          s->v[ip][2] = vz;
-          s->x[ip][2] = xold[n][2] + update->dt * vz;
-        }
-        ftot += (inv_dt * s->mass[ip]) * Dv;
-        n++;
+      if (s->mask[ip] & groupbit) ilist.push_back(ip);
+    }
+
+    int n = ilist.size();
+    values.resize(n);
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (!set[dim]) continue;
+
+      expr[dim]->evaluate(n, ilist.data(), &xold[isolid], &s->x0, values.data());
+
+      for (int i = 0; i < n; i++) {
+	int ip = ilist[i];
+	ftot[dim] += inv_dt * s->mass[ip] * (values[i] - s->v[ip][dim]);
+	s->v[ip][dim] = values[i];
+	s->x[ip][dim] = xold[isolid][ip][dim] + update->dt * values[i];
       }
     }
-    // cout << "v for " << n << " particles from solid " <<
-    // domain->solids[solid]->id << " set." << endl;
   }
 
   // Reduce ftot:
@@ -335,13 +252,19 @@ void FixVelocityParticles::read_restart(ifstream *ifr) {
   if (xset) {
     xvalue.read_from_restart(ifr);
     xprevvalue.read_from_restart(ifr);
+    xexpr.compile(mpm, xvalue);
+    xprevexpr.compile(mpm, xprevvalue);
   }
   if (yset) {
     yvalue.read_from_restart(ifr);
     yprevvalue.read_from_restart(ifr);
+    yexpr.compile(mpm, yvalue);
+    yprevexpr.compile(mpm, yprevvalue);
   }
   if (zset) {
     zvalue.read_from_restart(ifr);
     zprevvalue.read_from_restart(ifr);
+    zexpr.compile(mpm, zvalue);
+    zprevexpr.compile(mpm, zprevvalue);
   }
 }
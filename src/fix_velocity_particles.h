@@ -9,6 +9,7 @@ FixStyle(velocity_particles,FixVelocityParticles)
 #ifndef MPM_FIX_VELOCITY_PARTICLES_H
 #define MPM_FIX_VELOCITY_PARTICLES_H
 
+#include "expression.h"
 #include "fix.h"
 #include "var.h"
 #include <Eigen/Eigen>
@@ -42,9 +43,13 @@ private:
 
   class Var xvalue, yvalue, zvalue;                  //< Velocities in x, y, and z directions.
   class Var xprevvalue, yprevvalue, zprevvalue;      //< Velocities in x, y, and z directions from previous time step.
+  class Expression xexpr, yexpr, zexpr;              //< Compiled forms of xvalue, yvalue, and zvalue.
+  class Expression xprevexpr, yprevexpr, zprevexpr;  //< Compiled forms of xprevvalue, yprevvalue, and zprevvalue.
   bool xset, yset, zset;                             //< Does the fix set the x, y, and z velocities of the group?
 
-  vector<Eigen::Vector3d> xold;          // particles' old position
+  vector<ParticleVectors> xold;                      //< Position of the particles of the group at the beginning of the step, for each solid.
+  vector<int> ilist;                                 //< Particles of the group, work array.
+  vector<double> values, prevvalues;                 //< Velocities of these particles, work arrays.
 };
 
 #endif
@@ -0,0 +1,241 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "ghost_particles.h"
+#include "domain.h"
+#include "method.h"
+#include "solid.h"
+#include "universe.h"
+#include "update.h"
+#include <Eigen/Eigen>
+#include <limits>
+
+using namespace std;
+using namespace Eigen;
+
+#define FORWARD_N 9 // x, v, mass, vol and vol0
+#define BOX_N 12    // Bounding boxes of the particles of all solids and of this solid
+
+/*! Grow the bounding box [lo, hi] to hold the local particles of solid s.
+ */
+static void add_to_box(Solid *s, double *lo, double *hi) {
+  for (int ip = 0; ip < s->np_local; ip++) {
+    for (int d = 0; d < 3; d++) {
+      lo[d] = MIN(lo[d], s->x[ip][d]);
+      hi[d] = MAX(hi[d], s->x[ip][d]);
+    }
+  }
+}
+
+/*! Does the box [lo1, hi1] intercept the box [lo2, hi2] enlarged by cutoff?
+ * Empty boxes (lo > hi) intercept nothing.
+ */
+static bool boxes_intercept(const double *lo1, const double *hi1,
+			    const double *lo2, const double *hi2, double cutoff) {
+  for (int d = 0; d < 3; d++) {
+    if (lo1[d] > hi1[d] || lo2[d] > hi2[d]) return false;
+    if (lo1[d] > hi2[d] + cutoff || hi1[d] < lo2[d] - cutoff) return false;
+  }
+  return true;
+}
+
+GhostParticles::GhostParticles(MPM *mpm, Solid *solid) : Pointers(mpm) {
+  s = solid;
+  thermal = false;
+  MPI_Comm_dup(universe->uworld, &comm);
+}
+
+GhostParticles::~GhostParticles() {
+  MPI_Comm_free(&comm);
+}
+
+void GhostParticles::forward() {
+  const double cutoff = s->ghost_cutoff;
+
+  s->np_ghost = 0;
+  thermal = s->has_field("gamma");
+
+  // Bounding boxes of the local particles of all the solids, which are the particles
+  // the ghosts can interact with, and of the particles of this solid:
+  double box[BOX_N];
+  for (int d = 0; d < 3; d++) {
+    box[d] = box[6 + d] = numeric_limits<double>::max();
+    box[3 + d] = box[9 + d] = -numeric_limits<double>::max();
+  }
+  for (Solid *si: domain->solids)
+    add_to_box(si, box, box + 3);
+  add_to_box(s, box + 6, box + 9);
+
+  // Only the CPUs whose sub-domains are close to this one can hold particles within the
+  // cutoff of the local ones. With updated Lagrangian methods the particles lie in the
+  // sub-domain of their CPU. With total Lagrangian methods they never migrate, and the
+  // sub-domains are extended by the largest distance of a particle outside its CPU's:
+  double excursion = 0;
+  if (update->method->is_TL) {
+    for (int d = 0; d < domain->dimension; d++)
+      excursion = MAX(excursion, MAX(domain->sublo[d] - box[d], box[3 + d] - domain->subhi[d]));
+    MPI_Allreduce(MPI_IN_PLACE, &excursion, 1, MPI_DOUBLE, MPI_MAX, comm);
+  }
+
+  vector<int> neighbours = domain->neighbour_procs(cutoff + excursion);
+  int nneigh = neighbours.size();
+
+  vector<double> boxes(BOX_N * nneigh);
+  requests.resize(2 * nneigh);
+  for (int k = 0; k < nneigh; k++)
+    MPI_Irecv(&boxes[BOX_N * k], BOX_N, MPI_DOUBLE, neighbours[k], 3, comm, &requests[k]);
+  for (int k = 0; k < nneigh; k++)
+    MPI_Isend(box, BOX_N, MPI_DOUBLE, neighbours[k], 3, comm, &requests[nneigh + k]);
+  MPI_Waitall(2 * nneigh, requests.data(), MPI_STATUSES_IGNORE);
+
+  // Both ends of every exchange are determined from the same boxes, so that each CPU
+  // knows which CPUs to expect messages from:
+  vector<const double *> send_boxes;
+  send_procs.clear();
+  recv_procs.clear();
+  for (int k = 0; k < nneigh; k++) {
+    const double *b = &boxes[BOX_N * k];
+    if (boxes_intercept(box + 6, box + 9, b, b + 3, cutoff)) {
+      send_procs.push_back(neighbours[k]);
+      send_boxes.push_back(b);
+    }
+    if (boxes_intercept(b + 6, b + 9, box, box + 3, cutoff))
+      recv_procs.push_back(neighbours[k]);
+  }
+
+  int nsend = send_procs.size();
+  int nrecv = recv_procs.size();
+
+  send_list.resize(nsend);
+  send_buf.resize(MAX(nsend, nrecv));
+  recv_buf.resize(MAX(nsend, nrecv));
+  requests.resize(nsend + nrecv);
+
+  for (int k = 0; k < nsend; k++) {
+    const double *b = send_boxes[k];
+    vector<double> &buf = send_buf[k];
+
+    send_list[k].clear();
+    buf.clear();
+    for (int ip = 0; ip < s->np_local; ip++) {
+      const Vector3d &xp = s->x[ip];
+      if (xp[0] < b[0] - cutoff || xp[0] > b[3] + cutoff ||
+	  xp[1] < b[1] - cutoff || xp[1] > b[4] + cutoff ||
+	  xp[2] < b[2] - cutoff || xp[2] > b[5] + cutoff)
+	continue;
+
+      send_list[k].push_back(ip);
+      buf.push_back(xp[0]);
+      buf.push_back(xp[1]);
+      buf.push_back(xp[2]);
+      buf.push_back(s->v[ip][0]);
+      buf.push_back(s->v[ip][1]);
+      buf.push_back(s->v[ip][2]);
+      buf.push_back(s->mass[ip]);
+      buf.push_back(s->vol[ip]);
+      buf.push_back(s->vol0[ip]);
+    }
+  }
+
+  // Number of ghosts sent to and received from each CPU:
+  vector<int> nsent(nsend), nreceived(nrecv);
+  for (int k = 0; k < nrecv; k++)
+    MPI_Irecv(&nreceived[k], 1, MPI_INT, recv_procs[k], 0, comm, &requests[k]);
+  for (int k = 0; k < nsend; k++) {
+    nsent[k] = send_list[k].size();
+    MPI_Isend(&nsent[k], 1, MPI_INT, send_procs[k], 0, comm, &requests[nrecv + k]);
+  }
+  MPI_Waitall(nsend + nrecv, requests.data(), MPI_STATUSES_IGNORE);
+
+  recv_offset.assign(nrecv + 1, 0);
+  for (int k = 0; k < nrecv; k++)
+    recv_offset[k + 1] = recv_offset[k] + nreceived[k];
+
+  // Ghosts:
+  for (int k = 0; k < nrecv; k++) {
+    recv_buf[k].resize(FORWARD_N * nreceived[k]);
+    MPI_Irecv(recv_buf[k].data(), recv_buf[k].size(), MPI_DOUBLE, recv_procs[k], 1,
+	      comm, &requests[k]);
+  }
+  for (int k = 0; k < nsend; k++)
+    MPI_Isend(send_buf[k].data(), send_buf[k].size(), MPI_DOUBLE, send_procs[k], 1,
+	      comm, &requests[nrecv + k]);
+  MPI_Waitall(nsend + nrecv, requests.data(), MPI_STATUSES_IGNORE);
+
+  s->np_ghost = recv_offset[nrecv];
+
+  // Only the fields flagged ParticleField::GHOST, which the contact fixes read or accumulate
+  // into, are extended. They are never shrunk, so that the ones holding more than np_local
+  // particles keep their size:
+  int n = s->np_local + s->np_ghost;
+  for (auto &field: s->fields)
+    if ((field->flags & ParticleField::GHOST) && field->size() < (size_t) n)
+      field->resize(n);
+
+  int ip = s->np_local;
+  for (int k = 0; k < nrecv; k++) {
+    const double *buf = recv_buf[k].data();
+    for (int i = 0; i < nreceived[k]; i++, ip++) {
+      s->x[ip] << buf[0], buf[1], buf[2];
+      s->v[ip] << buf[3], buf[4], buf[5];
+      s->mass[ip] = buf[6];
+      s->vol[ip] = buf[7];
+      s->vol0[ip] = buf[8];
+      s->mbp[ip].setZero();
+      if (thermal) s->gamma[ip] = 0;
+      buf += FORWARD_N;
+    }
+  }
+}
+
+void GhostParticles::reverse() {
+  const int nsend = send_procs.size();
+  const int nrecv = recv_procs.size();
+  const int n = thermal ? 4 : 3;
+
+  // The ghosts received from recv_procs[k] are returned to it, and the copies of the
+  // local particles sent to send_procs[k] come back from it:
+  for (int k = 0; k < nrecv; k++) {
+    vector<double> &buf = send_buf[k];
+    buf.clear();
+    for (int ip = s->np_local + recv_offset[k]; ip < s->np_local + recv_offset[k + 1]; ip++) {
+      buf.push_back(s->mbp[ip][0]);
+      buf.push_back(s->mbp[ip][1]);
+      buf.push_back(s->mbp[ip][2]);
+      if (thermal) buf.push_back(s->gamma[ip]);
+    }
+  }
+
+  for (int k = 0; k < nsend; k++) {
+    recv_buf[k].resize(n * send_list[k].size());
+    MPI_Irecv(recv_buf[k].data(), recv_buf[k].size(), MPI_DOUBLE, send_procs[k], 2,
+	      comm, &requests[k]);
+  }
+  for (int k = 0; k < nrecv; k++)
+    MPI_Isend(send_buf[k].data(), send_buf[k].size(), MPI_DOUBLE, recv_procs[k], 2,
+	      comm, &requests[nsend + k]);
+  MPI_Waitall(nsend + nrecv, requests.data(), MPI_STATUSES_IGNORE);
+
+  for (int k = 0; k < nsend; k++) {
+    const double *buf = recv_buf[k].data();
+    for (int ip: send_list[k]) {
+      s->mbp[ip][0] += buf[0];
+      s->mbp[ip][1] += buf[1];
+      s->mbp[ip][2] += buf[2];
+      if (thermal) s->gamma[ip] += buf[3];
+      buf += n;
+    }
+  }
+
+  s->np_ghost = 0;
+}
@@ -0,0 +1,62 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_GHOST_PARTICLES_H
+#define MPM_GHOST_PARTICLES_H
+
+#include "pointers.h"
+#include <mpi.h>
+#include <vector>
+
+/*! Copies of the particles of a solid owned by other CPUs, used by the fixes that
+ * make particles interact directly with each other (Fix::requires_ghost_particles).
+ *
+ * Every CPU sends the bounding box of its local particles to the CPUs of the neighbouring
+ * sub-domains (Domain::neighbour_procs()). The particles of the solid that lie within
+ * Solid::ghost_cutoff of the bounding box of one of them are sent to it. The received copies
+ * are stored after the local particles in x, v, mass, vol and vol0, and Solid::np_ghost is
+ * set to their number, so that the fixes can treat them as any other particle. Only the
+ * fields flagged ParticleField::GHOST are valid for the ghosts. The forces (mbp) and heat
+ * sources (gamma) the fixes accumulate on the ghosts are then sent back and added to the
+ * particles they are copies of.
+ *
+ * With the updated Lagrangian methods the local particles lie in the CPU's sub-domain,
+ * so that only the particles close to the sub-domain boundaries are copied. Using the
+ * bounding box of the particles instead of the sub-domain also works for total Lagrangian
+ * methods, in which the particles do not migrate between CPUs: the neighbouring sub-domains
+ * are then those within the cutoff plus the largest distance of a particle outside its CPU's.
+ */
+class GhostParticles : protected Pointers {
+ public:
+  GhostParticles(class MPM *, class Solid *);
+  ~GhostParticles();
+
+  void forward();    ///< Copy the particles of the other CPUs close to the local particles after the local particles.
+  void reverse();    ///< Add mbp and gamma of the ghosts to the particles they are copies of, and discard the ghosts.
+
+ private:
+  class Solid *s;                      ///< Solid whose particles are copied
+  MPI_Comm comm;                       ///< Communicator of the ghost exchanges, so that their messages cannot match other ones
+  bool thermal;                        ///< Is gamma returned with mbp?
+
+  vector<int> send_procs;              ///< CPUs some local particles are copied to
+  vector<vector<int>> send_list;       ///< Local particles copied to each CPU of send_procs
+  vector<int> recv_procs;              ///< CPUs some ghosts are copies from
+  vector<int> recv_offset;             ///< Ghosts from recv_procs[k] are np_local + recv_offset[k] to np_local + recv_offset[k + 1] - 1
+
+  vector<vector<double>> send_buf;     ///< Buffers of the messages to send_procs (forward) or recv_procs (reverse)
+  vector<vector<double>> recv_buf;     ///< Buffers of the messages from recv_procs (forward) or send_procs (reverse)
+  vector<MPI_Request> requests;
+};
+
+#endif
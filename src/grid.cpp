@@ -26,6 +26,10 @@
 #include "method.h"
 #include "universe.h"
 #include "error.h"
+#include "solid.h"
+#include "timer.h"
+#include <unordered_map>
+#include <climits>
 
 using namespace std;
 using namespace Eigen;
@@ -58,14 +62,24 @@ Grid::Grid(MPM *mpm) :
   MPI_Type_create_struct(4, blocklen, disp, type, &Pointtype);
   MPI_Type_commit(&Pointtype);
 
+  // Each grid uses its own pair of tags so that the reductions of several
+  // grids can be in progress at the same time:
+  static int ngrids = 0;
+  exchange_tag = 2 * ngrids + 1;
+  ngrids++;
+  pending_exchange = -1;
+  exchange_version = 0;
 }
 
 Grid::~Grid() {
+  free_ghost_exchanges();
+
   // Destroy MPI type:
   MPI_Type_free(&Pointtype);
 }
 
 void Grid::init(double *solidlo, double *solidhi) {
+  double tstart = MPI_Wtime();
 
   bool linear = false;
   bool cubic = false;
@@ -171,7 +185,6 @@ void Grid::init(double *solidlo, double *solidhi) {
 
   // Determine the total number of nodes:
   nnodes = nx_global * ny_global * nz_global;
-  map_ntag.assign(nnodes, -1);
 
   nx = MAX(0, noffsethi_[0] - noffsetlo[0]);
   if (domain->dimension >= 2) {
@@ -250,12 +263,6 @@ void Grid::init(double *solidlo, double *solidhi) {
 
 	ntag[l] = nz_global*ny_global*(i+noffsetlo[0]) + nz_global*(j+noffsetlo[1]) + k+noffsetlo[2];
 	// cout << "ntag = " << ntag[l] << endl;
-
-	// Check if ntag[l] already exists:
-	if(map_ntag[ntag[l]] != -1 ) {
-	  error->all(FLERR, "node " + to_string(ntag[l]) + " already exists.");
-	}
-	map_ntag[ntag[l]] = l;
 	nowner[l] = universe->me;
 
 	l++;
@@ -304,74 +311,67 @@ void Grid::init(double *solidlo, double *solidhi) {
 
   nshared = ns.size();
 
-  // Send over the tag and coordinates of the nodes to send:
-  int size_n;
-  vector<Point> tmp_shared;
-
-  for (int sproc = 0; sproc < universe->nprocs; sproc++) {
-    if (sproc == universe->me) {
-      size_n = ns.size();
-    } else {
-      size_n = 0;
-    }
-
-    MPI_Bcast(&size_n, 1, MPI_INT, sproc, universe->uworld);
-
-    if (sproc == universe->me) {
-      tmp_shared = ns;
-    } else {
-      tmp_shared.resize(size_n);
-    }
-
-    MPI_Bcast(tmp_shared.data(), size_n, Pointtype, sproc, universe->uworld);
-
-
-    if (sproc == universe->me) {
-
-      // Receive destination lists:
-
-      int size_origin;
-      for (int rproc = 0; rproc < universe->nprocs; rproc++) {
-        if (rproc != universe->me) {
-          MPI_Recv(&size_origin, 1, MPI_INT, rproc, 0, universe->uworld,
-                   MPI_STATUS_IGNORE);
-
-          if (size_origin != 0) {
-            vector<tagint> buf_recv(size_origin);
-
-            MPI_Recv(&buf_recv[0], size_origin, MPI_MPM_TAGINT, rproc, 0,
-                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            for (int i = 0; i < size_origin; i++) {
-              dest_nshared[rproc].push_back(buf_recv[i]);
-            }
-          }
-        }
-      }
-    } else {
-      vector<tagint> origin_gnodes;
-
-      // Check if the nodes received are in the subdomain:
-      for (int i_recv = 0; i_recv < size_n; i_recv++) {
-        if (domain->inside_subdomain_extended(tmp_shared[i_recv].x[0],
-                                              tmp_shared[i_recv].x[1],
-                                              tmp_shared[i_recv].x[2], delta)) {
-          gnodes.push_back(tmp_shared[i_recv]);
-          origin_gnodes.push_back(tmp_shared[i_recv].tag);
-        }
-      }
+  // Only the nodes of the neighbouring CPUs can be ghosts of this one. The margin
+  // also covers the nodes created slightly beyond the upper boundaries of the domain:
+  vector<int> neighbours = domain->neighbour_procs(delta + h);
+  int nneigh = neighbours.size();
 
-      // Send origin list:
-      int size_origin = origin_gnodes.size();
-      MPI_Send(&size_origin, 1, MPI_INT, sproc, 0, universe->uworld);
+  vector<MPI_Request> requests(2 * nneigh);
+  vector<int> size_recv(nneigh);
+  int size_send = ns.size();
 
-      if (size_origin != 0) {
-        MPI_Send(origin_gnodes.data(), size_origin, MPI_MPM_TAGINT, sproc, 0,
-                 MPI_COMM_WORLD);
-	origin_nshared[sproc] = origin_gnodes;
+  // Send over the tag and coordinates of the nodes to send:
+  for (int i = 0; i < nneigh; i++) {
+    MPI_Irecv(&size_recv[i], 1, MPI_INT, neighbours[i], 0, universe->uworld, &requests[i]);
+    MPI_Isend(&size_send, 1, MPI_INT, neighbours[i], 0, universe->uworld, &requests[nneigh + i]);
+  }
+  MPI_Waitall(2 * nneigh, requests.data(), MPI_STATUSES_IGNORE);
+
+  vector<vector<Point>> points_recv(nneigh);
+  for (int i = 0; i < nneigh; i++) {
+    points_recv[i].resize(size_recv[i]);
+    MPI_Irecv(points_recv[i].data(), size_recv[i], Pointtype, neighbours[i], 0,
+	      universe->uworld, &requests[i]);
+    MPI_Isend(ns.data(), size_send, Pointtype, neighbours[i], 0, universe->uworld,
+	      &requests[nneigh + i]);
+  }
+  MPI_Waitall(2 * nneigh, requests.data(), MPI_STATUSES_IGNORE);
+
+  // Check if the nodes received are in the subdomain, and send the list of those that
+  // are back to their owner:
+  vector<vector<tagint>> origin_gnodes(nneigh), dest_gnodes(nneigh);
+  vector<int> size_origin(nneigh);
+
+  for (int i = 0; i < nneigh; i++) {
+    for (const Point &p: points_recv[i]) {
+      if (domain->inside_subdomain_extended(p.x[0], p.x[1], p.x[2], delta)) {
+	gnodes.push_back(p);
+	origin_gnodes[i].push_back(p.tag);
       }
     }
+    size_origin[i] = origin_gnodes[i].size();
+
+    MPI_Irecv(&size_recv[i], 1, MPI_INT, neighbours[i], 0, universe->uworld, &requests[i]);
+    MPI_Isend(&size_origin[i], 1, MPI_INT, neighbours[i], 0, universe->uworld,
+	      &requests[nneigh + i]);
   }
+  MPI_Waitall(2 * nneigh, requests.data(), MPI_STATUSES_IGNORE);
+
+  for (int i = 0; i < nneigh; i++) {
+    dest_gnodes[i].resize(size_recv[i]);
+    MPI_Irecv(dest_gnodes[i].data(), size_recv[i], MPI_MPM_TAGINT, neighbours[i], 0,
+	      universe->uworld, &requests[i]);
+    MPI_Isend(origin_gnodes[i].data(), size_origin[i], MPI_MPM_TAGINT, neighbours[i], 0,
+	      universe->uworld, &requests[nneigh + i]);
+  }
+  MPI_Waitall(2 * nneigh, requests.data(), MPI_STATUSES_IGNORE);
 
+  for (int i = 0; i < nneigh; i++) {
+    if (!origin_gnodes[i].empty())
+      origin_nshared[neighbours[i]] = origin_gnodes[i];
+    if (!dest_gnodes[i].empty())
+      dest_nshared[neighbours[i]] = dest_gnodes[i];
+  }
 
   nnodes_ghost = gnodes.size();
 
@@ -384,14 +384,6 @@ void Grid::init(double *solidlo, double *solidhi) {
     nowner[i] = gnodes[in].owner;
     ntag[i] = gnodes[in].tag;
 
-    // Check if ntag[l] already exists:
-    if(map_ntag[ntag[i]] != -1 ) {
-      cout << "x0[" << ntag[i] << "]=[" << gnodes[in].x[0] << "," << gnodes[in].x[1] << "," << gnodes[in].x[2] << "]\t exits in x=[" << x0[map_ntag[i]][0] << "," << x0[map_ntag[i]][1] << "," << x0[map_ntag[i]][2] << "]\n";
-      error->all(FLERR, "node " + to_string(ntag[i]) + " already exists.");
-    }
-
-    map_ntag[ntag[i]] = i;
-
     x0[i][0] = x[i][0] = gnodes[in].x[0];
     x0[i][1] = x[i][1] = gnodes[in].x[1];
     x0[i][2] = x[i][2] = gnodes[in].x[2];
@@ -407,6 +399,19 @@ void Grid::init(double *solidlo, double *solidhi) {
     mass[i] = 0;
   }
 
+  map_local_nodes();
+  setup_ghost_exchange();
+  setup_blocks();
+
+  double t = MPI_Wtime() - tstart, tmax;
+  int nneigh_max;
+  MPI_Reduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, universe->uworld);
+  MPI_Reduce(&nneigh, &nneigh_max, 1, MPI_INT, MPI_MAX, 0, universe->uworld);
+  if (universe->me == 0) {
+    cout << "Grid of " << nnodes << " nodes set up in " << tmax
+	 << " s, each CPU exchanging nodes with at most " << nneigh_max << " others\n";
+  }
+
   // // Determine the total number of nodes:
   // bigint nnodes_temp = nnodes_local;
   // MPI_Allreduce(&nnodes_temp, &nnodes, 1, MPI_MPM_BIGINT, MPI_SUM, universe->uworld);
@@ -419,6 +424,17 @@ void Grid::setup(string cs){
   }
 }
 
+/*! The nodal values are discarded, since the next step computes them all again from
+ * the particles. Node groups have to be assigned again (Group::update_node_masks()).
+ */
+void Grid::rebuild(double *solidlo, double *solidhi) {
+  shared.clear();
+  dest_nshared.clear();
+  origin_nshared.clear();
+  grow(0);
+  init(solidlo, solidhi);
+}
+
 void Grid::grow(int nn){
   //nnodes_local = nn;
 
@@ -450,8 +466,9 @@ void Grid::update_grid_velocities()
   Vector3d vtemp;
   vtemp.setZero();
 
-  // Update all particles (even the ghost to not have to communicate the result)
-  for (int i=0; i<nnodes_local + nnodes_ghost; i++){
+  // Update all active nodes (even the ghost to not have to communicate the result)
+  for (int ia = 0; ia < active_nodes.size(); ia++) {
+    int i = active_nodes[ia];
     if (!rigid[i]) {
       if (mass[i] != 0) v_update[i] = v[i] + update->dt * (f[i] + mb[i])/mass[i];
       else v_update[i] = v[i];
@@ -475,149 +492,8 @@ void Grid::update_grid_positions()
 
 
 void Grid::reduce_mass_ghost_nodes() {
-  vector<vector<double>> tmp_mass_vect(universe->nprocs);
-  vector<vector<double>> buf_recv_vect(universe->nprocs);
-  //vector<double> tmp_mass;
-  int j, size_r, size_s, jproc;
-
-  // 1. Pack mass of nodes to be sent back to their owner:
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc == universe->me) {
-      for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-           ++idest) {
-        jproc = idest->first;
-	size_r = idest->second.size();
-
-        buf_recv_vect[jproc].resize(size_r);
-      }
-    } else {
-      // Check if iproc is listed in origin_nshared:
-
-      if (origin_nshared.count(iproc)) {
-        // me should send the list of masses of all the ghost nodes gotten from
-        // iproc to iproc.
-        size_s = origin_nshared[iproc].size();
-
-        // Create the list of masses:
-
-        tmp_mass_vect[iproc].resize(size_s);
-        for (int is = 0; is < size_s; is++) {
-          j = origin_nshared[iproc][is];
-
-          if (map_ntag[j] != -1) {
-            tmp_mass_vect[iproc][is] = mass[map_ntag[j]];
-          } else {
-	    error->one(FLERR, "Grid node j does not exist on this CPU.\n");
-	  }
-        }
-      }      
-    }
-  }
-
-  // 2. New send and receive
-  for (int i = 0; i < universe->sendnrecv.size(); i++) {
-    if (universe->sendnrecv[i][0] == 0) {
-      // Receive
-      jproc = universe->sendnrecv[i][1];
-
-      MPI_Recv(&buf_recv_vect[jproc][0], dest_nshared[jproc].size(), MPI_DOUBLE,
-               jproc, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    } else {
-      // Send
-      jproc = universe->sendnrecv[i][1];
-      MPI_Send(tmp_mass_vect[jproc].data(), origin_nshared[jproc].size(),
-               MPI_DOUBLE, jproc, 0, MPI_COMM_WORLD);
-    }
-  }
-
-  // 3. Add the received masses to that of the nodes:
-  for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-       ++idest) {
-    for (int is = 0; is < idest->second.size(); is++) {
-      j = idest->second[is];
-      if (map_ntag[j] != -1) {
-	mass[map_ntag[j]] += buf_recv_vect[idest->first][is];
-      } else {
-	error->one(FLERR, "Grid node j does not exist on this CPU.\n");
-      }
-    }
-  }
-
-  // Share the updated masses:
-  // 1. Pack
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc == universe->me) {
-
-      for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-           ++idest) {
-        // Send the updated list of masses to jproc:
-
-        jproc = idest->first;
-        size_s = idest->second.size();
-
-	// cout << "proc " << universe->me << " sends size to " << jproc << endl;
-
-        // Create the list of masses:
-        tmp_mass_vect[jproc].resize(size_s);
-        for (int is = 0; is < size_s; is++) {
-          j = idest->second[is];
-
-          if (map_ntag[j] != -1) {
-            tmp_mass_vect[jproc][is] = mass[map_ntag[j]];
-          } else {
-	    error->one(FLERR, "Grid node j does not exist on this CPU.\n");
-	  }
-        }
-      }
-    } else {
-
-      // Check if iproc listed in origin_nshared:
-
-      if (origin_nshared.count(iproc)) {
-        // Receive the updated list of masses from iproc
-
-	// cout << "proc " << universe->me << " receives size from " << iproc << endl;
-
-	size_r = origin_nshared[iproc].size();
-        buf_recv_vect[iproc].resize(size_r);
-      }
-    }
-  }
-
-
-  // 2. New send and receive
-  for (int i = 0; i < universe->sendnrecv.size(); i++) {
-    if (universe->sendnrecv[i][0] == 0) {
-      // Receive
-      jproc = universe->sendnrecv[i][1];
-
-      MPI_Send(tmp_mass_vect[jproc].data(), dest_nshared[jproc].size(), MPI_DOUBLE,
-               jproc, 0, MPI_COMM_WORLD);
-    } else {
-      // Send
-      jproc = universe->sendnrecv[i][1];
-      MPI_Recv(&buf_recv_vect[jproc][0], origin_nshared[jproc].size(),
-	       MPI_DOUBLE, jproc, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    }
-  }
-
-  // 3. Overwrite the nodes' mass with the received values
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc != universe->me) {
-      // Check if iproc listed in origin_nshared:
-
-      if (origin_nshared.count(iproc)) {
-	size_r = origin_nshared[iproc].size();
-        for (int is = 0; is < size_r; is++) {
-	  j = origin_nshared[iproc][is];
-
-          if (map_ntag[j] != -1) {
-            mass[map_ntag[j]] = buf_recv_vect[iproc][is];
-          }
-        }
-      }
-    }
-  }
+  reduce_ghost_nodes_begin(GHOST_MASS);
+  reduce_ghost_nodes_end();
 }
 
 
@@ -648,8 +524,8 @@ void Grid::reduce_mass_ghost_nodes_old() {
         for (int is = 0; is < size_r; is++) {
           j = idest->second[is];
 
-          if (map_ntag[j] != -1) {
-            mass[map_ntag[j]] += buf_recv[is];
+          if (local_index(j) != -1) {
+            mass[local_index(j)] += buf_recv[is];
           }
         }
       }
@@ -671,8 +547,8 @@ void Grid::reduce_mass_ghost_nodes_old() {
         for (int is = 0; is < size_s; is++) {
           j = origin_nshared[iproc][is];
 
-          if (map_ntag[j] != -1) {
-            tmp_mass[is] = mass[map_ntag[j]];
+          if (local_index(j) != -1) {
+            tmp_mass[is] = mass[local_index(j)];
           }
         }
 
@@ -702,8 +578,8 @@ void Grid::reduce_mass_ghost_nodes_old() {
         for (int is = 0; is < size_s; is++) {
           j = idest->second[is];
 
-          if (map_ntag[j] != -1) {
-            tmp_mass[is] = mass[map_ntag[j]];
+          if (local_index(j) != -1) {
+            tmp_mass[is] = mass[local_index(j)];
           }
         }
 
@@ -733,9 +609,9 @@ void Grid::reduce_mass_ghost_nodes_old() {
         for (int is = 0; is < size_r; is++) {
 	  j = origin_nshared[iproc][is];
 
-          if (map_ntag[j] != -1) {
-            mass[map_ntag[j]] = buf_recv[is];
-            // cout << "mass[" << j << "]=" << mass[map_ntag[j]] << "\n";
+          if (local_index(j) != -1) {
+            mass[local_index(j)] = buf_recv[is];
+            // cout << "mass[" << j << "]=" << mass[local_index(j)] << "\n";
           }
         }
       }
@@ -744,391 +620,476 @@ void Grid::reduce_mass_ghost_nodes_old() {
 }
 
 void Grid::reduce_rigid_ghost_nodes() {
-  vector<int> tmp_rigid;
-  int j, size_r, size_s, jproc;
-
-  // Some ghost nodes' rigid value on the CPU that owns them:
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc == universe->me) {
-
-      for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-           ++idest) {
-        // Receive the list of rigid from jproc:
-
-        jproc = idest->first;
-
-	// cout << "proc " << universe->me << " receives size from " << jproc << endl;
-        // MPI_Recv(&size_r, 1, MPI_INT, jproc, 0, universe->uworld,
-        //          MPI_STATUS_IGNORE);
-
-        // if (size_r != idest->second.size()) {
-        //   error->one(
-        //       FLERR,
-        //       "proc " + to_string(iproc) +
-        //           " received a conflicting number of shared nodes from proc " +
-        //           to_string(jproc) + "\n");
-        // }
-
-	size_r = idest->second.size();
-
-        vector<int> buf_recv(size_r);
-
-	// cout << "proc " << universe->me << " receives rigids from " << jproc << endl;
-        MPI_Recv(&buf_recv[0], size_r, MPI_INT, jproc, 0, MPI_COMM_WORLD,
-                 MPI_STATUS_IGNORE);
+  reduce_ghost_nodes_begin(GHOST_RIGID);
+  reduce_ghost_nodes_end();
+}
 
-        // Apply LOR to the received values of rigid with to that of the nodes:
+void Grid::reduce_ghost_nodes(bool reduce_v, bool reduce_forces, bool temp) {
+  int quantities = 0;
+  if (reduce_v) quantities |= GHOST_V;
+  if (reduce_forces) quantities |= GHOST_FORCES;
+  if (temp) quantities |= GHOST_TEMP;
 
-        for (int is = 0; is < size_r; is++) {
-          j = idest->second[is];
+  reduce_ghost_nodes_begin(quantities);
+  reduce_ghost_nodes_end();
+}
 
-          if (map_ntag[j] != -1) {
-	    if (buf_recv[is] && !rigid[map_ntag[j]])
-	      rigid[map_ntag[j]] = true;
-          }
-        }
-      }
-    } else {
+/*! The lists of shared and ghost nodes do not change after init(), so the
+ * local indices of the nodes exchanged with each CPU are computed once here
+ * instead of being looked up with local_index() at every reduction.
+ */
+void Grid::setup_ghost_exchange() {
+  free_ghost_exchanges();
+
+  // Unique among all grids, so that a GridExchange notices a new grid as well:
+  static int nversions = 0;
+  exchange_version = ++nversions;
+
+  shared_procs.clear();
+  shared_nodes.clear();
+  shared_offset.assign(1, 0);
+  for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend(); ++idest) {
+    shared_procs.push_back(idest->first);
+    for (auto j: idest->second) {
+      int in = local_index(j);
+      if (in == -1)
+	error->one(FLERR, "Grid node j does not exist on this CPU.\n");
+      shared_nodes.push_back(in);
+    }
+    shared_offset.push_back(shared_nodes.size());
+  }
 
-      // Check if iproc listed in origin_nshared:
+  ghost_procs.clear();
+  ghost_nodes.clear();
+  ghost_offset.assign(1, 0);
+  for (auto iorigin = origin_nshared.cbegin(); iorigin != origin_nshared.cend(); ++iorigin) {
+    ghost_procs.push_back(iorigin->first);
+    for (auto j: iorigin->second) {
+      int in = local_index(j);
+      if (in == -1)
+	error->one(FLERR, "Grid node j does not exist on this CPU.\n");
+      ghost_nodes.push_back(in);
+    }
+    ghost_offset.push_back(ghost_nodes.size());
+  }
 
-      if (origin_nshared.count(iproc)) {
-        // me should send the list of masses of all the ghost nodes gotten from
-        // iproc to iproc.
-        size_s = origin_nshared[iproc].size();
+  exchanged.assign(nnodes_local + nnodes_ghost, 0);
+  for (int in: shared_nodes)
+    exchanged[in] = 1;
+  for (int in: ghost_nodes)
+    exchanged[in] = 1;
+}
 
-	// cout << "proc " << universe->me << " sends size to " << iproc << endl;
-        // MPI_Send(&size_s, 1, MPI_INT, iproc, 0, MPI_COMM_WORLD);
+/*! The local and ghost nodes of a CPU span a box of global indices barely larger than
+ * its sub-domain: their local indices are stored for this box only, so that the memory
+ * used does not grow with the size of the whole grid.
+ */
+void Grid::map_local_nodes() {
+  int nn = nnodes_local + nnodes_ghost;
+  int ijk[3], box_hi[3] = {-1, -1, -1};
+
+  for (int d = 0; d < 3; d++)
+    box_lo[d] = nn ? INT_MAX : 0;
+
+  for (int in = 0; in < nn; in++) {
+    global_indices(ntag[in], ijk);
+    for (int d = 0; d < 3; d++) {
+      box_lo[d] = MIN(box_lo[d], ijk[d]);
+      box_hi[d] = MAX(box_hi[d], ijk[d]);
+    }
+  }
 
-        // Create the list of masses:
+  for (int d = 0; d < 3; d++)
+    box_n[d] = box_hi[d] - box_lo[d] + 1;
 
-        tmp_rigid.assign(size_s, 0); // Reset vector to all 0
-        for (int is = 0; is < size_s; is++) {
-          j = origin_nshared[iproc][is];
+  map_box.assign((size_t) box_n[0] * box_n[1] * box_n[2], -1);
 
-          if (map_ntag[j] != -1) {
-            tmp_rigid[is] = (int) rigid[map_ntag[j]]; // Populate tmp_rigid with the value of rigid
-          }
-        }
+  for (int in = 0; in < nn; in++) {
+    global_indices(ntag[in], ijk);
+    size_t m = ((size_t) (ijk[0] - box_lo[0]) * box_n[1] + ijk[1] - box_lo[1]) * box_n[2]
+      + ijk[2] - box_lo[2];
 
-	// cout << "proc " << universe->me << " sends rigids to " << iproc << endl;
-	MPI_Send(tmp_rigid.data(),  size_s, MPI_INT, iproc, 0, MPI_COMM_WORLD);
-      }
+    if (map_box[m] != -1) {
+      error->all(FLERR, "node " + to_string(ntag[in]) + " already exists.");
     }
+    map_box[m] = in;
   }
+}
 
-  // Share the updated rigids:
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc == universe->me) {
-
-      for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-           ++idest) {
-        // Send the updated list of masses to jproc:
+/*! Nodes are grouped in blocks of GRID_BLOCK nodes per direction according to their
+ * global indices, so that a block can hold both local and ghost nodes.
+ * All blocks are active until update_active_blocks() is called.
+ */
+void Grid::setup_blocks() {
+  int nn = nnodes_local + nnodes_ghost;
+  tagint nby = (ny_global + GRID_BLOCK - 1) / GRID_BLOCK;
+  tagint nbz = (nz_global + GRID_BLOCK - 1) / GRID_BLOCK;
+
+  unordered_map<tagint, int> map_block;
+  vector<int> count;
+
+  nblock.resize(nn);
+  for (int in = 0; in < nn; in++) {
+    tagint i = ntag[in] / ((tagint) nz_global * ny_global);
+    tagint j = (ntag[in] / nz_global) % ny_global;
+    tagint k = ntag[in] % nz_global;
+    tagint key = ((i / GRID_BLOCK) * nby + j / GRID_BLOCK) * nbz + k / GRID_BLOCK;
+
+    auto it = map_block.find(key);
+    if (it == map_block.end()) {
+      it = map_block.emplace(key, count.size()).first;
+      count.push_back(0);
+    }
+    nblock[in] = it->second;
+    count[it->second]++;
+  }
 
-        jproc = idest->first;
-        size_s = idest->second.size();
+  int nb = count.size();
+  block_offset.assign(nb + 1, 0);
+  for (int b = 0; b < nb; b++)
+    block_offset[b + 1] = block_offset[b] + count[b];
 
-	// cout << "proc " << universe->me << " sends size to " << jproc << endl;
-        // MPI_Send(&size_s, 1, MPI_INT, jproc, 0, universe->uworld);
+  vector<int> next(block_offset.begin(), block_offset.end() - 1);
+  block_nodes.resize(nn);
+  for (int in = 0; in < nn; in++)
+    block_nodes[next[nblock[in]]++] = in;
 
-        // Create the list of rigids:
+  exchange_active = exchanged;
 
-        tmp_rigid.assign(size_s, 0);
-        for (int is = 0; is < size_s; is++) {
-          j = idest->second[is];
+  block_active.assign(nb, 1);
+  active_nodes.resize(nn);
+  for (int in = 0; in < nn; in++)
+    active_nodes[in] = in;
+}
 
-          if (map_ntag[j] != -1) {
-            tmp_rigid[is] = (int) rigid[map_ntag[j]];
-          }
-        }
+/*! A block is active if one of its nodes neighbours a particle of one of the solids
+ * using this grid, on this CPU or, for the nodes exchanged with other CPUs, on any
+ * CPU holding the node: exchange_active is reduced with the CPUs sharing the nodes,
+ * so that they agree on which exchanged nodes the ghost reductions skip.
+ * The nodes of the blocks that become inactive are reset once, so that they hold
+ * the same values as nodes without any particle nearby after a P2G over all nodes.
+ * This has to be called after the particle-node neighbour lists of all these solids
+ * are built, and before the P2G.
+ */
+void Grid::update_active_blocks() {
+  int nb = block_active.size();
+
+  // Bit 0: was active, bit 1: is active.
+  for (int b = 0; b < nb; b++)
+    block_active[b] = block_active[b] ? 1 : 0;
+
+  for (int in: shared_nodes)
+    exchange_active[in] = 0;
+  for (int in: ghost_nodes)
+    exchange_active[in] = 0;
+
+  for (Solid *s: domain->solids) {
+    if (s->grid != this) continue;
+    for (int in: s->neigh_pn) {
+      block_active[nblock[in]] |= 2;
+      if (exchanged[in])
+	exchange_active[in] = 1;
+    }
+  }
 
-	// cout << "proc " << universe->me << " sends rigids to " << jproc << endl;
-        MPI_Send(tmp_rigid.data(), size_s, MPI_INT, jproc, 0, MPI_COMM_WORLD);
-      }
+  reduce_ghost_nodes_begin(GHOST_ACTIVE);
+  reduce_ghost_nodes_end();
+
+  for (int in: shared_nodes)
+    if (exchange_active[in])
+      block_active[nblock[in]] |= 2;
+  for (int in: ghost_nodes)
+    if (exchange_active[in])
+      block_active[nblock[in]] |= 2;
+
+  active_nodes.clear();
+  for (int b = 0; b < nb; b++) {
+    if (block_active[b] & 2) {
+      active_nodes.insert(active_nodes.end(), block_nodes.begin() + block_offset[b],
+			  block_nodes.begin() + block_offset[b + 1]);
+      block_active[b] = 1;
     } else {
-
-      // Check if iproc listed in origin_nshared:
-
-      if (origin_nshared.count(iproc)) {
-        // Receive the updated list of masses from iproc
-
-	// cout << "proc " << universe->me << " receives size from " << iproc << endl;
-        // MPI_Recv(&size_r, 1, MPI_INT, iproc, 0, MPI_COMM_WORLD,
-        //          MPI_STATUS_IGNORE);
-
-	size_r = origin_nshared[iproc].size();
-        vector<int> buf_recv(size_r);
-
-	// cout << "proc " << universe->me << " receives rigids from " << iproc << endl;
-        MPI_Recv(&buf_recv[0], size_r, MPI_INT, iproc, 0, MPI_COMM_WORLD,
-                 MPI_STATUS_IGNORE);
-
-        // LOR the received rigids to that of the nodes:
-
-        for (int is = 0; is < size_r; is++) {
-	  j = origin_nshared[iproc][is];
-
-          if (map_ntag[j] != -1) {
-	    if (buf_recv[is] && !rigid[map_ntag[j]])
-	      rigid[map_ntag[j]] = true;
-          }
-        }
+      if (block_active[b] & 1) {
+	for (int l = block_offset[b]; l < block_offset[b + 1]; l++) {
+	  int in = block_nodes[l];
+	  mass[in] = 0;
+	  v[in].setZero();
+	  v_update[in].setZero();
+	  mb[in].setZero();
+	  f[in].setZero();
+	  T[in] = 0;
+	  T_update[in] = 0;
+	  Qext[in] = 0;
+	  Qint[in] = 0;
+	}
       }
+      block_active[b] = 0;
     }
   }
 }
 
-void Grid::reduce_ghost_nodes(bool reduce_v, bool reduce_forces, bool temp) {
-  vector<vector<double>> tmp_vect(universe->nprocs);
-  vector<vector<double>> buf_recv_vect(universe->nprocs);
-  //vector<double> tmp_mass;
-  int j, k, m, size_r, size_s, jproc, nsend;
-
-  nsend = (3 + temp) * (reduce_v + 2*reduce_forces);
-
-  // 1. Pack mass of nodes to be sent back to their owner:
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc == universe->me) {
-      for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-           ++idest) {
-        jproc = idest->first;
-	size_r = idest->second.size();
-
-        buf_recv_vect[jproc].resize(nsend * size_r);
-      }
-    } else {
-      // Check if iproc is listed in origin_nshared:
-
-      if (origin_nshared.count(iproc)) {
-        // me should send the list of masses of all the ghost nodes gotten from
-        // iproc to iproc.
-        size_s = origin_nshared[iproc].size();
-
-        // Create the list of masses:
+void Grid::free_ghost_exchanges() {
+  for (auto &ie: ghost_exchanges) {
+    for (auto &r: ie.second.reduce_recv) MPI_Request_free(&r);
+    for (auto &r: ie.second.reduce_send) MPI_Request_free(&r);
+    for (auto &r: ie.second.update_send) MPI_Request_free(&r);
+    for (auto &r: ie.second.update_recv) MPI_Request_free(&r);
+  }
+  ghost_exchanges.clear();
+  pending_exchange = -1;
+}
 
-        tmp_vect[iproc].resize(nsend * size_s);
+/*! The buffers and persistent requests of a combination of quantities are
+ * created the first time it is reduced and reused by all later reductions.
+ */
+Grid::GhostExchange &Grid::ghost_exchange(int quantities) {
+  auto it = ghost_exchanges.find(quantities);
+  if (it != ghost_exchanges.end())
+    return it->second;
+
+  GhostExchange &ge = ghost_exchanges[quantities];
+
+  ge.nsend = ghost_values_size(quantities);
+
+  int n = ge.nsend;
+  ge.buf_shared.resize(n * shared_nodes.size());
+  ge.buf_ghost.resize(n * ghost_nodes.size());
+  ge.reduce_recv.resize(shared_procs.size());
+  ge.update_send.resize(shared_procs.size());
+  ge.reduce_send.resize(ghost_procs.size());
+  ge.update_recv.resize(ghost_procs.size());
+
+  for (int k = 0; k < shared_procs.size(); k++) {
+    double *buf = ge.buf_shared.data() + n * shared_offset[k];
+    int size = n * (shared_offset[k + 1] - shared_offset[k]);
+    MPI_Recv_init(buf, size, MPI_DOUBLE, shared_procs[k], exchange_tag,
+                  universe->uworld, &ge.reduce_recv[k]);
+    MPI_Send_init(buf, size, MPI_DOUBLE, shared_procs[k], exchange_tag + 1,
+                  universe->uworld, &ge.update_send[k]);
+  }
 
-	k = 0;
+  for (int k = 0; k < ghost_procs.size(); k++) {
+    double *buf = ge.buf_ghost.data() + n * ghost_offset[k];
+    int size = n * (ghost_offset[k + 1] - ghost_offset[k]);
+    MPI_Send_init(buf, size, MPI_DOUBLE, ghost_procs[k], exchange_tag,
+                  universe->uworld, &ge.reduce_send[k]);
+    MPI_Recv_init(buf, size, MPI_DOUBLE, ghost_procs[k], exchange_tag + 1,
+                  universe->uworld, &ge.update_recv[k]);
+  }
 
-	for (int is = 0; is < size_s; is++) {
-          j = origin_nshared[iproc][is];
+  return ge;
+}
 
-          if (map_ntag[j] != -1) {
-            m = map_ntag[j];
-            //k = nsend * is;
-	    if (reduce_v) {
-	      tmp_vect[iproc][k++] = v[m][0];
-	      tmp_vect[iproc][k++] = v[m][1];
-	      tmp_vect[iproc][k++] = v[m][2];
-	    }
-            if (reduce_forces) {
-              tmp_vect[iproc][k++] = f[m][0];
-              tmp_vect[iproc][k++] = f[m][1];
-              tmp_vect[iproc][k++] = f[m][2];
-
-              tmp_vect[iproc][k++] = mb[m][0];
-              tmp_vect[iproc][k++] = mb[m][1];
-              tmp_vect[iproc][k++] = mb[m][2];
-            }
+int Grid::ghost_values_size(int quantities) {
+  bool temp = quantities & GHOST_TEMP;
+  int n = 0;
+  if (quantities & GHOST_MASS) n += 1;
+  if (quantities & GHOST_RIGID) n += 1;
+  if (quantities & GHOST_V) n += 3 + temp;
+  if (quantities & GHOST_FORCES) n += 6 + 2 * temp;
+  if (quantities & GHOST_ACTIVE) n += 1;
+  return n;
+}
 
-	    if (temp) {
-	      if (reduce_v)
-		tmp_vect[iproc][k++] = T[m];
-	      if (reduce_forces) {
-		tmp_vect[iproc][k++] = Qint[m];
-		tmp_vect[iproc][k++] = Qext[m];
-	      }	      
-	    }
-          } else {
-	    error->one(FLERR, "Grid node j does not exist on this CPU.\n");
-	  }
-        }
-      }      
+/*! The nodes far from the particles of all the CPUs (exchange_active[in] == 0) receive
+ * no contribution: they are neither packed nor unpacked, and their part of the messages
+ * is ignored.
+ */
+void Grid::pack_ghost_values(int quantities, int in, double *buf) {
+  int k = 0;
+  bool temp = quantities & GHOST_TEMP;
+
+  if (quantities & GHOST_ACTIVE) {
+    buf[k++] = exchange_active[in];
+    return;
+  }
+  if (!exchange_active[in])
+    return;
+
+  if (quantities & GHOST_MASS)
+    buf[k++] = mass[in];
+  if (quantities & GHOST_RIGID)
+    buf[k++] = rigid[in];
+  if (quantities & GHOST_V) {
+    buf[k++] = v[in][0];
+    buf[k++] = v[in][1];
+    buf[k++] = v[in][2];
+    if (temp)
+      buf[k++] = T[in];
+  }
+  if (quantities & GHOST_FORCES) {
+    buf[k++] = f[in][0];
+    buf[k++] = f[in][1];
+    buf[k++] = f[in][2];
+
+    buf[k++] = mb[in][0];
+    buf[k++] = mb[in][1];
+    buf[k++] = mb[in][2];
+    if (temp) {
+      buf[k++] = Qint[in];
+      buf[k++] = Qext[in];
     }
   }
+}
 
-  // 2. New send and receive
-  for (int i = 0; i < universe->sendnrecv.size(); i++) {
-    if (universe->sendnrecv[i][0] == 0) {
-      // Receive
-      jproc = universe->sendnrecv[i][1];
+void Grid::add_ghost_values(int quantities, int in, const double *buf) {
+  int k = 0;
+  bool temp = quantities & GHOST_TEMP;
 
-      MPI_Recv(&buf_recv_vect[jproc][0], nsend * dest_nshared[jproc].size(), MPI_DOUBLE,
-               jproc, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    } else {
-      // Send
-      jproc = universe->sendnrecv[i][1];
-      MPI_Send(tmp_vect[jproc].data(), nsend * origin_nshared[jproc].size(),
-               MPI_DOUBLE, jproc, 0, MPI_COMM_WORLD);
+  if (quantities & GHOST_ACTIVE) {
+    if (buf[k++] != 0) exchange_active[in] = 1;
+    return;
+  }
+  if (!exchange_active[in])
+    return;
+
+  if (quantities & GHOST_MASS)
+    mass[in] += buf[k++];
+  if (quantities & GHOST_RIGID)
+    if (buf[k++] != 0) rigid[in] = true;
+  if (quantities & GHOST_V) {
+    v[in][0] += buf[k++];
+    v[in][1] += buf[k++];
+    v[in][2] += buf[k++];
+    if (temp)
+      T[in] += buf[k++];
+  }
+  if (quantities & GHOST_FORCES) {
+    f[in][0] += buf[k++];
+    f[in][1] += buf[k++];
+    f[in][2] += buf[k++];
+
+    mb[in][0] += buf[k++];
+    mb[in][1] += buf[k++];
+    mb[in][2] += buf[k++];
+    if (temp) {
+      Qint[in] += buf[k++];
+      Qext[in] += buf[k++];
     }
   }
+}
 
-  // 3. Add the received masses to that of the nodes:
-  for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-       ++idest) {
-
-    k = 0;
-
-    for (int is = 0; is < idest->second.size(); is++) {
-      j = idest->second[is];
-      if (map_ntag[j] != -1) {
-	//mass[map_ntag[j]] += buf_recv_vect[idest->first][is];
-	m = map_ntag[j];
-	//k = nsend * is;
-	if (reduce_v) {
-	  v[m][0] += buf_recv_vect[idest->first][k++];
-	  v[m][1] += buf_recv_vect[idest->first][k++];
-	  v[m][2] += buf_recv_vect[idest->first][k++];
-	}
-	if (reduce_forces) {
-	  f[m][0] += buf_recv_vect[idest->first][k++];
-	  f[m][1] += buf_recv_vect[idest->first][k++];
-	  f[m][2] += buf_recv_vect[idest->first][k++];
-
-	  mb[m][0] += buf_recv_vect[idest->first][k++];
-	  mb[m][1] += buf_recv_vect[idest->first][k++];
-	  mb[m][2] += buf_recv_vect[idest->first][k++];
-	}
+void Grid::set_ghost_values(int quantities, int in, const double *buf) {
+  int k = 0;
+  bool temp = quantities & GHOST_TEMP;
 
-	if (temp) {
-	  if (reduce_v)
-	    T[m] += buf_recv_vect[idest->first][k++];
-	  if (reduce_forces) {
-	    Qint[m] += buf_recv_vect[idest->first][k++];
-	    Qext[m] += buf_recv_vect[idest->first][k++];
-	  }
-	}
-      } else {
-	error->one(FLERR, "Grid node j does not exist on this CPU.\n");
-      }
+  if (quantities & GHOST_ACTIVE) {
+    exchange_active[in] = buf[k++] != 0;
+    return;
+  }
+  if (!exchange_active[in])
+    return;
+
+  if (quantities & GHOST_MASS)
+    mass[in] = buf[k++];
+  if (quantities & GHOST_RIGID)
+    if (buf[k++] != 0) rigid[in] = true;
+  if (quantities & GHOST_V) {
+    v[in][0] = buf[k++];
+    v[in][1] = buf[k++];
+    v[in][2] = buf[k++];
+    if (temp)
+      T[in] = buf[k++];
+  }
+  if (quantities & GHOST_FORCES) {
+    f[in][0] = buf[k++];
+    f[in][1] = buf[k++];
+    f[in][2] = buf[k++];
+
+    mb[in][0] = buf[k++];
+    mb[in][1] = buf[k++];
+    mb[in][2] = buf[k++];
+    if (temp) {
+      Qint[in] = buf[k++];
+      Qext[in] = buf[k++];
     }
   }
+}
 
-  // Share the updated masses:
-  // 1. Pack
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc == universe->me) {
-
-      for (auto idest = dest_nshared.cbegin(); idest != dest_nshared.cend();
-           ++idest) {
-        // Send the updated list of masses to jproc:
-
-        jproc = idest->first;
-        size_s = idest->second.size();
-
-	// cout << "proc " << universe->me << " sends size to " << jproc << endl;
-
-        // Create the list of masses:
-        tmp_vect[jproc].resize(nsend * size_s);
-
-	k = 0;
-        for (int is = 0; is < size_s; is++) {
-          j = idest->second[is];
-
-          if (map_ntag[j] != -1) {
-            m = map_ntag[j];
-            //k = nsend * is;
-	    if (reduce_v) {
-	      tmp_vect[jproc][k++] = v[m][0];
-	      tmp_vect[jproc][k++] = v[m][1];
-	      tmp_vect[jproc][k++] = v[m][2];
-	    }
-            if (reduce_forces) {
-              tmp_vect[jproc][k++] = f[m][0];
-              tmp_vect[jproc][k++] = f[m][1];
-              tmp_vect[jproc][k++] = f[m][2];
-
-              tmp_vect[jproc][k++] = mb[m][0];
-              tmp_vect[jproc][k++] = mb[m][1];
-              tmp_vect[jproc][k++] = mb[m][2];
-            }
-
-	    if (temp) {
-	      if (reduce_v)
-		tmp_vect[jproc][k++] = T[m];
-	      if (reduce_forces) {
-		tmp_vect[jproc][k++] = Qint[m];
-		tmp_vect[jproc][k++] = Qext[m];
-	      }	      
-	    }
-          } else {
-	    error->one(FLERR, "Grid node j does not exist on this CPU.\n");
-	  }
-        }
-      }
-    } else {
-
-      // Check if iproc listed in origin_nshared:
+/*! The contributions of the ghost nodes are packed and sent to the CPUs
+ * owning them, and the receptions of the contributions to the shared nodes
+ * are posted. The function returns without waiting, so that the caller can
+ * do the P2G of the nodes that are not exchanged (exchanged[in] == 0) before
+ * calling reduce_ghost_nodes_end(): all the contributions to the exchanged
+ * nodes must be complete before this call, and they must not be modified
+ * until the end of the reduction.
+ */
+void Grid::reduce_ghost_nodes_begin(int quantities) {
+  if (pending_exchange != -1)
+    error->one(FLERR, "Error: a reduction of the ghost nodes is already in progress on this grid.\n");
+
+  pending_exchange = quantities;
+  if (shared_procs.empty() && ghost_procs.empty())
+    return;
+
+  timer->start(Timer::GHOST_NODES);
+
+  GhostExchange &ge = ghost_exchange(quantities);
+
+  if (!ge.reduce_recv.empty())
+    MPI_Startall(ge.reduce_recv.size(), ge.reduce_recv.data());
+
+  for (int k = 0; k < ghost_procs.size(); k++) {
+    for (int is = ghost_offset[k]; is < ghost_offset[k + 1]; is++)
+      pack_ghost_values(quantities, ghost_nodes[is], &ge.buf_ghost[ge.nsend * is]);
+    MPI_Start(&ge.reduce_send[k]);
+  }
 
-      if (origin_nshared.count(iproc)) {
-        // Receive the updated list of masses from iproc
+  timer->stop();
+}
 
-	// cout << "proc " << universe->me << " receives size from " << iproc << endl;
-        buf_recv_vect[iproc].resize(nsend * origin_nshared[iproc].size());
-      }
-    }
+/*! The contributions received for the shared nodes are summed in the order of
+ * shared_procs, so that the result does not depend on the order in which the
+ * messages arrive, while the messages not yet received are still in flight.
+ * The reduced values are then sent back to the CPUs holding them as ghost nodes,
+ * which unpack them as soon as each message arrives.
+ */
+void Grid::reduce_ghost_nodes_end() {
+  if (pending_exchange == -1)
+    error->one(FLERR, "Error: no reduction of the ghost nodes is in progress on this grid.\n");
+
+  int quantities = pending_exchange;
+  pending_exchange = -1;
+  if (shared_procs.empty() && ghost_procs.empty())
+    return;
+
+  timer->start(Timer::GHOST_NODES);
+
+  GhostExchange &ge = ghost_exchanges[quantities];
+
+  // 1. Add the contributions of the other CPUs to the shared nodes:
+  for (int k = 0; k < shared_procs.size(); k++) {
+    MPI_Wait(&ge.reduce_recv[k], MPI_STATUS_IGNORE);
+    for (int is = shared_offset[k]; is < shared_offset[k + 1]; is++)
+      add_ghost_values(quantities, shared_nodes[is], &ge.buf_shared[ge.nsend * is]);
   }
 
+  // The ghost buffer is reused for the reception of the reduced values:
+  if (!ge.reduce_send.empty())
+    MPI_Waitall(ge.reduce_send.size(), ge.reduce_send.data(), MPI_STATUSES_IGNORE);
 
-  // 2. New send and receive
-  for (int i = 0; i < universe->sendnrecv.size(); i++) {
-    if (universe->sendnrecv[i][0] == 0) {
-      // Receive
-      jproc = universe->sendnrecv[i][1];
+  if (!ge.update_recv.empty())
+    MPI_Startall(ge.update_recv.size(), ge.update_recv.data());
 
-      MPI_Send(tmp_vect[jproc].data(), nsend * dest_nshared[jproc].size(),
-               MPI_DOUBLE, jproc, 0, MPI_COMM_WORLD);
-    } else {
-      // Send
-      jproc = universe->sendnrecv[i][1];
-      MPI_Recv(&buf_recv_vect[jproc][0], nsend * origin_nshared[jproc].size(),
-               MPI_DOUBLE, jproc, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    }
+  // 2. Send the reduced values of the shared nodes:
+  for (int k = 0; k < shared_procs.size(); k++) {
+    for (int is = shared_offset[k]; is < shared_offset[k + 1]; is++)
+      pack_ghost_values(quantities, shared_nodes[is], &ge.buf_shared[ge.nsend * is]);
+    MPI_Start(&ge.update_send[k]);
   }
 
-  // 3. Overwrite the nodes' mass with the received values
-  for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-    if (iproc != universe->me) {
-      // Check if iproc listed in origin_nshared:
-
-      if (origin_nshared.count(iproc)) {
-	k = 0;
-        for (int is = 0; is < origin_nshared[iproc].size(); is++) {
-	  j = origin_nshared[iproc][is];
+  // 3. Overwrite the ghost nodes with the reduced values:
+  for (int i = 0; i < ghost_procs.size(); i++) {
+    int k;
+    MPI_Waitany(ge.update_recv.size(), ge.update_recv.data(), &k, MPI_STATUS_IGNORE);
+    for (int is = ghost_offset[k]; is < ghost_offset[k + 1]; is++)
+      set_ghost_values(quantities, ghost_nodes[is], &ge.buf_ghost[ge.nsend * is]);
+  }
 
-          if (map_ntag[j] != -1) {
-	    m = map_ntag[j];
-            //k = nsend * is;
-	    if (reduce_v) {
-	      v[m][0] = buf_recv_vect[iproc][k++];
-	      v[m][1] = buf_recv_vect[iproc][k++];
-	      v[m][2] = buf_recv_vect[iproc][k++];
-	    }
-            if (reduce_forces) {
-              f[m][0] = buf_recv_vect[iproc][k++];
-              f[m][1] = buf_recv_vect[iproc][k++];
-              f[m][2] = buf_recv_vect[iproc][k++];
-
-              mb[m][0] = buf_recv_vect[iproc][k++];
-              mb[m][1] = buf_recv_vect[iproc][k++];
-              mb[m][2] = buf_recv_vect[iproc][k++];
-            }
+  if (!ge.update_send.empty())
+    MPI_Waitall(ge.update_send.size(), ge.update_send.data(), MPI_STATUSES_IGNORE);
 
-            if (temp) {
-	      if (reduce_v)
-		T[m] = buf_recv_vect[iproc][k++];
-              if (reduce_forces) {
-                Qint[m] = buf_recv_vect[iproc][k++];
-                Qext[m] = buf_recv_vect[iproc][k++];
-              }
-            }
-          } else {
-            error->one(FLERR, "Grid node j does not exist on this CPU.\n");
-          }
-        }
-      }
-    }
-  }
+  timer->stop();
 }
 
 void Grid::reduce_ghost_nodes_old(bool only_v, bool temp) {
@@ -1166,8 +1127,8 @@ void Grid::reduce_ghost_nodes_old(bool only_v, bool temp) {
         for (int is = 0; is < size_r; is++) {
           j = idest->second[is];
 
-          if (map_ntag[j] != -1) {
-            m = map_ntag[j];
+          m = local_index(j);
+          if (m != -1) {
             //k = nsend * is;
             v[m][0] += buf_recv[k++];
             v[m][1] += buf_recv[k++];
@@ -1211,8 +1172,8 @@ void Grid::reduce_ghost_nodes_old(bool only_v, bool temp) {
         for (int is = 0; is < size_s; is++) {
           j = origin_nshared[iproc][is];
 
-          if (map_ntag[j] != -1) {
-            m = map_ntag[j];
+          m = local_index(j);
+          if (m != -1) {
             //k = nsend * is;
             tmp[k++] = v[m][0];
             tmp[k++] = v[m][1];
@@ -1266,8 +1227,8 @@ void Grid::reduce_ghost_nodes_old(bool only_v, bool temp) {
         for (int is = 0; is < size_s; is++) {
           j = idest->second[is];
 
-          if (map_ntag[j] != -1) {
-            m = map_ntag[j];
+          m = local_index(j);
+          if (m != -1) {
             //k = nsend * is;
             tmp[k++] = v[m][0];
             tmp[k++] = v[m][1];
@@ -1321,8 +1282,8 @@ void Grid::reduce_ghost_nodes_old(bool only_v, bool temp) {
         for (int is = 0; is < size_r; is++) {
           j = origin_nshared[iproc][is];
 
-          if (map_ntag[j] != -1) {
-            m = map_ntag[j];
+          m = local_index(j);
+          if (m != -1) {
             //k = nsend * is;
             v[m][0] = buf_recv[k++];
             v[m][1] = buf_recv[k++];
@@ -1352,8 +1313,9 @@ void Grid::reduce_ghost_nodes_old(bool only_v, bool temp) {
 }
 
 void Grid::update_grid_temperature() {
-  // Update all particles (even the ghost to not have to communicate the result)
-  for (int i = 0; i < nnodes_local + nnodes_ghost; i++) {
+  // Update all active nodes (even the ghost to not have to communicate the result)
+  for (int ia = 0; ia < active_nodes.size(); ia++) {
+    int i = active_nodes[ia];
     if (mass[i] != 0)
       T_update[i] = T[i] + update->dt * (Qint[i] + Qext[i]) / mass[i];
     else
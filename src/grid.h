@@ -25,6 +25,8 @@
 
 using namespace Eigen;
 
+#define GRID_BLOCK 4   ///< Number of nodes per direction in a block of nodes
+
 /*! This structure is used to duplicate a grid point to another CPU.
  *  
  * Each CPU create the series of grid points that lie in their respective domains.
@@ -54,12 +56,23 @@ struct Point {
  */
 class Grid : protected Pointers {
  public:
+  enum GhostQuantities {
+    GHOST_MASS   = 1 << 0,   ///< Nodal mass
+    GHOST_RIGID  = 1 << 1,   ///< Rigid flag (logical OR instead of sum)
+    GHOST_V      = 1 << 2,   ///< Nodal velocity (and temperature if GHOST_TEMP)
+    GHOST_FORCES = 1 << 3,   ///< Internal and external forces (and thermal driving forces if GHOST_TEMP)
+    GHOST_TEMP   = 1 << 4,   ///< Include the thermal quantities
+    GHOST_ACTIVE = 1 << 5,   ///< Is the node near particles (logical OR), reduced alone for all exchanged nodes
+  };
+
   int ncells;            ///< number of cells
   bigint nnodes;         ///< total number of nodes in the domain
   bigint nnodes_local;   ///< number of nodes (in this CPU)
   bigint nnodes_ghost;   ///< number of ghost nodes (in this CPU)
   vector<tagint> ntag;   ///< unique identifier for nodes in the system.
-  vector<tagint> map_ntag;  ///< map_ntag[ntag[i]] = i;
+  int box_lo[3];         ///< smallest global index along each axis of the local and ghost nodes
+  int box_n[3];          ///< number of global indices along each axis spanned by the local and ghost nodes
+  vector<int> map_box;   ///< local index of each node of that box, -1 if the node is not on this CPU
 
   int nx;                ///< number of nodes along x on this CPU
   int ny;                ///< number of nodes along y on this CPU
@@ -95,6 +108,11 @@ class Grid : protected Pointers {
   vector<double> Qext;              ///< nodes' external thermal driving force
   vector<double> Qint;              ///< nodes' internal thermal driving force
 
+  vector<int> nblock;               ///< block of GRID_BLOCK^dimension nodes each node belongs to
+  vector<int> active_nodes;         ///< nodes of the active blocks, the only ones the P2G, grid updates and node fixes loop over
+  vector<char> exchanged;           ///< is the node shared with or a ghost of another CPU? Its P2G values are only complete once reduced
+  vector<char> exchange_active;     ///< is the exchanged node near particles on one of the CPUs holding it? Only these are reduced
+
   MPI_Datatype Pointtype;           ///< MPI type for struct Point
 
   Grid(class MPM *);
@@ -103,15 +121,83 @@ class Grid : protected Pointers {
   void grow_ghosts(int);       ///< Allocate memory for the vectors used for ghost nodes or resize them
   void setup(string);
   void init(double*, double*); ///< Create the array of nodes. Give them their position, tag, and type
+  void rebuild(double*, double*); ///< Create the nodes again after the boundaries of the sub-domain moved
 
   void reduce_mass_ghost_nodes();                  ///< Reduce the mass of all the ghost nodes from that computed on each CPU.
   void reduce_mass_ghost_nodes_old();              ///< Deprecated
   void reduce_rigid_ghost_nodes();                 ///< Reduce the rigid bool of all the ghost nodes from that computed on each CPU.
   void reduce_ghost_nodes(bool reduce_v, bool reduce_forces, bool temp = false);    ///< Reduce the force and velocities of all the ghost nodes from that computed on each CPU.
   void reduce_ghost_nodes_old(bool only_v = false, bool temp = false);    ///< Deprecated
+  void reduce_ghost_nodes_begin(int);              ///< Start the reduction of a combination of GhostQuantities without waiting for it to complete.
+  void reduce_ghost_nodes_end();                   ///< Complete the reduction started by reduce_ghost_nodes_begin().
   void update_grid_velocities();                   ///< Determine the temporary grid velocities \f$\tilde{v}_{n}\f$. 
   void update_grid_positions();                    ///< Determine the new position of the grid nodes.
   void update_grid_temperature();                  ///< Determine the temporary grid temperature \f$\tilde{T}_{n}\f$.
+  void update_active_blocks();                     ///< Activate the blocks of nodes neighbouring the particles of the solids using this grid.
+
+  /// Local index of the node of global indices (i, j, k), -1 if it is not on this CPU
+  int local_index(int i, int j, int k) const {
+    i -= box_lo[0];
+    j -= box_lo[1];
+    k -= box_lo[2];
+    if (i < 0 || i >= box_n[0] || j < 0 || j >= box_n[1] || k < 0 || k >= box_n[2])
+      return -1;
+    return map_box[((size_t) i * box_n[1] + j) * box_n[2] + k];
+  }
+
+  /// Global indices along each axis of the node of tag ntag
+  void global_indices(tagint tag, int *ijk) const {
+    ijk[0] = tag / ((tagint) nz_global * ny_global);
+    ijk[1] = (tag / nz_global) % ny_global;
+    ijk[2] = tag % nz_global;
+  }
+
+  /// Local index of the node of tag ntag, -1 if it is not on this CPU
+  int local_index(tagint tag) const {
+    int ijk[3];
+    global_indices(tag, ijk);
+    return local_index(ijk[0], ijk[1], ijk[2]);
+  }
+
+ private:
+  friend class GridExchange;
+
+  /*! Persistent communications used to reduce one combination of GhostQuantities.
+   */
+  struct GhostExchange {
+    int nsend;                            ///< Number of doubles per node
+    vector<double> buf_shared;            ///< Contributions received for the shared nodes, then their reduced values sent back
+    vector<double> buf_ghost;             ///< Contributions of the ghost nodes sent to their owner, then their reduced values
+    vector<MPI_Request> reduce_recv;      ///< Receive the contributions to the shared nodes (one per CPU in shared_procs)
+    vector<MPI_Request> reduce_send;      ///< Send the contributions of the ghost nodes (one per CPU in ghost_procs)
+    vector<MPI_Request> update_send;      ///< Send the reduced values of the shared nodes
+    vector<MPI_Request> update_recv;      ///< Receive the reduced values of the ghost nodes
+  };
+
+  vector<int> shared_procs;               ///< CPUs holding ghosts of local nodes (keys of dest_nshared)
+  vector<int> shared_offset;              ///< Nodes shared with shared_procs[k] are shared_nodes[shared_offset[k]] to shared_nodes[shared_offset[k + 1] - 1]
+  vector<int> shared_nodes;               ///< Local index of the nodes of dest_nshared
+  vector<int> ghost_procs;                ///< CPUs owning ghost nodes of this CPU (keys of origin_nshared)
+  vector<int> ghost_offset;               ///< Ghost nodes owned by ghost_procs[k] are ghost_nodes[ghost_offset[k]] to ghost_nodes[ghost_offset[k + 1] - 1]
+  vector<int> ghost_nodes;                ///< Local index of the nodes of origin_nshared
+  map<int, GhostExchange> ghost_exchanges; ///< Persistent communications, created on first use for each combination of GhostQuantities
+  int pending_exchange;                   ///< GhostQuantities of the reduction in progress (-1 if none)
+  int exchange_tag;                       ///< MPI tag of the messages of this grid (each grid has its own)
+  int exchange_version;                   ///< Changes each time the lists of shared and ghost nodes are built
+
+  vector<int> block_offset;               ///< Nodes of block b are block_nodes[block_offset[b]] to block_nodes[block_offset[b + 1] - 1]
+  vector<int> block_nodes;                ///< List of the nodes of each block, stored contiguously block after block
+  vector<char> block_active;              ///< Is the block active?
+
+  void setup_blocks();                    ///< Group the nodes in blocks and activate all of them.
+  void map_local_nodes();                 ///< Build map_box from the tags of the local and ghost nodes.
+  void setup_ghost_exchange();            ///< Build the index lists of the shared and ghost nodes.
+  void free_ghost_exchanges();            ///< Free the persistent communications.
+  GhostExchange &ghost_exchange(int);     ///< Get or create the persistent communications for a combination of GhostQuantities.
+  static int ghost_values_size(int);      ///< Number of doubles per node packed for a combination of GhostQuantities.
+  void pack_ghost_values(int, int, double *);
+  void add_ghost_values(int, int, const double *);
+  void set_ghost_values(int, int, const double *);
 };
 
 #endif
@@ -0,0 +1,215 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "grid_exchange.h"
+#include "error.h"
+#include "timer.h"
+#include "universe.h"
+
+using namespace std;
+
+GridExchange::GridExchange(MPM *mpm) : Pointers(mpm)
+{
+  MPI_Comm_dup(universe->uworld, &comm);
+  pending_exchange = -1;
+}
+
+GridExchange::~GridExchange()
+{
+  free_exchanges();
+  MPI_Comm_free(&comm);
+}
+
+/*! The nodes exchanged with each CPU are listed grid after grid, in the order
+ * of the grids and, within a grid, in the order of Grid::shared_nodes and
+ * Grid::ghost_nodes, which is the same on both CPUs.
+ */
+void GridExchange::setup(const vector<Grid *> &new_grids)
+{
+  free_exchanges();
+
+  grids = new_grids;
+  versions.resize(grids.size());
+
+  map<int, vector<pair<int, int>>> shared, ghost;
+  for (size_t ig = 0; ig < grids.size(); ig++) {
+    Grid *g = grids[ig];
+    versions[ig] = g->exchange_version;
+
+    for (size_t k = 0; k < g->shared_procs.size(); k++)
+      for (int is = g->shared_offset[k]; is < g->shared_offset[k + 1]; is++)
+	shared[g->shared_procs[k]].push_back(make_pair(ig, g->shared_nodes[is]));
+
+    for (size_t k = 0; k < g->ghost_procs.size(); k++)
+      for (int is = g->ghost_offset[k]; is < g->ghost_offset[k + 1]; is++)
+	ghost[g->ghost_procs[k]].push_back(make_pair(ig, g->ghost_nodes[is]));
+  }
+
+  shared_procs.clear();
+  shared_nodes.clear();
+  shared_grid.clear();
+  shared_offset.assign(1, 0);
+  for (auto &p: shared) {
+    shared_procs.push_back(p.first);
+    for (auto &n: p.second) {
+      shared_grid.push_back(n.first);
+      shared_nodes.push_back(n.second);
+    }
+    shared_offset.push_back(shared_nodes.size());
+  }
+
+  ghost_procs.clear();
+  ghost_nodes.clear();
+  ghost_grid.clear();
+  ghost_offset.assign(1, 0);
+  for (auto &p: ghost) {
+    ghost_procs.push_back(p.first);
+    for (auto &n: p.second) {
+      ghost_grid.push_back(n.first);
+      ghost_nodes.push_back(n.second);
+    }
+    ghost_offset.push_back(ghost_nodes.size());
+  }
+}
+
+void GridExchange::free_exchanges()
+{
+  for (auto &ie: exchanges) {
+    for (auto &r: ie.second.reduce_recv) MPI_Request_free(&r);
+    for (auto &r: ie.second.reduce_send) MPI_Request_free(&r);
+    for (auto &r: ie.second.update_send) MPI_Request_free(&r);
+    for (auto &r: ie.second.update_recv) MPI_Request_free(&r);
+  }
+  exchanges.clear();
+}
+
+Grid::GhostExchange &GridExchange::exchange(int quantities)
+{
+  auto it = exchanges.find(quantities);
+  if (it != exchanges.end())
+    return it->second;
+
+  Grid::GhostExchange &ge = exchanges[quantities];
+
+  ge.nsend = Grid::ghost_values_size(quantities);
+
+  int n = ge.nsend;
+  ge.buf_shared.resize(n * shared_nodes.size());
+  ge.buf_ghost.resize(n * ghost_nodes.size());
+  ge.reduce_recv.resize(shared_procs.size());
+  ge.update_send.resize(shared_procs.size());
+  ge.reduce_send.resize(ghost_procs.size());
+  ge.update_recv.resize(ghost_procs.size());
+
+  for (size_t k = 0; k < shared_procs.size(); k++) {
+    double *buf = ge.buf_shared.data() + n * shared_offset[k];
+    int size = n * (shared_offset[k + 1] - shared_offset[k]);
+    MPI_Recv_init(buf, size, MPI_DOUBLE, shared_procs[k], 0, comm, &ge.reduce_recv[k]);
+    MPI_Send_init(buf, size, MPI_DOUBLE, shared_procs[k], 1, comm, &ge.update_send[k]);
+  }
+
+  for (size_t k = 0; k < ghost_procs.size(); k++) {
+    double *buf = ge.buf_ghost.data() + n * ghost_offset[k];
+    int size = n * (ghost_offset[k + 1] - ghost_offset[k]);
+    MPI_Send_init(buf, size, MPI_DOUBLE, ghost_procs[k], 0, comm, &ge.reduce_send[k]);
+    MPI_Recv_init(buf, size, MPI_DOUBLE, ghost_procs[k], 1, comm, &ge.update_recv[k]);
+  }
+
+  return ge;
+}
+
+/*! All the CPUs must pass the same grids in the same order.
+ * As with Grid::reduce_ghost_nodes_begin(), the P2G of the nodes of the grids that
+ * are not exchanged can be done before calling reduce_ghost_nodes_end().
+ */
+void GridExchange::reduce_ghost_nodes_begin(const vector<Grid *> &new_grids, int quantities)
+{
+  if (pending_exchange != -1)
+    error->one(FLERR, "Error: a reduction of the ghost nodes is already in progress on these grids.\n");
+
+  bool changed = new_grids != grids;
+  for (size_t ig = 0; !changed && ig < grids.size(); ig++)
+    changed = grids[ig]->exchange_version != versions[ig];
+  if (changed)
+    setup(new_grids);
+
+  pending_exchange = quantities;
+  if (shared_procs.empty() && ghost_procs.empty())
+    return;
+
+  timer->start(Timer::GHOST_NODES);
+
+  Grid::GhostExchange &ge = exchange(quantities);
+
+  if (!ge.reduce_recv.empty())
+    MPI_Startall(ge.reduce_recv.size(), ge.reduce_recv.data());
+
+  for (size_t k = 0; k < ghost_procs.size(); k++) {
+    for (int is = ghost_offset[k]; is < ghost_offset[k + 1]; is++)
+      grids[ghost_grid[is]]->pack_ghost_values(quantities, ghost_nodes[is], &ge.buf_ghost[ge.nsend * is]);
+    MPI_Start(&ge.reduce_send[k]);
+  }
+
+  timer->stop();
+}
+
+/*! Same steps as Grid::reduce_ghost_nodes_end(), each node being unpacked
+ * into its own grid.
+ */
+void GridExchange::reduce_ghost_nodes_end()
+{
+  if (pending_exchange == -1)
+    error->one(FLERR, "Error: no reduction of the ghost nodes is in progress on these grids.\n");
+
+  int quantities = pending_exchange;
+  pending_exchange = -1;
+  if (shared_procs.empty() && ghost_procs.empty())
+    return;
+
+  timer->start(Timer::GHOST_NODES);
+
+  Grid::GhostExchange &ge = exchanges[quantities];
+
+  // 1. Add the contributions of the other CPUs to the shared nodes:
+  for (size_t k = 0; k < shared_procs.size(); k++) {
+    MPI_Wait(&ge.reduce_recv[k], MPI_STATUS_IGNORE);
+    for (int is = shared_offset[k]; is < shared_offset[k + 1]; is++)
+      grids[shared_grid[is]]->add_ghost_values(quantities, shared_nodes[is], &ge.buf_shared[ge.nsend * is]);
+  }
+
+  if (!ge.reduce_send.empty())
+    MPI_Waitall(ge.reduce_send.size(), ge.reduce_send.data(), MPI_STATUSES_IGNORE);
+
+  if (!ge.update_recv.empty())
+    MPI_Startall(ge.update_recv.size(), ge.update_recv.data());
+
+  // 2. Send the reduced values of the shared nodes:
+  for (size_t k = 0; k < shared_procs.size(); k++) {
+    for (int is = shared_offset[k]; is < shared_offset[k + 1]; is++)
+      grids[shared_grid[is]]->pack_ghost_values(quantities, shared_nodes[is], &ge.buf_shared[ge.nsend * is]);
+    MPI_Start(&ge.update_send[k]);
+  }
+
+  // 3. Overwrite the ghost nodes with the reduced values:
+  for (size_t i = 0; i < ghost_procs.size(); i++) {
+    int k;
+    MPI_Waitany(ge.update_recv.size(), ge.update_recv.data(), &k, MPI_STATUS_IGNORE);
+    for (int is = ghost_offset[k]; is < ghost_offset[k + 1]; is++)
+      grids[ghost_grid[is]]->set_ghost_values(quantities, ghost_nodes[is], &ge.buf_ghost[ge.nsend * is]);
+  }
+
+  if (!ge.update_send.empty())
+    MPI_Waitall(ge.update_send.size(), ge.update_send.data(), MPI_STATUSES_IGNORE);
+
+  timer->stop();
+}
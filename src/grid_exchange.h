@@ -0,0 +1,66 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_GRID_EXCHANGE_H
+#define MPM_GRID_EXCHANGE_H
+
+#include "grid.h"
+#include "pointers.h"
+#include <map>
+#include <mpi.h>
+#include <vector>
+
+/*! Reduction of the ghost nodes of several grids at once, such as the grids of the solids
+ * of the total Lagrangian methods.
+ *
+ * Grid::reduce_ghost_nodes_begin() sends one message per grid to each neighbouring CPU.
+ * Here the values of the shared and ghost nodes of all the grids exchanged with the same
+ * CPU are packed one grid after the other into a single message, so that each phase
+ * of the reduction costs one message per neighbouring CPU whatever the number of grids.
+ *
+ * The node lists are taken from the grids (Grid::shared_nodes and Grid::ghost_nodes), and
+ * built again whenever the set of grids changes or one of them is initialised again.
+ * The values of each node are summed in the same order as with Grid::reduce_ghost_nodes_end(),
+ * so that the results are identical.
+ */
+class GridExchange : protected Pointers {
+ public:
+  GridExchange(class MPM *);
+  ~GridExchange();
+
+  void reduce_ghost_nodes_begin(const vector<Grid *> &, int); ///< Start the reduction of a combination of Grid::GhostQuantities on all the grids.
+  void reduce_ghost_nodes_end();                              ///< Complete the reduction started by reduce_ghost_nodes_begin().
+
+ private:
+  MPI_Comm comm;                          ///< Communicator of the exchanges, so that their messages cannot match those of the grids
+  vector<Grid *> grids;                   ///< Grids of the node lists
+  vector<int> versions;                   ///< Grid::exchange_version of each grid when the lists were built
+
+  vector<int> shared_procs;               ///< CPUs holding ghosts of local nodes of any grid
+  vector<int> shared_offset;              ///< Nodes shared with shared_procs[k] are shared_nodes[shared_offset[k]] to shared_nodes[shared_offset[k + 1] - 1]
+  vector<int> shared_nodes;               ///< Local index of the shared nodes in their grid
+  vector<int> shared_grid;                ///< Index in grids of the grid of each node of shared_nodes
+  vector<int> ghost_procs;                ///< CPUs owning ghost nodes of any grid
+  vector<int> ghost_offset;               ///< Ghost nodes owned by ghost_procs[k] are ghost_nodes[ghost_offset[k]] to ghost_nodes[ghost_offset[k + 1] - 1]
+  vector<int> ghost_nodes;                ///< Local index of the ghost nodes in their grid
+  vector<int> ghost_grid;                 ///< Index in grids of the grid of each node of ghost_nodes
+
+  map<int, Grid::GhostExchange> exchanges; ///< Persistent communications, created on first use for each combination of GhostQuantities
+  int pending_exchange;                   ///< GhostQuantities of the reduction in progress (-1 if none)
+
+  void setup(const vector<Grid *> &);     ///< Build the node lists of all the grids.
+  void free_exchanges();                  ///< Free the persistent communications.
+  Grid::GhostExchange &exchange(int);     ///< Get or create the persistent communications for a combination of GhostQuantities.
+};
+
+#endif
@@ -18,6 +18,7 @@
 #include "region.h"
 #include "solid.h"
 #include "error.h"
+#include "grid.h"
 #include "universe.h"
 
 #define MAX_GROUP 32
@@ -25,6 +26,18 @@
 using namespace std;
 using namespace Eigen;
 
+/*! Positions or forces of either the particles of a solid or the nodes of its grid.
+ */
+struct GroupVectors {
+  const ParticleVectors *particles = nullptr;
+  const vector<Eigen::Vector3d> *nodes = nullptr;
+
+  GroupVectors &operator=(const ParticleVectors *v) { particles = v; nodes = nullptr; return *this; }
+  GroupVectors &operator=(const vector<Eigen::Vector3d> *v) { particles = nullptr; nodes = v; return *this; }
+
+  double operator()(int i, int d) const { return particles ? (*particles)[i][d] : (*nodes)[i][d]; }
+};
+
 Group::Group(MPM *mpm) : Pointers(mpm)
 {
   names       = new string[MAX_GROUP];
@@ -119,7 +132,7 @@ void Group::assign(vector<string> args)
 	for (int isolid = 0; isolid < domain->solids.size(); isolid++)
 	  {
 
-	    vector<Eigen::Vector3d> *x;
+	    GroupVectors x;
 	    int nmax;
 	    vector<int> *mask;
 
@@ -151,7 +164,7 @@ void Group::assign(vector<string> args)
 
 	    for (int ip = 0; ip < nmax; ip++)
 	      {
-		if (domain->regions[region[igroup]]->match((*x)[ip][0],(*x)[ip][1],(*x)[ip][2]))
+		if (domain->regions[region[igroup]]->match(x(ip, 0),x(ip, 1),x(ip, 2)))
 		  {
 		    (*mask)[ip] |= bit;
 		    n++;
@@ -177,7 +190,7 @@ void Group::assign(vector<string> args)
 	      error->all(FLERR, "Error: cannot find solid with ID " + args[i] + ".\n");
 	    }
 
-	    vector<Eigen::Vector3d> *x;
+	    GroupVectors x;
 	    int nmax;
 	    vector<int> *mask;
 
@@ -207,7 +220,7 @@ void Group::assign(vector<string> args)
 
 	    for (int ip = 0; ip < nmax; ip++)
 	      {
-		if (domain->regions[region[igroup]]->match((*x)[ip][0],(*x)[ip][1],(*x)[ip][2])) {
+		if (domain->regions[region[igroup]]->match(x(ip, 0),x(ip, 1),x(ip, 2))) {
 		  (*mask)[ip] |= bit;
 		  n++;
 		}
@@ -258,9 +271,27 @@ int Group::find_unused()
   return -1;
 }
 
+/*! Node groups are defined by a region, so the nodes that lie in it are found again.
+ * Only used with updated Lagrangian methods, whose nodes do not move.
+ */
+void Group::update_node_masks(Grid *grid)
+{
+  int nmax = grid->nnodes_local + grid->nnodes_ghost;
+
+  for (int igroup = 0; igroup < MAX_GROUP; igroup++)
+    {
+      if (names[igroup] == "" || pon[igroup] != "nodes" || region[igroup] < 0)
+	continue;
+
+      for (int ip = 0; ip < nmax; ip++)
+	if (domain->regions[region[igroup]]->match(grid->x0[ip][0], grid->x0[ip][1], grid->x0[ip][2]))
+	  grid->mask[ip] |= bitmask[igroup];
+    }
+}
+
 double Group::xcm(int igroup, int dir)
 {
-  vector<Eigen::Vector3d> *x;
+  GroupVectors x;
   vector<double> *mass;
   int nmax;
   vector<int> *mask;
@@ -293,7 +324,7 @@ double Group::xcm(int igroup, int dir)
 	  {
 	    if ((*mask)[ip] & groupbit)
 	      {
-		com += (*x)[ip][dir] * (*mass)[ip];
+		com += x(ip, dir) * (*mass)[ip];
 		mass_tot += (*mass)[ip];
 	      }
 	  }
@@ -322,7 +353,7 @@ double Group::xcm(int igroup, int dir)
 	{
 	  if ((*mask)[ip] & groupbit)
 	    {
-	      com += (*x)[ip][dir] * (*mass)[ip];
+	      com += x(ip, dir) * (*mass)[ip];
 	      mass_tot += (*mass)[ip];
 	    }
 	}
@@ -340,7 +371,7 @@ double Group::xcm(int igroup, int dir)
 double Group::internal_force(int igroup, int dir)
 {
   
-  vector<Eigen::Vector3d> *f;
+  GroupVectors f;
   int nmax;
   vector<int> *mask;
   double resulting_force = 0;
@@ -369,7 +400,7 @@ double Group::internal_force(int igroup, int dir)
 	  {
 	    if ((*mask)[ip] & groupbit)
 	      {
-		resulting_force += (*f)[ip][dir];
+		resulting_force += f(ip, dir);
 	      }
       }
     }
@@ -395,7 +426,7 @@ double Group::internal_force(int igroup, int dir)
       {
 	if ((*mask)[ip] & groupbit)
 	  {
-	    resulting_force += (*f)[ip][dir];
+	    resulting_force += f(ip, dir);
       }
     }
   }
@@ -415,7 +446,7 @@ double Group::external_force(int igroup, int dir)
 		 + names[igroup] + ".\n");
     }
   
-  vector<Eigen::Vector3d> *f;
+  GroupVectors f;
   int nmax;
   vector<int> *mask;
   double resulting_force = 0;
@@ -435,7 +466,7 @@ double Group::external_force(int igroup, int dir)
 	  {
 	    if ((*mask)[ip] & groupbit)
 	      {
-		resulting_force += (*f)[ip][dir];
+		resulting_force += f(ip, dir);
 	      }
       }
     }
@@ -452,7 +483,7 @@ double Group::external_force(int igroup, int dir)
       {
 	if ((*mask)[ip] & groupbit)
 	  {
-	    resulting_force += (*f)[ip][dir];
+	    resulting_force += f(ip, dir);
       }
     }
   }
@@ -543,7 +574,7 @@ void Group::read_restart(ifstream *ifr) {
       // Consider all solids
       for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
 
-        vector<Eigen::Vector3d> *x;
+        GroupVectors x;
         int nmax;
         vector<int> *mask;
 
@@ -569,8 +600,8 @@ void Group::read_restart(ifstream *ifr) {
         int n = 0;
 
         for (int ip = 0; ip < nmax; ip++) {
-          if (domain->regions[region[igroup]]->match((*x)[ip][0], (*x)[ip][1],
-                                              (*x)[ip][2])) {
+          if (domain->regions[region[igroup]]->match(x(ip, 0), x(ip, 1),
+                                              x(ip, 2))) {
             (*mask)[ip] |= bitmask[igroup];
             n++;
           }
@@ -585,7 +616,7 @@ void Group::read_restart(ifstream *ifr) {
 	}
       }
     } else {
-      vector<Eigen::Vector3d> *x;
+      GroupVectors x;
       int nmax;
       vector<int> *mask;
 
@@ -611,8 +642,8 @@ void Group::read_restart(ifstream *ifr) {
       int n = 0;
 
       for (int ip = 0; ip < nmax; ip++) {
-        if (domain->regions[region[igroup]]->match((*x)[ip][0], (*x)[ip][1],
-                                            (*x)[ip][2])) {
+        if (domain->regions[region[igroup]]->match(x(ip, 0), x(ip, 1),
+                                            x(ip, 2))) {
           (*mask)[ip] |= bitmask[igroup];
           n++;
         }
@@ -37,6 +37,7 @@ public:
   void assign(vector<string>); ///< Assign atoms to a new or existing group
   int find(string);            ///< Return group index
   int find_unused();           ///< Return index of first available group
+  void update_node_masks(class Grid *); ///< Assign the nodes of a grid that was created again to their groups
 
   double xcm(int, int);        ///< Determine the centre of mass of a group
   double internal_force(
@@ -23,9 +23,11 @@
 #include "output.h"
 #include "scheme.h"
 #include "style_command.h"
+#include "timer.h"
 #include "universe.h"
 #include "update.h"
 #include "var.h"
+#include "writer.h"
 #include <fstream>
 #include <iostream>
 #include <map>
@@ -33,6 +35,9 @@
 #include <mpi.h>
 #include <stack>
 #include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define DELTALINE 256
 #define DELTA 4
@@ -323,6 +328,16 @@ Var Input::evaluate_function(string func, string arg){
     return Var(set_dt_factor(args));
   if (func.compare("set_dt") == 0)
     return Var(set_dt(args));
+  if (func.compare("set_num_threads") == 0)
+    return Var(set_num_threads(args));
+  if (func.compare("sort_particles") == 0)
+    return Var(sort_particles(args));
+  if (func.compare("balance") == 0)
+    return Var(balance(args));
+  if (func.compare("timer") == 0)
+    return Var(set_timer(args));
+  if (func.compare("output_buffer") == 0)
+    return Var(set_output_buffer(args));
   if (func.compare("value") == 0)
     return value(args);
   if (func.compare("plot") == 0)
@@ -851,6 +866,67 @@ int Input::set_dt(vector<string> args) {
   return 0;
 }
 
+/*! Sets the number of OpenMP threads used by each MPI process.\n
+ * Syntax: set_num_threads(N)\n
+ * It has no effect if Karamelo was compiled without OpenMP (cmake -DUSE_OPENMP=ON).
+ */
+int Input::set_num_threads(vector<string> args) {
+  if (args.size() != 1) {
+    error->all(FLERR, "Error: set_num_threads() needs exactly one argument: set_num_threads(N).\n");
+  }
+
+  int n = (int) parsev(args[0]).result(mpm);
+
+  if (n < 1) {
+    error->all(FLERR, "Error: the number of threads given to set_num_threads() must be at least 1.\n");
+  }
+
+#ifdef _OPENMP
+  omp_set_num_threads(n);
+  if (universe->me == 0)
+    cout << "Using " << n << " OpenMP threads per process\n";
+#else
+  if (universe->me == 0 && n > 1)
+    cout << "Warning: Karamelo was compiled without OpenMP, set_num_threads() is ignored.\n";
+#endif
+  return 0;
+}
+
+/*! Reorders the particles in memory along a Morton curve every N steps.\n
+ * Syntax: sort_particles(N)\n
+ * Improves cache locality in updated Lagrangian simulations where particles move across the grid.
+ */
+int Input::sort_particles(vector<string> args) {
+  update->set_sort_every(args);
+  return 0;
+}
+
+/*! Moves the boundaries between the CPU sub-domains to share the particles evenly.\n
+ * Syntax: balance(N, threshold)\n
+ * Every N steps, the sub-domains are balanced if the largest number of particles held by a CPU
+ * exceeds the average by more than the factor threshold.
+ */
+int Input::balance(vector<string> args) {
+  domain->set_balance(args);
+  return 0;
+}
+
+/*! Reports the time spent in each phase of the time step every N steps, on top of the end of each run.\n
+ * Syntax: timer(N)
+ */
+int Input::set_timer(vector<string> args) {
+  timer->set_every(args);
+  return 0;
+}
+
+/*! Sets how many megabytes of dump and restart files each CPU can queue while they are written in the background.\n
+ * Syntax: output_buffer(size)
+ */
+int Input::set_output_buffer(vector<string> args) {
+  output->writer->set_max_size(args);
+  return 0;
+}
+
 /* The returned value is a constant user-variables that will no longer change.
  */
 Var Input::value(vector<string> args) {
@@ -80,6 +80,11 @@ private:
   int delete_compute(vector<string>);        ///< Deletes a compute.
   int set_dt_factor(vector<string>);         ///< Sets the factor to be applied to the CFL timestep
   int set_dt(vector<string>);                ///< Sets the timestep
+  int set_num_threads(vector<string>);       ///< Sets the number of OpenMP threads used by each process
+  int sort_particles(vector<string>);        ///< Sets the interval between spatial sorts of the particles
+  int balance(vector<string>);               ///< Sets the interval between load balancing of the CPU sub-domains
+  int set_timer(vector<string>);             ///< Sets the interval between reports of the timings
+  int set_output_buffer(vector<string>);     ///< Sets the size of the queue of files written in the background
   class Var value(vector<string>);           ///< Returns the current value of a user variable.
   int plot(vector<string>);                  ///< Add a curve to be plotted.
   int save_plot(vector<string>);             ///< Save the plot as ...
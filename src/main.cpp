@@ -20,7 +20,13 @@
 
 int main(int argc, char **argv) {
 
-  MPI_Init(&argc,&argv);                        /// Initialized MPI
+  // Only the main thread calls MPI, the OpenMP and writer threads do not:
+  int provided;
+  MPI_Init_thread(&argc,&argv,MPI_THREAD_FUNNELED,&provided); /// Initialized MPI
+  if (provided < MPI_THREAD_FUNNELED) {
+    fprintf(stderr, "ERROR: the MPI library does not support MPI_THREAD_FUNNELED\n");
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
 
   MPM *mpm = new MPM(argc,argv,MPI_COMM_WORLD); /// Create the MPM entity
   mpm->input->file();                           /// Read input file and execute commands
@@ -13,10 +13,15 @@
 
 #include "modify.h"
 #include "compute.h"
+#include "domain.h"
 #include "error.h"
 #include "fix.h"
+#include "ghost_particles.h"
+#include "solid.h"
 #include "style_compute.h"
 #include "style_fix.h"
+#include "timer.h"
+#include "universe.h"
 #include "update.h"
 
 using namespace FixConst;
@@ -24,6 +29,7 @@ using namespace FixConst;
 Modify::Modify(MPM *mpm) : Pointers(mpm)
 {
   end_of_step_every = nullptr;
+  ghost_particles = false;
 
   list_timeflag = nullptr;
 
@@ -78,9 +84,30 @@ Modify::~Modify()
 
 void Modify::init()
 {
+  // fixes requiring ghost particles set the cutoff of the solids they need them for
+
+  for (int i = 0; i < domain->solids.size(); i++)
+    domain->solids[i]->ghost_cutoff = 0;
+
   for (int i = 0; i < fix.size(); i++) fix[i]->init();
   for (int i = 0; i < compute.size(); i++) compute[i]->init();
 
+  ghost_particles = false;
+  for (int i = 0; i < fix.size(); i++)
+    if (fix[i]->requires_ghost_particles) ghost_particles = true;
+
+  if (ghost_particles && universe->nprocs > 1) {
+    for (int i = 0; i < domain->solids.size(); i++) {
+      Solid *s = domain->solids[i];
+      if (s->ghost_cutoff > 0 && s->ghosts == nullptr)
+	s->ghosts = new GhostParticles(mpm, s);
+    }
+  }
+
+  fix_timer.resize(fix.size());
+  for (int i = 0; i < fix.size(); i++)
+    fix_timer[i] = timer->find("fix " + fix[i]->id);
+
   list_init(INITIAL_INTEGRATE, list_initial_integrate);
   list_init(POST_PARTICLES_TO_GRID, list_post_particles_to_grid);
   list_init(POST_UPDATE_GRID_STATE, list_post_update_grid_state);
@@ -242,8 +269,29 @@ void Modify::list_init(int mask, vector<int> &list) {
 
 void Modify::initial_integrate()
 {
-  for (int i = 0; i < list_initial_integrate.size(); i++)
+  if (ghost_particles) {
+    timer->start(Timer::GHOST_PARTICLES);
+    for (int i = 0; i < domain->solids.size(); i++)
+      if (domain->solids[i]->ghosts && domain->solids[i]->ghost_cutoff > 0)
+	domain->solids[i]->ghosts->forward();
+    timer->stop();
+  }
+
+  for (int i = 0; i < list_initial_integrate.size(); i++) {
+    timer->start(fix_timer[list_initial_integrate[i]]);
     fix[list_initial_integrate[i]]->initial_integrate();
+    timer->stop();
+  }
+
+  // forces and heat sources accumulated on ghost particles go back to their owners
+
+  if (ghost_particles) {
+    timer->start(Timer::GHOST_PARTICLES);
+    for (int i = 0; i < domain->solids.size(); i++)
+      if (domain->solids[i]->ghosts && domain->solids[i]->ghost_cutoff > 0)
+	domain->solids[i]->ghosts->reverse();
+    timer->stop();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -252,8 +300,11 @@ void Modify::initial_integrate()
 
 void Modify::post_particles_to_grid()
 {
-  for (int i = 0; i < list_post_particles_to_grid.size(); i++)
+  for (int i = 0; i < list_post_particles_to_grid.size(); i++) {
+    timer->start(fix_timer[list_post_particles_to_grid[i]]);
     fix[list_post_particles_to_grid[i]]->post_particles_to_grid();
+    timer->stop();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -261,8 +312,11 @@ void Modify::post_particles_to_grid()
 ------------------------------------------------------------------------- */
 
 void Modify::post_update_grid_state(){
-  for (int i = 0; i < list_post_update_grid_state.size(); i++)
+  for (int i = 0; i < list_post_update_grid_state.size(); i++) {
+    timer->start(fix_timer[list_post_update_grid_state[i]]);
     fix[list_post_update_grid_state[i]]->post_update_grid_state();
+    timer->stop();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -270,8 +324,11 @@ void Modify::post_update_grid_state(){
 ------------------------------------------------------------------------- */
 
 void Modify::post_grid_to_point(){
-  for (int i = 0; i < list_post_grid_to_point.size(); i++)
+  for (int i = 0; i < list_post_grid_to_point.size(); i++) {
+    timer->start(fix_timer[list_post_grid_to_point[i]]);
     fix[list_post_grid_to_point[i]]->post_grid_to_point();
+    timer->stop();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -279,8 +336,11 @@ void Modify::post_grid_to_point(){
 ------------------------------------------------------------------------- */
 
 void Modify::post_advance_particles(){
-  for (int i = 0; i < list_post_advance_particles.size(); i++)
+  for (int i = 0; i < list_post_advance_particles.size(); i++) {
+    timer->start(fix_timer[list_post_advance_particles[i]]);
     fix[list_post_advance_particles[i]]->post_advance_particles();
+    timer->stop();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -288,8 +348,11 @@ void Modify::post_advance_particles(){
 ------------------------------------------------------------------------- */
 
 void Modify::post_velocities_to_grid(){
-  for (int i = 0; i < list_post_velocities_to_grid.size(); i++)
+  for (int i = 0; i < list_post_velocities_to_grid.size(); i++) {
+    timer->start(fix_timer[list_post_velocities_to_grid[i]]);
     fix[list_post_velocities_to_grid[i]]->post_velocities_to_grid();
+    timer->stop();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -297,8 +360,11 @@ void Modify::post_velocities_to_grid(){
 ------------------------------------------------------------------------- */
 
 void Modify::final_integrate(){
-  for (int i = 0; i < list_final_integrate.size(); i++)
+  for (int i = 0; i < list_final_integrate.size(); i++) {
+    timer->start(fix_timer[list_final_integrate[i]]);
     fix[list_final_integrate[i]]->final_integrate();
+    timer->stop();
+  }
 }
 
 
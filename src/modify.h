@@ -32,6 +32,8 @@ public:
 
   vector<class Compute *> compute; // list of computes
 
+  bool ghost_particles;     // true if a fix requires ghost particles
+
   Modify(class MPM *);
   virtual ~Modify();
   virtual void init();
@@ -77,6 +79,7 @@ protected:
   vector<int> list_post_advance_particles;
   vector<int> list_post_velocities_to_grid;
   vector<int> list_final_integrate;
+  vector<int> fix_timer;        // Timer phase of each fix
 
   int *end_of_step_every;
 
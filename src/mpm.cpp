@@ -24,9 +24,13 @@
 #include "modify.h"
 #include "memory.h"
 #include "group.h"
+#include "timer.h"
 #include "universe.h"
 #include "error.h"
 #include "version.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 MPM::MPM(int narg, char **arg, MPI_Comm communicator)
 {
@@ -41,6 +45,7 @@ MPM::MPM(int narg, char **arg, MPI_Comm communicator)
   material = new Material(this);
   modify = new Modify(this);
   group = new Group(this);
+  timer = new Timer(this);
 
   initclock = MPI_Wtime();
 
@@ -75,6 +80,9 @@ MPM::MPM(int narg, char **arg, MPI_Comm communicator)
     cout << "Karamelo -- Parallel Material Point Methods Simulator Build SHA1:"
          << Version::GIT_SHA1 << endl;
     cout << "Running on " << universe->nprocs << " procs\n";
+#ifdef _OPENMP
+    cout << "with " << omp_get_max_threads() << " OpenMP threads per proc\n";
+#endif
 
     if (inflag != 0)
       {
@@ -107,6 +115,7 @@ MPM::~MPM()
   delete material;
   delete modify;
   delete group;
+  delete timer;
 
   double totalclock = MPI_Wtime() - initclock;
 
@@ -37,6 +37,7 @@ class Material;
 class Update;
 class Modify;
 class Group;
+class Timer;
 
 class MPM {
 
@@ -53,6 +54,7 @@ class MPM {
   Update *update;          ///< pointer to update 
   Modify *modify;          ///< fixes and computes
   Group *group;            ///< groups of particles
+  Timer *timer;            ///< timings of the phases of the time step
 
   MPI_Comm world;                ///< MPI communicator
   double initclock;              ///< wall clock at instantiation
@@ -15,6 +15,7 @@
 #ifndef MPM_MATH_H_
 #define MPM_MATH_H_
 
+#include "mpm_math_3x3.h"
 #include <Eigen/Eigen>
 #include <iostream>
 using namespace Eigen;
@@ -51,9 +52,12 @@ static inline Matrix2d Deviator(const Matrix2d M) {
  * In this case, the inversion direction is heuristically identified with the eigenvector of the smallest entry of S, which should work for most cases.
  * The sign of this corresponding eigenvalue is flipped, the original matrix M is recomputed using the flipped S, and the rotation and translation matrices are
  * obtained again from an SVD. The rotation should proper now, i.e., det(R) = +1.
+ *
+ * PolDec() obtains S and V in closed form from the eigen decomposition of M^T M, and R = M V S^-1 V^T.
+ * It falls back on PolDecSVD() when M is too ill-conditioned for this to be accurate.
  */
 
-static inline bool PolDec(Matrix3d M, Matrix3d &R, Matrix3d &T, bool scaleF) {
+static inline bool PolDecSVD(Matrix3d M, Matrix3d &R, Matrix3d &T, bool scaleF) {
 
 	JacobiSVD<Matrix3d> svd(M, ComputeFullU | ComputeFullV); // SVD(A) = U S V*
 	Vector3d S_eigenvalues = svd.singularValues();
@@ -101,7 +105,7 @@ static inline bool PolDec(Matrix3d M, Matrix3d &R, Matrix3d &T, bool scaleF) {
 	}
 }
 
-static inline bool PolDec(Matrix3d M, Matrix3d &R) {
+static inline bool PolDecSVD(Matrix3d M, Matrix3d &R) {
 
   JacobiSVD<Matrix3d> svd(M, ComputeFullU | ComputeFullV); // SVD(A) = U S V*
   Vector3d S_eigenvalues = svd.singularValues();
@@ -132,17 +136,68 @@ static inline bool PolDec(Matrix3d M, Matrix3d &R) {
   }
 }
 
+static inline bool PolDec(const Matrix3d &M, Matrix3d &R, Matrix3d &T, bool scaleF) {
+
+  Vector3d S;
+  Matrix3d V;
+  if (!SingularValues3x3(M, S, V))
+    return PolDecSVD(M, R, T, scaleF);
+
+  R = M * V * S.cwiseInverse().asDiagonal() * V.transpose();
+  T = V * S.asDiagonal() * V.transpose();
+
+  if (R.determinant() < 0.0) { // this is an improper rotation
+    // the smallest singular value is S(0): flip its sign
+    S(0) *= -1.0;
+    R = M * V * S.cwiseInverse().asDiagonal() * V.transpose();
+  }
+
+  if (scaleF) {
+    double min = 0.3;
+    double max = 2.0;
+    for (int i = 0; i < 3; i++) {
+      if (S(i) < min) {
+	S(i) = min;
+      } else if (S(i) > max) {
+	S(i) = max;
+      }
+    }
+    T = V * S.asDiagonal() * V.transpose();
+  }
+
+  return R.determinant() > 0.0;
+}
+
+static inline bool PolDec(const Matrix3d &M, Matrix3d &R) {
+
+  Vector3d S;
+  Matrix3d V;
+  if (!SingularValues3x3(M, S, V))
+    return PolDecSVD(M, R);
+
+  R = M * V * S.cwiseInverse().asDiagonal() * V.transpose();
+
+  if (R.determinant() < 0.0) { // this is an improper rotation
+    S(0) *= -1.0;
+    R = M * V * S.cwiseInverse().asDiagonal() * V.transpose();
+  }
+
+  return R.determinant() > 0.0;
+}
+
 /*
  * Pseudo-inverse via SVD
  */
 
 static inline void pseudo_inverse_SVD(Matrix3d &M) {
 
-	//JacobiSVD < Matrix3d > svd(M, ComputeFullU | ComputeFullV);
-	JacobiSVD<Matrix3d> svd(M, ComputeFullU); // one Eigevector base is sufficient because matrix is square and symmetric
-
+	// M being symmetric, its singular values are the absolute values of its eigenvalues,
+	// and its left singular vectors are its eigenvectors:
+	Matrix3d U;
 	Vector3d singularValuesInv;
-	Vector3d singularValues = svd.singularValues();
+	Vector3d singularValues;
+	SymmetricEigen(M, singularValues, U);
+	singularValues = singularValues.cwiseAbs();
 
 //cout << "Here is the matrix V:" << endl << V * singularValues.asDiagonal() * U << endl;
 //cout << "Its singular values are:" << endl << singularValues << endl;
@@ -156,7 +211,7 @@ static inline void pseudo_inverse_SVD(Matrix3d &M) {
 		}
 	}
 
-	M = svd.matrixU() * singularValuesInv.asDiagonal() * svd.matrixU().transpose();
+	M = U * singularValuesInv.asDiagonal() * U.transpose();
 
 	/*
 	 * commented version below is for non-symmetric matrices
@@ -189,10 +244,11 @@ static inline void pseudo_inverse_SVD(Matrix3d &M) {
 
 static inline void pseudo_inverse_SVD_limit_eigenvalue(Matrix3d &M, const double limit) {
 
-	JacobiSVD<Matrix3d> svd(M, ComputeFullU); // one Eigevector base is sufficient because matrix is square and symmetric
-
+	Matrix3d U;
 	Vector3d singularValuesInv;
-	Vector3d singularValues = svd.singularValues();
+	Vector3d singularValues;
+	SymmetricEigen(M, singularValues, U);
+	singularValues = singularValues.cwiseAbs();
 
 	double pinvtoler = 1.0e-16; // 2d machining example goes unstable if this value is increased (1.0e-16).
 	for (int row = 0; row < 3; row++) {
@@ -207,7 +263,7 @@ static inline void pseudo_inverse_SVD_limit_eigenvalue(Matrix3d &M, const double
 		}
 	}
 
-	M = svd.matrixU() * singularValuesInv.asDiagonal() * svd.matrixU().transpose();
+	M = U * singularValuesInv.asDiagonal() * U.transpose();
 }
 
 /*
@@ -235,7 +291,7 @@ static inline Matrix3d LimitEigenvalues(Matrix3d S, double limitEigenvalue) {
 	 * compute Eigenvalues of matrix S
 	 */
 	SelfAdjointEigenSolver<Matrix3d> es;
-	es.compute(S);
+	es.computeDirect(S);
 
 	double max_eigenvalue = es.eigenvalues().maxCoeff();
 	double min_eigenvalue = es.eigenvalues().minCoeff();
@@ -269,7 +325,7 @@ static inline bool LimitMinMaxEigenvalues(Matrix3d &S, double min, double max) {
 	 * compute Eigenvalues of matrix S
 	 */
 	SelfAdjointEigenSolver<Matrix3d> es;
-	es.compute(S);
+	es.computeDirect(S);
 
 	if ((es.eigenvalues().maxCoeff() > max) || (es.eigenvalues().minCoeff() < min)) {
 		Matrix3d S_diag = es.eigenvalues().asDiagonal();
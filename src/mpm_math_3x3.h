@@ -0,0 +1,169 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_MATH_3X3_H_
+#define MPM_MATH_3X3_H_
+
+#include <Eigen/Eigen>
+#include <math.h>
+#include <utility>
+
+using namespace Eigen;
+
+/*! Closed-form kernels for 3x3 matrices.
+ *
+ * The generic Eigen decompositions (EigenSolver, JacobiSVD, SelfAdjointEigenSolver::compute)
+ * are iterative. The functions below only use the analytic solution of the characteristic
+ * polynomial, so that they can be called for every particle at every time step.
+ */
+namespace MPM_Math {
+
+  /*! Inverse of M computed from its cofactors. Returns the determinant of M.
+   */
+  static inline double Inverse3x3(const Matrix3d &M, Matrix3d &Minv) {
+    const double c00 = M(1, 1) * M(2, 2) - M(1, 2) * M(2, 1);
+    const double c10 = M(1, 2) * M(2, 0) - M(1, 0) * M(2, 2);
+    const double c20 = M(1, 0) * M(2, 1) - M(1, 1) * M(2, 0);
+    const double det = M(0, 0) * c00 + M(0, 1) * c10 + M(0, 2) * c20;
+    const double inv_det = 1.0 / det;
+
+    Minv(0, 0) = c00 * inv_det;
+    Minv(1, 0) = c10 * inv_det;
+    Minv(2, 0) = c20 * inv_det;
+    Minv(0, 1) = (M(0, 2) * M(2, 1) - M(0, 1) * M(2, 2)) * inv_det;
+    Minv(1, 1) = (M(0, 0) * M(2, 2) - M(0, 2) * M(2, 0)) * inv_det;
+    Minv(2, 1) = (M(0, 1) * M(2, 0) - M(0, 0) * M(2, 1)) * inv_det;
+    Minv(0, 2) = (M(0, 1) * M(1, 2) - M(0, 2) * M(1, 1)) * inv_det;
+    Minv(1, 2) = (M(0, 2) * M(1, 0) - M(0, 0) * M(1, 2)) * inv_det;
+    Minv(2, 2) = (M(0, 0) * M(1, 1) - M(0, 1) * M(1, 0)) * inv_det;
+    return det;
+  }
+
+  /*! Real parts of the eigenvalues of a (not necessarily symmetric) matrix M.
+   *
+   * The characteristic polynomial is solved for the deviatoric part B = M - tr(M)/3 I,
+   * i.e. t^3 + p t + q = 0 with p the second invariant of B and q = -det(B),
+   * using Cardano's formula when it has complex roots, and the trigonometric
+   * solution when all three roots are real.
+   */
+  static inline Vector3d EigenvaluesRealParts(const Matrix3d &M) {
+    const double m = M.trace() / 3.0;
+    Matrix3d B = M;
+    B(0, 0) -= m;
+    B(1, 1) -= m;
+    B(2, 2) -= m;
+
+    const double p = B(0, 0) * B(1, 1) - B(0, 1) * B(1, 0)
+                   + B(0, 0) * B(2, 2) - B(0, 2) * B(2, 0)
+                   + B(1, 1) * B(2, 2) - B(1, 2) * B(2, 1);
+    const double q = -B.determinant();
+    const double delta = 0.25 * q * q + p * p * p / 27.0;
+
+    Vector3d re;
+    if (delta > 0) {
+      // One real root, and a pair of complex conjugate roots whose real parts are -t/2.
+      // The cube root of largest magnitude is taken first to avoid cancellations:
+      double u = cbrt(0.5 * fabs(q) + sqrt(delta));
+      if (q > 0) u = -u;
+      double t = u == 0 ? 0 : u - p / (3.0 * u);
+      re << t, -0.5 * t, -0.5 * t;
+    } else if (p < 0) {
+      double r = sqrt(-p / 3.0);
+      double c = -0.5 * q / (r * r * r);
+      c = c > 1 ? 1 : (c < -1 ? -1 : c);
+      double phi = acos(c) / 3.0;
+      re << 2 * r * cos(phi),
+	2 * r * cos(phi - 2.0 * M_PI / 3.0),
+	2 * r * cos(phi + 2.0 * M_PI / 3.0);
+    } else {
+      re.setZero();
+    }
+    re.array() += m;
+    return re;
+  }
+
+  /*! Eigenvalues (in increasing order) and orthonormal eigenvectors of a symmetric matrix S,
+   * computed in closed form.
+   *
+   * The roots of the characteristic polynomial lose half of their digits when two eigenvalues
+   * are close compared to their spread, and so do the eigenvectors derived from them, which are
+   * then neither exact nor orthogonal. In that case they are orthonormalised, and a Jacobi sweep
+   * on V^T S V, which is then nearly diagonal, brings them back to full accuracy.
+   */
+  static inline void SymmetricEigen(const Matrix3d &S, Vector3d &lambda, Matrix3d &V) {
+    SelfAdjointEigenSolver<Matrix3d> es;
+    es.computeDirect(S);
+    lambda = es.eigenvalues();
+    V = es.eigenvectors();
+
+    const double spread = lambda(2) - lambda(0);
+    if (!(fmin(lambda(1) - lambda(0), lambda(2) - lambda(1)) < 0.05 * spread))
+      return;
+
+    V.col(0).normalize();
+    V.col(1) -= V.col(0).dot(V.col(1)) * V.col(0);
+    V.col(1).normalize();
+    V.col(2) = V.col(0).cross(V.col(1));
+
+    Matrix3d D = V.transpose() * S * V;
+    for (int p = 0; p < 2; p++)
+      for (int q = p + 1; q < 3; q++) {
+	const double dpq = D(p, q);
+	if (dpq == 0)
+	  continue;
+	// Rotation of angle theta in the (p, q) plane cancelling D(p, q):
+	const double tau = (D(q, q) - D(p, p)) / (2 * dpq);
+	const double t = (tau >= 0 ? 1 : -1) / (fabs(tau) + sqrt(1 + tau * tau));
+	const double c = 1 / sqrt(1 + t * t);
+	const double s = t * c;
+	const int r = 3 - p - q;
+	const double drp = D(r, p), drq = D(r, q);
+	D(p, p) -= t * dpq;
+	D(q, q) += t * dpq;
+	D(p, q) = D(q, p) = 0;
+	D(r, p) = D(p, r) = c * drp - s * drq;
+	D(r, q) = D(q, r) = s * drp + c * drq;
+	const Vector3d vp = V.col(p);
+	V.col(p) = c * vp - s * V.col(q);
+	V.col(q) = s * vp + c * V.col(q);
+      }
+
+    // Restore the increasing order, which the sweep may have changed for close eigenvalues:
+    lambda = D.diagonal();
+    for (int i = 0; i < 2; i++)
+      for (int j = 2; j > i; j--)
+	if (lambda(j) < lambda(j - 1)) {
+	  std::swap(lambda(j), lambda(j - 1));
+	  V.col(j).swap(V.col(j - 1));
+	}
+  }
+
+  /*! Singular values (in increasing order) and right singular vectors of M, obtained from the
+   * eigen decomposition of M^T M.
+   *
+   * Squaring M squares its condition number, and the accuracy of the smallest singular values
+   * degrades accordingly. The function returns false if the ratio between the smallest and the largest
+   * eigenvalues of M^T M is below min_ratio, in which case the caller should use an SVD instead.
+   */
+  static inline bool SingularValues3x3(const Matrix3d &M, Vector3d &S, Matrix3d &V,
+				       double min_ratio = 1.0e-4) {
+    Vector3d lambda;
+    SymmetricEigen(M.transpose() * M, lambda, V);
+    if (!(lambda(0) > min_ratio * lambda(2)))
+      return false;
+    S = lambda.cwiseSqrt();
+    return true;
+  }
+}
+
+#endif
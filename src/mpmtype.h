@@ -18,3 +18,11 @@ typedef int64_t tagint;
 
 #define MPI_MPM_TAGINT MPI_INT64_T
 #define MPI_MPM_BIGINT MPI_INT64_T
+
+// OpenMP directives are written MPM_OMP(omp parallel for ...), which expands to nothing
+// when compiling without OpenMP, instead of an unknown #pragma warned about by -Wall:
+#ifdef _OPENMP
+#define MPM_OMP(x) _Pragma(#x)
+#else
+#define MPM_OMP(x)
+#endif
@@ -19,10 +19,12 @@
 #include "modify.h"
 #include "plot.h"
 #include "style_dump.h"
+#include "timer.h"
 #include "universe.h"
 #include "update.h"
 #include "var.h"
 #include "write_restart.h"
+#include "writer.h"
 
 #define MIN(A,B) ((A) < (B) ? (A) : (B))
 
@@ -50,6 +52,8 @@ Output::Output(MPM *mpm) : Pointers(mpm)
 
   every_restart = next_restart = restart_flag = 0;
   restart = nullptr;
+
+  writer = new Writer(mpm);
 }
 
 
@@ -59,6 +63,7 @@ Output::~Output()
   for (int i=0; i<plots.size();i++) delete plots[i];
   delete log;
   delete restart;
+  delete writer;
 }
 
 void Output::setup(){
@@ -139,7 +144,9 @@ void Output::write(bigint ntimestep){
     for (int idump = 0; idump < ndumps; idump++) {
       // Which dump requested output:
       if (next_dump[idump] == ntimestep) {
+	timer->start(timer->find("dump " + dumps[idump]->id));
 	dumps[idump]->write();
+	timer->stop();
       }
 
       if (every_dump[idump]) next_dump[idump] += every_dump[idump];
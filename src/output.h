@@ -49,6 +49,8 @@ public:
   int restart_flag;            // 1 if any restart files are written
   class WriteRestart *restart; ///< restart
 
+  class Writer *writer;        ///< background writer of the dump and restart files
+
   Output(class MPM *);
   ~Output();
 
@@ -0,0 +1,382 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_PARTICLE_FIELD_H
+#define MPM_PARTICLE_FIELD_H
+
+#include <Eigen/Eigen>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*! Storage of NC doubles per entry as NC separate columns (structure of arrays).
+ *
+ * Component c of entry i is column(c)[i]. The columns share one allocation, aligned by
+ * Eigen::aligned_allocator, and their leading dimension is a multiple of 8 doubles, so
+ * that every column starts on a 64 byte boundary and a loop over the particles reads
+ * each component with unit stride.\n
+ * Like a std::vector, the allocation only grows, so that particles arriving from other
+ * CPUs at every step do not reallocate it.
+ */
+template <int NC> class ParticleColumns {
+ public:
+  ParticleColumns() : n(0), ld(0) {};
+
+  size_t size() const { return n; }                  ///< Number of entries.
+  bool empty() const { return n == 0; }
+  size_t stride() const { return ld; }               ///< Distance between two columns, in doubles.
+  double *column(int c) { return data.data() + c * ld; }
+  const double *column(int c) const { return data.data() + c * ld; }
+
+  /// Resize to n_ entries, keeping the first ones and setting the new ones to zero.
+  void resize(size_t n_) {
+    if (n_ > ld) {
+      size_t ld_ = max(n_, ld + ld / 2);
+      ld_ = (ld_ + 7) & ~size_t(7);
+      vector<double, Eigen::aligned_allocator<double>> data_(NC * ld_, 0.0);
+      for (int c = 0; c < NC; c++)
+	copy_n(column(c), n, data_.data() + c * ld_);
+      data.swap(data_);
+      ld = ld_;
+    } else if (n_ > n) {
+      for (int c = 0; c < NC; c++)
+	fill(column(c) + n, column(c) + n_, 0.0);
+    }
+    n = n_;
+  }
+
+  void clear() { n = 0; }
+
+  /// Copy entry i into entry j.
+  void copy(size_t i, size_t j) {
+    for (int c = 0; c < NC; c++)
+      column(c)[j] = column(c)[i];
+  }
+
+  /// Entries k * stride_ to (k + 1) * stride_ - 1 become those that were at perm[k] * stride_.
+  void permute(const vector<int> &perm, int stride_) {
+    vector<double> tmp(perm.size() * stride_);
+    for (int c = 0; c < NC; c++) {
+      double *col = column(c);
+      for (size_t k = 0; k < perm.size(); k++)
+	for (int s = 0; s < stride_; s++)
+	  tmp[k * stride_ + s] = col[perm[k] * stride_ + s];
+      copy_n(tmp.begin(), tmp.size(), col);
+    }
+  }
+
+ protected:
+  size_t n;                  ///< Number of entries
+  size_t ld;                 ///< Leading dimension: number of entries allocated per column
+  vector<double, Eigen::aligned_allocator<double>> data; ///< NC columns of ld doubles
+};
+
+/*! Vector3d fields, stored as 3 columns.
+ *
+ * v[i] is an Eigen::Map of the 3 components of entry i, usable in any Eigen expression.
+ */
+class ParticleVectors : public ParticleColumns<3> {
+ public:
+  typedef Eigen::Map<Eigen::Vector3d, 0, Eigen::InnerStride<>> Ref;
+  typedef Eigen::Map<const Eigen::Vector3d, 0, Eigen::InnerStride<>> ConstRef;
+
+  Ref operator[](size_t i) { return Ref(data.data() + i, Eigen::InnerStride<>(ld)); }
+  ConstRef operator[](size_t i) const { return ConstRef(data.data() + i, Eigen::InnerStride<>(ld)); }
+};
+
+/*! Matrix3d fields, stored as 9 columns in column major order.
+ *
+ * M[i] is an Eigen::Map of the 9 components of entry i, usable in any Eigen expression.
+ */
+class ParticleMatrices : public ParticleColumns<9> {
+ public:
+  typedef Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic> Stride;
+  typedef Eigen::Map<Eigen::Matrix3d, 0, Stride> Ref;
+  typedef Eigen::Map<const Eigen::Matrix3d, 0, Stride> ConstRef;
+
+  Ref operator[](size_t i) { return Ref(data.data() + i, Stride(3 * ld, ld)); }
+  ConstRef operator[](size_t i) const { return ConstRef(data.data() + i, Stride(3 * ld, ld)); }
+};
+
+/*! One symmetric 3x3 matrix stored in 6 columns, in the order xx, yy, zz, xy, xz, yz.
+ *
+ * Assigning a matrix stores its diagonal and upper triangle. It is read as a
+ * Matrix3d through matrix(), or implicitly where a Matrix3d is expected.
+ * Scalar is double, see SymmetricMatrixRef, or const double for a read only
+ * access, see ConstSymmetricMatrixRef.
+ */
+template <typename Scalar> class SymmetricMatrixMap {
+ public:
+  SymmetricMatrixMap(Scalar *p_, size_t ld_) : p(p_), ld(ld_) {};
+
+  /// A read only access can be built from a writable one.
+  SymmetricMatrixMap(const SymmetricMatrixMap<double> &a) : p(a.data()), ld(a.stride()) {};
+
+  static int voigt(int i, int j) {
+    static const int index[3][3] = {{0, 3, 4}, {3, 1, 5}, {4, 5, 2}};
+    return index[i][j];
+  }
+
+  Scalar *data() const { return p; }
+  size_t stride() const { return ld; }
+
+  Scalar &operator()(int i, int j) { return p[voigt(i, j) * ld]; }
+  double operator()(int i, int j) const { return p[voigt(i, j) * ld]; }
+
+  Eigen::Matrix3d matrix() const {
+    Eigen::Matrix3d m;
+    m(0,0) = p[0];
+    m(1,1) = p[ld];
+    m(2,2) = p[2 * ld];
+    m(0,1) = m(1,0) = p[3 * ld];
+    m(0,2) = m(2,0) = p[4 * ld];
+    m(1,2) = m(2,1) = p[5 * ld];
+    return m;
+  }
+  operator Eigen::Matrix3d() const { return matrix(); }
+
+  double trace() const { return p[0] + p[ld] + p[2 * ld]; }
+
+  // The members below write the matrix, they only compile for SymmetricMatrixRef.
+
+  template <typename Derived> SymmetricMatrixMap &operator=(const Eigen::MatrixBase<Derived> &a) {
+    const Eigen::Matrix3d m = a; // Evaluated first, a may depend on this matrix
+    p[0] = m(0,0);
+    p[ld] = m(1,1);
+    p[2 * ld] = m(2,2);
+    p[3 * ld] = m(0,1);
+    p[4 * ld] = m(0,2);
+    p[5 * ld] = m(1,2);
+    return *this;
+  }
+
+  SymmetricMatrixMap &operator=(const SymmetricMatrixMap &a) {
+    for (int c = 0; c < 6; c++)
+      p[c * ld] = a.p[c * a.ld];
+    return *this;
+  }
+
+  template <typename Derived> SymmetricMatrixMap &operator+=(const Eigen::MatrixBase<Derived> &a) {
+    return *this = matrix() + a;
+  }
+
+  template <typename Derived> SymmetricMatrixMap &operator-=(const Eigen::MatrixBase<Derived> &a) {
+    return *this = matrix() - a;
+  }
+
+  void setZero() {
+    for (int c = 0; c < 6; c++)
+      p[c * ld] = 0;
+  }
+
+ private:
+  Scalar *p;                 ///< xx component of the matrix
+  size_t ld;                 ///< Distance between two components
+};
+
+typedef SymmetricMatrixMap<double> SymmetricMatrixRef;
+typedef SymmetricMatrixMap<const double> ConstSymmetricMatrixRef;
+
+/*! Read only access to symmetric matrices stored in 6 columns, starting at a given entry.
+ */
+class SymmetricMatrixColumns {
+ public:
+  SymmetricMatrixColumns(const double *p_, size_t ld_) : p(p_), ld(ld_) {};
+
+  ConstSymmetricMatrixRef operator[](size_t i) const { return ConstSymmetricMatrixRef(p + i, ld); }
+
+ private:
+  const double *p;
+  size_t ld;
+};
+
+/*! Symmetric Matrix3d fields (stresses, strains, rates of deformation), stored as 6 columns.
+ */
+class ParticleSymmetricMatrices : public ParticleColumns<6> {
+ public:
+  SymmetricMatrixRef operator[](size_t i) { return SymmetricMatrixRef(data.data() + i, ld); }
+  ConstSymmetricMatrixRef operator[](size_t i) const { return ConstSymmetricMatrixRef(data.data() + i, ld); }
+
+  /// Access to the entries from first on, for the functions working on a range of particles.
+  SymmetricMatrixColumns columns(size_t first) const { return SymmetricMatrixColumns(data.data() + first, ld); }
+};
+
+/*! Type independent access to one of the per-particle vectors of a Solid.
+ *
+ * Every per-particle vector of a Solid is registered once with its name, the number
+ * of entries it holds per particle and flags telling whether it has to be exchanged
+ * between CPUs or written in restart files. Resizing, copying, reordering, packing
+ * and restart I/O of particles are then generic loops over the registered fields.
+ */
+class ParticleField {
+ public:
+  enum Flags {
+    COMM      = 1 << 0,      ///< Packed when particles migrate to another CPU
+    RESTART   = 1 << 1,      ///< Written in restart files
+    GHOST     = 1 << 2,      ///< Sized and valid for the ghost particles (see GhostParticles)
+  };
+
+  string name;               ///< Name of the field
+  int stride;                ///< Number of entries per particle
+  int flags;                 ///< Combination of Flags
+
+  ParticleField(string name_, int stride_, int flags_)
+    : name(name_), stride(stride_), flags(flags_) {};
+  virtual ~ParticleField() {};
+
+  virtual void resize(int) = 0;                        ///< Resize the vector for n particles.
+  virtual void copy(int, int) = 0;                     ///< Copy particle i into particle j.
+  virtual void permute(const vector<int> &) = 0;       ///< Particle k becomes the particle that was at perm[k].
+  virtual void set_zero(int) = 0;                      ///< Set all entries of particle i to zero.
+  virtual void pack(int, vector<double> &) const = 0;  ///< Append particle i to a buffer of doubles.
+  virtual const double *unpack(int, const double *) = 0; ///< Read particle i from a buffer, return the position after it.
+  virtual void write(ofstream *, int) const = 0;       ///< Write particle i in a binary file.
+  virtual void read(ifstream *, int) = 0;              ///< Read particle i from a binary file.
+  virtual int ncomponents() const = 0;                 ///< Number of doubles packed per particle.
+  virtual size_t bytes() const = 0;                    ///< Memory used per particle in bytes.
+  virtual size_t size() const = 0;                     ///< Number of particles the vector is allocated for.
+};
+
+/*! ParticleField wrapping a vector<T> of scalars of a Solid.
+ */
+template <typename T> class ParticleScalarField : public ParticleField {
+ public:
+  ParticleScalarField(string name_, vector<T> &v_, int stride_, int flags_)
+    : ParticleField(name_, stride_, flags_), v(v_) {};
+
+  void resize(int n) { v.resize(n * stride); }
+
+  void copy(int i, int j) {
+    for (int s = 0; s < stride; s++)
+      v[j * stride + s] = v[i * stride + s];
+  }
+
+  void permute(const vector<int> &perm) {
+    vector<T> tmp(perm.size() * stride);
+    for (size_t k = 0; k < perm.size(); k++)
+      for (int s = 0; s < stride; s++)
+	tmp[k * stride + s] = v[perm[k] * stride + s];
+    copy_n(tmp.begin(), tmp.size(), v.begin());
+  }
+
+  void set_zero(int i) {
+    for (int s = 0; s < stride; s++)
+      v[i * stride + s] = 0;
+  }
+
+  void pack(int i, vector<double> &buf) const {
+    for (int s = 0; s < stride; s++)
+      buf.push_back(v[i * stride + s]);
+  }
+
+  const double *unpack(int i, const double *buf) {
+    for (int s = 0; s < stride; s++)
+      v[i * stride + s] = (T) *buf++;
+    return buf;
+  }
+
+  void write(ofstream *of, int i) const {
+    of->write(reinterpret_cast<const char *>(&v[i * stride]), stride * sizeof(T));
+  }
+
+  void read(ifstream *ifr, int i) {
+    ifr->read(reinterpret_cast<char *>(&v[i * stride]), stride * sizeof(T));
+  }
+
+  int ncomponents() const { return stride; }
+  size_t bytes() const { return stride * sizeof(T); }
+  size_t size() const { return v.size() / stride; }
+
+ private:
+  vector<T> &v;                ///< Vector of the Solid holding the field
+};
+
+/*! ParticleField wrapping the columns of a vector or matrix field of a Solid.
+ *
+ * Restart files hold each entry as a full Vector3d or Matrix3d, in Eigen's column major
+ * order, whatever the number of columns it is stored in.
+ */
+template <int NC> class ParticleColumnsField : public ParticleField {
+ public:
+  ParticleColumnsField(string name_, ParticleColumns<NC> &v_, int stride_, int flags_)
+    : ParticleField(name_, stride_, flags_), v(v_) {};
+
+  void resize(int n) { v.resize(n * stride); }
+
+  void copy(int i, int j) {
+    for (int s = 0; s < stride; s++)
+      v.copy(i * stride + s, j * stride + s);
+  }
+
+  void permute(const vector<int> &perm) { v.permute(perm, stride); }
+
+  void set_zero(int i) {
+    for (int c = 0; c < NC; c++)
+      fill_n(v.column(c) + i * stride, stride, 0.0);
+  }
+
+  void pack(int i, vector<double> &buf) const {
+    for (int s = 0; s < stride; s++)
+      for (int c = 0; c < NC; c++)
+	buf.push_back(v.column(c)[i * stride + s]);
+  }
+
+  const double *unpack(int i, const double *buf) {
+    for (int s = 0; s < stride; s++)
+      for (int c = 0; c < NC; c++)
+	v.column(c)[i * stride + s] = *buf++;
+    return buf;
+  }
+
+  void write(ofstream *of, int i) const {
+    double entry[9];
+    for (int s = 0; s < stride; s++) {
+      int n = expand(i * stride + s, entry);
+      of->write(reinterpret_cast<const char *>(entry), n * sizeof(double));
+    }
+  }
+
+  void read(ifstream *ifr, int i) {
+    double entry[9];
+    for (int s = 0; s < stride; s++) {
+      int n = NC == 6 ? 9 : NC;
+      ifr->read(reinterpret_cast<char *>(entry), n * sizeof(double));
+      for (int c = 0; c < n; c++)
+	v.column(NC == 6 ? SymmetricMatrixRef::voigt(c % 3, c / 3) : c)[i * stride + s] = entry[c];
+    }
+  }
+
+  int ncomponents() const { return stride * NC; }
+  size_t bytes() const { return stride * NC * sizeof(double); }
+  size_t size() const { return v.size() / stride; }
+
+ private:
+  ParticleColumns<NC> &v;      ///< Columns of the Solid holding the field
+
+  /// Components of entry k as a full vector or matrix, return their number.
+  int expand(size_t k, double *entry) const {
+    if (NC != 6) {
+      for (int c = 0; c < NC; c++)
+	entry[c] = v.column(c)[k];
+      return NC;
+    }
+    for (int c = 0; c < 9; c++)
+      entry[c] = v.column(SymmetricMatrixRef::voigt(c % 3, c / 3))[k];
+    return 9;
+  }
+};
+
+#endif
@@ -42,7 +42,8 @@ class Pointers {
    material(ptr->material),
    update(ptr->update),
    modify(ptr->modify),
-   group(ptr->group) {}
+   group(ptr->group),
+   timer(ptr->timer) {}
   virtual ~Pointers() {}
  protected:
   MPM *mpm;
@@ -57,6 +58,7 @@ class Pointers {
   Update *&update;
   Modify *&modify;
   Group *&group;
+  Timer *&timer;
 
   filebuf *infile;
   filebuf *logfile;
@@ -114,6 +114,11 @@ Var PopulateCylindricalCoordinates::command(vector<string> args) {
   domain->np_total -= s->np;
   s->grow(N);
 
+  bool tl = update->method->is_TL;
+  bool has_damage_init = s->has_field("damage_init");
+  bool has_T = s->has_field("T");
+  bool has_Finv = s->has_field("Finv");
+
   int l = 0;
 
   double Ndr_ = R/Ndr;
@@ -163,18 +168,23 @@ Var PopulateCylindricalCoordinates::command(vector<string> args) {
           s->eff_plastic_strain[l] = 0;
           s->eff_plastic_strain_rate[l] = 0;
           s->damage[l] = 0;
-          s->damage_init[l] = 0;
-          s->T[l] = T0;
+          if (has_damage_init)
+            s->damage_init[l] = 0;
+          if (has_T)
+            s->T[l] = T0;
           s->ienergy[l] = 0;
           s->strain_el[l].setZero();
           s->sigma[l].setZero();
-          s->vol0PK1[l].setZero();
           s->L[l].setZero();
           s->F[l].setIdentity();
-          s->R[l].setIdentity();
           s->D[l].setZero();
-          s->Finv[l].setZero();
-          s->Fdot[l].setZero();
+          if (tl) {
+            s->vol0PK1[l].setZero();
+            s->R[l].setIdentity();
+            s->Fdot[l].setZero();
+          }
+          if (has_Finv)
+            s->Finv[l].setZero();
           s->J[l] = 1;
           s->mask[l] = 1;
           l++;
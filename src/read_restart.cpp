@@ -21,10 +21,11 @@
 #include "update.h"
 #include "var.h"
 #include "version.h"
+#include "write_restart.h"
 #include <iostream>
 #include <vector>
 
-enum { VERSION, DIMENSION, NPROCS };
+enum { VERSION, DIMENSION, NPROCS, FORMAT };
 /* ---------------------------------------------------------------------- */
 
 ReadRestart::ReadRestart(MPM *mpm) : Pointers(mpm) {
@@ -89,6 +90,7 @@ Var ReadRestart::command(vector<string> args) {
  */
 void ReadRestart::header() {
   // Karamelo version:
+  int format = -1;
   int flag = read_int();
 
   while (flag >= 0) {
@@ -107,9 +109,18 @@ void ReadRestart::header() {
       if (nprocs != universe->nprocs) {
 	error->one(FLERR, "Restart file written for " + to_string(nprocs) + " CPUs.\n");
       }
+    } else if (flag == FORMAT) {
+      format = read_int();
     }
     flag = read_int();
   }
+
+  // Files of older formats cannot be read: format 1 does not record the boundaries of the
+  // balanced sub-boxes, and files without a format do not list the fields of the particles:
+  if (format != WriteRestart::format) {
+    error->one(FLERR, "Restart file format " + to_string(format) + " is not supported, expected format "
+	       + to_string(WriteRestart::format) + ".\n");
+  }
 }
 
 /*!  read a flag and a variable into restart file.
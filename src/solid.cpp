@@ -14,6 +14,7 @@
 #include "solid.h"
 #include "domain.h"
 #include "error.h"
+#include "ghost_particles.h"
 #include "input.h"
 #include "material.h"
 #include "memory.h"
@@ -30,6 +31,10 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace std;
 using namespace Eigen;
@@ -88,6 +93,10 @@ Solid::Solid(MPM *mpm, vector<string> args) : Pointers(mpm)
     nc = 0;
 
   mat = nullptr;
+  np_ghost = 0;
+  ghost_cutoff = 0;
+  neigh_nodes_boundary = 0;
+  ghosts = nullptr;
 
   if (update->method->is_TL) {
     is_TL = true;
@@ -110,7 +119,7 @@ Solid::Solid(MPM *mpm, vector<string> args) : Pointers(mpm)
   max_p_wave_speed = 0;
   vtot  = 0;
   mtot = 0;
-  comm_n = 50; // Number of double to pack for particle exchange between CPUs.
+  comm_n = 0; // Set by register_fields()
 
 
   if (args[1].compare("restart") == 0) {
@@ -155,16 +164,12 @@ Solid::Solid(MPM *mpm, vector<string> args) : Pointers(mpm)
 
     read_file(args[2]);
   }
-
-  if (update->method->temp)
-    comm_n = 54; // Number of double to pack for particle exchange between CPUs.
-  else
-    comm_n = 49;
 }
 
 Solid::~Solid()
 {
   if (is_TL) delete grid;
+  delete ghosts;
 }
 
 void Solid::init()
@@ -188,9 +193,14 @@ void Solid::init()
   MPI_Allreduce(&vtot_local, &vtot, 1, MPI_DOUBLE, MPI_SUM, universe->uworld);
   MPI_Allreduce(&mtot_local, &mtot, 1, MPI_DOUBLE, MPI_SUM, universe->uworld);
 
+  size_t bytes = 0;
+  for (auto &field: fields)
+    bytes += field->bytes();
+
   if (universe->me == 0) {
     cout << "Solid " << id << " total volume = " << vtot << endl;
     cout << "Solid " << id << " total mass = " << mtot << endl;
+    cout << "Solid " << id << " uses " << bytes << " bytes per particle in " << fields.size() << " fields\n";
   }
 
   if (grid->nnodes == 0) grid->init(solidlo, solidhi);
@@ -239,9 +249,48 @@ void Solid::options(vector<string> *args, vector<string>::iterator it)
 
 void Solid::grow(int nparticles)
 {
-  ptag.resize(nparticles);
-  x0.resize(nparticles);
-  x.resize(nparticles);
+  if (fields.empty()) register_fields();
+
+  for (auto &field: fields)
+    field->resize(nparticles);
+
+  neigh_pn_offset.assign(nparticles + 1, 0);
+}
+
+// True if the per-particle vector of that name is registered, and hence allocated:
+bool Solid::has_field(string name) const
+{
+  for (auto &field: fields)
+    if (field->name == name)
+      return true;
+  return false;
+}
+
+/*! Only the fields needed by the method and the material are registered, the others
+ * are never allocated: vol0PK1, R and Fdot are only used by total Lagrangian methods,
+ * Finv by total Lagrangian methods and Neo-Hookean materials, damage_init by damage
+ * models, T, gamma and q by thermal simulations, and rp, rp0, xpc and xpc0 by CPDI.\n
+ * The acceleration a is recomputed by every G2P before being read, so that it is not
+ * sent with the migrating particles.\n
+ * Fields flagged ParticleField::COMM are packed in the order they are registered,
+ * and Method::exchange_particles() expects the position right after the tag.
+ * Fields flagged ParticleField::RESTART are written in restart files in the order of
+ * restart_order, which is the order the particles were written in before the registry.
+ * Fields flagged ParticleField::GHOST are the only ones extended to the ghost particles
+ * by GhostParticles::forward(): the fixes that use ghosts must not read the others.
+ */
+void Solid::register_fields()
+{
+  int COMM = ParticleField::COMM;
+  int RESTART = ParticleField::RESTART;
+  int GHOST = ParticleField::GHOST;
+
+  fields.clear();
+  comm_n = 0;
+
+  add_field("ptag", ptag, COMM | RESTART);
+  add_field("x", x, COMM | RESTART | GHOST);
+  add_field("x0", x0, COMM | RESTART);
 
   if (method_type.compare("tlcpdi") == 0
       || method_type.compare("ulcpdi") == 0)
@@ -249,102 +298,128 @@ void Solid::grow(int nparticles)
 
       if (update->method->style == 0)
 	{ // CPDI-R4
-	  rp0.resize(domain->dimension*nparticles);
-	  rp.resize(domain->dimension*nparticles);
+	  add_field("rp0", rp0, COMM, domain->dimension);
+	  add_field("rp", rp, COMM, domain->dimension);
 	}
       if (update->method->style == 1)
 	{ // CPDI-Q4
-	  xpc0.resize(nc * nparticles);
-	  xpc.resize(nc * nparticles);
+	  add_field("xpc0", xpc0, COMM, nc);
+	  add_field("xpc", xpc, COMM, nc);
 	}
     }
 
   if (method_type.compare("tlcpdi2") == 0
       || method_type.compare("ulcpdi2") == 0)
     {
-      xpc0.resize(nparticles);
-      xpc.resize(nparticles);
-    }
-
-  v.resize(nparticles);
-  v_update.resize(nparticles);
-  a.resize(nparticles);
-  mbp.resize(nparticles);
-  f.resize(nparticles);
-  sigma.resize(nparticles);
-  strain_el.resize(nparticles);
-  vol0PK1.resize(nparticles);
-  L.resize(nparticles);
-  F.resize(nparticles);
-  R.resize(nparticles);
-  D.resize(nparticles);
-  Finv.resize(nparticles);
-  Fdot.resize(nparticles);
-  vol0.resize(nparticles);
-  vol.resize(nparticles);
-  rho0.resize(nparticles);
-  rho.resize(nparticles);
-  mass.resize(nparticles);
-  eff_plastic_strain.resize(nparticles);
-  eff_plastic_strain_rate.resize(nparticles);
-  damage.resize(nparticles);
-  damage_init.resize(nparticles);
-  ienergy.resize(nparticles);
-  mask.resize(nparticles);
-  J.resize(nparticles);
-
-  numneigh_pn.resize(nparticles);
-  neigh_pn.resize(nparticles);
-  wf_pn.resize(nparticles);
-  if (nc != 0)
-    wf_pn_corners.resize(nc * nparticles);
-  wfd_pn.resize(nparticles);
-
-  bigint nnodes = grid->nnodes_local + grid->nnodes_ghost;
-
-  numneigh_np.resize(nnodes);
-  neigh_np.resize(nnodes);
-  wf_np.resize(nnodes);
-  wfd_np.resize(nnodes);
-
-  if (mat->cp != 0) {
-    T.resize(nparticles);
-    gamma.resize(nparticles);
-    q.resize(nparticles);
-  }
+      add_field("xpc0", xpc0, COMM);
+      add_field("xpc", xpc, COMM);
+    }
+
+  add_field("v", v, COMM | RESTART | GHOST);
+  add_field("v_update", v_update, COMM);
+  add_field("a", a, 0);
+  add_field("mbp", mbp, COMM | GHOST);
+  add_field("f", f, COMM);
+  add_field("sigma", sigma, COMM | RESTART);
+  add_field("strain_el", strain_el, RESTART);
+  if (is_TL)
+    add_field("vol0PK1", vol0PK1, RESTART);
+  add_field("L", L, 0);
+  add_field("F", F, COMM | RESTART);
+  if (is_TL)
+    add_field("R", R, 0);
+  add_field("D", D, 0);
+  if (is_TL || mat->type == material->constitutive_model::NEO_HOOKEAN)
+    add_field("Finv", Finv, 0);
+  if (is_TL)
+    add_field("Fdot", Fdot, 0);
+  add_field("J", J, COMM | RESTART);
+  add_field("vol0", vol0, COMM | RESTART | GHOST);
+  add_field("vol", vol, COMM | GHOST);
+  add_field("rho0", rho0, COMM | RESTART);
+  add_field("rho", rho, COMM);
+  add_field("mass", mass, COMM | GHOST);
+  add_field("eff_plastic_strain", eff_plastic_strain, COMM | RESTART);
+  add_field("eff_plastic_strain_rate", eff_plastic_strain_rate, COMM | RESTART);
+  add_field("damage", damage, COMM | RESTART);
+  if (mat->damage != nullptr)
+    add_field("damage_init", damage_init, COMM | RESTART);
+  add_field("ienergy", ienergy, COMM | RESTART);
+  add_field("mask", mask, COMM | RESTART);
+
+  if (update->method->temp || mat->cp != 0) {
+    add_field("T", T, COMM | RESTART);
+    add_field("gamma", gamma, COMM | GHOST);
+    add_field("q", q, COMM);
+  }
+
+  static const char *restart_order[] = {"ptag", "x0", "x", "v", "sigma", "strain_el", "vol0PK1",
+					"F", "J", "vol0", "rho0", "eff_plastic_strain",
+					"eff_plastic_strain_rate", "damage", "damage_init", "T",
+					"ienergy", "mask"};
+
+  restart_fields.clear();
+  for (const char *name: restart_order)
+    for (auto &field: fields)
+      if (field->name == name && (field->flags & RESTART))
+	restart_fields.push_back(field.get());
+
+  for (auto &field: fields)
+    if ((field->flags & RESTART)
+	&& find(restart_fields.begin(), restart_fields.end(), field.get()) == restart_fields.end())
+      error->all(FLERR, "Error: field " + field->name + " is flagged RESTART but missing from restart_order.\n");
 }
 
-void Solid::compute_mass_nodes(bool reset)
+/*! The active nodes are reset if reset is true, then only the nodes neighbouring
+ * the particles of this solid are visited, so that the cost of each additional solid
+ * sharing the grid is proportional to its own number of particles.\n
+ * Like the other P2G functions, it can visit the boundary nodes only, so that their
+ * reduction with the other CPUs is started before the interior nodes are visited.
+ * The active nodes are then reset with the boundary nodes.
+ */
+void Solid::compute_mass_nodes(bool reset, NodeSet nodes)
 {
-  int ip;
-  int nn = grid->nnodes_local + grid->nnodes_ghost;
-
-  for (int in = 0; in < nn; in++)
+  int ip, a0, a1;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  neigh_nodes_range(nodes, a0, a1);
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->mass[active[ia]] = 0;
+
+MPM_OMP(omp parallel for private(ip))
+  for (int a = a0; a < a1; a++)
     {
-      if (reset) grid->mass[in] = 0;
+      int in = neigh_nodes[a];
 
       if (grid->rigid[in] && !mat->rigid) continue;
 
-      for (int j = 0; j < numneigh_np[in]; j++)
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++)
 	{
-	  ip = neigh_np[in][j];
-	  grid->mass[in] += wf_np[in][j] * mass[ip];
+	  ip = neigh_np[j];
+	  grid->mass[in] += wf_pn[np_to_pn[j]] * mass[ip];
 	}
     }
   return;
 }
 
-void Solid::compute_velocity_nodes(bool reset)
+void Solid::compute_velocity_nodes(bool reset, NodeSet nodes)
 {
   Eigen::Vector3d vtemp, vtemp_update;
   //double mass_rigid;
   int ip;
-  int nn = grid->nnodes_local + grid->nnodes_ghost;
-
-  for (int in = 0; in < nn; in++)
-  {
-    if (reset)
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++)
     {
+      int in = active[ia];
       grid->v[in].setZero();
       //grid->v_update[in].setZero();
       if (grid->rigid[in]) {
@@ -352,6 +427,11 @@ void Solid::compute_velocity_nodes(bool reset)
       }
     }
 
+MPM_OMP(omp parallel for private(ip, vtemp, vtemp_update))
+  for (int a = a0; a < a1; a++)
+  {
+    int in = neigh_nodes[a];
+
     if (grid->rigid[in] && !mat->rigid) continue;
 
     if (grid->mass[in] > 0)
@@ -360,19 +440,19 @@ void Solid::compute_velocity_nodes(bool reset)
       if (grid->rigid[in])
 	vtemp_update.setZero();
 
-      for (int j = 0; j < numneigh_np[in]; j++)
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++)
       {
-        ip = neigh_np[in][j];
+        ip = neigh_np[j];
 	if (grid->rigid[in]) {
-	  vtemp_update += (wf_np[in][j] * mass[ip]) * v_update[ip];
+	  vtemp_update += (wf_pn[np_to_pn[j]] * mass[ip]) * v_update[ip];
 	}
 	if (update->method->ge) {
-	  vtemp += (wf_np[in][j] * mass[ip]) *
+	  vtemp += (wf_pn[np_to_pn[j]] * mass[ip]) *
 	    (v[ip] + L[ip] * (grid->x0[in] - x[ip]));
 	} else {
-	  vtemp += wf_np[in][j] * mass[ip] * v[ip];
+	  vtemp += wf_pn[np_to_pn[j]] * mass[ip] * v[ip];
 	}
-        // grid->v[in] += (wf_np[in][j] * mass[ip]) * v[ip]/ grid->mass[in];
+        // grid->v[in] += (wf_pn[np_to_pn[j]] * mass[ip]) * v[ip]/ grid->mass[in];
       }
       vtemp /= grid->mass[in];
       grid->v[in] += vtemp;
@@ -389,13 +469,16 @@ void Solid::compute_velocity_nodes(bool reset)
   }
 }
 
-void Solid::compute_velocity_nodes_APIC(bool reset) {
+void Solid::compute_velocity_nodes_APIC(bool reset, NodeSet nodes) {
   int ip;
-  int nn = grid->nnodes_local + grid->nnodes_ghost;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
   Eigen::Vector3d vtemp;
 
-  vector<Eigen::Vector3d> *pos;
-  vector<Eigen::Matrix3d> *C;
+  ParticleVectors *pos;
+  ParticleMatrices *C;
 
   if (is_TL) {
     pos = &x0;
@@ -405,18 +488,23 @@ void Solid::compute_velocity_nodes_APIC(bool reset) {
     C = &L;
   }
 
-  for (int in = 0; in < nn; in++) {
-    if (reset)
-      grid->v[in].setZero();
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->v[active[ia]].setZero();
+
+MPM_OMP(omp parallel for private(ip, vtemp))
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
 
     if (grid->rigid[in] && !mat->rigid)
       continue;
 
     if (grid->mass[in] > 0) {
       vtemp.setZero();
-      for (int j = 0; j < numneigh_np[in]; j++) {
-        ip = neigh_np[in][j];
-        vtemp += (wf_np[in][j] * mass[ip]) *
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+        ip = neigh_np[j];
+        vtemp += (wf_pn[np_to_pn[j]] * mass[ip]) *
 	  (v[ip] + (*C)[ip] * (grid->x0[in] - (*pos)[ip]));
       }
       vtemp /= grid->mass[in];
@@ -425,53 +513,70 @@ void Solid::compute_velocity_nodes_APIC(bool reset) {
   }
 }
 
-void Solid::compute_external_forces_nodes(bool reset)
+void Solid::compute_external_forces_nodes(bool reset, NodeSet nodes)
 {
   int ip;
-  int nn = grid->nnodes_local + grid->nnodes_ghost;
-
-  for (int in = 0; in < nn; in++)
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->mb[active[ia]].setZero();
+
+MPM_OMP(omp parallel for private(ip))
+  for (int a = a0; a < a1; a++)
   {
-    if (reset)
-      grid->mb[in].setZero();
+    int in = neigh_nodes[a];
 
     if (grid->rigid[in])
       continue;
 
     if (grid->mass[in] > 0)
     {
-      for (int j = 0; j < numneigh_np[in]; j++)
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++)
       {
-        ip = neigh_np[in][j];
-        grid->mb[in] += wf_np[in][j] * mbp[ip];
+        ip = neigh_np[j];
+        grid->mb[in] += wf_pn[np_to_pn[j]] * mbp[ip];
       }
     }
   }
 }
 
-void Solid::compute_internal_forces_nodes_TL()
+void Solid::compute_internal_forces_nodes_TL(NodeSet nodes)
 {
   Eigen::Vector3d ftemp;
   int ip;
-  int nn = grid->nnodes_local + grid->nnodes_ghost;
-
-  for (int in = 0; in < nn; in++)
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
+
+  // The forces are assigned rather than accumulated, the active nodes away
+  // from the particles must still end up with no force:
+  if (nodes != INTERIOR_NODES)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->f[active[ia]].setZero();
+
+MPM_OMP(omp parallel for private(ip, ftemp))
+  for (int a = a0; a < a1; a++)
   {
+    int in = neigh_nodes[a];
     if (grid->rigid[in])
-    {
-      grid->f[in].setZero();
       continue;
-    }
 
     ftemp.setZero();
-    for (int j = 0; j < numneigh_np[in]; j++)
+    for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++)
     {
-      ip = neigh_np[in][j];
-      ftemp -= vol0PK1[ip] * wfd_np[in][j];
+      ip = neigh_np[j];
+      ftemp -= vol0PK1[ip] * wfd_pn[np_to_pn[j]];
 
       if (domain->axisymmetric == true)
       {
-        ftemp[0] -= vol0PK1[ip](2, 2) * wf_np[in][j] / x0[ip][0];
+        ftemp[0] -= vol0PK1[ip](2, 2) * wf_pn[np_to_pn[j]] / x0[ip][0];
       }
     }
 
@@ -479,52 +584,64 @@ void Solid::compute_internal_forces_nodes_TL()
   }
 }
 
-void Solid::compute_external_and_internal_forces_nodes_UL(bool reset)
+void Solid::compute_external_and_internal_forces_nodes_UL(bool reset, NodeSet nodes)
 {
   int ip;
-  int nn = grid->nnodes_local + grid->nnodes_ghost;
-
-  for (int in = 0; in < nn; in++) {
-    if (reset) {
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++) {
+      int in = active[ia];
       grid->f[in].setZero();
       grid->mb[in].setZero();
     }
 
+MPM_OMP(omp parallel for private(ip))
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
+
     if (grid->rigid[in]) {
-      for (int j = 0; j < numneigh_np[in]; j++) {
-        ip = neigh_np[in][j];
-        grid->f[in] -= vol[ip] * (sigma[ip] * wfd_np[in][j]);
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+        ip = neigh_np[j];
+        grid->f[in] -= vol[ip] * (sigma[ip].matrix() * wfd_pn[np_to_pn[j]]);
       }
 
       if (domain->axisymmetric == true) {
-        for (int j = 0; j < numneigh_np[in]; j++) {
-          ip = neigh_np[in][j];
+        for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+          ip = neigh_np[j];
           grid->f[in][0] -=
-              vol[ip] * (sigma[ip](2, 2) * wf_np[in][j] / x[ip][0]);
+              vol[ip] * (sigma[ip](2, 2) * wf_pn[np_to_pn[j]] / x[ip][0]);
         }
       }
     } else {
-      for (int j = 0; j < numneigh_np[in]; j++) {
-        ip = neigh_np[in][j];
-        grid->f[in] -= vol[ip] * (sigma[ip] * wfd_np[in][j]);
-        grid->mb[in] += wf_np[in][j] * mbp[ip];
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+        ip = neigh_np[j];
+        grid->f[in] -= vol[ip] * (sigma[ip].matrix() * wfd_pn[np_to_pn[j]]);
+        grid->mb[in] += wf_pn[np_to_pn[j]] * mbp[ip];
       }
 
       if (domain->axisymmetric == true) {
-        for (int j = 0; j < numneigh_np[in]; j++) {
-          ip = neigh_np[in][j];
+        for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+          ip = neigh_np[j];
           grid->f[in][0] -=
-              vol[ip] * (sigma[ip](2, 2) * wf_np[in][j] / x[ip][0]);
+              vol[ip] * (sigma[ip](2, 2) * wf_pn[np_to_pn[j]] / x[ip][0]);
         }
       }
     }
   }
 }
 
-void Solid::compute_external_and_internal_forces_nodes_UL_MLS(bool reset) {
+void Solid::compute_external_and_internal_forces_nodes_UL_MLS(bool reset, NodeSet nodes) {
   int ip;
-  int nn = grid->nnodes_local + grid->nnodes_ghost;
-  vector<Eigen::Vector3d> *pos;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
+  ParticleVectors *pos;
 
   if (is_TL) {
     pos = &x0;
@@ -532,41 +649,47 @@ void Solid::compute_external_and_internal_forces_nodes_UL_MLS(bool reset) {
     pos = &x;
   }
 
-  for (int in = 0; in < nn; in++) {
-    if (reset) {
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++) {
+      int in = active[ia];
       grid->f[in].setZero();
       grid->mb[in].setZero();
     }
 
+MPM_OMP(omp parallel for private(ip))
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
+
     if (grid->rigid[in]) {
-      for (int j = 0; j < numneigh_np[in]; j++) {
-        ip = neigh_np[in][j];
-        // grid->f[in] -= vol[ip] * (sigma[ip] * wfd_np[in][j]);
-        grid->f[in] -= vol[ip] * wf_np[in][j] *
-                       (sigma[ip] * Di * (grid->x0[in] - (*pos)[ip]));
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+        ip = neigh_np[j];
+        // grid->f[in] -= vol[ip] * (sigma[ip].matrix() * wfd_pn[np_to_pn[j]]);
+        grid->f[in] -= vol[ip] * wf_pn[np_to_pn[j]] *
+                       (sigma[ip].matrix() * Di * (grid->x0[in] - (*pos)[ip]));
       }
 
       if (domain->axisymmetric == true) {
-        for (int j = 0; j < numneigh_np[in]; j++) {
-          ip = neigh_np[in][j];
+        for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+          ip = neigh_np[j];
           grid->f[in][0] -=
-              vol[ip] * (sigma[ip](2, 2) * wf_np[in][j] / x[ip][0]);
+              vol[ip] * (sigma[ip](2, 2) * wf_pn[np_to_pn[j]] / x[ip][0]);
         }
       }
     } else {
-      for (int j = 0; j < numneigh_np[in]; j++) {
-        ip = neigh_np[in][j];
-        // grid->f[in] -= vol[ip] * (sigma[ip] * wfd_np[in][j]);
-        grid->f[in] -= vol[ip] * wf_np[in][j] *
-                       (sigma[ip] * Di * (grid->x0[in] - (*pos)[ip]));
-        grid->mb[in] += wf_np[in][j] * mbp[ip];
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+        ip = neigh_np[j];
+        // grid->f[in] -= vol[ip] * (sigma[ip].matrix() * wfd_pn[np_to_pn[j]]);
+        grid->f[in] -= vol[ip] * wf_pn[np_to_pn[j]] *
+                       (sigma[ip].matrix() * Di * (grid->x0[in] - (*pos)[ip]));
+        grid->mb[in] += wf_pn[np_to_pn[j]] * mbp[ip];
       }
 
       if (domain->axisymmetric == true) {
-        for (int j = 0; j < numneigh_np[in]; j++) {
-          ip = neigh_np[in][j];
+        for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+          ip = neigh_np[j];
           grid->f[in][0] -=
-              vol[ip] * (sigma[ip](2, 2) * wf_np[in][j] / x[ip][0]);
+              vol[ip] * (sigma[ip](2, 2) * wf_pn[np_to_pn[j]] / x[ip][0]);
         }
       }
     }
@@ -591,6 +714,9 @@ void Solid::compute_particle_accelerations_velocities_and_positions() {
   } else
     update_corners = false;
 
+  int outside_ip = np_local;
+
+MPM_OMP(omp parallel for private(in) firstprivate(vc_update) reduction(min : outside_ip))
   for (int ip = 0; ip < np_local; ip++) {
     v_update[ip].setZero();
     a[ip].setZero();
@@ -598,15 +724,15 @@ void Solid::compute_particle_accelerations_velocities_and_positions() {
       for (int i = 0; i < nc; i++)
         vc_update[i].setZero();
 
-    for (int j = 0; j < numneigh_pn[ip]; j++) {
-      in = neigh_pn[ip][j];
-      v_update[ip] += wf_pn[ip][j] * grid->v_update[in];
-      a[ip] += wf_pn[ip][j] * (grid->v_update[in] - grid->v[in]);
-      //x[ip] += update->dt * wf_pn[ip][j] * grid->v_update[in];
+    for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+      in = neigh_pn[j];
+      v_update[ip] += wf_pn[j] * grid->v_update[in];
+      a[ip] += wf_pn[j] * (grid->v_update[in] - grid->v[in]);
+      //x[ip] += update->dt * wf_pn[j] * grid->v_update[in];
 
       if (update_corners) {
         for (int ic = 0; ic < nc; ic++) {
-          vc_update[ic] += wf_pn_corners[nc * ip + ic][j] * grid->v_update[in];
+          vc_update[ic] += wf_pn_corners[nc * j + ic] * grid->v_update[in];
         }
       }
     }
@@ -616,14 +742,8 @@ void Solid::compute_particle_accelerations_velocities_and_positions() {
 
     if (!is_TL) {
       // Check if the particle is within the box's domain:
-      if (domain->inside(x[ip]) == 0) {
-        cout << "Error: Particle " << ip << " left the domain ("
-             << domain->boxlo[0] << "," << domain->boxhi[0] << ","
-             << domain->boxlo[1] << "," << domain->boxhi[1] << ","
-             << domain->boxlo[2] << "," << domain->boxhi[2] << ",):\n"
-             << x[ip] << endl;
-        error->one(FLERR, "");
-      }
+      if (domain->inside(x[ip]) == 0)
+        outside_ip = MIN(outside_ip, ip);
     }
 
     if (update_corners) {
@@ -632,6 +752,16 @@ void Solid::compute_particle_accelerations_velocities_and_positions() {
       }
     }
   }
+
+  // Reported by the master thread once the loop is over (MPI_THREAD_FUNNELED):
+  if (outside_ip < np_local) {
+    cout << "Error: Particle " << outside_ip << " left the domain ("
+         << domain->boxlo[0] << "," << domain->boxhi[0] << ","
+         << domain->boxlo[1] << "," << domain->boxhi[1] << ","
+         << domain->boxlo[2] << "," << domain->boxhi[2] << ",):\n"
+         << x[outside_ip] << endl;
+    error->one(FLERR, "");
+  }
 }
 
 void Solid::compute_particle_accelerations_velocities() {
@@ -652,6 +782,9 @@ void Solid::compute_particle_accelerations_velocities() {
   } else
     update_corners = false;
 
+  int outside_ip = np_local;
+
+MPM_OMP(omp parallel for private(in) firstprivate(vc_update) reduction(min : outside_ip))
   for (int ip = 0; ip < np_local; ip++) {
     v_update[ip].setZero();
     a[ip].setZero();
@@ -659,14 +792,14 @@ void Solid::compute_particle_accelerations_velocities() {
       for (int i = 0; i < nc; i++)
         vc_update[i].setZero();
 
-    for (int j = 0; j < numneigh_pn[ip]; j++) {
-      in = neigh_pn[ip][j];
-      v_update[ip] += wf_pn[ip][j] * grid->v_update[in];
-      a[ip] += wf_pn[ip][j] * (grid->v_update[in] - grid->v[in]);
+    for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+      in = neigh_pn[j];
+      v_update[ip] += wf_pn[j] * grid->v_update[in];
+      a[ip] += wf_pn[j] * (grid->v_update[in] - grid->v[in]);
 
       if (update_corners) {
         for (int ic = 0; ic < nc; ic++) {
-          vc_update[ic] += wf_pn_corners[nc * ip + ic][j] * grid->v_update[in];
+          vc_update[ic] += wf_pn_corners[nc * j + ic] * grid->v_update[in];
         }
       }
     }
@@ -675,14 +808,8 @@ void Solid::compute_particle_accelerations_velocities() {
 
     if (!is_TL) {
       // Check if the particle is within the box's domain:
-      if (domain->inside(x[ip]) == 0) {
-        cout << "Error: Particle " << ip << " left the domain ("
-             << domain->boxlo[0] << "," << domain->boxhi[0] << ","
-             << domain->boxlo[1] << "," << domain->boxhi[1] << ","
-             << domain->boxlo[2] << "," << domain->boxhi[2] << ",):\n"
-             << x[ip] << endl;
-        error->one(FLERR, "");
-      }
+      if (domain->inside(x[ip]) == 0)
+        outside_ip = MIN(outside_ip, ip);
     }
 
     if (update_corners) {
@@ -691,6 +818,15 @@ void Solid::compute_particle_accelerations_velocities() {
       }
     }
   }
+
+  if (outside_ip < np_local) {
+    cout << "Error: Particle " << outside_ip << " left the domain ("
+         << domain->boxlo[0] << "," << domain->boxhi[0] << ","
+         << domain->boxlo[1] << "," << domain->boxhi[1] << ","
+         << domain->boxlo[2] << "," << domain->boxhi[2] << ",):\n"
+         << x[outside_ip] << endl;
+    error->one(FLERR, "");
+  }
 }
 
 void Solid::compute_particle_velocities_and_positions()
@@ -712,6 +848,9 @@ void Solid::compute_particle_velocities_and_positions()
   else
     update_corners = false;
 
+  int outside_ip = np_local;
+
+MPM_OMP(omp parallel for private(in) firstprivate(vc_update) reduction(min : outside_ip))
   for (int ip = 0; ip < np_local; ip++)
   {
     v_update[ip].setZero();
@@ -719,22 +858,22 @@ void Solid::compute_particle_velocities_and_positions()
       for (int i = 0; i < nc; i++)
         vc_update[i].setZero();
 
-    for (int j = 0; j < numneigh_pn[ip]; j++)
+    for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
       {
-      in = neigh_pn[ip][j];
-      v_update[ip] += wf_pn[ip][j] * grid->v_update[in];
-      x[ip] += update->dt * wf_pn[ip][j] * grid->v_update[in];
+      in = neigh_pn[j];
+      v_update[ip] += wf_pn[j] * grid->v_update[in];
+      x[ip] += update->dt * wf_pn[j] * grid->v_update[in];
       // if (isnan(x[ip](0)))
       //   cout << "ip=" << ip << "\tx=[" << x[ip](0) << "," << x[ip](1) << ","
       //        << x[ip](2) << "]\tin=" << in << "\tvn_update=["
       //        << grid->v_update[in](0) << "," << grid->v_update[in](1) << ","
-      //        << grid->v_update[in](2) << "]\twf_pn=" << wf_pn[ip][j] << "\n";
+      //        << grid->v_update[in](2) << "]\twf_pn=" << wf_pn[j] << "\n";
 
       if (update_corners)
       {
         for (int ic = 0; ic < nc; ic++)
         {
-          vc_update[ic] += wf_pn_corners[nc * ip + ic][j] * grid->v_update[in];
+          vc_update[ic] += wf_pn_corners[nc * j + ic] * grid->v_update[in];
         }
       }
     }
@@ -743,14 +882,7 @@ void Solid::compute_particle_velocities_and_positions()
     {
       // Check if the particle is within the box's domain:
       if (domain->inside(x[ip]) == 0)
-      {
-        cout << "Error: Particle " << ip << " left the domain ("
-             << domain->boxlo[0] << "," << domain->boxhi[0] << ","
-             << domain->boxlo[1] << "," << domain->boxhi[1] << ","
-             << domain->boxlo[2] << "," << domain->boxhi[2] << ",):\n"
-             << x[ip] << endl;
-        error->one(FLERR, "");
-      }
+        outside_ip = MIN(outside_ip, ip);
     }
 
     if (update_corners)
@@ -761,6 +893,15 @@ void Solid::compute_particle_velocities_and_positions()
       }
     }
   }
+
+  if (outside_ip < np_local) {
+    cout << "Error: Particle " << outside_ip << " left the domain ("
+         << domain->boxlo[0] << "," << domain->boxhi[0] << ","
+         << domain->boxlo[1] << "," << domain->boxhi[1] << ","
+         << domain->boxlo[2] << "," << domain->boxhi[2] << ",):\n"
+         << x[outside_ip] << endl;
+    error->one(FLERR, "");
+  }
 }
 
 void Solid::compute_particle_acceleration()
@@ -769,14 +910,15 @@ void Solid::compute_particle_acceleration()
 
   int in;
 
+MPM_OMP(omp parallel for private(in))
   for (int ip = 0; ip < np_local; ip++){
     a[ip].setZero();
     if (mat->rigid)
       continue;
-    for (int j = 0; j < numneigh_pn[ip]; j++)
+    for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
     {
-      in = neigh_pn[ip][j];
-      a[ip] += wf_pn[ip][j] * (grid->v_update[in] - grid->v[in]);
+      in = neigh_pn[j];
+      a[ip] += wf_pn[j] * (grid->v_update[in] - grid->v[in]);
     }
     a[ip] *= inv_dt;
     f[ip] = a[ip] * mass[ip];
@@ -784,11 +926,13 @@ void Solid::compute_particle_acceleration()
 }
 
 void Solid::update_particle_velocities(double alpha) {
+MPM_OMP(omp parallel for)
   for (int ip = 0; ip < np_local; ip++) {
     v[ip] = (1 - alpha) * v_update[ip] + alpha * (v[ip] + update->dt * a[ip]);
   }
 }
 void Solid::update_particle_velocities_and_positions(double alpha) {
+MPM_OMP(omp parallel for)
   for (int ip = 0; ip < np_local; ip++) {
     v[ip] = (1 - alpha) * v_update[ip] + alpha * (v[ip] + update->dt * a[ip]);
     x[ip] += update->dt * v[ip];
@@ -810,48 +954,48 @@ void Solid::compute_rate_deformation_gradient_TL(bool doublemapping) {
   if (domain->dimension == 1) {
     for (int ip = 0; ip < np_local; ip++) {
       Fdot[ip].setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++) {
-        in = neigh_pn[ip][j];
-        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[ip][j][0];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+        in = neigh_pn[j];
+        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[j][0];
       }
     }
   } else if ((domain->dimension == 2) && (domain->axisymmetric == true)) {
     for (int ip = 0; ip < np_local; ip++) {
       Fdot[ip].setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++) {
-        in = neigh_pn[ip][j];
-        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[ip][j][0];
-        Fdot[ip](0, 1) += (*vn)[in][0] * wfd_pn[ip][j][1];
-        Fdot[ip](1, 0) += (*vn)[in][1] * wfd_pn[ip][j][0];
-        Fdot[ip](1, 1) += (*vn)[in][1] * wfd_pn[ip][j][1];
-        Fdot[ip](2, 2) += (*vn)[in][0] * wf_pn[ip][j] / x0[ip][0];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+        in = neigh_pn[j];
+        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[j][0];
+        Fdot[ip](0, 1) += (*vn)[in][0] * wfd_pn[j][1];
+        Fdot[ip](1, 0) += (*vn)[in][1] * wfd_pn[j][0];
+        Fdot[ip](1, 1) += (*vn)[in][1] * wfd_pn[j][1];
+        Fdot[ip](2, 2) += (*vn)[in][0] * wf_pn[j] / x0[ip][0];
       }
     }
   } else if ((domain->dimension == 2) && (domain->axisymmetric == false)) {
     for (int ip = 0; ip < np_local; ip++) {
       Fdot[ip].setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++) {
-        in = neigh_pn[ip][j];
-        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[ip][j][0];
-        Fdot[ip](0, 1) += (*vn)[in][0] * wfd_pn[ip][j][1];
-        Fdot[ip](1, 0) += (*vn)[in][1] * wfd_pn[ip][j][0];
-        Fdot[ip](1, 1) += (*vn)[in][1] * wfd_pn[ip][j][1];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+        in = neigh_pn[j];
+        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[j][0];
+        Fdot[ip](0, 1) += (*vn)[in][0] * wfd_pn[j][1];
+        Fdot[ip](1, 0) += (*vn)[in][1] * wfd_pn[j][0];
+        Fdot[ip](1, 1) += (*vn)[in][1] * wfd_pn[j][1];
       }
     }
   } else if (domain->dimension == 3) {
     for (int ip = 0; ip < np_local; ip++) {
       Fdot[ip].setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++) {
-        in = neigh_pn[ip][j];
-        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[ip][j][0];
-        Fdot[ip](0, 1) += (*vn)[in][0] * wfd_pn[ip][j][1];
-        Fdot[ip](0, 2) += (*vn)[in][0] * wfd_pn[ip][j][2];
-        Fdot[ip](1, 0) += (*vn)[in][1] * wfd_pn[ip][j][0];
-        Fdot[ip](1, 1) += (*vn)[in][1] * wfd_pn[ip][j][1];
-        Fdot[ip](1, 2) += (*vn)[in][1] * wfd_pn[ip][j][2];
-        Fdot[ip](2, 0) += (*vn)[in][2] * wfd_pn[ip][j][0];
-        Fdot[ip](2, 1) += (*vn)[in][2] * wfd_pn[ip][j][1];
-        Fdot[ip](2, 2) += (*vn)[in][2] * wfd_pn[ip][j][2];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+        in = neigh_pn[j];
+        Fdot[ip](0, 0) += (*vn)[in][0] * wfd_pn[j][0];
+        Fdot[ip](0, 1) += (*vn)[in][0] * wfd_pn[j][1];
+        Fdot[ip](0, 2) += (*vn)[in][0] * wfd_pn[j][2];
+        Fdot[ip](1, 0) += (*vn)[in][1] * wfd_pn[j][0];
+        Fdot[ip](1, 1) += (*vn)[in][1] * wfd_pn[j][1];
+        Fdot[ip](1, 2) += (*vn)[in][1] * wfd_pn[j][2];
+        Fdot[ip](2, 0) += (*vn)[in][2] * wfd_pn[j][0];
+        Fdot[ip](2, 1) += (*vn)[in][2] * wfd_pn[j][1];
+        Fdot[ip](2, 2) += (*vn)[in][2] * wfd_pn[j][2];
       }
     }
   }
@@ -875,10 +1019,10 @@ void Solid::compute_rate_deformation_gradient_UL(bool doublemapping)
       for (int ip = 0; ip < np_local; ip++)
 	{
 	  L[ip].setZero();
-	  for (int j = 0; j < numneigh_pn[ip]; j++)
+	  for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
 	    {
-	      in = neigh_pn[ip][j];
-	      L[ip](0,0) += (*vn)[in][0]*wfd_pn[ip][j][0];
+	      in = neigh_pn[j];
+	      L[ip](0,0) += (*vn)[in][0]*wfd_pn[j][0];
 	    }
 	}
     }
@@ -887,13 +1031,13 @@ void Solid::compute_rate_deformation_gradient_UL(bool doublemapping)
       for (int ip = 0; ip < np_local; ip++)
 	{
 	  L[ip].setZero();
-	  for (int j = 0; j < numneigh_pn[ip]; j++)
+	  for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
 	    {
-	      in = neigh_pn[ip][j];
-	      L[ip](0,0) += (*vn)[in][0]*wfd_pn[ip][j][0];
-	      L[ip](0,1) += (*vn)[in][0]*wfd_pn[ip][j][1];
-	      L[ip](1,0) += (*vn)[in][1]*wfd_pn[ip][j][0];
-	      L[ip](1,1) += (*vn)[in][1]*wfd_pn[ip][j][1];
+	      in = neigh_pn[j];
+	      L[ip](0,0) += (*vn)[in][0]*wfd_pn[j][0];
+	      L[ip](0,1) += (*vn)[in][0]*wfd_pn[j][1];
+	      L[ip](1,0) += (*vn)[in][1]*wfd_pn[j][0];
+	      L[ip](1,1) += (*vn)[in][1]*wfd_pn[j][1];
 	    }
 	}
     }
@@ -902,14 +1046,14 @@ void Solid::compute_rate_deformation_gradient_UL(bool doublemapping)
       for (int ip = 0; ip < np_local; ip++)
 	{
 	  L[ip].setZero();
-	  for (int j = 0; j < numneigh_pn[ip]; j++)
+	  for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
 	    {
-	      in = neigh_pn[ip][j];
-	      L[ip](0, 0) += (*vn)[in][0] * wfd_pn[ip][j][0];
-	      L[ip](0, 1) += (*vn)[in][0] * wfd_pn[ip][j][1];
-	      L[ip](1, 0) += (*vn)[in][1] * wfd_pn[ip][j][0];
-	      L[ip](1, 1) += (*vn)[in][1] * wfd_pn[ip][j][1];
-	      L[ip](2, 2) += (*vn)[in][0] * wf_pn[ip][j] / x[ip][0];
+	      in = neigh_pn[j];
+	      L[ip](0, 0) += (*vn)[in][0] * wfd_pn[j][0];
+	      L[ip](0, 1) += (*vn)[in][0] * wfd_pn[j][1];
+	      L[ip](1, 0) += (*vn)[in][1] * wfd_pn[j][0];
+	      L[ip](1, 1) += (*vn)[in][1] * wfd_pn[j][1];
+	      L[ip](2, 2) += (*vn)[in][0] * wf_pn[j] / x[ip][0];
 	    }
 	}
     }
@@ -918,18 +1062,18 @@ void Solid::compute_rate_deformation_gradient_UL(bool doublemapping)
       for (int ip = 0; ip < np_local; ip++)
 	{
 	  L[ip].setZero();
-	  for (int j = 0; j < numneigh_pn[ip]; j++)
+	  for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
 	    {
-	      in = neigh_pn[ip][j];
-	      L[ip](0,0) += (*vn)[in][0]*wfd_pn[ip][j][0];
-	      L[ip](0,1) += (*vn)[in][0]*wfd_pn[ip][j][1];
-	      L[ip](0,2) += (*vn)[in][0]*wfd_pn[ip][j][2];
-	      L[ip](1,0) += (*vn)[in][1]*wfd_pn[ip][j][0];
-	      L[ip](1,1) += (*vn)[in][1]*wfd_pn[ip][j][1];
-	      L[ip](1,2) += (*vn)[in][1]*wfd_pn[ip][j][2];
-	      L[ip](2,0) += (*vn)[in][2]*wfd_pn[ip][j][0];
-	      L[ip](2,1) += (*vn)[in][2]*wfd_pn[ip][j][1];
-	      L[ip](2,2) += (*vn)[in][2]*wfd_pn[ip][j][2];
+	      in = neigh_pn[j];
+	      L[ip](0,0) += (*vn)[in][0]*wfd_pn[j][0];
+	      L[ip](0,1) += (*vn)[in][0]*wfd_pn[j][1];
+	      L[ip](0,2) += (*vn)[in][0]*wfd_pn[j][2];
+	      L[ip](1,0) += (*vn)[in][1]*wfd_pn[j][0];
+	      L[ip](1,1) += (*vn)[in][1]*wfd_pn[j][1];
+	      L[ip](1,2) += (*vn)[in][1]*wfd_pn[j][2];
+	      L[ip](2,0) += (*vn)[in][2]*wfd_pn[j][0];
+	      L[ip](2,1) += (*vn)[in][2]*wfd_pn[j][1];
+	      L[ip](2,2) += (*vn)[in][2]*wfd_pn[j][2];
       }
     }
   }
@@ -951,10 +1095,10 @@ void Solid::compute_deformation_gradient()
     {
     for (int ip = 0; ip < np_local; ip++) {
       Ftemp.setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++) {
-        in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+        in = neigh_pn[j];
         dx = (*xn)[in] - (*x0n)[in];
-        Ftemp(0, 0) += dx[0] * wfd_pn[ip][j][0];
+        Ftemp(0, 0) += dx[0] * wfd_pn[j][0];
       }
       F[ip](0, 0) = Ftemp(0, 0) + 1;
     }
@@ -965,14 +1109,14 @@ void Solid::compute_deformation_gradient()
     {
       // F[ip].setZero();
       Ftemp.setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++)
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
       {
-        in = neigh_pn[ip][j];
+        in = neigh_pn[j];
 	dx = (*xn)[in] - (*x0n)[in];
-        Ftemp(0, 0) += dx[0] * wfd_pn[ip][j][0];
-        Ftemp(0, 1) += dx[0] * wfd_pn[ip][j][1];
-        Ftemp(1, 0) += dx[1] * wfd_pn[ip][j][0];
-        Ftemp(1, 1) += dx[1] * wfd_pn[ip][j][1];
+        Ftemp(0, 0) += dx[0] * wfd_pn[j][0];
+        Ftemp(0, 1) += dx[0] * wfd_pn[j][1];
+        Ftemp(1, 0) += dx[1] * wfd_pn[j][0];
+        Ftemp(1, 1) += dx[1] * wfd_pn[j][1];
       }
       F[ip] = Ftemp + eye;
     }
@@ -983,19 +1127,19 @@ void Solid::compute_deformation_gradient()
     {
       // F[ip].setZero();
       Ftemp.setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++)
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
       {
-        in = neigh_pn[ip][j];
+        in = neigh_pn[j];
 	dx = (*xn)[in] - (*x0n)[in];
-        Ftemp(0, 0) += dx[0] * wfd_pn[ip][j][0];
-        Ftemp(0, 1) += dx[0] * wfd_pn[ip][j][1];
-        Ftemp(0, 2) += dx[0] * wfd_pn[ip][j][2];
-        Ftemp(1, 0) += dx[1] * wfd_pn[ip][j][0];
-        Ftemp(1, 1) += dx[1] * wfd_pn[ip][j][1];
-        Ftemp(1, 2) += dx[1] * wfd_pn[ip][j][2];
-        Ftemp(2, 0) += dx[2] * wfd_pn[ip][j][0];
-        Ftemp(2, 1) += dx[2] * wfd_pn[ip][j][1];
-        Ftemp(2, 2) += dx[2] * wfd_pn[ip][j][2];
+        Ftemp(0, 0) += dx[0] * wfd_pn[j][0];
+        Ftemp(0, 1) += dx[0] * wfd_pn[j][1];
+        Ftemp(0, 2) += dx[0] * wfd_pn[j][2];
+        Ftemp(1, 0) += dx[1] * wfd_pn[j][0];
+        Ftemp(1, 1) += dx[1] * wfd_pn[j][1];
+        Ftemp(1, 2) += dx[1] * wfd_pn[j][2];
+        Ftemp(2, 0) += dx[2] * wfd_pn[j][0];
+        Ftemp(2, 1) += dx[2] * wfd_pn[j][1];
+        Ftemp(2, 2) += dx[2] * wfd_pn[j][2];
       }
       // F[ip].noalias() += eye;
       F[ip] = Ftemp + eye;
@@ -1023,55 +1167,55 @@ void Solid::compute_rate_deformation_gradient_TL_APIC(bool doublemapping)
   if (domain->dimension == 1) {
     for (int ip=0; ip<np_local; ip++){
       Fdot[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x0[ip];
-	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
+	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
       }
       Fdot[ip] *= Di;
     }
   } else if ((domain->dimension == 2) && (domain->axisymmetric == false)) {
     for (int ip=0; ip<np_local; ip++){
       Fdot[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x0[ip];
-	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
-	Fdot[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[ip][j];
-	Fdot[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[ip][j];
-	Fdot[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[ip][j];
+	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
+	Fdot[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[j];
+	Fdot[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[j];
+	Fdot[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[j];
       }
       Fdot[ip] *= Di;
     }
   } else if ((domain->dimension == 2) && (domain->axisymmetric == true)) {
     for (int ip=0; ip<np_local; ip++){
       Fdot[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x0[ip];
-	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
-	Fdot[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[ip][j];
-	Fdot[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[ip][j];
-	Fdot[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[ip][j];
-        Fdot[ip](2,2) += (*vn)[in][0] * wf_pn[ip][j] / x0[ip][0];
+	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
+	Fdot[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[j];
+	Fdot[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[j];
+	Fdot[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[j];
+        Fdot[ip](2,2) += (*vn)[in][0] * wf_pn[j] / x0[ip][0];
       }
       Fdot[ip] *= Di;
     }
   } else if (domain->dimension == 3) {
     for (int ip=0; ip<np_local; ip++){
       Fdot[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x0[ip];
-	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
-	Fdot[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[ip][j];
-	Fdot[ip](0,2) += (*vn)[in][0]*dx[2]*wf_pn[ip][j];
-	Fdot[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[ip][j];
-	Fdot[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[ip][j];
-	Fdot[ip](1,2) += (*vn)[in][1]*dx[2]*wf_pn[ip][j];
-	Fdot[ip](2,0) += (*vn)[in][2]*dx[0]*wf_pn[ip][j];
-	Fdot[ip](2,1) += (*vn)[in][2]*dx[1]*wf_pn[ip][j];
-	Fdot[ip](2,2) += (*vn)[in][2]*dx[2]*wf_pn[ip][j];
+	Fdot[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
+	Fdot[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[j];
+	Fdot[ip](0,2) += (*vn)[in][0]*dx[2]*wf_pn[j];
+	Fdot[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[j];
+	Fdot[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[j];
+	Fdot[ip](1,2) += (*vn)[in][1]*dx[2]*wf_pn[j];
+	Fdot[ip](2,0) += (*vn)[in][2]*dx[0]*wf_pn[j];
+	Fdot[ip](2,1) += (*vn)[in][2]*dx[1]*wf_pn[j];
+	Fdot[ip](2,2) += (*vn)[in][2]*dx[2]*wf_pn[j];
       }
       Fdot[ip] *= Di;
     }
@@ -1097,55 +1241,55 @@ void Solid::compute_rate_deformation_gradient_UL_APIC(bool doublemapping)
   if (domain->dimension == 1) {
     for (int ip=0; ip<np_local; ip++){
       L[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x[ip];
-	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
+	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
       }
       L[ip] *= Di;
     }
   } else if ((domain->dimension == 2) && (domain->axisymmetric == false)) {
     for (int ip=0; ip<np_local; ip++){
       L[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x[ip];
-	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
-	L[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[ip][j];
-	L[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[ip][j];
-	L[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[ip][j];
+	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
+	L[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[j];
+	L[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[j];
+	L[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[j];
       }
       L[ip] *= Di;
     }
   } else if ((domain->dimension == 2) && (domain->axisymmetric == true)) {
     for (int ip=0; ip<np_local; ip++){
       L[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x[ip];
-	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
-	L[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[ip][j];
-	L[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[ip][j];
-	L[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[ip][j];
-	L[ip](2,2) += (*vn)[in][0] * wf_pn[ip][j] / x[ip][0];
+	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
+	L[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[j];
+	L[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[j];
+	L[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[j];
+	L[ip](2,2) += (*vn)[in][0] * wf_pn[j] / x[ip][0];
       }
       L[ip] *= Di;
     }
   } else if (domain->dimension == 3) {
     for (int ip=0; ip<np_local; ip++){
       L[ip].setZero();
-      for (int j=0; j<numneigh_pn[ip]; j++){
-	in = neigh_pn[ip][j];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++){
+	in = neigh_pn[j];
 	dx = (*x0n)[in] - x[ip];
-	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[ip][j];
-	L[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[ip][j];
-	L[ip](0,2) += (*vn)[in][0]*dx[2]*wf_pn[ip][j];
-	L[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[ip][j];
-	L[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[ip][j];
-	L[ip](1,2) += (*vn)[in][1]*dx[2]*wf_pn[ip][j];
-	L[ip](2,0) += (*vn)[in][2]*dx[0]*wf_pn[ip][j];
-	L[ip](2,1) += (*vn)[in][2]*dx[1]*wf_pn[ip][j];
-	L[ip](2,2) += (*vn)[in][2]*dx[2]*wf_pn[ip][j];
+	L[ip](0,0) += (*vn)[in][0]*dx[0]*wf_pn[j];
+	L[ip](0,1) += (*vn)[in][0]*dx[1]*wf_pn[j];
+	L[ip](0,2) += (*vn)[in][0]*dx[2]*wf_pn[j];
+	L[ip](1,0) += (*vn)[in][1]*dx[0]*wf_pn[j];
+	L[ip](1,1) += (*vn)[in][1]*dx[1]*wf_pn[j];
+	L[ip](1,2) += (*vn)[in][1]*dx[2]*wf_pn[j];
+	L[ip](2,0) += (*vn)[in][2]*dx[0]*wf_pn[j];
+	L[ip](2,1) += (*vn)[in][2]*dx[1]*wf_pn[j];
+	L[ip](2,2) += (*vn)[in][2]*dx[2]*wf_pn[j];
       }
       L[ip] *= Di;
     }
@@ -1158,7 +1302,7 @@ void Solid::update_deformation_gradient()
     return;
 
   bool status, nh, vol_cpdi;
-  Eigen::Matrix3d eye;
+  Eigen::Matrix3d eye, Finvp, Rp;
   eye.setIdentity();
 
   if (mat->type == material->constitutive_model::NEO_HOOKEAN)
@@ -1183,7 +1327,12 @@ void Solid::update_deformation_gradient()
     else
       F[ip] = (eye + update->dt * L[ip]) * F[ip];
 
-    Finv[ip] = F[ip].inverse();
+    double detF;
+    if (is_TL || nh) {
+      detF = Inverse3x3(F[ip], Finvp);
+      Finv[ip] = Finvp;
+    } else
+      detF = F[ip].determinant();
 
     if (vol_cpdi)
     {
@@ -1200,7 +1349,7 @@ void Solid::update_deformation_gradient()
     }
     else
     {
-      J[ip]   = F[ip].determinant();
+      J[ip]   = detF;
       vol[ip] = J[ip] * vol0[ip];
     }
 
@@ -1209,7 +1358,8 @@ void Solid::update_deformation_gradient()
     {
       cout << "Error: J[" << ptag[ip] << "]<=0.0 == " << J[ip] << endl;
       cout << "F[" << ptag[ip] << "]:" << endl << F[ip] << endl;
-      cout << "Fdot[" << ptag[ip] << "]:" << endl << Fdot[ip] << endl;
+      if (is_TL)
+	cout << "Fdot[" << ptag[ip] << "]:" << endl << Fdot[ip] << endl;
       cout << "damage[" << ptag[ip] << "]:" << endl << damage[ip] << endl;
       error->one(FLERR,"");
     }
@@ -1219,8 +1369,9 @@ void Solid::update_deformation_gradient()
       // Only done if not Neo-Hookean:
 
       if (is_TL) {
-        status = PolDec(F[ip], R[ip]); // polar decomposition of the deformation
-                                       // gradient, F = R * U
+        status = PolDec(F[ip], Rp); // polar decomposition of the deformation
+                                    // gradient, F = R * U
+        R[ip] = Rp;
 
         // In TLMPM. L is computed from Fdot:
         L[ip] = Fdot[ip] * Finv[ip];
@@ -1239,7 +1390,7 @@ void Solid::update_deformation_gradient()
         D[ip] = 0.5 * (L[ip] + L[ip].transpose());
     }
 
-    // strain_increment[ip] = update->dt * D[ip];
+    // strain_increment[ip] = update->dt * D[ip].matrix();
   }
 }
 
@@ -1249,7 +1400,6 @@ void Solid::update_stress()
     return;
 
   max_p_wave_speed = 0;
-  double flow_stress;
   Matrix3d eye, FinvT, PK1, strain_increment;
   bool lin, nh;
 
@@ -1266,154 +1416,85 @@ void Solid::update_stress()
   eye.setIdentity();
 
   if (lin) {
+MPM_OMP(omp parallel for private(strain_increment))
     for (int ip = 0; ip < np_local; ip++) {
-      strain_increment = update->dt * D[ip];
+      strain_increment = update->dt * D[ip].matrix();
       strain_el[ip] += strain_increment;
       sigma[ip] += 2 * mat->G * strain_increment +
                    mat->lambda * strain_increment.trace() * eye;
 
       if (is_TL) {
 	vol0PK1[ip] = vol0[ip] * J[ip] *
-	  (R[ip] * sigma[ip] * R[ip].transpose()) *
+	  (R[ip] * sigma[ip].matrix() * R[ip].transpose()) *
 	  Finv[ip].transpose();
       }
     }
   } else if (nh) {
+MPM_OMP(omp parallel for private(FinvT, PK1))
     for (int ip = 0; ip < np_local; ip++) {
       // Neo-Hookean material:
       FinvT = Finv[ip].transpose();
       PK1 = mat->G * (F[ip] - FinvT) + mat->lambda * log(J[ip]) * FinvT;
-      vol0PK1[ip] = vol0[ip] * PK1;
+      if (is_TL)
+	vol0PK1[ip] = vol0[ip] * PK1;
       sigma[ip] = 1.0 / J[ip] * (F[ip] * PK1.transpose());
 
       strain_el[ip] =
-          0.5 * (F[ip].transpose() * F[ip] - eye); // update->dt * D[ip];
+          0.5 * (F[ip].transpose() * F[ip] - eye); // update->dt * D[ip].matrix();
     }
   } else {
-
-    vector<double> pH(np_local, 0);
-    vector<double> plastic_strain_increment(np_local, 0);
-    vector<Eigen::Matrix3d> sigma_dev;
+    // Work arrays, kept between steps so that they are not reallocated:
+    pH.resize(np_local);
+    plastic_strain_increment.resize(np_local);
     sigma_dev.resize(np_local);
-    double tav = 0;
-
-    for (int ip = 0; ip < np_local; ip++) {
-
-      if (mat->cp != 0) {
-        mat->eos->compute_pressure(pH[ip], ienergy[ip], J[ip], rho[ip],
-                                   damage[ip], D[ip], grid->cellsize, T[ip]);
-        pH[ip] += mat->temp->compute_thermal_pressure(T[ip]);
-
-        sigma_dev[ip] = mat->strength->update_deviatoric_stress(
-            sigma[ip], D[ip], plastic_strain_increment[ip],
-            eff_plastic_strain[ip], eff_plastic_strain_rate[ip], damage[ip],
-            T[ip]);
-      } else {
-        mat->eos->compute_pressure(pH[ip], ienergy[ip], J[ip], rho[ip],
-                                   damage[ip], D[ip], grid->cellsize);
-        sigma_dev[ip] = mat->strength->update_deviatoric_stress(
-            sigma[ip], D[ip], plastic_strain_increment[ip],
-            eff_plastic_strain[ip], eff_plastic_strain_rate[ip], damage[ip]);
-      }
-
-      eff_plastic_strain[ip] += plastic_strain_increment[ip];
-
-      // // compute a characteristic time over which to average the plastic
-      // strain
-
-      tav = 1000 * grid->cellsize / mat->signal_velocity;
-
-      eff_plastic_strain_rate[ip] -=
-          eff_plastic_strain_rate[ip] * update->dt / tav;
-      eff_plastic_strain_rate[ip] += plastic_strain_increment[ip] / tav;
-      eff_plastic_strain_rate[ip] = MAX(0.0, eff_plastic_strain_rate[ip]);
-
-      if (mat->damage != nullptr) {
-	if (update->method->temp) {
-	  mat->damage->compute_damage(damage_init[ip], damage[ip], pH[ip],
-				      sigma_dev[ip], eff_plastic_strain_rate[ip],
-				      plastic_strain_increment[ip], T[ip]);
-	} else {
-	  mat->damage->compute_damage(damage_init[ip], damage[ip], pH[ip],
-				      sigma_dev[ip], eff_plastic_strain_rate[ip],
-				      plastic_strain_increment[ip]);
-	}
-      }
-
-      if (mat->cp != 0) {
-	flow_stress = SQRT_3_OVER_2 * sigma_dev[ip].norm();
-        mat->temp->compute_heat_source(T[ip], gamma[ip], flow_stress,
-                                       eff_plastic_strain_rate[ip]);
-        if (is_TL)
-          gamma[ip] *= vol0[ip] * mat->invcp;
-        else
-          gamma[ip] *= vol[ip] * mat->invcp;
-      }
+    if (mat->cp != 0)
+      flow_stress.resize(np_local);
 
-      if (damage[ip] == 0 || pH[ip] >= 0)
-	sigma[ip] = -pH[ip] * eye + sigma_dev[ip];
-      else
-	sigma[ip] = -pH[ip] * (1.0 - damage[ip])* eye + sigma_dev[ip];
-
-      if (damage[ip] > 1e-10) {
-        strain_el[ip] =
-            (update->dt * D[ip].trace() + strain_el[ip].trace()) / 3.0 * eye +
-            sigma_dev[ip] / (mat->G * (1 - damage[ip]));
-      } else {
-        strain_el[ip] =
-            (update->dt * D[ip].trace() + strain_el[ip].trace()) / 3.0 * eye +
-            sigma_dev[ip] / mat->G;
-      }
-
-      if (is_TL) {
-	vol0PK1[ip] = vol0[ip] * J[ip] *
-	  (R[ip] * sigma[ip] * R[ip].transpose()) *
-	  Finv[ip].transpose();
-      }
+    // Each thread updates a contiguous range of particles, so that the material
+    // models are called once per thread instead of once per particle:
+MPM_OMP(omp parallel)
+    {
+      int first = 0, last = np_local;
+#ifdef _OPENMP
+      int nthreads = omp_get_num_threads();
+      int ithread = omp_get_thread_num();
+      first = (long) np_local * ithread / nthreads;
+      last = (long) np_local * (ithread + 1) / nthreads;
+#endif
+      update_stress_range(first, last - first);
     }
   }
 
   double min_h_ratio = 1.0;
+  double max_speed = 0;
 
+  // max_p_wave_speed being a member, it cannot be reduced by OpenMP directly.
+  // The first faulty particles are recorded and reported once the loop is over,
+  // by the master thread (MPI_THREAD_FUNNELED):
+  int nan_ip = np_local, negative_ip = np_local, flat_ip = np_local;
+MPM_OMP(omp parallel for reduction(max : max_speed) reduction(min : min_h_ratio, nan_ip, negative_ip, flat_ip))
   for (int ip = 0; ip < np_local; ip++) {
     if (damage[ip] >= 1.0)
       continue;
 
-    max_p_wave_speed =
-        MAX(max_p_wave_speed,
+    max_speed =
+        MAX(max_speed,
             sqrt((mat->K + FOUR_THIRD * mat->G) / rho[ip]) +
                 MAX(MAX(fabs(v[ip](0)), fabs(v[ip](1))), fabs(v[ip](2))));
 
-    if (std::isnan(max_p_wave_speed)) {
-      cout << "Error: max_p_wave_speed is nan with ip=" << ip
-           << ", ptag[ip]=" << ptag[ip] << ", rho0[ip]=" << rho0[ip]<< ", rho[ip]=" << rho[ip]
-           << ", K=" << mat->K << ", G=" << mat->G << ", J[ip]=" << J[ip]
-           << endl;
-      error->one(FLERR, "");
-    } else if (max_p_wave_speed < 0.0) {
-      cout << "Error: max_p_wave_speed= " << max_p_wave_speed
-           << " with ip=" << ip << ", rho[ip]=" << rho[ip] << ", K=" << mat->K
-           << ", G=" << mat->G << endl;
-      error->one(FLERR, "");
-    }
+    if (std::isnan(max_speed))
+      nan_ip = MIN(nan_ip, ip);
+    else if (max_speed < 0.0)
+      negative_ip = MIN(negative_ip, ip);
 
     if (is_TL) {
-      EigenSolver<Matrix3d> esF(F[ip], false);
-      if (esF.info()!= Success) {
-	min_h_ratio = MIN(min_h_ratio,1.0);
-      } else {
-	min_h_ratio = MIN(min_h_ratio,fabs(esF.eigenvalues()[0].real()));
-	min_h_ratio = MIN(min_h_ratio,fabs(esF.eigenvalues()[1].real()));
-	min_h_ratio = MIN(min_h_ratio,fabs(esF.eigenvalues()[2].real()));
-      }
+      Vector3d eigF = EigenvaluesRealParts(F[ip]);
+      min_h_ratio = MIN(min_h_ratio,fabs(eigF[0]));
+      min_h_ratio = MIN(min_h_ratio,fabs(eigF[1]));
+      min_h_ratio = MIN(min_h_ratio,fabs(eigF[2]));
 
-      if (min_h_ratio == 0) {
-	cout << "min_h_ratio == 0 with ip=" << ip
-	     << "F=\n" <<  F[ip] << endl
-	     << "eigenvalues of F:" << esF.eigenvalues()[0].real() << "\t" << esF.eigenvalues()[1].real() << "\t" << esF.eigenvalues()[2].real() << endl;
-	cout << "esF.info()=" << esF.info() << endl;
-	error->one(FLERR, "");
-      }
+      if (min_h_ratio == 0)
+	flat_ip = MIN(flat_ip, ip);
 
       // // dt should also be lower than the inverse of \dot{F}e_i.
       // EigenSolver<Matrix3d> esFdot(Fdot[ip], false);
@@ -1426,6 +1507,31 @@ void Solid::update_stress()
     }
   }
 
+  if (nan_ip < np_local) {
+    int ip = nan_ip;
+    cout << "Error: max_p_wave_speed is nan with ip=" << ip
+	 << ", ptag[ip]=" << ptag[ip] << ", rho0[ip]=" << rho0[ip]<< ", rho[ip]=" << rho[ip]
+	 << ", K=" << mat->K << ", G=" << mat->G << ", J[ip]=" << J[ip]
+	 << endl;
+    error->one(FLERR, "");
+  } else if (negative_ip < np_local) {
+    int ip = negative_ip;
+    cout << "Error: max_p_wave_speed= " << max_speed
+	 << " with ip=" << ip << ", rho[ip]=" << rho[ip] << ", K=" << mat->K
+	 << ", G=" << mat->G << endl;
+    error->one(FLERR, "");
+  }
+
+  if (flat_ip < np_local) {
+    int ip = flat_ip;
+    Vector3d eigF = EigenvaluesRealParts(F[ip]);
+    cout << "min_h_ratio == 0 with ip=" << ip
+	 << "F=\n" <<  F[ip] << endl
+	 << "eigenvalues of F:" << eigF[0] << "\t" << eigF[1] << "\t" << eigF[2] << endl;
+    error->one(FLERR, "");
+  }
+
+  max_p_wave_speed = max_speed;
   dtCFL = MIN(dtCFL, grid->cellsize * min_h_ratio / max_p_wave_speed);
 
   if (std::isnan(dtCFL))
@@ -1437,10 +1543,489 @@ void Solid::update_stress()
   }
 }
 
+/*! Updates the stress of particles first to first + n - 1 using the strength,
+ * EOS, damage and temperature models of the material (see update_stress()).
+ */
+void Solid::update_stress_range(int first, int n)
+{
+  if (n == 0)
+    return;
+
+  Matrix3d eye;
+  eye.setIdentity();
+
+  const bool thermal = mat->cp != 0;
+  const double *Tp = T.empty() ? nullptr : T.data() + first;
+  double *pHp = pH.data() + first;
+  double *dep = plastic_strain_increment.data() + first;
+  double *epsdot = eff_plastic_strain_rate.data() + first;
+  Matrix3d *Sdev = sigma_dev.data() + first;
+
+  fill_n(pHp, n, 0.0);
+  fill_n(dep, n, 0.0);
+
+  mat->eos->compute_pressure(n, pHp, ienergy.data() + first, J.data() + first,
+                             rho.data() + first, damage.data() + first,
+                             D.columns(first), grid->cellsize,
+                             thermal ? Tp : nullptr);
+  if (thermal)
+    mat->temp->compute_thermal_pressure(n, Tp, pHp);
+
+  mat->strength->update_deviatoric_stress(n, sigma.columns(first), D.columns(first),
+                                          Sdev, dep, eff_plastic_strain.data() + first,
+                                          epsdot, damage.data() + first,
+                                          thermal ? Tp : nullptr);
+
+  // compute a characteristic time over which to average the plastic strain
+  const double tav = 1000 * grid->cellsize / mat->signal_velocity;
+
+  for (int i = 0; i < n; i++) {
+    eff_plastic_strain[first + i] += dep[i];
+
+    epsdot[i] -= epsdot[i] * update->dt / tav;
+    epsdot[i] += dep[i] / tav;
+    epsdot[i] = MAX(0.0, epsdot[i]);
+  }
+
+  if (mat->damage != nullptr)
+    mat->damage->compute_damage(n, damage_init.data() + first, damage.data() + first,
+                                pHp, Sdev, epsdot, dep,
+                                update->method->temp ? Tp : nullptr);
+
+  if (thermal) {
+    double *flow = flow_stress.data() + first;
+    for (int i = 0; i < n; i++)
+      flow[i] = SQRT_3_OVER_2 * Sdev[i].norm();
+
+    mat->temp->compute_heat_source(n, Tp, gamma.data() + first, flow, epsdot);
+
+    const vector<double> &volume = is_TL ? vol0 : vol;
+    for (int ip = first; ip < first + n; ip++)
+      gamma[ip] *= volume[ip] * mat->invcp;
+  }
+
+  for (int ip = first; ip < first + n; ip++) {
+    const int i = ip - first;
+
+    if (damage[ip] == 0 || pH[ip] >= 0)
+      sigma[ip] = -pH[ip] * eye + Sdev[i];
+    else
+      sigma[ip] = -pH[ip] * (1.0 - damage[ip])* eye + Sdev[i];
+
+    if (damage[ip] > 1e-10) {
+      strain_el[ip] =
+	(update->dt * D[ip].trace() + strain_el[ip].trace()) / 3.0 * eye +
+	Sdev[i] / (mat->G * (1 - damage[ip]));
+    } else {
+      strain_el[ip] =
+	(update->dt * D[ip].trace() + strain_el[ip].trace()) / 3.0 * eye +
+	Sdev[i] / mat->G;
+    }
+
+    if (is_TL) {
+      vol0PK1[ip] = vol0[ip] * J[ip] *
+	(R[ip] * sigma[ip].matrix() * R[ip].transpose()) *
+	Finv[ip].transpose();
+    }
+  }
+}
+
+void Solid::clear_neighbours()
+{
+  // clear() keeps the capacity of the vectors, so that rebuilding the lists
+  // at every time step does not reallocate them:
+  neigh_pn.clear();
+  wf_pn.clear();
+  wfd_pn.clear();
+  wf_pn_corners.clear();
+  neigh_pn_offset.assign(np_local + 1, 0);
+}
+
+/*! node_slot is -1 for all the nodes between two calls: only the entries of the nodes
+ * found are set, then reset, so that the cost does not depend on the size of the grid.\n
+ * The nodes exchanged with other CPUs come first, so that the P2G functions can visit
+ * them apart from the others (see NodeSet).
+ */
+void Solid::compute_neigh_nodes()
+{
+  int nn = grid->nnodes_local + grid->nnodes_ghost;
+
+  node_slot.resize(nn, -1);
+  neigh_nodes.clear();
+  for (int in: neigh_pn) {
+    if (node_slot[in] < 0) {
+      node_slot[in] = 0;
+      neigh_nodes.push_back(in);
+    }
+  }
+
+  for (int in: neigh_nodes)
+    node_slot[in] = -1;
+
+  // Nodes in increasing order are visited in the order of the grid arrays:
+  sort(neigh_nodes.begin(), neigh_nodes.end());
+
+  const vector<char> &exchanged = grid->exchanged;
+  auto interior = stable_partition(neigh_nodes.begin(), neigh_nodes.end(),
+				   [&exchanged](int in) { return exchanged[in] != 0; });
+  neigh_nodes_boundary = interior - neigh_nodes.begin();
+}
+
+void Solid::neigh_nodes_range(NodeSet nodes, int &a0, int &a1) const
+{
+  a0 = nodes == INTERIOR_NODES ? neigh_nodes_boundary : 0;
+  a1 = nodes == BOUNDARY_NODES ? neigh_nodes_boundary : neigh_nodes.size();
+}
+
+void Solid::scatter_colour_range(NodeSet nodes, int &c0, int &c1) const
+{
+  int ncolours = (scatter_colour_offset.size() - 1) / 2;
+  c0 = nodes == INTERIOR_NODES ? ncolours : 0;
+  c1 = nodes == BOUNDARY_NODES ? ncolours : 2 * ncolours;
+}
+
+/*! Only the nodes neighbouring the particles, listed in neigh_nodes, get a list of
+ * particles, so that building and visiting the lists costs as much as the particle-node
+ * pairs, whatever the size of the grid shared with other solids.
+ */
+void Solid::compute_neigh_np()
+{
+  int npairs = neigh_pn.size();
+
+  compute_neigh_nodes();
+  int nnodes = neigh_nodes.size();
+  for (int a = 0; a < nnodes; a++)
+    node_slot[neigh_nodes[a]] = a;
+
+  // Count the particles neighbouring each node:
+  neigh_np_offset.assign(nnodes + 1, 0);
+  for (int k = 0; k < npairs; k++)
+    neigh_np_offset[node_slot[neigh_pn[k]] + 1]++;
+
+  for (int a = 0; a < nnodes; a++)
+    neigh_np_offset[a + 1] += neigh_np_offset[a];
+
+  // Fill the lists, particles being sorted by increasing index for each node.
+  // neigh_np_offset[a] is used as insertion point, so it ends up equal to
+  // neigh_np_offset[a + 1] and has to be shifted back afterwards:
+  neigh_np.resize(npairs);
+  np_to_pn.resize(npairs);
+
+  for (int ip = 0; ip < np_local; ip++)
+    for (int k = neigh_pn_offset[ip]; k < neigh_pn_offset[ip + 1]; k++) {
+      int j = neigh_np_offset[node_slot[neigh_pn[k]]]++;
+      neigh_np[j] = ip;
+      np_to_pn[j] = k;
+    }
+
+  for (int a = nnodes; a > 0; a--)
+    neigh_np_offset[a] = neigh_np_offset[a - 1];
+  neigh_np_offset[0] = 0;
+
+  for (int in: neigh_nodes)
+    node_slot[in] = -1;
+}
+
+/*! The domain is divided into blocks of nstencil cells per direction, nstencil being the
+ * number of nodes per direction a particle interacts with. Blocks are coloured with
+ * 2^dimension colours so that two blocks of the same colour are always separated by
+ * a block of another colour: the particles of two blocks of the same colour never
+ * share a node, and the blocks of one colour can be scattered concurrently.\n
+ * Within a block, particles are kept in increasing order so that the summation order
+ * at each node, hence the result, does not depend on the number of threads.\n
+ * The particles neighbouring a node exchanged with other CPUs (Grid::exchanged) are
+ * sorted first, in colours of their own: they are the only ones contributing to these
+ * nodes, which are complete once they are scattered, while the other particles only
+ * contribute to interior nodes.
+ */
+void Solid::compute_scatter_blocks(int nstencil)
+{
+  int nb[3] = {1, 1, 1};
+  double inv_blocksize = 1.0 / (nstencil * grid->cellsize);
+
+  for (int d = 0; d < domain->dimension; d++)
+    nb[d] = (int) ((domain->boxhi[d] - domain->boxlo[d]) * inv_blocksize) + 2;
+
+  long int nblocks = (long int) nb[0] * nb[1] * nb[2];
+  int ncolours = 1 << domain->dimension;
+  vector<pair<long int, int>> keys(np_local);
+
+  for (int ip = 0; ip < np_local; ip++) {
+    int b[3] = {0, 0, 0};
+    int colour = ncolours;
+    for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++)
+      if (grid->exchanged[neigh_pn[j]]) {
+	colour = 0;
+	break;
+      }
+
+    for (int d = 0; d < domain->dimension; d++) {
+      // Particles outside of the box join the first or last block along d. These blocks
+      // only grow away from the other blocks of the same colour, which stay independent:
+      double t = (x[ip][d] - domain->boxlo[d]) * inv_blocksize;
+      if (!(t >= 0)) b[d] = 0;
+      else if (t >= nb[d] - 1) b[d] = nb[d] - 1;
+      else b[d] = (int) t;
+      colour += (b[d] & 1) << d;
+    }
+    keys[ip] = make_pair(colour * nblocks + b[0] + nb[0] * (b[1] + (long int) nb[1] * b[2]), ip);
+  }
+
+  sort(keys.begin(), keys.end());
+
+  scatter_particles.resize(np_local);
+  scatter_block_offset.clear();
+  scatter_colour_offset.assign(2 * ncolours + 1, 0);
+
+  for (int k = 0; k < np_local; k++) {
+    scatter_particles[k] = keys[k].second;
+    if (k == 0 || keys[k].first != keys[k - 1].first) {
+      scatter_colour_offset[keys[k].first / nblocks + 1] = scatter_block_offset.size() + 1;
+      scatter_block_offset.push_back(k);
+    }
+  }
+  scatter_block_offset.push_back(np_local);
+
+  // Colours without any block start where the previous colour ends:
+  for (int c = 1; c <= 2 * ncolours; c++)
+    scatter_colour_offset[c] = MAX(scatter_colour_offset[c], scatter_colour_offset[c - 1]);
+}
+
+/*! Particles are sorted by the Morton code of the cell they are in, so that
+ * particles close in space are also close in memory and the nodes they share
+ * stay in cache during the particle loops and the P2G and G2P transfers.\n
+ * All per-particle vectors are permuted together. The neighbour lists become
+ * invalid and must be rebuilt before being used again.
+ */
+void Solid::sort_particles()
+{
+  if (np_local < 2) return;
+
+  double inv_cellsize = 1.0 / grid->cellsize;
+  vector<pair<uint64_t, int>> keys(np_local);
+
+  for (int ip = 0; ip < np_local; ip++) {
+    uint64_t code = 0;
+    for (int d = 0; d < domain->dimension; d++) {
+      // 21 bits per axis fit the 3 interleaved indices in 64 bits:
+      uint64_t c = (uint64_t) MAX(0, (int) ((x[ip][d] - domain->boxlo[d]) * inv_cellsize)) & 0x1FFFFF;
+      for (int b = 0; b < 21; b++)
+	code |= ((c >> b) & 1) << (domain->dimension * b + d);
+    }
+    keys[ip] = make_pair(code, ip);
+  }
+
+  sort(keys.begin(), keys.end());
+
+  vector<int> perm(np_local);
+  bool sorted = true;
+  for (int k = 0; k < np_local; k++) {
+    perm[k] = keys[k].second;
+    if (perm[k] != k) sorted = false;
+  }
+  if (sorted) return;
+
+  for (auto &field: fields)
+    field->permute(perm);
+}
+
+void Solid::compute_mass_nodes_scatter(bool reset, NodeSet nodes)
+{
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int c0, c1;
+  scatter_colour_range(nodes, c0, c1);
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->mass[active[ia]] = 0;
+
+  for (int c = c0; c < c1; c++) {
+MPM_OMP(omp parallel for schedule(dynamic))
+    for (int b = scatter_colour_offset[c]; b < scatter_colour_offset[c + 1]; b++) {
+      for (int k = scatter_block_offset[b]; k < scatter_block_offset[b + 1]; k++) {
+	int ip = scatter_particles[k];
+	for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+	  int in = neigh_pn[j];
+	  if (grid->rigid[in] && !mat->rigid) continue;
+	  grid->mass[in] += wf_pn[j] * mass[ip];
+	}
+      }
+    }
+  }
+}
+
+/*! The boundary particles also contribute to interior nodes: the buffer is zeroed for
+ * all the nodes with the boundary nodes, and kept until the interior nodes are done.
+ */
+void Solid::compute_velocity_nodes_scatter(bool reset, NodeSet nodes)
+{
+  int nn = grid->nnodes_local + grid->nnodes_ghost;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int nnodes = neigh_nodes.size();
+  int a0, a1, c0, c1;
+  neigh_nodes_range(nodes, a0, a1);
+  scatter_colour_range(nodes, c0, c1);
+
+  // Particles only contribute to the nodes of neigh_nodes, so only these have
+  // to be zeroed and combined with the grid:
+  scatter_buffer.resize(nn);
+  scatter_buffer_update.resize(nn);
+  if (nodes != INTERIOR_NODES)
+MPM_OMP(omp parallel for)
+    for (int a = 0; a < nnodes; a++) {
+      scatter_buffer[neigh_nodes[a]].setZero();
+      scatter_buffer_update[neigh_nodes[a]].setZero();
+    }
+
+  for (int c = c0; c < c1; c++) {
+MPM_OMP(omp parallel for schedule(dynamic))
+    for (int b = scatter_colour_offset[c]; b < scatter_colour_offset[c + 1]; b++) {
+      for (int k = scatter_block_offset[b]; k < scatter_block_offset[b + 1]; k++) {
+	int ip = scatter_particles[k];
+	for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+	  int in = neigh_pn[j];
+	  if (grid->rigid[in] && !mat->rigid) continue;
+
+	  if (grid->rigid[in]) {
+	    scatter_buffer_update[in] += (wf_pn[j] * mass[ip]) * v_update[ip];
+	  }
+	  if (update->method->ge) {
+	    scatter_buffer[in] += (wf_pn[j] * mass[ip]) *
+	      (v[ip] + L[ip] * (grid->x0[in] - x[ip]));
+	  } else {
+	    scatter_buffer[in] += wf_pn[j] * mass[ip] * v[ip];
+	  }
+	}
+      }
+    }
+  }
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++) {
+      int in = active[ia];
+      grid->v[in].setZero();
+      if (grid->rigid[in]) {
+	grid->mb[in].setZero();
+      }
+    }
+
+MPM_OMP(omp parallel for)
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
+
+    if (grid->rigid[in] && !mat->rigid) continue;
+
+    if (grid->mass[in] > 0) {
+      grid->v[in] += scatter_buffer[in] / grid->mass[in];
+      if (grid->rigid[in]) {
+	grid->mb[in] += scatter_buffer_update[in] / grid->mass[in]; // See compute_velocity_nodes()
+      }
+    }
+  }
+}
+
+void Solid::compute_velocity_nodes_APIC_scatter(bool reset, NodeSet nodes)
+{
+  int nn = grid->nnodes_local + grid->nnodes_ghost;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int nnodes = neigh_nodes.size();
+  int a0, a1, c0, c1;
+  neigh_nodes_range(nodes, a0, a1);
+  scatter_colour_range(nodes, c0, c1);
+
+  ParticleVectors *pos;
+  ParticleMatrices *C;
+
+  if (is_TL) {
+    pos = &x0;
+    C = &Fdot;
+  } else {
+    pos = &x;
+    C = &L;
+  }
+
+  scatter_buffer.resize(nn);
+  if (nodes != INTERIOR_NODES)
+MPM_OMP(omp parallel for)
+    for (int a = 0; a < nnodes; a++)
+      scatter_buffer[neigh_nodes[a]].setZero();
+
+  for (int c = c0; c < c1; c++) {
+MPM_OMP(omp parallel for schedule(dynamic))
+    for (int b = scatter_colour_offset[c]; b < scatter_colour_offset[c + 1]; b++) {
+      for (int k = scatter_block_offset[b]; k < scatter_block_offset[b + 1]; k++) {
+	int ip = scatter_particles[k];
+	for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+	  int in = neigh_pn[j];
+	  if (grid->rigid[in] && !mat->rigid) continue;
+	  scatter_buffer[in] += (wf_pn[j] * mass[ip]) *
+	    (v[ip] + (*C)[ip] * (grid->x0[in] - (*pos)[ip]));
+	}
+      }
+    }
+  }
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->v[active[ia]].setZero();
+
+MPM_OMP(omp parallel for)
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
+
+    if (grid->rigid[in] && !mat->rigid)
+      continue;
+
+    if (grid->mass[in] > 0)
+      grid->v[in] += scatter_buffer[in] / grid->mass[in];
+  }
+}
+
+void Solid::compute_external_and_internal_forces_nodes_UL_scatter(bool reset, NodeSet nodes)
+{
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int c0, c1;
+  scatter_colour_range(nodes, c0, c1);
+
+  if (reset)
+MPM_OMP(omp parallel for)
+    for (int ia = 0; ia < nactive; ia++) {
+      int in = active[ia];
+      grid->f[in].setZero();
+      grid->mb[in].setZero();
+    }
+
+  for (int c = c0; c < c1; c++) {
+MPM_OMP(omp parallel for schedule(dynamic))
+    for (int b = scatter_colour_offset[c]; b < scatter_colour_offset[c + 1]; b++) {
+      for (int k = scatter_block_offset[b]; k < scatter_block_offset[b + 1]; k++) {
+	int ip = scatter_particles[k];
+	for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+	  int in = neigh_pn[j];
+	  grid->f[in] -= vol[ip] * (sigma[ip].matrix() * wfd_pn[j]);
+
+	  if (domain->axisymmetric == true)
+	    grid->f[in][0] -= vol[ip] * (sigma[ip](2, 2) * wf_pn[j] / x[ip][0]);
+
+	  if (!grid->rigid[in])
+	    grid->mb[in] += wf_pn[j] * mbp[ip];
+	}
+      }
+    }
+  }
+}
+
 void Solid::compute_inertia_tensor() {
   Eigen::Vector3d dx;
 
-  vector<Eigen::Vector3d> *pos;
+  ParticleVectors *pos;
   Eigen::Matrix3d eye, Dtemp;
   eye.setIdentity();
   double cellsizeSqInv = 1.0 / (grid->cellsize * grid->cellsize);
@@ -1485,12 +2070,12 @@ void Solid::compute_inertia_tensor() {
   // if (domain->dimension == 2) {
   //   for (int ip = 0; ip < np_local; ip++) {
   //     Dtemp.setZero();
-  //     for (int j = 0; j < numneigh_pn[ip]; j++) {
-  //       in = neigh_pn[ip][j];
+  //     for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+  //       in = neigh_pn[j];
   //       dx = grid->x0[in] - (*pos)[ip];
-  //       Dtemp(0, 0) += wf_pn[ip][j] * (dx[0] * dx[0]);
-  //       Dtemp(0, 1) += wf_pn[ip][j] * (dx[0] * dx[1]);
-  //       Dtemp(1, 1) += wf_pn[ip][j] * (dx[1] * dx[1]);
+  //       Dtemp(0, 0) += wf_pn[j] * (dx[0] * dx[0]);
+  //       Dtemp(0, 1) += wf_pn[j] * (dx[0] * dx[1]);
+  //       Dtemp(1, 1) += wf_pn[j] * (dx[1] * dx[1]);
   //     }
   //     Dtemp(1, 0) = Dtemp(0, 1);
   //     Dtemp(2, 2) = 1;
@@ -1499,15 +2084,15 @@ void Solid::compute_inertia_tensor() {
   // } else if (domain->dimension == 3) {
   //   for (int ip = 0; ip < np_local; ip++) {
   //     Dtemp.setZero();
-  //     for (int j = 0; j < numneigh_pn[ip]; j++) {
-  //       in = neigh_pn[ip][j];
+  //     for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+  //       in = neigh_pn[j];
   //       dx = grid->x0[in] - (*pos)[ip];
-  //       Dtemp(0, 0) += wf_pn[ip][j] * (dx[0] * dx[0]);
-  //       Dtemp(0, 1) += wf_pn[ip][j] * (dx[0] * dx[1]);
-  //       Dtemp(0, 2) += wf_pn[ip][j] * (dx[0] * dx[2]);
-  //       Dtemp(1, 1) += wf_pn[ip][j] * (dx[1] * dx[1]);
-  //       Dtemp(1, 2) += wf_pn[ip][j] * (dx[1] * dx[2]);
-  //       Dtemp(2, 2) += wf_pn[ip][j] * (dx[2] * dx[2]);
+  //       Dtemp(0, 0) += wf_pn[j] * (dx[0] * dx[0]);
+  //       Dtemp(0, 1) += wf_pn[j] * (dx[0] * dx[1]);
+  //       Dtemp(0, 2) += wf_pn[j] * (dx[0] * dx[2]);
+  //       Dtemp(1, 1) += wf_pn[j] * (dx[1] * dx[1]);
+  //       Dtemp(1, 2) += wf_pn[j] * (dx[1] * dx[2]);
+  //       Dtemp(2, 2) += wf_pn[j] * (dx[2] * dx[2]);
   //     }
   //     Dtemp(1, 0) = Dtemp(0, 1);
   //     Dtemp(2, 1) = Dtemp(1, 2);
@@ -1553,256 +2138,26 @@ void Solid::compute_inertia_tensor() {
 }
 
 void Solid::copy_particle(int i, int j) {
-  ptag[j]                    = ptag[i];
-  x0[j]                      = x0[i];
-  x[j]                       = x[i];
-  v[j]                       = v[i];
-  v_update[j]                = v_update[i];
-  a[j]                       = a[i];
-  mbp[j]                     = mbp[i];
-  f[j]                       = f[i];
-  vol0[j]                    = vol0[i];
-  vol[j]                     = vol[i];
-  rho0[j]                    = rho0[i];
-  rho[j]                     = rho[i];
-  mass[j]                    = mass[i];
-  eff_plastic_strain[j]      = eff_plastic_strain[i];
-  eff_plastic_strain_rate[j] = eff_plastic_strain_rate[i];
-  damage[j]                  = damage[i];
-  damage_init[j]             = damage_init[i];
-  if (update->method->temp) {
-    T[j]                     = T[i];
-    gamma[j]                   = gamma[i];
-    q[j]                       = q[i];
-  }
-  ienergy[j]                 = ienergy[i];
-  mask[j]                    = mask[i];
-  sigma[j]                   = sigma[i];
-  strain_el[j]               = strain_el[i];
-  vol0PK1[j]                 = vol0PK1[i];
-  L[j]                       = L[i];
-  F[j]                       = F[i];
-  R[j]                       = R[i];
-  D[j]                       = D[i];
-  Finv[j]                    = Finv[i];
-  Fdot[j]                    = Fdot[i];
-  J[j]                       = J[i];
-  // if (method_type.compare("tlcpdi") == 0 || method_type.compare("ulcpdi") == 0)
-  //   {
-  //     if (update->method->style == 0)
-  // 	{ // CPDI-R4
-  // 	  for (int id = 0; id < domain->dimension; id++)
-  // 	    {
-  // 	      rp0[domain->dimension * j + id] = rp0[domain->dimension * i + id];
-  // 	      rp[domain->dimension * j + id]  = rp[domain->dimension * i + id];
-  // 	    }
-  // 	}
-
-  //     if (update->method->style == 1)
-  // 	{ // CPDI-Q4
-  // 	  for (int ic = 0; ic < nc; ic++)
-  // 	    {
-  // 	      xpc0[nc * j + ic] = xpc0[nc * i + ic];
-  // 	      xpc[nc * j + ic]  = xpc[nc * i + ic];
-  // 	    }
-  // 	}
-  //   }
+  for (auto &field: fields)
+    field->copy(i, j);
 }
 
 void Solid::pack_particle(int i, vector<double> &buf)
 {
-  buf.push_back(ptag[i]);
-
-  buf.push_back(x[i](0));
-  buf.push_back(x[i](1));
-  buf.push_back(x[i](2));
-
-  buf.push_back(x0[i](0));
-  buf.push_back(x0[i](1));
-  buf.push_back(x0[i](2));
-
-  buf.push_back(v[i](0));
-  buf.push_back(v[i](1));
-  buf.push_back(v[i](2));
-
-  buf.push_back(v_update[i](0));
-  buf.push_back(v_update[i](1));
-  buf.push_back(v_update[i](2));
-
-  buf.push_back(a[i](0));
-  buf.push_back(a[i](1));
-  buf.push_back(a[i](2));
-
-  buf.push_back(mbp[i](0));
-  buf.push_back(mbp[i](1));
-  buf.push_back(mbp[i](2));
-
-  buf.push_back(f[i](0));
-  buf.push_back(f[i](1));
-  buf.push_back(f[i](2));
-
-  buf.push_back(vol0[i]);
-  buf.push_back(vol[i]);
-  
-  buf.push_back(rho0[i]);
-  buf.push_back(rho[i]);
-
-  buf.push_back(mass[i]);
-  buf.push_back(eff_plastic_strain[i]);
-  buf.push_back(eff_plastic_strain_rate[i]);
-  buf.push_back(damage[i]);
-  buf.push_back(damage_init[i]);
-  if (update->method->temp) {
-    buf.push_back(T[i]);
-    buf.push_back(gamma[i]);
-    buf.push_back(q[i][0]);
-    buf.push_back(q[i][1]);
-    buf.push_back(q[i][2]);
-  }
-  buf.push_back(ienergy[i]);
-  buf.push_back(mask[i]);
-
-  buf.push_back(sigma[i](0,0));
-  buf.push_back(sigma[i](1,1));
-  buf.push_back(sigma[i](2,2));
-  buf.push_back(sigma[i](0,1));
-  buf.push_back(sigma[i](0,2));
-  buf.push_back(sigma[i](1,2));
-
-  // buf.push_back(vol0PK1[i](0,0));
-  // buf.push_back(vol0PK1[i](0,1));
-  // buf.push_back(vol0PK1[i](0,2));
-  // buf.push_back(vol0PK1[i](1,0));
-  // buf.push_back(vol0PK1[i](1,1));
-  // buf.push_back(vol0PK1[i](1,2));
-  // buf.push_back(vol0PK1[i](2,0));
-  // buf.push_back(vol0PK1[i](2,1));
-  // buf.push_back(vol0PK1[i](2,2));
-
-  // buf.push_back(L[i](0,0));
-  // buf.push_back(L[i](0,1));
-  // buf.push_back(L[i](0,2));
-  // buf.push_back(L[i](1,0));
-  // buf.push_back(L[i](1,1));
-  // buf.push_back(L[i](1,2));
-  // buf.push_back(L[i](2,0));
-  // buf.push_back(L[i](2,1));
-  // buf.push_back(L[i](2,2));
-
-  buf.push_back(F[i](0,0));
-  buf.push_back(F[i](0,1));
-  buf.push_back(F[i](0,2));
-  buf.push_back(F[i](1,0));
-  buf.push_back(F[i](1,1));
-  buf.push_back(F[i](1,2));
-  buf.push_back(F[i](2,0));
-  buf.push_back(F[i](2,1));
-  buf.push_back(F[i](2,2));
-
-  buf.push_back(J[i]);
+  for (auto &field: fields)
+    if (field->flags & ParticleField::COMM)
+      field->pack(i, buf);
 }
 
 void Solid::unpack_particle(int &i, vector<int> list, vector<double> &buf)
 {
-  int m;
   for (auto j: list)
     {
-      m = j;
-
-      ptag[i] = (tagint) buf[m++];
-
-      x[i](0) = buf[m++];
-      x[i](1) = buf[m++];
-      x[i](2) = buf[m++];
-
-      x0[i](0) = buf[m++];
-      x0[i](1) = buf[m++];
-      x0[i](2) = buf[m++];
-
-      v[i](0) = buf[m++];
-      v[i](1) = buf[m++];
-      v[i](2) = buf[m++];
-
-      v_update[i](0) = buf[m++];
-      v_update[i](1) = buf[m++];
-      v_update[i](2) = buf[m++];
-
-      a[i](0) = buf[m++];
-      a[i](1) = buf[m++];
-      a[i](2) = buf[m++];
-
-      mbp[i](0) = buf[m++];
-      mbp[i](1) = buf[m++];
-      mbp[i](2) = buf[m++];
+      const double *b = &buf[j];
 
-      f[i](0) = buf[m++];
-      f[i](1) = buf[m++];
-      f[i](2) = buf[m++];
-
-      vol0[i] = buf[m++];
-      vol[i] = buf[m++];
-
-      rho0[i] = buf[m++];
-      rho[i] = buf[m++];
-
-      mass[i] = buf[m++];
-      eff_plastic_strain[i] = buf[m++];
-      eff_plastic_strain_rate[i] = buf[m++];
-      damage[i] = buf[m++];
-      damage_init[i] = buf[m++];
-      if (update->method->temp) {
-	T[i] = buf[m++];
-	gamma[i] = buf[m++];
-
-	q[i][0] = buf[m++];
-	q[i][1] = buf[m++];
-	q[i][2] = buf[m++];
-      }
-
-      ienergy[i] = buf[m++];
-      mask[i] = buf[m++];
-
-      sigma[i](0,0) = buf[m++];
-      sigma[i](1,1) = buf[m++];
-      sigma[i](2,2) = buf[m++];
-      sigma[i](0,1) = buf[m++];
-      sigma[i](0,2) = buf[m++];
-      sigma[i](1,2) = buf[m++];
-      sigma[i](1,0) = sigma[i](0,1);
-      sigma[i](2,0) = sigma[i](0,2);
-      sigma[i](2,1) = sigma[i](1,2);
-
-      // vol0PK1[i](0,0) = buf[m++];
-      // vol0PK1[i](0,1) = buf[m++];
-      // vol0PK1[i](0,2) = buf[m++];
-      // vol0PK1[i](1,0) = buf[m++];
-      // vol0PK1[i](1,1) = buf[m++];
-      // vol0PK1[i](1,2) = buf[m++];
-      // vol0PK1[i](2,0) = buf[m++];
-      // vol0PK1[i](2,1) = buf[m++];
-      // vol0PK1[i](2,2) = buf[m++];
-
-      // L[i](0,0) = buf[m++];
-      // L[i](0,1) = buf[m++];
-      // L[i](0,2) = buf[m++];
-      // L[i](1,0) = buf[m++];
-      // L[i](1,1) = buf[m++];
-      // L[i](1,2) = buf[m++];
-      // L[i](2,0) = buf[m++];
-      // L[i](2,1) = buf[m++];
-      // L[i](2,2) = buf[m++];
-
-      F[i](0,0) = buf[m++];
-      F[i](0,1) = buf[m++];
-      F[i](0,2) = buf[m++];
-      F[i](1,0) = buf[m++];
-      F[i](1,1) = buf[m++];
-      F[i](1,2) = buf[m++];
-      F[i](2,0) = buf[m++];
-      F[i](2,1) = buf[m++];
-      F[i](2,2) = buf[m++];
-
-      J[i] = buf[m++];
+      for (auto &field: fields)
+	if (field->flags & ParticleField::COMM)
+	  b = field->unpack(i, b);
       i++;
     }
 }
@@ -2284,6 +2639,8 @@ void Solid::populate(vector<string> args)
   np_local = l; // Adjust np to account for the particles outside the domain
   cout << "np_local=" << np_local << endl;
 
+  bool has_Finv = has_field("Finv");
+
   for (int i = 0; i < np_local; i++)
   {
     a[i].setZero();
@@ -2304,7 +2661,8 @@ void Solid::populate(vector<string> args)
     eff_plastic_strain[i]      = 0;
     eff_plastic_strain_rate[i] = 0;
     damage[i]                  = 0;
-    damage_init[i]             = 0;
+    if (mat->damage != nullptr)
+      damage_init[i]           = 0;
     if (update->method->temp) {
       T[i]                     = T0;
       gamma[i]                 = 0;
@@ -2313,13 +2671,16 @@ void Solid::populate(vector<string> args)
     ienergy[i]                 = 0;
     strain_el[i].setZero();
     sigma[i].setZero();
-    vol0PK1[i].setZero();
     L[i].setZero();
     F[i].setIdentity();
-    R[i].setIdentity();
     D[i].setZero();
-    Finv[i].setZero();
-    Fdot[i].setZero();
+    if (is_TL) {
+      vol0PK1[i].setZero();
+      R[i].setIdentity();
+      Fdot[i].setZero();
+    }
+    if (has_Finv)
+      Finv[i].setZero();
     J[i] = 1;
     mask[i] = 1;
 
@@ -2690,6 +3051,8 @@ void Solid::read_mesh(string fileName)
     if (universe->me > proc) ptag0 += np_local_bcast;
   }
 
+  bool has_Finv = has_field("Finv");
+
   for (int i = 0; i < np_local; i++)
   {
     a[i].setZero();
@@ -2708,7 +3071,8 @@ void Solid::read_mesh(string fileName)
     eff_plastic_strain[i]      = 0;
     eff_plastic_strain_rate[i] = 0;
     damage[i]                  = 0;
-    damage_init[i]             = 0;
+    if (mat->damage != nullptr)
+      damage_init[i]           = 0;
     if (update->method->temp) {
       T[i]                     = T0;
       gamma[i]                 = 0;
@@ -2717,13 +3081,16 @@ void Solid::read_mesh(string fileName)
     ienergy[i]                 = 0;
     strain_el[i].setZero();
     sigma[i].setZero();
-    vol0PK1[i].setZero();
     L[i].setZero();
     F[i].setIdentity();
-    R[i].setIdentity();
     D[i].setZero();
-    Finv[i].setZero();
-    Fdot[i].setZero();
+    if (is_TL) {
+      vol0PK1[i].setZero();
+      R[i].setIdentity();
+      Fdot[i].setZero();
+    }
+    if (has_Finv)
+      Finv[i].setZero();
     J[i] = 1;
     mask[i] = 1;
 
@@ -2744,21 +3111,27 @@ void Solid::read_mesh(string fileName)
 }
 
 
-void Solid::compute_temperature_nodes(bool reset) {
+void Solid::compute_temperature_nodes(bool reset, NodeSet nodes) {
   double Ttemp;
-  int ip, nn = grid->nnodes_local + grid->nnodes_ghost;
+  int ip;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
 
-  for (int in = 0; in < nn; in++) {
-    if (reset) {
-      grid->T[in] = 0;
-    }
+  if (reset)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->T[active[ia]] = 0;
+
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
 
     if (grid->mass[in] > 0) {
       Ttemp = 0;
 
-      for (int j = 0; j < numneigh_np[in]; j++) {
-        ip = neigh_np[in][j];
-        Ttemp += wf_np[in][j] * mass[ip] * T[ip];
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+        ip = neigh_np[j];
+        Ttemp += wf_pn[np_to_pn[j]] * mass[ip] * T[ip];
       }
       Ttemp /= grid->mass[in];
       grid->T[in] += Ttemp;
@@ -2766,34 +3139,52 @@ void Solid::compute_temperature_nodes(bool reset) {
   }
 }
 
-void Solid::compute_external_temperature_driving_forces_nodes(bool reset) {
-  int ip, nn = grid->nnodes_local + grid->nnodes_ghost;
+void Solid::compute_external_temperature_driving_forces_nodes(bool reset, NodeSet nodes) {
+  int ip;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
+
+  if (reset)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->Qext[active[ia]] = 0;
 
-  for (int in = 0; in < nn; in++) {
-    if (reset)
-      grid->Qext[in] = 0;
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
 
     if (grid->mass[in] > 0) {
-      for (int j = 0; j < numneigh_np[in]; j++) {
-        ip = neigh_np[in][j];
-        grid->Qext[in] += wf_np[in][j] * gamma[ip];
+      for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+        ip = neigh_np[j];
+        grid->Qext[in] += wf_pn[np_to_pn[j]] * gamma[ip];
       }
     }
   }
 }
 
-void Solid::compute_internal_temperature_driving_forces_nodes() {
-  int ip, nn = grid->nnodes_local + grid->nnodes_ghost;
+/*! Contributions of all the solids sharing the grid are summed, like the other
+ * nodal quantities, instead of each solid overwriting those of the previous ones.
+ */
+void Solid::compute_internal_temperature_driving_forces_nodes(bool reset, NodeSet nodes) {
+  int ip;
+  const vector<int> &active = grid->active_nodes;
+  int nactive = active.size();
+  int a0, a1;
+  neigh_nodes_range(nodes, a0, a1);
 
-  for (int in = 0; in < nn; in++) {
-    grid->Qint[in] = 0;
-    for (int j = 0; j < numneigh_np[in]; j++) {
-      ip = neigh_np[in][j];
-      grid->Qint[in] += wfd_np[in][j].dot(q[ip]);
+  if (reset)
+    for (int ia = 0; ia < nactive; ia++)
+      grid->Qint[active[ia]] = 0;
+
+  for (int a = a0; a < a1; a++) {
+    int in = neigh_nodes[a];
+    for (int j = neigh_np_offset[a]; j < neigh_np_offset[a + 1]; j++) {
+      ip = neigh_np[j];
+      grid->Qint[in] += wfd_pn[np_to_pn[j]].dot(q[ip]);
 
       if (domain->axisymmetric == true) {
 	error->one(FLERR,"Temperature and axisymmetric not yet supported.\n");
-        //ftemp[0] -= vol0PK1[ip](2, 2) * wf_np[in][j] / x0[ip][0];
+        //ftemp[0] -= vol0PK1[ip](2, 2) * wf_pn[np_to_pn[j]] / x0[ip][0];
       }
     }
   }
@@ -2803,10 +3194,10 @@ void Solid::update_particle_temperature() {
   int in;
   for (int ip = 0; ip < np_local; ip++) {
     T[ip] = 0;
-    for (int j = 0; j < numneigh_pn[ip]; j++) {
-      in = neigh_pn[ip][j];
-      // T[ip] += wf_pn[ip][j] * (grid->T_update[in] - grid->T[in]);
-      T[ip] += wf_pn[ip][j] * grid->T_update[in];
+    for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+      in = neigh_pn[j];
+      // T[ip] += wf_pn[j] * (grid->T_update[in] - grid->T[in]);
+      T[ip] += wf_pn[j] * grid->T_update[in];
     }
   }
 }
@@ -2824,18 +3215,18 @@ void Solid::update_heat_flux(bool doublemapping) {
   if (is_TL) {
     for (int ip = 0; ip < np_local; ip++) {
       q[ip].setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++) {
-        in = neigh_pn[ip][j];
-        q[ip] -= wfd_pn[ip][j] * (*Tn)[in];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+        in = neigh_pn[j];
+        q[ip] -= wfd_pn[j] * (*Tn)[in];
       }
       q[ip] *= vol0[ip] * mat->invcp * mat->kappa;
     }
   } else {
     for (int ip = 0; ip < np_local; ip++) {
       q[ip].setZero();
-      for (int j = 0; j < numneigh_pn[ip]; j++) {
-        in = neigh_pn[ip][j];
-        q[ip] -= wfd_pn[ip][j] * (*Tn)[in];
+      for (int j = neigh_pn_offset[ip]; j < neigh_pn_offset[ip + 1]; j++) {
+        in = neigh_pn[j];
+        q[ip] -= wfd_pn[j] * (*Tn)[in];
       }
       q[ip] *= vol[ip] * mat->invcp * mat->kappa;
     }
@@ -2862,29 +3253,19 @@ void Solid::write_restart(ofstream *of) {
   of->write(reinterpret_cast<const char *>(&grid->cellsize), sizeof(double));
 
 
+  // Write the names of the particle's attributes, which depend on the method and material:
+  int nfields = restart_fields.size();
+  of->write(reinterpret_cast<const char *>(&nfields), sizeof(int));
+  for (auto field: restart_fields) {
+    size_t N = field->name.size();
+    of->write(reinterpret_cast<const char *>(&N), sizeof(size_t));
+    of->write(field->name.c_str(), N);
+  }
+
   // Write particle's attributes:
-  // cout << x[0](0) << ", " << x[0](1) << ", " << x[0](2) << endl;
   for (int ip = 0; ip < np_local; ip++) {
-    of->write(reinterpret_cast<const char *>(&ptag[ip]), sizeof(tagint));
-    of->write(reinterpret_cast<const char *>(&x0[ip]), sizeof(Eigen::Vector3d));
-    of->write(reinterpret_cast<const char *>(&x[ip]), sizeof(Eigen::Vector3d));
-    of->write(reinterpret_cast<const char *>(&v[ip]), sizeof(Eigen::Vector3d));
-    of->write(reinterpret_cast<const char *>(&sigma[ip]), sizeof(Eigen::Matrix3d));
-    of->write(reinterpret_cast<const char *>(&strain_el[ip]), sizeof(Eigen::Matrix3d));
-    if (is_TL) {
-      of->write(reinterpret_cast<const char *>(&vol0PK1[ip]), sizeof(Eigen::Matrix3d));
-    }
-    of->write(reinterpret_cast<const char *>(&F[ip]), sizeof(Eigen::Matrix3d));
-    of->write(reinterpret_cast<const char *>(&J[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&vol0[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&rho0[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&eff_plastic_strain[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&eff_plastic_strain_rate[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&damage[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&damage_init[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&T[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&ienergy[ip]), sizeof(double));
-    of->write(reinterpret_cast<const char *>(&mask[ip]), sizeof(int));
+    for (auto field: restart_fields)
+      field->write(of, ip);
   }
 }
 
@@ -2916,42 +3297,37 @@ void Solid::read_restart(ifstream *ifr) {
     grid->init(solidlo, solidhi);
   }
 
+  // Read the names of the particle's attributes:
+  int nfields = 0;
+  ifr->read(reinterpret_cast<char *>(&nfields), sizeof(int));
+  string written, expected;
+  for (int i = 0; i < nfields; i++) {
+    size_t N = 0;
+    ifr->read(reinterpret_cast<char *>(&N), sizeof(size_t));
+    string name(N, ' ');
+    ifr->read(&name[0], N);
+    written += " " + name;
+  }
+
   // Read particle's attributes:
   grow(np_local);
 
+  // Check that they are those the method and material require:
+  for (auto field: restart_fields)
+    expected += " " + field->name;
+  if (written != expected)
+    error->one(FLERR, "Error: the particles of solid " + id + " were written with the fields" + written
+	       + " but the method and material require" + expected + ".\n");
+
   for (int ip = 0; ip < np_local; ip++) {
-    ifr->read(reinterpret_cast<char *>(&ptag[ip]), sizeof(tagint));
-    ifr->read(reinterpret_cast<char *>(&x0[ip]), sizeof(Eigen::Vector3d));
-    ifr->read(reinterpret_cast<char *>(&x[ip]), sizeof(Eigen::Vector3d));
-    ifr->read(reinterpret_cast<char *>(&v[ip]), sizeof(Eigen::Vector3d));
-    v_update[ip].setZero();
-    a[ip].setZero();
-    mbp[ip].setZero();
-    f[ip].setZero();
-    ifr->read(reinterpret_cast<char *>(&sigma[ip]), sizeof(Eigen::Matrix3d));
-    ifr->read(reinterpret_cast<char *>(&strain_el[ip]), sizeof(Eigen::Matrix3d));
-    if (is_TL) {
-      ifr->read(reinterpret_cast<char *>(&vol0PK1[ip]), sizeof(Eigen::Matrix3d));
-    }
-    L[ip].setZero();
-    ifr->read(reinterpret_cast<char *>(&F[ip]), sizeof(Eigen::Matrix3d));
-    R[ip].setZero();
-    D[ip].setZero();
-    Finv[ip].setZero();
-    Fdot[ip].setZero();
-    ifr->read(reinterpret_cast<char *>(&J[ip]), sizeof(double));
-    ifr->read(reinterpret_cast<char *>(&vol0[ip]), sizeof(double));
+    for (auto &field: fields)
+      if (!(field->flags & ParticleField::RESTART))
+	field->set_zero(ip);
+    for (auto field: restart_fields)
+      field->read(ifr, ip);
     vol[ip] = J[ip] * vol0[ip];
-    ifr->read(reinterpret_cast<char *>(&rho0[ip]), sizeof(double));
     rho[ip] = rho0[ip] / J[ip];
     mass[ip] = rho0[ip] * vol0[ip];
-    ifr->read(reinterpret_cast<char *>(&eff_plastic_strain[ip]), sizeof(double));
-    ifr->read(reinterpret_cast<char *>(&eff_plastic_strain_rate[ip]), sizeof(double));
-    ifr->read(reinterpret_cast<char *>(&damage[ip]), sizeof(double));
-    ifr->read(reinterpret_cast<char *>(&damage_init[ip]), sizeof(double));
-    ifr->read(reinterpret_cast<char *>(&T[ip]), sizeof(double));
-    ifr->read(reinterpret_cast<char *>(&ienergy[ip]), sizeof(double));
-    ifr->read(reinterpret_cast<char *>(&mask[ip]), sizeof(int));
   }
   // cout << x[0](0) << ", " << x[0](1) << ", " << x[0](2) << endl;
 }
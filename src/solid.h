@@ -17,7 +17,9 @@
 #include "pointers.h"
 #include "material.h"
 #include "grid.h"
+#include "particle_field.h"
 #include <vector>
+#include <memory>
 #include <Eigen/Eigen>
 
 
@@ -35,6 +37,13 @@ using namespace Eigen;
  */
 class Solid : protected Pointers {
  public:
+  /// Nodes visited by the P2G functions
+  enum NodeSet {
+    ALL_NODES,        ///< All the nodes neighbouring the particles
+    BOUNDARY_NODES,   ///< Only the nodes exchanged with other CPUs (Grid::exchanged)
+    INTERIOR_NODES,   ///< Only the other nodes, once the boundary nodes are done
+  };
+
   string id;                                ///< Solid id
 
   double solidlo[3], solidhi[3];            ///< Solid global bounds
@@ -42,40 +51,42 @@ class Solid : protected Pointers {
 
   bigint np;                                ///< Total number of particles in the domain
   int np_local;                             ///< Number of local particles (in this CPU)
+  int np_ghost;                             ///< Number of ghost particles, copies of particles of other CPUs stored after the local ones
+  double ghost_cutoff;                      ///< Particles of other CPUs closer than this distance to the local particles are copied as ghosts (0 if no fix needs them)
   int np_per_cell;                          ///< Number of particles per cell (at the beginning)
-  int comm_n;                               ///< Number of double to pack for particle exchange between CPU
+  int comm_n;                               ///< Number of double to pack for particle exchange between CPU (set by register_fields())
   double vtot;                              ///< Total volume
   double mtot;                              ///< Total mass
 
   vector<tagint> ptag;                      ///< Unique identifier for particles in the system
 
-  vector<Eigen::Vector3d> x;                ///< Particles' current position
-  vector<Eigen::Vector3d> x0;               ///< Particles' reference position
+  ParticleVectors x;                        ///< Particles' current position
+  ParticleVectors x0;                       ///< Particles' reference position
 
   
-  vector<Eigen::Vector3d> rp;               ///< Current domain vector (CPDI1)
-  vector<Eigen::Vector3d> rp0;              ///< Reference domain vector (CPDI1)
-  vector<Eigen::Vector3d> xpc;              ///< Current position of the corners of the particles' domain (CPDI2o)
-  vector<Eigen::Vector3d> xpc0;             ///< Reference position of the corners of the particles' domain (CPDI2)
+  ParticleVectors rp;                       ///< Current domain vector (CPDI1)
+  ParticleVectors rp0;                      ///< Reference domain vector (CPDI1)
+  ParticleVectors xpc;                      ///< Current position of the corners of the particles' domain (CPDI2o)
+  ParticleVectors xpc0;                     ///< Reference position of the corners of the particles' domain (CPDI2)
   int nc;                                   ///< Number of corners per particles: \f$2^{dimension}\f$
   
-  vector<Eigen::Vector3d> v;                ///< Particles' current velocity
-  vector<Eigen::Vector3d> v_update;         ///< Particles' velocity at time t+dt
-
-  vector<Eigen::Vector3d> a;                ///< Particles' acceleration
-
-  vector<Eigen::Vector3d> mbp;              ///< Particles' external forces times mass
-  vector<Eigen::Vector3d> f;                ///< Particles' internal forces
-
-  vector<Eigen::Matrix3d> sigma;            ///< Stress matrix
-  vector<Eigen::Matrix3d> strain_el;        ///< Elastic strain matrix
-  vector<Eigen::Matrix3d> vol0PK1;          ///< Transpose of the 1st Piola-Kirchhoff matrix times vol0
-  vector<Eigen::Matrix3d> L;                ///< Velocity gradient matrix
-  vector<Eigen::Matrix3d> F;                ///< Deformation gradient matrix
-  vector<Eigen::Matrix3d> R;                ///< Rotation matrix
-  vector<Eigen::Matrix3d> D;                ///< Symmetric part of L
-  vector<Eigen::Matrix3d> Finv;             ///< Inverse of the deformation gradient matrix
-  vector<Eigen::Matrix3d> Fdot;             ///< Rate of deformation gradient matrix
+  ParticleVectors v;                        ///< Particles' current velocity
+  ParticleVectors v_update;                 ///< Particles' velocity at time t+dt
+
+  ParticleVectors a;                        ///< Particles' acceleration
+
+  ParticleVectors mbp;                      ///< Particles' external forces times mass
+  ParticleVectors f;                        ///< Particles' internal forces
+
+  ParticleSymmetricMatrices sigma;          ///< Stress matrix
+  ParticleSymmetricMatrices strain_el;      ///< Elastic strain matrix
+  ParticleMatrices vol0PK1;                 ///< Transpose of the 1st Piola-Kirchhoff matrix times vol0
+  ParticleMatrices L;                       ///< Velocity gradient matrix
+  ParticleMatrices F;                       ///< Deformation gradient matrix
+  ParticleMatrices R;                       ///< Rotation matrix
+  ParticleSymmetricMatrices D;              ///< Symmetric part of L
+  ParticleMatrices Finv;                    ///< Inverse of the deformation gradient matrix
+  ParticleMatrices Fdot;                    ///< Rate of deformation gradient matrix
   Eigen::Matrix3d Di;                       ///< Inertia tensor
   // vector<Eigen::Matrix3d> BDinv;            ///< APIC B*Dinv tensor
 
@@ -94,28 +105,41 @@ class Solid : protected Pointers {
 
   vector<double> T;                         ///< Particles' current temperature
   vector<double> gamma;                     ///< Particles' heat source
-  vector<Eigen::Vector3d> q;                ///< Particles' heat flux
+  ParticleVectors q;                        ///< Particles' heat flux
 
   double max_p_wave_speed;                  ///< Maximum of the particle wave speed
   double dtCFL;
 
-  vector<int> numneigh_pn;                  ///< Number of nodes neighbouring a given particle
-  vector<int> numneigh_np;                  ///< Number of nodes neighbouring a given node
-  vector<vector<int>> neigh_pn;             ///< List of the nodes neighbouring a given particle
-  vector<vector<int>> neigh_np;             ///< List of the particles neighbouring a given node
+  vector<int> neigh_pn_offset;              ///< Nodes neighbouring particle ip are neigh_pn[neigh_pn_offset[ip]] to neigh_pn[neigh_pn_offset[ip + 1] - 1]
+  vector<int> neigh_pn;                     ///< List of the nodes neighbouring each particle, stored contiguously particle after particle
+  vector<int> neigh_nodes;                  ///< Nodes neighbouring at least one particle of the solid, the boundary nodes first, each set in increasing order
+  int neigh_nodes_boundary;                 ///< Number of boundary nodes (Grid::exchanged) at the beginning of neigh_nodes
+  vector<int> neigh_np_offset;              ///< Particles neighbouring node neigh_nodes[a] are neigh_np[neigh_np_offset[a]] to neigh_np[neigh_np_offset[a + 1] - 1]
+  vector<int> neigh_np;                     ///< List of the particles neighbouring each node of neigh_nodes, stored contiguously node after node
+  vector<int> np_to_pn;                     ///< Position in neigh_pn of each particle-node pair of neigh_np
+
+  vector<double> wf_pn;                     ///< Weight functions \f$\Phi_{pI}\f$ of each particle-node pair of neigh_pn.
+  vector<double> wf_pn_corners;             ///< Weight functions \f$\Phi_{Ic}\f$ evaluated at the nc corners of the particle's domain for each pair of neigh_pn (used in CPDI)
 
-  vector<vector< double >> wf_pn;           ///< Array of arrays (matrix) of the weight functions \f$\Phi_{pI}\f$.
-  vector<vector< double >> wf_np;           ///< Array of arrays (matrix) of the weight functions \f$\Phi_{Ip}\f$ effectively the transpose of wf_pn.
-  vector<vector< double >> wf_pn_corners;   ///< Array of arrays (matrix) of the weight functions \f$\Phi_{Ic}\f$ evaluated at the corners of the particle's domain (used in CPDI)
+  vector<Eigen::Vector3d> wfd_pn;           ///< Derivative of the weight functions \f$\partial \Phi_{pI}/\partial x\f$ of each particle-node pair of neigh_pn.
 
-  vector<vector< Eigen::Vector3d >> wfd_pn; ///< Array of arrays (matrix) of the derivative of the weight functions \f$\partial \Phi_{pI}/\partial x\f$.
-  vector<vector< Eigen::Vector3d >> wfd_np; ///< Array of arrays (matrix) of the derivative of the weight functions \f$\partial \Phi_{Ip}/ \partial x\f$ effectively the transpose of wfd_pn.
+  vector<int> scatter_particles;            ///< Particles sorted by colour and by block of cells, used by the scatter P2G
+  vector<int> scatter_block_offset;         ///< Particles of block b are scatter_particles[scatter_block_offset[b]] to scatter_particles[scatter_block_offset[b + 1] - 1]
+  vector<int> scatter_colour_offset;        ///< Blocks of colour c are scatter_colour_offset[c] to scatter_colour_offset[c + 1] - 1, the colours of the boundary particles coming first
+  vector<Eigen::Vector3d> scatter_buffer;        ///< Per node momentum accumulated by the scatter P2G
+  vector<Eigen::Vector3d> scatter_buffer_update; ///< Per node updated momentum accumulated by the scatter P2G for rigid nodes
+  vector<int> node_slot;                    ///< Position of each node in neigh_nodes while the lists are built, -1 otherwise
+
+  vector<unique_ptr<ParticleField>> fields;  ///< Registry of the per-particle vectors, filled by register_fields()
+  vector<ParticleField *> restart_fields;    ///< Fields flagged ParticleField::RESTART, in the order of the restart files
 
 
   class Mat *mat;                          ///< Pointer to the material
 
   class Grid *grid;                         ///< Pointer to the background grid
 
+  class GhostParticles *ghosts;             ///< Exchange of the ghost particles (nullptr if not needed)
+
   string method_type;                       ///< Either tlmpm, tlcpdi, tlcpdi2, ulmpm, ulcpdi, or ulcpdi2 (all kinds of MPM supported)
 
   Solid(class MPM *, vector<string>);       ///< The main task of the constructor is to read the input arguments and launch the creation of particles.
@@ -124,14 +148,16 @@ class Solid : protected Pointers {
   void init();                              ///< Launch the initialization of the grid.
   void options(vector<string> *, vector<string>::iterator); ///< Determines the material and temperature schemes used.
   void grow(int);                           ///< Allocate memory for the vectors used for particles or resize them.
-
-  void compute_mass_nodes(bool);                    ///< Compute nodal mass step of the Particle to Grid step of the MPM algorithm.
-  void compute_velocity_nodes(bool);                ///< Compute nodal velocity (via momentum) step of the Particle to Grid step of the MPM algorithm.
-  void compute_velocity_nodes_APIC(bool);           ///< Specific function that computes the nodal velocity (via momentum) when using Affine PIC (APIC).
-  void compute_external_forces_nodes(bool);         ///< Compute external forces step of the Particle to Grid step of the MPM algorithm.
-  void compute_internal_forces_nodes_TL();          ///< Compute internal forces step of the Particle to Grid step of the total Lagrangian MPM algorithm.
-  void compute_external_and_internal_forces_nodes_UL(bool);      ///< Compute both external and internal forces step of the Particle to Grid step of the updated Lagrangian MPM algorithm.
-  void compute_external_and_internal_forces_nodes_UL_MLS(bool);      ///< Compute both external and internal forces step of the Particle to Grid step of the moving least square updated Lagrangian MPM algorithm.
+  void register_fields();                   ///< Register the per-particle vectors used by the method and the material in fields.
+  bool has_field(string) const;             ///< True if the per-particle vector of that name is allocated.
+
+  void compute_mass_nodes(bool, NodeSet nodes = ALL_NODES); ///< Compute nodal mass step of the Particle to Grid step of the MPM algorithm.
+  void compute_velocity_nodes(bool, NodeSet nodes = ALL_NODES); ///< Compute nodal velocity (via momentum) step of the Particle to Grid step of the MPM algorithm.
+  void compute_velocity_nodes_APIC(bool, NodeSet nodes = ALL_NODES); ///< Specific function that computes the nodal velocity (via momentum) when using Affine PIC (APIC).
+  void compute_external_forces_nodes(bool, NodeSet nodes = ALL_NODES); ///< Compute external forces step of the Particle to Grid step of the MPM algorithm.
+  void compute_internal_forces_nodes_TL(NodeSet nodes = ALL_NODES); ///< Compute internal forces step of the Particle to Grid step of the total Lagrangian MPM algorithm.
+  void compute_external_and_internal_forces_nodes_UL(bool, NodeSet nodes = ALL_NODES); ///< Compute both external and internal forces step of the Particle to Grid step of the updated Lagrangian MPM algorithm.
+  void compute_external_and_internal_forces_nodes_UL_MLS(bool, NodeSet nodes = ALL_NODES); ///< Compute both external and internal forces step of the Particle to Grid step of the moving least square updated Lagrangian MPM algorithm.
   void compute_particle_velocities_and_positions(); ///< Compute the particles' temporary velocities and position, part of the Grid to Particles step of the MPM algorithm.
   void compute_particle_accelerations_velocities_and_positions(); ///< Compute the particles' temporary acceleration, velocities and position, part of the Grid to Particles step of the MPM algorithm.
   void compute_particle_accelerations_velocities(); ///< Compute the particles' temporary acceleration and velocities, part of the Grid to Particles step of the MPM algorithm.
@@ -146,6 +172,15 @@ class Solid : protected Pointers {
   void compute_rate_deformation_gradient_UL_APIC(bool); ///< Compute the time derivative of the deformation matrix for ULMPM, when APIC is in use.
   void update_deformation_gradient();               ///< Update the deformation gradient, volume, density, and the necessary strain matrices
   void update_stress();                             ///< Calculate the stress, damage and temperature at each particle, and determine the maximum allowed time step.
+  void clear_neighbours();                          ///< Empty the particle-node neighbour lists before they are rebuilt.
+  void compute_neigh_nodes();                       ///< List in neigh_nodes the nodes found in neigh_pn.
+  void compute_neigh_np();                          ///< Build the node-particle neighbour lists as the transpose of neigh_pn.
+  void compute_scatter_blocks(int);                 ///< Sort the particles by colour and block of cells for the scatter P2G.
+  void sort_particles();                            ///< Reorder the particles along a Morton curve of the cells they are in.
+  void compute_mass_nodes_scatter(bool, NodeSet nodes = ALL_NODES); ///< Same as compute_mass_nodes() but scattering from the particles.
+  void compute_velocity_nodes_scatter(bool, NodeSet nodes = ALL_NODES); ///< Same as compute_velocity_nodes() but scattering from the particles.
+  void compute_velocity_nodes_APIC_scatter(bool, NodeSet nodes = ALL_NODES); ///< Same as compute_velocity_nodes_APIC() but scattering from the particles.
+  void compute_external_and_internal_forces_nodes_UL_scatter(bool, NodeSet nodes = ALL_NODES); ///< Same as compute_external_and_internal_forces_nodes_UL() but scattering from the particles.
   void compute_inertia_tensor();                    ///< Compute the inertia tensor necessary for the Affice PIC.
   void compute_deformation_gradient();              ///< Compute the deformation gradient directly from the grid nodes' positions
   void update_particle_domain();                    ///< Update the particle domain. Used with CPDI
@@ -153,19 +188,43 @@ class Solid : protected Pointers {
   void copy_particle(int, int);                     ///< Copy particle i attribute and copy it to particle j.
                                                     ///< This function is used to re-order the memory arrangment of particles.
                                                     ///< Usually this is done when particle j is deleted.
-  void pack_particle(int, vector<double> &);        ///< Pack particles attributes into a buffer (used for generating a restart).
-  void unpack_particle(int &, vector<int>, vector<double> &); ///< Unpack particles attributes from a buffer (used when reading a restart).
+  void pack_particle(int, vector<double> &);        ///< Pack the attributes flagged ParticleField::COMM of a particle into a buffer (used for particle exchange between CPUs).
+  void unpack_particle(int &, vector<int>, vector<double> &); ///< Unpack particles attributes from a buffer (used for particle exchange between CPUs).
 
   void write_restart(ofstream*);                    ///< Write solid information in the restart file
   void read_restart(ifstream*);                     ///< Read solid information from the restart file
 
-  void compute_temperature_nodes(bool);             ///< Compute nodal temperature step of the particle
-  void compute_external_temperature_driving_forces_nodes(bool); ///< Compute external temperature driving forces
-  void compute_internal_temperature_driving_forces_nodes(); ///< Compute internal forces step of the Particle to Grid step of the total Lagrangian MPM algorithm.
+  void compute_temperature_nodes(bool, NodeSet nodes = ALL_NODES); ///< Compute nodal temperature step of the particle
+  void compute_external_temperature_driving_forces_nodes(bool, NodeSet nodes = ALL_NODES); ///< Compute external temperature driving forces
+  void compute_internal_temperature_driving_forces_nodes(bool, NodeSet nodes = ALL_NODES); ///< Compute internal forces step of the Particle to Grid step of the total Lagrangian MPM algorithm.
   void update_particle_temperature();               ///< Update the particles' temperature
   void update_heat_flux(bool);                      ///< Update the particles' heat source and fluxes
 
 private:
+  template <typename T>
+  void add_field(string name, vector<T> &v, int flags, int stride = 1) {
+    add_field(new ParticleScalarField<T>(name, v, stride, flags));
+  }
+
+  template <int NC>
+  void add_field(string name, ParticleColumns<NC> &v, int flags, int stride = 1) {
+    add_field(new ParticleColumnsField<NC>(name, v, stride, flags));
+  }
+
+  void add_field(ParticleField *field) {
+    fields.emplace_back(field);
+    if (field->flags & ParticleField::COMM)
+      comm_n += field->ncomponents();
+  }
+
+  vector<double> pH;                        ///< Hydrostatic pressure, work array of update_stress()
+  vector<double> plastic_strain_increment;  ///< Plastic strain increment, work array of update_stress()
+  vector<double> flow_stress;               ///< Von Mises flow stress, work array of update_stress()
+  vector<Eigen::Matrix3d> sigma_dev;        ///< Deviatoric stress, work array of update_stress()
+
+  void update_stress_range(int, int);               ///< Update the stress of a contiguous range of particles.
+  void neigh_nodes_range(NodeSet, int &, int &) const;     ///< Range of positions in neigh_nodes of a set of nodes.
+  void scatter_colour_range(NodeSet, int &, int &) const;  ///< Range of colours in scatter_colour_offset of the particles contributing to a set of nodes.
   void populate(vector<string>);
   void read_mesh(string);
   void read_file(string);
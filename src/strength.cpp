@@ -58,3 +58,25 @@ void Strength::options(vector<string> *args, vector<string>::iterator it)
   }
 }
 
+
+/*! Default implementation calling update_deviatoric_stress() for each particle.
+ * Models override it where a loop over the arrays pays off, see StrengthJohnsonCook.
+ */
+void Strength::update_deviatoric_stress(int n, const SymmetricMatrixColumns &sigma,
+                                        const SymmetricMatrixColumns &D,
+                                        Eigen::Matrix3d *sigma_dev,
+                                        double *plastic_strain_increment,
+                                        const double *eff_plastic_strain,
+                                        const double *epsdot,
+                                        const double *damage, const double *T)
+{
+  if (T != nullptr) {
+    for (int i = 0; i < n; i++)
+      sigma_dev[i] = update_deviatoric_stress(sigma[i], D[i], plastic_strain_increment[i],
+                                              eff_plastic_strain[i], epsdot[i], damage[i], T[i]);
+  } else {
+    for (int i = 0; i < n; i++)
+      sigma_dev[i] = update_deviatoric_stress(sigma[i], D[i], plastic_strain_increment[i],
+                                              eff_plastic_strain[i], epsdot[i], damage[i]);
+  }
+}
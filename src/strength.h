@@ -15,6 +15,7 @@
 #define MPM_STRENGTH_H
 
 #include "pointers.h"
+#include "particle_field.h"
 #include <vector>
 #include <Eigen/Eigen>
 
@@ -43,6 +44,17 @@ class Strength : protected Pointers {
     const double           epsdot,
     const double           damage,
     const double           temperature = 0) = 0;
+
+  virtual void update_deviatoric_stress
+  ( int                    n,
+    const SymmetricMatrixColumns &sigma,
+    const SymmetricMatrixColumns &D,
+    Eigen::Matrix3d       *sigma_dev,
+    double                *plastic_strain_increment,
+    const double          *eff_plastic_strain,
+    const double          *epsdot,
+    const double          *damage,
+    const double          *temperature = nullptr); ///< Updates the deviatoric stress of n consecutive particles.
   //protected:
 };
 
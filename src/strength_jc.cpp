@@ -210,3 +210,72 @@ void StrengthJohnsonCook::read_restart(ifstream *ifr) {
   ifr->read(reinterpret_cast<char *>(&Tm), sizeof(double));
   Tmr = Tm - Tr;
 }
+
+/*! Johnson-Cook update of n consecutive particles, by blocks of JC_BLOCK particles.
+ * The flow stress and damaged shear modulus of the whole block are computed first
+ * in a loop over plain arrays, then the radial return is applied to each particle.
+ * The results are identical to the per-particle version.
+ */
+void StrengthJohnsonCook::update_deviatoric_stress(int np, const SymmetricMatrixColumns &sigma,
+                                                   const SymmetricMatrixColumns &D,
+                                                   Eigen::Matrix3d *sigma_dev,
+                                                   double *plastic_strain_increment,
+                                                   const double *eff_plastic_strain,
+                                                   const double *epsdot,
+                                                   const double *damage, const double *T)
+{
+  // Local copies, so that the compiler knows the writes to the arrays do not change them:
+  const double A_ = A, B_ = B, n_ = n, m_ = m, C_ = C, Tr_ = Tr, Tm_ = Tm, Tmr_ = Tmr;
+  const double epsdot0_ = epsdot0, dt = update->dt;
+  double yieldStress[JC_BLOCK], Gd[JC_BLOCK];
+
+  for (int first = 0; first < np; first += JC_BLOCK) {
+    int nb = MIN(JC_BLOCK, np - first);
+    const double *eps = eff_plastic_strain + first;
+    const double *rate = epsdot + first;
+    const double *d = damage + first;
+    const double *Tb = T == nullptr ? nullptr : T + first;
+
+    for (int j = 0; j < nb; j++) {
+      double ys = eps[j] < 1.0e-10 ? A_ : A_ + B_ * pow(eps[j], n_);
+      if (C_ != 0)
+	ys *= pow(1.0 + MAX(rate[j] / epsdot0_, 1.0), C_);
+
+      double Tj = Tb == nullptr ? 0 : Tb[j];
+      if (Tj < Tm_) {
+	if (m_ != 0 && Tj >= Tr_)
+	  ys *= 1.0 - pow((Tj - Tr_) / Tmr_, m_);
+      } else {
+	ys = 0;
+      }
+
+      double g = G_;
+      if (d[j] > 0) {
+	g *= 1 - d[j];
+	ys *= 1 - d[j];
+      }
+      yieldStress[j] = ys;
+      Gd[j] = g;
+    }
+
+    for (int j = 0; j < nb; j++) {
+      int i = first + j;
+
+      if (d[j] >= 1.0) {
+	sigma_dev[i].setZero();
+	continue;
+      }
+
+      Matrix3d sigmaTrial = sigma[i].matrix() + dt * 2.0 * Gd[j] * D[i].matrix();
+      sigma_dev[i] = Deviator(sigmaTrial);
+      double J2 = SQRT_3_OVER_2 * sigma_dev[i].norm();
+
+      if (J2 < yieldStress[j]) {
+	plastic_strain_increment[i] = 0.0;
+      } else {
+	plastic_strain_increment[i] = (J2 - yieldStress[j]) / (3.0 * Gd[j]);
+	sigma_dev[i] *= yieldStress[j] / J2;
+      }
+    }
+  }
+}
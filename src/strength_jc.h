@@ -24,6 +24,8 @@ StrengthStyle(johnson_cook,StrengthJohnsonCook)
 #include "strength.h"
 #include <Eigen/Eigen>
 
+#define JC_BLOCK 64   ///< Number of particles whose flow stress is computed together
+
 class StrengthJohnsonCook : public Strength {
 
 public:
@@ -43,6 +45,16 @@ public:
     const double           epsdot,
     const double           damage,
     const double           temperature = 0);
+  void update_deviatoric_stress
+  ( int                    np,
+    const SymmetricMatrixColumns &sigma,
+    const SymmetricMatrixColumns &D,
+    Eigen::Matrix3d       *sigma_dev,
+    double                *plastic_strain_increment,
+    const double          *eff_plastic_strain,
+    const double          *epsdot,
+    const double          *damage,
+    const double          *temperature = nullptr);
 
 protected:
   double G_, A, B, n, m, epsdot0, C, Tr, Tm, Tmr;
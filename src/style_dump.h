@@ -1,4 +1,5 @@
 #include "dump_particle.h"
 #include "dump_particle_gz.h"
+#include "dump_particle_bin.h"
 #include "dump_grid.h"
 #include "dump_grid_gz.h"
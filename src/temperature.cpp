@@ -40,3 +40,21 @@ void Temperature::options(vector<string> *args, vector<string>::iterator it)
   }
 }
 
+
+/*! Default implementation calling compute_heat_source() for each particle.
+ */
+void Temperature::compute_heat_source(int n, const double *T, double *gamma,
+                                      const double *flow_stress,
+                                      const double *eff_plastic_strain_rate)
+{
+  for (int i = 0; i < n; i++)
+    compute_heat_source(T[i], gamma[i], flow_stress[i], eff_plastic_strain_rate[i]);
+}
+
+/*! Default implementation calling compute_thermal_pressure() for each particle.
+ */
+void Temperature::compute_thermal_pressure(int n, const double *T, double *pH)
+{
+  for (int i = 0; i < n; i++)
+    pH[i] += compute_thermal_pressure(T[i]);
+}
@@ -25,6 +25,8 @@ class Temperature : protected Pointers {
   virtual double kappa() = 0;
   virtual void compute_heat_source(double, double &, const double &, const double &) = 0;
   virtual double compute_thermal_pressure(double) = 0;
+  virtual void compute_heat_source(int, const double *, double *, const double *, const double *); ///< Computes the heat source of n consecutive particles.
+  virtual void compute_thermal_pressure(int, const double *, double *); ///< Adds the thermal pressure of n consecutive particles to pH.
 };
 
 #endif
@@ -0,0 +1,169 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "timer.h"
+#include "error.h"
+#include "input.h"
+#include "universe.h"
+#include "update.h"
+#include "var.h"
+#include <iomanip>
+#include <iostream>
+#include <mpi.h>
+#include <sstream>
+
+using namespace std;
+
+Timer::Timer(MPM *mpm) : Pointers(mpm)
+{
+  every = 0;
+
+  // Same order as Timer::Phase:
+  const char *phase_names[NPHASES] = {
+    "weights", "reset", "P2G", "grid update", "G2P", "advance", "V2G",
+    "grid positions", "rate deformation", "stress", "ghost nodes", "ghost particles",
+    "exchange", "balance", "sort", "timestep", "output"};
+
+  for (int i = 0; i < NPHASES; i++)
+    find(phase_names[i]);
+
+  init();
+}
+
+/*! The phases of the fixes and dumps are registered in the order they are first
+ * timed, which is the same on all CPUs.
+ */
+int Timer::find(string name)
+{
+  auto it = index.find(name);
+  if (it != index.end())
+    return it->second;
+
+  names.push_back(name);
+  elapsed.push_back(0);
+  elapsed_reported.push_back(0);
+  return index[name] = names.size() - 1;
+}
+
+void Timer::start(int i)
+{
+  double t = MPI_Wtime();
+  if (!running.empty())
+    elapsed[running.back()] += t - tlast;
+  running.push_back(i);
+  tlast = t;
+}
+
+void Timer::stop()
+{
+  double t = MPI_Wtime();
+  elapsed[running.back()] += t - tlast;
+  running.pop_back();
+  tlast = t;
+}
+
+void Timer::init()
+{
+  elapsed.assign(names.size(), 0);
+  elapsed_reported.assign(names.size(), 0);
+  running.clear();
+  trun = treported = tlast = MPI_Wtime();
+  step_reported = update ? update->ntimestep : 0;
+}
+
+void Timer::step(bigint ntimestep)
+{
+  if (every == 0 || ntimestep % every != 0)
+    return;
+
+  double t = MPI_Wtime();
+  vector<double> interval(names.size());
+  for (int i = 0; i < names.size(); i++)
+    interval[i] = elapsed[i] - elapsed_reported[i];
+
+  write("Timings of steps " + to_string(step_reported + 1) + " to " + to_string(ntimestep),
+        interval, t - treported);
+
+  elapsed_reported = elapsed;
+  treported = t;
+  step_reported = ntimestep;
+}
+
+void Timer::report()
+{
+  write("Timings of the run", elapsed, MPI_Wtime() - trun);
+}
+
+/*! The time spent outside of all the phases is reported as "other".
+ */
+void Timer::write(string title, const vector<double> &t, double total)
+{
+  const int nprocs = universe->nprocs;
+
+  // All CPUs register the same phases, but check before reducing them:
+  int n = t.size(), nmin;
+  MPI_Allreduce(&n, &nmin, 1, MPI_INT, MPI_MIN, universe->uworld);
+
+  vector<double> local(t.begin(), t.begin() + nmin);
+  double other = total;
+  for (int i = 0; i < nmin; i++)
+    other -= local[i];
+  local.push_back(other);
+  local.push_back(total);
+
+  int m = local.size();
+  vector<double> tmin(m), tmax(m), tsum(m);
+  MPI_Reduce(local.data(), tmin.data(), m, MPI_DOUBLE, MPI_MIN, 0, universe->uworld);
+  MPI_Reduce(local.data(), tmax.data(), m, MPI_DOUBLE, MPI_MAX, 0, universe->uworld);
+  MPI_Reduce(local.data(), tsum.data(), m, MPI_DOUBLE, MPI_SUM, 0, universe->uworld);
+
+  if (universe->me != 0) return;
+
+  double avg_total = tsum[m - 1] / nprocs;
+
+  stringstream s;
+  s << title << " on " << nprocs << " procs (wall time in seconds):\n";
+  s << left << setw(24) << "Phase" << right << setw(12) << "min" << setw(12) << "avg"
+    << setw(12) << "max" << setw(10) << "%total" << setw(10) << "max/avg" << "\n";
+
+  for (int i = 0; i < m; i++) {
+    string name = i < nmin ? names[i] : (i == nmin ? "other" : "total");
+    double avg = tsum[i] / nprocs;
+
+    // Phases that never ran are skipped:
+    if (i < nmin && tmax[i] == 0) continue;
+
+    s << left << setw(24) << name << right << fixed << setprecision(4)
+      << setw(12) << tmin[i] << setw(12) << avg << setw(12) << tmax[i]
+      << setprecision(1) << setw(10) << (avg_total > 0 ? 100 * avg / avg_total : 0)
+      << setprecision(2) << setw(10) << (avg > 0 ? tmax[i] / avg : 1) << "\n";
+  }
+
+  cout << s.str();
+  if (wlogfile->is_open())
+    (*wlogfile) << s.str();
+}
+
+/*! This function is the C++ equivalent to the timer() user function.\n
+ * Syntax: timer(N)
+ */
+void Timer::set_every(vector<string> args)
+{
+  if (args.size() != 1) {
+    error->all(FLERR, "Illegal timer command: not enough arguments or too many arguments.\n");
+  }
+  every = (int) input->parsev(args[0]).result(mpm);
+  if (every < 0) {
+    error->all(FLERR, "Error: the interval given to timer() must be positive or 0.\n");
+  }
+}
@@ -0,0 +1,107 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_TIMER_H
+#define MPM_TIMER_H
+
+#include "pointers.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/*! Measures the wall time spent in each phase of the time step loop.
+ *
+ * A phase is timed between start() and stop(). Phases can be nested, in which case
+ * the time spent in the inner phase is not counted in the outer one: the ghost node
+ * reductions are for instance timed apart from the particle to grid transfer that
+ * triggers them. The phases of the schemes are known in advance (Timer::Phase), while
+ * those of the fixes and dumps are registered with find() on first use.
+ *
+ * At the end of each run, and every Timer::every steps if requested with timer(),
+ * the minimum, average and maximum over the CPUs of the time spent in each phase are
+ * written to the console and to log.mpm. The ratio of the maximum to the average shows
+ * how imbalanced the CPUs are.
+ */
+class Timer : protected Pointers {
+ public:
+  enum Phase {
+    WEIGHTS,         ///< Method::compute_grid_weight_functions_and_gradients()
+    RESET,           ///< Method::reset()
+    P2G,             ///< Method::particles_to_grid()
+    GRID_UPDATE,     ///< Method::update_grid_state()
+    G2P,             ///< Method::grid_to_points()
+    ADVANCE,         ///< Method::advance_particles()
+    V2G,             ///< Method::velocities_to_grid()
+    GRID_POSITIONS,  ///< Method::update_grid_positions()
+    RATE_DEFORMATION, ///< Method::compute_rate_deformation_gradient()
+    STRESS,          ///< Method::update_deformation_gradient() and Method::update_stress()
+    GHOST_NODES,     ///< Reductions of the ghost nodes (Grid::reduce_ghost_nodes_begin() and Grid::reduce_ghost_nodes_end())
+    GHOST_PARTICLES, ///< Exchanges of ghost particles for the fixes needing them
+    EXCHANGE,        ///< Method::exchange_particles()
+    BALANCE,         ///< Domain::balance()
+    SORT,            ///< Update::sort_particles()
+    TIMESTEP,        ///< Update::update_time() and Method::adjust_dt()
+    OUTPUT,          ///< Computes, logs and restart files
+    NPHASES
+  };
+
+  int every;                         ///< Report the timings every so many steps (only at the end of each run if 0)
+
+  Timer(class MPM *);
+
+  int find(string);                  ///< Index of the phase with this name, registered on first call
+  void start(int);                   ///< Start timing a phase, pausing the current one
+  void stop();                       ///< Stop timing the current phase, resuming the one it interrupted
+  void init();                       ///< Reset the timings at the beginning of a run
+  void step(bigint);                 ///< Report the timings of the last steps if due at this step
+  void report();                     ///< Report the timings of the whole run
+  void set_every(vector<string>);    ///< Called when user calls timer()
+
+ private:
+  vector<string> names;              ///< Name of each phase
+  vector<double> elapsed;            ///< Time spent in each phase since the beginning of the run
+  vector<double> elapsed_reported;   ///< Value of elapsed at the last report
+  map<string, int> index;            ///< Index of each phase from its name
+  vector<int> running;               ///< Stack of the phases being timed, the innermost last
+  double tlast;                      ///< Time of the last start() or stop()
+  double trun;                       ///< Time of the beginning of the run
+  double treported;                  ///< Time of the last report
+  bigint step_reported;              ///< Last step of the last report
+
+  void write(string, const vector<double> &, double); ///< Reduce the timings over the CPUs and print them
+};
+
+#endif
+
+/*! \defgroup timer timer
+
+\section Syntax Syntax
+\code
+timer(N)
+\endcode
+
+<ul>
+<li>N: number of steps between two reports of the timings (0 to only report them at the end of each run).</li>
+</ul>
+
+\section Examples Examples
+\code
+timer(1000)
+\endcode
+Report the time spent in each phase of the last 1000 steps every 1000 steps.
+
+\section Description Description
+
+The wall time spent in each phase of the time step (weight functions, particle to grid transfer, grid update, ghost node reduction, particle exchange, each fix and each dump, ...) is measured on every CPU. At the end of each run, the minimum, average and maximum of these times over the CPUs are written to the console and to log.mpm, along with the share of the total time of each phase and the ratio of the maximum to the average, which is larger than 1 when the work is not evenly shared between the CPUs. The time not spent in any of the phases is listed as "other".
+
+*/
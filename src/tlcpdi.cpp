@@ -114,23 +114,19 @@ void TLCPDI::compute_grid_weight_functions_and_gradients()
       nc = domain->solids[isolid]->nc;
       nnodes = domain->solids[isolid]->grid->nnodes;
 
-      vector<int> *numneigh_pn = &domain->solids[isolid]->numneigh_pn;
-      vector<int> *numneigh_np = &domain->solids[isolid]->numneigh_np;
+      vector<int> *neigh_pn_offset = &domain->solids[isolid]->neigh_pn_offset;
 
-      vector<vector<int>> *neigh_pn = &domain->solids[isolid]->neigh_pn;
-      vector<vector<int>> *neigh_np = &domain->solids[isolid]->neigh_np;
+      vector<int> *neigh_pn = &domain->solids[isolid]->neigh_pn;
 
-      vector<vector< double >> *wf_pn = &domain->solids[isolid]->wf_pn;
-      vector<vector< double >> *wf_pn_corners = &domain->solids[isolid]->wf_pn_corners;
-      vector<vector< double >> *wf_np = &domain->solids[isolid]->wf_np;
+      vector<double> *wf_pn = &domain->solids[isolid]->wf_pn;
+      vector<double> *wf_pn_corners = &domain->solids[isolid]->wf_pn_corners;
 
-      vector<vector< Eigen::Vector3d >> *wfd_pn = &domain->solids[isolid]->wfd_pn;
-      vector<vector< Eigen::Vector3d >> *wfd_np = &domain->solids[isolid]->wfd_np;
+      vector<Eigen::Vector3d> *wfd_pn = &domain->solids[isolid]->wfd_pn;
 
-      vector<Eigen::Vector3d> *xp  = &domain->solids[isolid]->x0;
-      vector<Eigen::Vector3d> *xpc = &domain->solids[isolid]->xpc;
+      ParticleVectors *xp          = &domain->solids[isolid]->x0;
+      ParticleVectors *xpc         = &domain->solids[isolid]->xpc;
       vector<Eigen::Vector3d> *xn  = &domain->solids[isolid]->grid->x0;
-      vector<Eigen::Vector3d> *rp  = &domain->solids[isolid]->rp;
+      ParticleVectors *rp          = &domain->solids[isolid]->rp;
 
       double inv_cellsize          = 1.0 / domain->solids[isolid]->grid->cellsize;
       vector<double> *vol          = &domain->solids[isolid]->vol;
@@ -144,21 +140,11 @@ void TLCPDI::compute_grid_weight_functions_and_gradients()
 
       double a, b, inv_Vp, alpha_over_Vp, sixVp;
 
-      for (int in=0; in<nnodes; in++) {
-	(*neigh_np)[in].clear();
-	(*numneigh_np)[in] = 0;
-	(*wf_np)[in].clear();
-	(*wfd_np)[in].clear();
-      }
+      domain->solids[isolid]->clear_neighbours();
 
       if (np_local && nnodes) {
 	for (int ip=0; ip<np_local; ip++) {
 
-	  (*neigh_pn)[ip].clear();
-	  (*numneigh_pn)[ip] = 0;
-	  (*wf_pn)[ip].clear();
-	  (*wfd_pn)[ip].clear();
-
 	  // Calculate what nodes the corner of Omega_p will interact with:
 	  int nx = domain->solids[isolid]->grid->nx;
 	  int ny = domain->solids[isolid]->grid->ny;
@@ -326,24 +312,22 @@ void TLCPDI::compute_grid_weight_functions_and_gradients()
 		wfd[2] = 0;
 
 		wfd *= 0.5*inv_Vp;
-		for(int ic=0; ic<nc; ic++) (*wf_pn_corners)[nc*ip+ic].push_back(wfc[ic]);
+		for(int ic=0; ic<nc; ic++) wf_pn_corners->push_back(wfc[ic]);
 	      }
 
-	      (*neigh_pn)[ip].push_back(in);
-	      (*neigh_np)[in].push_back(ip);
-	      (*numneigh_pn)[ip]++;
-	      (*numneigh_np)[in]++;
+	      neigh_pn->push_back(in);
 
-	      (*wf_pn)[ip].push_back(wf);
-	      (*wf_np)[in].push_back(wf);
-	      (*wfd_pn)[ip].push_back(wfd);
-	      (*wfd_np)[in].push_back(wfd);
+	      wf_pn->push_back(wf);
+	      wfd_pn->push_back(wfd);
 	      // cout << "node: " << in << " [ " << (*xn)[in][0] << "," << (*xn)[in][1] << "," << (*xn)[in][2] << "]" <<
 	      // 	" with\twf=" << wf << " and\twfd=["<< wfd[0] << "," << wfd[1] << "," << wfd[2] << "]\n";
 	    }
 	  }
+	  (*neigh_pn_offset)[ip + 1] = neigh_pn->size();
 	}
       }
+      domain->solids[isolid]->compute_neigh_np();
+
       if (method_type.compare("APIC") == 0) domain->solids[isolid]->compute_inertia_tensor();
     }
   }
@@ -16,12 +16,14 @@
 #include "domain.h"
 #include "error.h"
 #include "grid.h"
+#include "grid_exchange.h"
 #include "input.h"
 #include "method.h"
 #include "solid.h"
 #include "universe.h"
 #include "update.h"
 #include "var.h"
+#include "weight_functions.h"
 #include <Eigen/Eigen>
 #include <algorithm>
 #include <iostream>
@@ -42,10 +44,13 @@ TLMPM::TLMPM(MPM *mpm) : Method(mpm) {
   // Default base function (linear):
   basis_function = &BasisFunction::linear;
   derivative_basis_function = &BasisFunction::derivative_linear;
+
+  grid_exchange = new GridExchange(mpm);
 }
 
 TLMPM::~TLMPM()
 {
+  delete grid_exchange;
 }
 
 void TLMPM::setup(vector<string> args)
@@ -99,309 +104,139 @@ void TLMPM::compute_grid_weight_functions_and_gradients()
   }
 
   // cout << "In TLMPM::compute_grid_weight_functions_and_gradients()\n";
-  bigint nsolids, np_local, nnodes_local, nnodes_ghost, nnodes;
+  bigint nsolids;
 
   nsolids = domain->solids.size();
 
   if (nsolids) {
     for (int isolid=0; isolid<nsolids; isolid++){
 
-      np_local = domain->solids[isolid]->np_local;
-      nnodes = domain->solids[isolid]->grid->nnodes;
-      nnodes_local = domain->solids[isolid]->grid->nnodes_local;
-      nnodes_ghost = domain->solids[isolid]->grid->nnodes_ghost;
-
-      vector<int> *numneigh_pn = &domain->solids[isolid]->numneigh_pn;
-      vector<int> *numneigh_np = &domain->solids[isolid]->numneigh_np;
-
-      vector<vector<int>> *neigh_pn = &domain->solids[isolid]->neigh_pn;
-      vector<vector<int>> *neigh_np = &domain->solids[isolid]->neigh_np;
-
-      vector<vector< double >> *wf_pn = &domain->solids[isolid]->wf_pn;
-      vector<vector< double >> *wf_np = &domain->solids[isolid]->wf_np;
-
-      vector<vector< Eigen::Vector3d >> *wfd_pn = &domain->solids[isolid]->wfd_pn;
-      vector<vector< Eigen::Vector3d >> *wfd_np = &domain->solids[isolid]->wfd_np;
-
-      Eigen::Vector3d r;
-      double s[3], sd[3];
-      vector<Eigen::Vector3d> *xp = &domain->solids[isolid]->x0;
-      vector<Eigen::Vector3d> *xn = &domain->solids[isolid]->grid->x0;
-      double inv_cellsize = 1.0 / domain->solids[isolid]->grid->cellsize;
-      double wf;
-      Eigen::Vector3d wfd;
-
-      vector<array<int, 3>> *ntype = &domain->solids[isolid]->grid->ntype;
-      vector<bool> *nrigid = &domain->solids[isolid]->grid->rigid;
-
-      vector<tagint> *map_ntag = &domain->solids[isolid]->grid->map_ntag;
-      int inn;
-      tagint tag = 0;
-      
-      r.setZero();
-      if (np_local && (nnodes_local + nnodes_ghost)) {
-
-	int nx = domain->solids[isolid]->grid->nx_global;
-	int ny = domain->solids[isolid]->grid->ny_global;
-	int nz = domain->solids[isolid]->grid->nz_global;
-
-	for (int ip=0; ip<np_local; ip++) {
-	  // Calculate what nodes particle ip will interact with:
-
-	  vector<int> n_neigh;
-
-	  if (update->shape_function == Update::ShapeFunctions::LINEAR) {
-	    int i0 = (int) (((*xp)[ip][0] - domain->solids[isolid]->solidlo[0])*inv_cellsize);
-	    int j0 = (int) (((*xp)[ip][1] - domain->solids[isolid]->solidlo[1])*inv_cellsize);
-	    int k0 = (int) (((*xp)[ip][2] - domain->solids[isolid]->solidlo[2])*inv_cellsize);
-
-	    // cout << "(" << i0 << "," << j0 << "," << k0 << ")\t";
-
-	    for(int i=i0; i<i0+2;i++){
-	      if (ny>1){
-		for(int j=j0; j<j0+2;j++){
-		  if (nz>1){
-		    for(int k=k0; k<k0+2;k++){
-		      tag = nz * ny * i + nz * j + k;
-		      if (tag < nnodes) {
-			inn = (*map_ntag)[tag];
-			if (inn != -1) {
-			  n_neigh.push_back(inn);
-			}
-		      }
-		    }
-		  } else {
-		    tag = ny * i + j;
-		    if (tag < nnodes) {
-		      inn = (*map_ntag)[tag];
-		      if (inn != -1) {
-			n_neigh.push_back(inn);
-		      }
-		    }
-		  }
-		}
-	      } else {
-		if (i < nnodes_local + nnodes_ghost)
-		  n_neigh.push_back(i);
-	      }
-	    }
-	  } else if (update->shape_function == Update::ShapeFunctions::BERNSTEIN){
-	    int i0 = 2*(int) (((*xp)[ip][0] - domain->solids[isolid]->solidlo[0])*inv_cellsize);
-	    int j0 = 2*(int) (((*xp)[ip][1] - domain->solids[isolid]->solidlo[1])*inv_cellsize);
-	    int k0 = 2*(int) (((*xp)[ip][2] - domain->solids[isolid]->solidlo[2])*inv_cellsize);
-
-	    if ((i0 >= 1) && (i0 % 2 != 0)) i0--;
-	    if ((j0 >= 1) && (j0 % 2 != 0)) j0--;
-	    if (nz>1) if ((k0 >= 1) && (k0 % 2 != 0)) k0--;
-
-	    // cout << "(" << i0 << "," << j0 << "," << k0 << ")\t";
-
-	    for(int i=i0; i<i0+3;i++){
-	      if (ny>1){
-		for(int j=j0; j<j0+3;j++){
-		  if (nz>1){
-		    for(int k=k0; k<k0+3;k++){
-		      tag = nz * ny * i + nz * j + k;
-		      if (tag < nnodes) {
-			inn = (*map_ntag)[tag];
-			if (inn != -1) {
-			  n_neigh.push_back(inn);
-			}
-		      }
-		    }
-		  } else {
-		    tag = ny * i + j;
-		    if (tag < nnodes) {
-		      inn = (*map_ntag)[tag];
-		      if (inn != -1) {
-			n_neigh.push_back(inn);
-		      }
-		    }
-		  }
-		}
-	      } else {
-		if (i < nnodes_local + nnodes_ghost)
-		  n_neigh.push_back(i);
-	      }
-	    }
-          } else {
-	    //(update->shape_function == Update::ShapeFunctions::CUBIC_SPLINE || update->shape_function == Update::ShapeFunctions::QUADRATIC_SPLINE) {
-            int i0 = (int) (((*xp)[ip][0] - domain->solids[isolid]->solidlo[0])*inv_cellsize - 1);
-	    int j0 = (int) (((*xp)[ip][1] - domain->solids[isolid]->solidlo[1])*inv_cellsize - 1);
-	    int k0 = (int) (((*xp)[ip][2] - domain->solids[isolid]->solidlo[2])*inv_cellsize - 1);
-
-	    // cout << "(" << i0 << "," << j0 << "," << k0 << ")\t";
-
-	    for(int i=i0; i<i0+4;i++){
-	      if (ny>1) {
-		for(int j=j0; j<j0+4;j++){
-		  if (nz>1){
-		    for(int k=k0; k<k0+4;k++){
-		      tag = nz * ny * i + nz * j + k;
-			if (tag < nnodes) {
-			  inn = (*map_ntag)[nz*ny*i+nz*j+k];
-			  if (inn != -1) {
-			    n_neigh.push_back(inn);
-			  }
-			}
-		    }
-		  } else {
-		    tag = ny * i + j;
-		    if (tag < nnodes) {
-		      inn = (*map_ntag)[ny*i+j];
-		      if (inn != -1) {
-			n_neigh.push_back(inn);
-		      }
-		    }
-		  }
-		}
-	      } else {
-		if (i < nnodes_local + nnodes_ghost)
-		  n_neigh.push_back(i);
-	      }
-	    }
-          }
-
-          // cout << "ip: "<< ip << "\t";
-	  // cout << "[";
-	  // for (auto ii: n_neigh)
-	  //   cout << domain->solids[isolid]->grid->ntag[ii] << ' ';
-	  // cout << "]\n";
-
-	  //for (int in=0; in<nnodes; in++) {
-	  for (auto in: n_neigh) {
-	    // Calculate the distance between each pair of particle/node:
-	    r = ((*xp)[ip] - (*xn)[in]) * inv_cellsize;
-
-	    s[0] = basis_function(r[0], (*ntype)[in][0]);
-	    if (domain->dimension >= 2) s[1] = basis_function(r[1], (*ntype)[in][1]);
-	    else s[1] = 1;
-	    if (domain->dimension == 3) s[2] = basis_function(r[2], (*ntype)[in][2]);
-	    else s[2] = 1;
-
-	    if (s[0] != 0 && s[1] != 0 && s[2] != 0) {
-	      if (domain->solids[isolid]->mat->rigid) (*nrigid)[in] = true;
-	      // // cout << in << "\t";
-	      // // Check if this node is in n_neigh:
-	      // if (find(n_neigh.begin(), n_neigh.end(), in) == n_neigh.end()) {
-	      // 	// in is not in n_neigh
-	      //  	cout << "in=" << in << " not found in n_neigh for ip=" << ip << " which is :[";
-	      //  	for (auto ii: n_neigh)
-	      //  	  cout << ii << ' ';
-	      //  	cout << "]\n";
-	      // }
-
-	      sd[0] = derivative_basis_function(r[0], (*ntype)[in][0], inv_cellsize);
-	      if (domain->dimension >= 2) sd[1] = derivative_basis_function(r[1], (*ntype)[in][1], inv_cellsize);
-	      if (domain->dimension == 3) sd[2] = derivative_basis_function(r[2], (*ntype)[in][2], inv_cellsize);
-
-	      (*neigh_pn)[ip].push_back(in);
-	      (*neigh_np)[in].push_back(ip);
-	      (*numneigh_pn)[ip]++;
-	      (*numneigh_np)[in]++;
-	      if (domain->dimension == 1) wf = s[0];
-	      if (domain->dimension == 2) wf = s[0]*s[1];
-	      if (domain->dimension == 3) wf = s[0]*s[1]*s[2];
-
-	      (*wf_pn)[ip].push_back(wf);
-	      (*wf_np)[in].push_back(wf);
-
-	      if (domain->dimension == 1)
-		{
-		  wfd[0] = sd[0];
-		  wfd[1] = 0;
-		  wfd[2] = 0;
-		}
-	      else if (domain->dimension == 2)
-		{
-		  wfd[0] = sd[0]*s[1];
-		  wfd[1] = s[0]*sd[1];
-		  wfd[2] = 0;
-		}
-	      else if (domain->dimension == 3)
-		{
-		  wfd[0] = sd[0]*s[1]*s[2];
-		  wfd[1] = s[0]*sd[1]*s[2];
-		  wfd[2] = s[0]*s[1]*sd[2];
-		}
-	      (*wfd_pn)[ip].push_back(wfd);
-	      (*wfd_np)[in].push_back(wfd);
-	      // cout << "ip=" << ip << ", in=" << in << ", wf=" << wf << ", wfd=[" << wfd[0] << "," << wfd[1] << "," << wfd[2] << "]" << endl;
-	    }
-	  }
-	  // cout << endl;
-	}
+      Solid *s = domain->solids[isolid];
+
+      s->clear_neighbours();
+
+      if (s->np_local && (s->grid->nnodes_local + s->grid->nnodes_ghost)) {
+	// Stencil of 2 nodes per direction starting at the cell containing the particle for linear
+	// functions, 3 nodes for Bernstein polynomials, whose grid has two nodes per cell, and
+	// 4 nodes starting one cell before for the splines:
+	if (update->shape_function == Update::ShapeFunctions::LINEAR)
+	  WeightFunctions::compute<2, &BasisFunction::linear, &BasisFunction::derivative_linear>
+	    (domain->dimension, s, s->x0, s->solidlo, 1, 0);
+	else if (update->shape_function == Update::ShapeFunctions::BERNSTEIN)
+	  WeightFunctions::compute<3, &BasisFunction::bernstein_quadratic, &BasisFunction::derivative_bernstein_quadratic>
+	    (domain->dimension, s, s->x0, s->solidlo, 2, 0);
+	else if (update->shape_function == Update::ShapeFunctions::CUBIC_SPLINE)
+	  WeightFunctions::compute<4, &BasisFunction::cubic_spline, &BasisFunction::derivative_cubic_spline>
+	    (domain->dimension, s, s->x0, s->solidlo, 1, 1);
+	else
+	  WeightFunctions::compute<4, &BasisFunction::quadratic_spline, &BasisFunction::derivative_quadratic_spline>
+	    (domain->dimension, s, s->x0, s->solidlo, 1, 1);
       }
-      if (update->sub_method_type == Update::SubMethodType::APIC) domain->solids[isolid]->compute_inertia_tensor();
+      s->compute_neigh_np();
+
+      if (update->sub_method_type == Update::SubMethodType::APIC) s->compute_inertia_tensor();
     }
   }
 
   update_wf = false;
 }
 
+/*! Each solid has its own grid in TLMPM: the ghost nodes of all these grids
+ * are reduced together, with one message per neighbouring CPU and phase
+ * instead of one per solid.
+ */
+void TLMPM::reduce_ghost_nodes_begin(int quantities)
+{
+  grids.clear();
+  for (int isolid=0; isolid<domain->solids.size(); isolid++)
+    grids.push_back(domain->solids[isolid]->grid);
+  grid_exchange->reduce_ghost_nodes_begin(grids, quantities);
+}
+
+void TLMPM::reduce_ghost_nodes_end()
+{
+  grid_exchange->reduce_ghost_nodes_end();
+}
+
+/*! Each P2G step first visits the nodes exchanged with other CPUs on the grids
+ * of all the solids, starts their reduction, then visits the interior nodes while
+ * the messages are in flight.
+ */
 void TLMPM::particles_to_grid()
 {
-  bool grid_reset = true; // Indicate if the grid quantities have to be reset
   if (update_mass_nodes) {
-    for (int isolid=0; isolid<domain->solids.size(); isolid++){
-      domain->solids[isolid]->compute_mass_nodes(grid_reset);
-      domain->solids[isolid]->grid->reduce_mass_ghost_nodes();
-    }
+    compute_mass_nodes(Solid::BOUNDARY_NODES);
+    reduce_ghost_nodes_begin(Grid::GHOST_MASS);
+    compute_mass_nodes(Solid::INTERIOR_NODES);
+    reduce_ghost_nodes_end();
     update_mass_nodes = false;
   }
 
-  for (int isolid=0; isolid<domain->solids.size(); isolid++){
-    if (update->sub_method_type == Update::SubMethodType::APIC) domain->solids[isolid]->compute_velocity_nodes_APIC(grid_reset);
-    else domain->solids[isolid]->compute_velocity_nodes(grid_reset);
-    domain->solids[isolid]->compute_external_forces_nodes(grid_reset);
-    domain->solids[isolid]->compute_internal_forces_nodes_TL();
-
-    if (temp) {
-      domain->solids[isolid]->compute_temperature_nodes(grid_reset);
-      domain->solids[isolid]->compute_external_temperature_driving_forces_nodes(grid_reset);
-      domain->solids[isolid]->compute_internal_temperature_driving_forces_nodes();
-    }
-    domain->solids[isolid]->grid->reduce_ghost_nodes(true, true, temp);
-  }
+  compute_nodes(Solid::BOUNDARY_NODES, true, true);
+  reduce_ghost_nodes_begin(Grid::GHOST_V | Grid::GHOST_FORCES | (temp ? Grid::GHOST_TEMP : 0));
+  compute_nodes(Solid::INTERIOR_NODES, true, true);
+  reduce_ghost_nodes_end();
 }
 
 void TLMPM::particles_to_grid_USF_1()
 {
-  bool grid_reset = true; // Indicate if the grid quantities have to be reset
   if (update_mass_nodes) {
-    for (int isolid=0; isolid<domain->solids.size(); isolid++){
-      domain->solids[isolid]->compute_mass_nodes(grid_reset);
-      domain->solids[isolid]->grid->reduce_mass_ghost_nodes();
-    }
+    compute_mass_nodes(Solid::BOUNDARY_NODES);
+    reduce_ghost_nodes_begin(Grid::GHOST_MASS);
+    compute_mass_nodes(Solid::INTERIOR_NODES);
+    reduce_ghost_nodes_end();
     update_mass_nodes = false;
   }
 
-  for (int isolid=0; isolid<domain->solids.size(); isolid++){
-    if (update->sub_method_type == Update::SubMethodType::APIC)
-      domain->solids[isolid]->compute_velocity_nodes_APIC(grid_reset);
-    else
-      domain->solids[isolid]->compute_velocity_nodes(grid_reset);
-
-    if (temp)
-      domain->solids[isolid]->compute_temperature_nodes(grid_reset);
-
-    domain->solids[isolid]->grid->reduce_ghost_nodes(true, false, temp);
-  }
+  compute_nodes(Solid::BOUNDARY_NODES, true, false);
+  reduce_ghost_nodes_begin(Grid::GHOST_V | (temp ? Grid::GHOST_TEMP : 0));
+  compute_nodes(Solid::INTERIOR_NODES, true, false);
+  reduce_ghost_nodes_end();
 }
 
 void TLMPM::particles_to_grid_USF_2()
 {
-  bool grid_reset = true; // Indicate if the grid quantities have to be reset
+  compute_nodes(Solid::BOUNDARY_NODES, false, true);
+  reduce_ghost_nodes_begin(Grid::GHOST_FORCES | (temp ? Grid::GHOST_TEMP : 0));
+  compute_nodes(Solid::INTERIOR_NODES, false, true);
+  reduce_ghost_nodes_end();
+}
 
+void TLMPM::compute_mass_nodes(Solid::NodeSet nodes)
+{
+  // Each solid has its own grid, reset with its boundary nodes:
+  bool grid_reset = nodes != Solid::INTERIOR_NODES;
+  for (int isolid=0; isolid<domain->solids.size(); isolid++)
+    domain->solids[isolid]->compute_mass_nodes(grid_reset, nodes);
+}
+
+void TLMPM::compute_nodes(Solid::NodeSet nodes, bool velocities, bool forces)
+{
+  // Each solid has its own grid, reset with its boundary nodes:
+  bool grid_reset = nodes != Solid::INTERIOR_NODES;
   for (int isolid=0; isolid<domain->solids.size(); isolid++){
-    domain->solids[isolid]->compute_external_forces_nodes(grid_reset);
-    domain->solids[isolid]->compute_internal_forces_nodes_TL();
+    Solid *s = domain->solids[isolid];
+
+    if (velocities) {
+      if (update->sub_method_type == Update::SubMethodType::APIC)
+	s->compute_velocity_nodes_APIC(grid_reset, nodes);
+      else
+	s->compute_velocity_nodes(grid_reset, nodes);
+    }
+
+    if (forces) {
+      s->compute_external_forces_nodes(grid_reset, nodes);
+      s->compute_internal_forces_nodes_TL(nodes);
+    }
 
     if (temp) {
-      domain->solids[isolid]->compute_external_temperature_driving_forces_nodes(grid_reset);
-      domain->solids[isolid]->compute_internal_temperature_driving_forces_nodes();
+      if (velocities)
+	s->compute_temperature_nodes(grid_reset, nodes);
+      if (forces) {
+	s->compute_external_temperature_driving_forces_nodes(grid_reset, nodes);
+	s->compute_internal_temperature_driving_forces_nodes(grid_reset, nodes);
+      }
     }
-    domain->solids[isolid]->grid->reduce_ghost_nodes(false, true, temp);
   }
 }
 
@@ -439,16 +274,10 @@ void TLMPM::advance_particles()
 
 void TLMPM::velocities_to_grid()
 {
-  for (int isolid=0; isolid<domain->solids.size(); isolid++) {
-    if (update->sub_method_type == Update::SubMethodType::APIC)
-      domain->solids[isolid]->compute_velocity_nodes_APIC(true);
-    else
-      domain->solids[isolid]->compute_velocity_nodes(true);
-    if (temp) {
-      domain->solids[isolid]->compute_temperature_nodes(true);
-    }
-    domain->solids[isolid]->grid->reduce_ghost_nodes(true, false, temp);
-  }
+  compute_nodes(Solid::BOUNDARY_NODES, true, false);
+  reduce_ghost_nodes_begin(Grid::GHOST_V | (temp ? Grid::GHOST_TEMP : 0));
+  compute_nodes(Solid::INTERIOR_NODES, true, false);
+  reduce_ghost_nodes_end();
 }
 
 void TLMPM::update_grid_positions()
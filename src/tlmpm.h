@@ -21,6 +21,7 @@ MethodStyle(tlmpm,TLMPM)
 #define LMP_TLMPM_H
 
 #include "method.h"
+#include "solid.h"
 #include <vector>
 #include <Eigen/Eigen>
 
@@ -51,6 +52,14 @@ public:
 
 private:
   bool update_wf, update_mass_nodes;
+
+  class GridExchange *grid_exchange; ///< Reduces the ghost nodes of the grids of all the solids at once
+  vector<class Grid *> grids;        ///< Grid of each solid
+
+  void reduce_ghost_nodes_begin(int); ///< Start the reduction of a combination of Grid::GhostQuantities on the grid of every solid.
+  void reduce_ghost_nodes_end();      ///< Complete the reduction started by reduce_ghost_nodes_begin().
+  void compute_mass_nodes(Solid::NodeSet);        ///< P2G of the mass of all the solids on a set of nodes.
+  void compute_nodes(Solid::NodeSet, bool, bool); ///< P2G of the velocities and/or forces (and thermal quantities) of all the solids on a set of nodes.
 };
 
 // double linear_basis_function(double, int);
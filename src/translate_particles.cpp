@@ -14,6 +14,7 @@
 #include "translate_particles.h"
 #include "domain.h"
 #include "error.h"
+#include "expression.h"
 #include "group.h"
 #include "input.h"
 #include "var.h"
@@ -72,49 +73,52 @@ void TranslateParticles::translate_region(vector<string> args, int isolid) {
   else zset = true;
 
   int ns = domain->solids.size();
-  double delx_value, dely_value, delz_value;
   Solid *s;
-  Grid *g;
+
+  Expression delexpr[3];
+  bool set[3] = {xset, yset, zset};
+  if (xset) delexpr[0].compile(mpm, delx);
+  if (yset) delexpr[1].compile(mpm, dely);
+  if (zset) delexpr[2].compile(mpm, delz);
+
+  vector<int> ilist;
+  vector<double> values[3];
 
   for(int is = 0; is < ns; is++)
     {
       if ((isolid < 0) || (is == isolid))
 	{
 	  s = domain->solids[is];
-	  g = s->grid;
+
+	  ilist.clear();
 
 	  for(int ip=0; ip < s->np_local; ip++)
 	    {
 	      if (domain->regions[iregion]->inside(s->x[ip][0], s->x[ip][1], s->x[ip][2])==1)
+		ilist.push_back(ip);
+	    }
+
+	  int n = ilist.size();
+
+	  // All the displacements are evaluated at the positions before the translation:
+	  for (int dim = 0; dim < 3; dim++)
+	    {
+	      if (!set[dim]) continue;
+
+	      values[dim].resize(n);
+	      delexpr[dim].evaluate(n, ilist.data(), &s->x, &s->x0, values[dim].data());
+	    }
+
+	  for (int dim = 0; dim < 3; dim++)
+	    {
+	      if (!set[dim]) continue;
+
+	      for (int i = 0; i < n; i++)
 		{
-		  (*input->vars)["x0"] = Var("x0", s->x0[ip][0]);
-		  (*input->vars)["y0"] = Var("y0", s->x0[ip][1]);
-		  (*input->vars)["z0"] = Var("z0", s->x0[ip][2]);
-
-		  (*input->vars)["x"]  = Var("x", s->x[ip][0]);
-		  (*input->vars)["y"]  = Var("y", s->x[ip][1]);
-		  (*input->vars)["z"]  = Var("z", s->x[ip][2]);
-
-		  if (xset)
-		    {
-		      delx_value    = delx.result(mpm);
-		      s->x0[ip][0] += delx_value;
-		      s->x[ip][0]  += delx_value;
-		    }
-		  if (yset)
-		    {
-		      dely_value    = dely.result(mpm);
-		      s->x0[ip][1] += dely_value;
-		      s->x[ip][1]  += dely_value;
-		    }
-		  if (zset)
-		    {
-		      delz_value    = delz.result(mpm);
-		      s->x0[ip][2] += delz_value;
-		      s->x[ip][2]  += delz_value;
-		    }
+		  s->x0[ilist[i]][dim] += values[dim][i];
+		  s->x[ilist[i]][dim]  += values[dim][i];
 		}
-	    }  
+	    }
 	}
     }
 }
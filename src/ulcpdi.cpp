@@ -131,23 +131,19 @@ void ULCPDI::compute_grid_weight_functions_and_gradients()
 	nc = s->nc;
 	nnodes = s->grid->nnodes_local + s->grid->nnodes_ghost;
 
-	vector<int> *numneigh_pn = &s->numneigh_pn;
-	vector<int> *numneigh_np = &s->numneigh_np;
+	vector<int> *neigh_pn_offset = &s->neigh_pn_offset;
 
-	vector<vector<int>> *neigh_pn = &s->neigh_pn;
-	vector<vector<int>> *neigh_np = &s->neigh_np;
+	vector<int> *neigh_pn = &s->neigh_pn;
 
-	vector<vector< double >> *wf_pn = &s->wf_pn;
-	vector<vector< double >> *wf_pn_corners = &s->wf_pn_corners;
-	vector<vector< double >> *wf_np = &s->wf_np;
+	vector<double> *wf_pn = &s->wf_pn;
+	vector<double> *wf_pn_corners = &s->wf_pn_corners;
 
-	vector<vector< Eigen::Vector3d >> *wfd_pn = &s->wfd_pn;
-	vector<vector< Eigen::Vector3d >> *wfd_np = &s->wfd_np;
+	vector<Eigen::Vector3d> *wfd_pn = &s->wfd_pn;
 
-	vector<Eigen::Vector3d> *xp  = &s->x;
-	vector<Eigen::Vector3d> *xpc = &s->xpc;
+	ParticleVectors *xp          = &s->x;
+	ParticleVectors *xpc         = &s->xpc;
 	vector<Eigen::Vector3d> *xn  = &s->grid->x0;
-	vector<Eigen::Vector3d> *rp  = &s->rp;
+	ParticleVectors *rp          = &s->rp;
 
 	double inv_cellsize          = 1.0 / s->grid->cellsize;
 	vector<array<int, 3>> *ntype = &s->grid->ntype;
@@ -160,24 +156,12 @@ void ULCPDI::compute_grid_weight_functions_and_gradients()
 
 	double a, b, inv_Vp, alpha_over_Vp, sixVp;
 
-	for (int in = 0; in < nnodes; in++)
-	  {
-	    (*neigh_np)[in].clear();
-	    (*numneigh_np)[in] = 0;
-	    (*wf_np)[in].clear();
-	    (*wfd_np)[in].clear();
-	  }
+	s->clear_neighbours();
 
 	if (np_local && nnodes)
 	  {
 	  for (int ip = 0; ip < np_local; ip++)
 	    {
-	      (*neigh_pn)[ip].clear();
-	      (*numneigh_pn)[ip] = 0;
-	      (*wf_pn)[ip].clear();
-	      for(int ic=0; ic<nc; ic++) (*wf_pn_corners)[nc*ip+ic].clear();
-	      (*wfd_pn)[ip].clear();
-
 	      // Calculate what nodes the corner of Omega_p will interact with:
 	      int nx = s->grid->nx;
 	      int ny = s->grid->ny;
@@ -371,22 +355,20 @@ void ULCPDI::compute_grid_weight_functions_and_gradients()
 			  wfd[2] = 0;
 
 			  wfd *= 0.5*inv_Vp;
-			  for(int ic=0; ic<nc; ic++) (*wf_pn_corners)[nc*ip+ic].push_back(wfc[ic]);
+			  for(int ic=0; ic<nc; ic++) wf_pn_corners->push_back(wfc[ic]);
 			}
 
-		      (*neigh_pn)[ip].push_back(in);
-		      (*neigh_np)[in].push_back(ip);
-		      (*numneigh_pn)[ip]++;
-		      (*numneigh_np)[in]++;
+		      neigh_pn->push_back(in);
 
-		      (*wf_pn)[ip].push_back(wf);
-		      (*wf_np)[in].push_back(wf);
-		      (*wfd_pn)[ip].push_back(wfd);
-		      (*wfd_np)[in].push_back(wfd);
+		      wf_pn->push_back(wf);
+		      wfd_pn->push_back(wfd);
 		    }
 		}
+	      (*neigh_pn_offset)[ip + 1] = neigh_pn->size();
 	    }
 	  }
+	s->compute_neigh_np();
+
 	if (method_type.compare("APIC") == 0) s->compute_inertia_tensor();
       }
     }
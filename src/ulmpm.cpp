@@ -21,6 +21,7 @@
 #include "universe.h"
 #include "update.h"
 #include "var.h"
+#include "weight_functions.h"
 #include <Eigen/Eigen>
 #include <algorithm>
 #include <iostream>
@@ -36,22 +37,39 @@ ULMPM::ULMPM(MPM *mpm) : Method(mpm)
   update_Di   = 1;
   update->PIC_FLIP = 0.99;
   apic        = false;
+  scatter     = false;
 
   // Default base function (linear):
   basis_function            = &BasisFunction::linear;
   derivative_basis_function = &BasisFunction::derivative_linear;
 
   rigid_solids = 0;
+
+  MPI_Comm_dup(universe->uworld, &exchange_comm);
 }
 
-ULMPM::~ULMPM() {}
+ULMPM::~ULMPM()
+{
+  MPI_Comm_free(&exchange_comm);
+}
 
 void ULMPM::setup(vector<string> args)
 {
-  if (args.size() > 0) {
+  if (args.size() > 1) {
     error->all(FLERR, "Illegal modify_method command: too many arguments.\n");
   }
 
+  if (args.size() == 1) {
+    if (args[0].compare("scatter") == 0) {
+      scatter = true;
+      if (universe->me == 0)
+	cout << "Using scatter particle to grid\n";
+    } else {
+      error->all(FLERR, "Illegal modify_method command: keyword " + args[0] +
+		 " unknown. Expected \033[1;32mscatter\033[0m.\n");
+    }
+  }
+
   if (update->shape_function == Update::ShapeFunctions::LINEAR) {
     if (universe->me == 0)
       cout << "Setting up linear basis functions\n";
@@ -87,7 +105,7 @@ void ULMPM::setup(vector<string> args)
 
 void ULMPM::compute_grid_weight_functions_and_gradients()
 {
-  bigint nsolids, np_local, nnodes_local, nnodes_ghost, nnodes;
+  bigint nsolids;
 
   nsolids = domain->solids.size();
 
@@ -98,230 +116,47 @@ void ULMPM::compute_grid_weight_functions_and_gradients()
       if (update->ntimestep == 0 && domain->solids[isolid]->mat->rigid)
         rigid_solids = 1;
 
-      np_local = domain->solids[isolid]->np_local;
-      nnodes = domain->solids[isolid]->grid->nnodes;
-      nnodes_local = domain->solids[isolid]->grid->nnodes_local;
-      nnodes_ghost = domain->solids[isolid]->grid->nnodes_ghost;
-
-      vector<int> *numneigh_pn = &domain->solids[isolid]->numneigh_pn;
-      vector<int> *numneigh_np = &domain->solids[isolid]->numneigh_np;
-
-      vector<vector<int>> *neigh_pn = &domain->solids[isolid]->neigh_pn;
-      vector<vector<int>> *neigh_np = &domain->solids[isolid]->neigh_np;
-
-      vector<vector<double>> *wf_pn = &domain->solids[isolid]->wf_pn;
-      vector<vector<double>> *wf_np = &domain->solids[isolid]->wf_np;
-
-      vector<vector<Eigen::Vector3d>> *wfd_pn = &domain->solids[isolid]->wfd_pn;
-      vector<vector<Eigen::Vector3d>> *wfd_np = &domain->solids[isolid]->wfd_np;
+      Solid *s = domain->solids[isolid];
 
-      Eigen::Vector3d r;
-      double s[3], sd[3];
-      vector<Eigen::Vector3d> *xp = &domain->solids[isolid]->x;
-      vector<Eigen::Vector3d> *xn = &domain->solids[isolid]->grid->x0;
-      double inv_cellsize = 1.0 / domain->solids[isolid]->grid->cellsize;
-      double wf;
-      Eigen::Vector3d wfd;
+      s->clear_neighbours();
 
-      vector<array<int, 3>> *ntype = &domain->solids[isolid]->grid->ntype;
-      vector<bool> *nrigid = &domain->solids[isolid]->grid->rigid;
-
-      vector<tagint> *map_ntag = &domain->solids[isolid]->grid->map_ntag;
-
-      vector<int> n_neigh;
-
-      int i0, j0, k0, inn;
-      tagint tag = 0;
-      int ny = domain->solids[isolid]->grid->ny_global;
-      int nz = domain->solids[isolid]->grid->nz_global;
-
-      r.setZero();
-
-      for (int in = 0; in < nnodes_local + nnodes_ghost; in++)
+      if (s->np_local && (s->grid->nnodes_local + s->grid->nnodes_ghost))
       {
-        (*neigh_np)[in].clear();
-        (*numneigh_np)[in] = 0;
-        (*wf_np)[in].clear();
-        (*wfd_np)[in].clear();
+        // Stencil of 2 nodes per direction starting at the cell containing
+        // the particle for linear functions, 4 nodes starting one cell before
+        // otherwise:
+        if (update->shape_function == Update::ShapeFunctions::LINEAR)
+          WeightFunctions::compute<2, &BasisFunction::linear, &BasisFunction::derivative_linear>
+            (domain->dimension, s, s->x, domain->boxlo, 1, 0);
+        else if (update->shape_function == Update::ShapeFunctions::CUBIC_SPLINE)
+          WeightFunctions::compute<4, &BasisFunction::cubic_spline, &BasisFunction::derivative_cubic_spline>
+            (domain->dimension, s, s->x, domain->boxlo, 1, 1);
+        else if (update->shape_function == Update::ShapeFunctions::QUADRATIC_SPLINE)
+          WeightFunctions::compute<4, &BasisFunction::quadratic_spline, &BasisFunction::derivative_quadratic_spline>
+            (domain->dimension, s, s->x, domain->boxlo, 1, 1);
+        else
+          WeightFunctions::compute<4, &BasisFunction::bernstein_quadratic, &BasisFunction::derivative_bernstein_quadratic>
+            (domain->dimension, s, s->x, domain->boxlo, 1, 1);
       }
 
-      if (np_local && (nnodes_local + nnodes_ghost))
-      {
-        for (int ip = 0; ip < np_local; ip++)
-        {
-          (*neigh_pn)[ip].clear();
-          (*numneigh_pn)[ip] = 0;
-          (*wf_pn)[ip].clear();
-          (*wfd_pn)[ip].clear();
-
-          // Calculate what nodes particle ip will interact with:
-
-          n_neigh.clear();
-
-          if (update->shape_function == Update::ShapeFunctions::LINEAR)
-          {
-	    i0 = (int) (((*xp)[ip][0] - domain->boxlo[0])*inv_cellsize);
-	    j0 = (int) (((*xp)[ip][1] - domain->boxlo[1])*inv_cellsize);
-	    k0 = (int) (((*xp)[ip][2] - domain->boxlo[2])*inv_cellsize);
-
-            for (int i = i0; i < i0 + 2; i++)
-            {
-              if (ny > 1)
-              {
-                for (int j = j0; j < j0 + 2; j++)
-                {
-                  if (nz > 1)
-                  {
-                    for (int k = k0; k < k0 + 2; k++)
-                    {
-		      tag = nz * ny * i + nz * j + k;
-		      if (tag < nnodes) {
-			inn = (*map_ntag)[tag];
-			if (inn != -1) {
-			  n_neigh.push_back(inn);
-			}
-		      }
-                    }
-                  }
-                  else
-                  {
-		    tag = ny * i + j;
-		    if (tag < nnodes) {
-		      inn = (*map_ntag)[tag];
-		      if (inn != -1) {
-			n_neigh.push_back(inn);
-		      }
-		    }
-                  }
-                }
-              }
-              else
-              {
-		if (i < nnodes_local + nnodes_ghost)
-                  n_neigh.push_back(i);
-              }
-            }
-	  } else {
-	    // cubic and quadratic B-splines
-            i0 = (int)(((*xp)[ip][0] - domain->boxlo[0]) * inv_cellsize - 1);
-            j0 = (int)(((*xp)[ip][1] - domain->boxlo[1]) * inv_cellsize - 1);
-            k0 = (int)(((*xp)[ip][2] - domain->boxlo[2]) * inv_cellsize - 1);
-
-            for (int i = i0; i < i0 + 4; i++) {
-              if (ny > 1) {
-                for (int j = j0; j < j0 + 4; j++) {
-                  if (nz > 1) {
-                    for (int k = k0; k < k0 + 4; k++) {
-		      tag = nz * ny * i + nz * j + k;
-		      if (tag < nnodes) {
-			inn = (*map_ntag)[tag];
-			if (inn != -1) {
-			  n_neigh.push_back(inn);
-			}
-		      }
-                    }
-                  }
-                  else
-                  {
-		    tag = ny * i + j;
-		    if (tag < nnodes) {
-		      inn = (*map_ntag)[tag];
-		      if (inn != -1) {
-			n_neigh.push_back(inn);
-		      }
-		    }
-                  }
-                }
-              }
-              else
-              {
-		if (i < nnodes_local + nnodes_ghost)
-                  n_neigh.push_back(i);
-              }
-            }
-          }
-
-          for (auto in : n_neigh)
-          {
-
-            // Calculate the distance between each pair of particle/node:
-	    r = ((*xp)[ip] - (*xn)[in]) * inv_cellsize;
-
-	    s[0] = basis_function(r[0], (*ntype)[in][0]);
-	    wf = s[0];
-	    if (wf != 0) {
-	      if (domain->dimension >= 2) {
-		s[1] = basis_function(r[1], (*ntype)[in][1]);
-		wf *= s[1];
-	      }
-	      else s[1] = 1;
-	      if (domain->dimension == 3 && wf != 0) {
-		s[2] = basis_function(r[2], (*ntype)[in][2]);
-		wf *= s[2];
-	      }
-	      else s[2] = 1;
-	    }
-
-	    if (wf != 0)
-            {
-              if (domain->solids[isolid]->mat->rigid)
-                (*nrigid)[in] = true;
-              // // cout << in << "\t";
-              // // Check if this node is in n_neigh:
-              // if (find(n_neigh.begin(), n_neigh.end(), in) == n_neigh.end())
-              // {
-              // 	// in is not in n_neigh
-              //  	cout << "in=" << in << " not found in n_neigh for ip=" << ip
-              //  << " which is :["; 	for (auto ii: n_neigh) 	  cout << ii << ' ';
-              //  	cout << "]\n";
-              // }
-
-	      sd[0] = derivative_basis_function(r[0], (*ntype)[in][0], inv_cellsize);
-	      if (domain->dimension >= 2) sd[1] = derivative_basis_function(r[1], (*ntype)[in][1], inv_cellsize);
-	      if (domain->dimension == 3) sd[2] = derivative_basis_function(r[2], (*ntype)[in][2], inv_cellsize);
-
-	      (*neigh_pn)[ip].push_back(in);
-              (*neigh_np)[in].push_back(ip);
-              (*numneigh_pn)[ip]++;
-              (*numneigh_np)[in]++;
-
-              (*wf_pn)[ip].push_back(wf);
-              (*wf_np)[in].push_back(wf);
-
-              
-              if (domain->dimension == 3)
-              {
-                wfd[0] = sd[0] * s[1] * s[2];
-                wfd[1] = s[0] * sd[1] * s[2];
-                wfd[2] = s[0] * s[1] * sd[2];
-              }
-              else if (domain->dimension == 2)
-              {
-                wfd[0] = sd[0] * s[1];
-                wfd[1] = s[0] * sd[1];
-                wfd[2] = 0;
-              }
-	      else
-              {
-                wfd[0] = sd[0];
-                wfd[1] = 0;
-                wfd[2] = 0;
-              }
-              (*wfd_pn)[ip].push_back(wfd);
-              (*wfd_np)[in].push_back(wfd);
-              // cout << "ip=" << ip << ", in=" << in << ", wf=" << wf << ",
-              // wfd=[" << wfd[0] << "," << wfd[1] << "," << wfd[2] << "]" <<
-              // endl;
-            }
-          }
-          // cout << endl;
-        }
-      }
+      // The scatter P2G does not need the node-particle lists, except for MLS
+      // forces and temperature which are always gathered, but only the list
+      // of the nodes the particles of the solid contribute to:
+      if (scatter)
+        s->compute_scatter_blocks(update->shape_function == Update::ShapeFunctions::LINEAR ? 2 : 4);
+      if (!scatter || temp || update->sub_method_type == Update::SubMethodType::MLS)
+        s->compute_neigh_np();
+      else
+        s->compute_neigh_nodes();
+
       if (update_Di && apic)
-        domain->solids[isolid]->compute_inertia_tensor();
+        s->compute_inertia_tensor();
     }
   } // end if (nsolids)
 
+  // Restrict the grid updates to the blocks of nodes close to particles:
+  domain->grid->update_active_blocks();
+
   if (update->ntimestep == 0) {
     // Reduce rigid_solids
     int rigid_solids_reduced = 0;
@@ -336,103 +171,100 @@ void ULMPM::compute_grid_weight_functions_and_gradients()
   update_Di = 0;
 }
 
+/*! Each P2G step first visits the nodes exchanged with other CPUs, starts their
+ * reduction, then visits the interior nodes while the messages are in flight.
+ * The grid is reset by the first solid with the boundary nodes.
+ */
 void ULMPM::particles_to_grid() {
-  bool grid_reset = false; // Indicate if the grid quantities have to be reset
-  for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
+  int quantities = Grid::GHOST_V | Grid::GHOST_FORCES | (temp ? Grid::GHOST_TEMP : 0);
 
-    if (isolid == 0)
-      grid_reset = true;
-    else
-      grid_reset = false;
-
-    domain->solids[isolid]->compute_mass_nodes(grid_reset);
-  }
-
-  domain->grid->reduce_mass_ghost_nodes();
-
-  for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
+  compute_mass_nodes(Solid::BOUNDARY_NODES);
+  domain->grid->reduce_ghost_nodes_begin(Grid::GHOST_MASS);
+  compute_mass_nodes(Solid::INTERIOR_NODES);
+  domain->grid->reduce_ghost_nodes_end();
 
-    if (isolid == 0)
-      grid_reset = true;
-    else
-      grid_reset = false;
-
-    if (apic)
-      domain->solids[isolid]->compute_velocity_nodes_APIC(grid_reset);
-    else
-      domain->solids[isolid]->compute_velocity_nodes(grid_reset);
-
-    if (update->sub_method_type == Update::SubMethodType::MLS) {
-      domain->solids[isolid]->compute_external_and_internal_forces_nodes_UL_MLS(grid_reset);
-    } else {
-      domain->solids[isolid]->compute_external_and_internal_forces_nodes_UL(grid_reset);
-    }
-
-    if (temp) {
-      domain->solids[isolid]->compute_temperature_nodes(grid_reset);
-      domain->solids[isolid]->compute_external_temperature_driving_forces_nodes(grid_reset);
-      domain->solids[isolid]->compute_internal_temperature_driving_forces_nodes();
-    }
-  }
-  domain->grid->reduce_ghost_nodes(true, true, temp);
+  compute_nodes(Solid::BOUNDARY_NODES, true, true);
+  domain->grid->reduce_ghost_nodes_begin(quantities);
+  compute_nodes(Solid::INTERIOR_NODES, true, true);
+  domain->grid->reduce_ghost_nodes_end();
 }
 
 void ULMPM::particles_to_grid_USF_1() {
-  bool grid_reset = false; // Indicate if the grid quantities have to be reset
-  for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
+  int quantities = Grid::GHOST_V | (temp ? Grid::GHOST_TEMP : 0);
 
-    if (isolid == 0)
-      grid_reset = true;
-    else
-      grid_reset = false;
+  compute_mass_nodes(Solid::BOUNDARY_NODES);
+  domain->grid->reduce_ghost_nodes_begin(Grid::GHOST_MASS);
+  compute_mass_nodes(Solid::INTERIOR_NODES);
+  domain->grid->reduce_ghost_nodes_end();
 
-    domain->solids[isolid]->compute_mass_nodes(grid_reset);
-  }
+  compute_nodes(Solid::BOUNDARY_NODES, true, false);
+  domain->grid->reduce_ghost_nodes_begin(quantities);
+  compute_nodes(Solid::INTERIOR_NODES, true, false);
+  domain->grid->reduce_ghost_nodes_end();
+}
 
-  domain->grid->reduce_mass_ghost_nodes();
+void ULMPM::particles_to_grid_USF_2() {
+  int quantities = Grid::GHOST_FORCES | (temp ? Grid::GHOST_TEMP : 0);
 
-  for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
+  compute_nodes(Solid::BOUNDARY_NODES, false, true);
+  domain->grid->reduce_ghost_nodes_begin(quantities);
+  compute_nodes(Solid::INTERIOR_NODES, false, true);
+  domain->grid->reduce_ghost_nodes_end();
+}
 
-    if (isolid == 0)
-      grid_reset = true;
-    else
-      grid_reset = false;
+void ULMPM::compute_mass_nodes(Solid::NodeSet nodes) {
+  for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
+    // Indicate if the grid quantities have to be reset:
+    bool grid_reset = isolid == 0 && nodes != Solid::INTERIOR_NODES;
 
-    if (apic)
-      domain->solids[isolid]->compute_velocity_nodes_APIC(grid_reset);
+    if (scatter)
+      domain->solids[isolid]->compute_mass_nodes_scatter(grid_reset, nodes);
     else
-      domain->solids[isolid]->compute_velocity_nodes(grid_reset);
-    if (temp)
-      domain->solids[isolid]->compute_temperature_nodes(grid_reset);
+      domain->solids[isolid]->compute_mass_nodes(grid_reset, nodes);
   }
-  domain->grid->reduce_ghost_nodes(true, false, temp);
 }
 
-void ULMPM::particles_to_grid_USF_2() {
-  bool grid_reset = false; // Indicate if the grid quantities have to be reset
-
+void ULMPM::compute_nodes(Solid::NodeSet nodes, bool velocities, bool forces) {
   for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
+    // Indicate if the grid quantities have to be reset:
+    bool grid_reset = isolid == 0 && nodes != Solid::INTERIOR_NODES;
+    Solid *s = domain->solids[isolid];
+
+    if (velocities) {
+      if (apic) {
+        if (scatter)
+          s->compute_velocity_nodes_APIC_scatter(grid_reset, nodes);
+        else
+          s->compute_velocity_nodes_APIC(grid_reset, nodes);
+      } else {
+        if (scatter)
+          s->compute_velocity_nodes_scatter(grid_reset, nodes);
+        else
+          s->compute_velocity_nodes(grid_reset, nodes);
+      }
+    }
 
-    if (isolid == 0)
-      grid_reset = true;
-    else
-      grid_reset = false;
-
-    if (update->sub_method_type == Update::SubMethodType::MLS) {
-      domain->solids[isolid]->compute_external_and_internal_forces_nodes_UL_MLS(grid_reset);
-    } else {
-      domain->solids[isolid]->compute_external_and_internal_forces_nodes_UL(grid_reset);
+    if (forces) {
+      if (update->sub_method_type == Update::SubMethodType::MLS) {
+        s->compute_external_and_internal_forces_nodes_UL_MLS(grid_reset, nodes);
+      } else if (scatter) {
+        s->compute_external_and_internal_forces_nodes_UL_scatter(grid_reset, nodes);
+      } else {
+        s->compute_external_and_internal_forces_nodes_UL(grid_reset, nodes);
+      }
     }
 
     if (temp) {
-      domain->solids[isolid]->compute_external_temperature_driving_forces_nodes(grid_reset);
-      domain->solids[isolid]->compute_internal_temperature_driving_forces_nodes();
+      if (velocities)
+        s->compute_temperature_nodes(grid_reset, nodes);
+      if (forces) {
+        s->compute_external_temperature_driving_forces_nodes(grid_reset, nodes);
+        s->compute_internal_temperature_driving_forces_nodes(grid_reset, nodes);
+      }
     }
   }
-  domain->grid->reduce_ghost_nodes(false, true, temp);
 }
 
-
 void ULMPM::update_grid_state() {
   domain->grid->update_grid_velocities();
   if (temp)
@@ -475,24 +307,12 @@ void ULMPM::advance_particles()
 
 void ULMPM::velocities_to_grid()
 {
-  bool grid_reset = false; // Indicate if the grid quantities have to be reset
-  for (int isolid = 0; isolid < domain->solids.size(); isolid++)
-  {
+  int quantities = Grid::GHOST_V | (temp ? Grid::GHOST_TEMP : 0);
 
-    if (isolid == 0)
-      grid_reset = true;
-    else
-      grid_reset = false;
-
-    if (apic)
-      domain->solids[isolid]->compute_velocity_nodes_APIC(grid_reset);
-    else
-      domain->solids[isolid]->compute_velocity_nodes(grid_reset);
-    if (temp) {
-      domain->solids[isolid]->compute_temperature_nodes(grid_reset);
-    }
-  }
-  domain->grid->reduce_ghost_nodes(true, false, temp);
+  compute_nodes(Solid::BOUNDARY_NODES, true, false);
+  domain->grid->reduce_ghost_nodes_begin(quantities);
+  compute_nodes(Solid::INTERIOR_NODES, true, false);
+  domain->grid->reduce_ghost_nodes_end();
 }
 
 void ULMPM::compute_rate_deformation_gradient(bool doublemapping) {
@@ -562,105 +382,121 @@ void ULMPM::reset()
   }
 }
 
+/*! The particles of all the solids leaving the sub-domain for the same neighbouring
+ * CPU are sent in a single message, which holds for each solid the number of particles
+ * followed by their packed fields. All the messages are sent at once without waiting,
+ * and are unpacked in the order of the CPUs once all of them are received, so that the
+ * particles end up in the same order whatever the order of arrival.\n
+ * Only the positions are scanned on all the particles, in parallel: which_CPU_owns_me()
+ * and the packing are only called for the few particles found out of the sub-domain.
+ */
 void ULMPM::exchange_particles() {
-  int ip, np_local_old;
-  vector<Eigen::Vector3d> *xp;
-  // vector<int> np_send;
-  vector<vector<double>> buf_send_vect(universe->nprocs);
-  vector<vector<double>> buf_recv_vect(universe->nprocs);
-  vector<int> unpack_list;
-  int owner = 0;
+  int nsolids = domain->solids.size();
+
+  exchange_procs = domain->neighbour_procs(0);
+  int nneigh = exchange_procs.size();
+  if (nneigh == 0)
+    return;
+
+  exchange_send.resize(nneigh);
+  exchange_recv.resize(nneigh);
+  for (int k = 0; k < nneigh; k++)
+    exchange_send[k].clear();
 
   // Identify the particles that are not in the subdomain
-  // and transfer their variables to the buffer:
+  // and transfer their variables to the buffers:
+  vector<size_t> count(nneigh);
 
-  for (int isolid = 0; isolid < domain->solids.size(); isolid++) {
-    for (int iproc = 0; iproc < universe->nprocs; iproc++) {
-      buf_send_vect[iproc].clear();
-      buf_recv_vect[iproc].clear();
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    Solid *s = domain->solids[isolid];
+    ParticleVectors &xp = s->x;
+
+    for (int k = 0; k < nneigh; k++) {
+      count[k] = exchange_send[k].size();
+      exchange_send[k].push_back(0);
     }
 
-    np_local_old = domain->solids[isolid]->np_local;
-    xp = &domain->solids[isolid]->x;
+    leaving.resize(s->np_local);
+MPM_OMP(omp parallel for)
+    for (int ip = 0; ip < s->np_local; ip++)
+      leaving[ip] = !domain->inside_subdomain(xp[ip][0], xp[ip][1], xp[ip][2]);
 
-    // np_send.assign(universe->nprocs, 0);
+    int ip = 0;
+    while (ip < s->np_local) {
+      int owner = leaving[ip] ? domain->which_CPU_owns_me(xp[ip][0], xp[ip][1], xp[ip][2]) : universe->me;
 
-    ip = 0;
-    while (ip < domain->solids[isolid]->np_local) {
-      owner = domain->which_CPU_owns_me((*xp)[ip][0], (*xp)[ip][1], (*xp)[ip][2]);
       if (owner != universe->me) {
+	int k = lower_bound(exchange_procs.begin(), exchange_procs.end(), owner) - exchange_procs.begin();
+	if (k == nneigh || exchange_procs[k] != owner)
+	  error->one(FLERR, "Error: particle " + to_string(s->ptag[ip]) + " of solid " + s->id
+		     + " moved further than the neighbouring CPUs.\n");
+
         // The particle is not located in the subdomain anymore:
         // transfer it to the buffer
-        domain->solids[isolid]->pack_particle(ip, buf_send_vect[owner]);
-        domain->solids[isolid]->copy_particle(
-            domain->solids[isolid]->np_local - 1, ip);
-        domain->solids[isolid]->np_local--;
-	// np_send[owner]++;
+	s->pack_particle(ip, exchange_send[k]);
+	exchange_send[k][count[k]]++;
+
+	s->copy_particle(s->np_local - 1, ip);
+	leaving[ip] = leaving[s->np_local - 1];
+	s->np_local--;
       } else {
         ip++;
       }
     }
+  }
 
-    // if (np_local_old != domain->solids[isolid]->np_local) {
-    //   domain->solids[isolid]->grow(domain->solids[isolid]->np_local);
-    // }
-
-    // New send and receive
-    int size_r, size_s;
-    int jproc;
-    for (int i = 0; i < universe->sendnrecv.size(); i++) {
-      if (universe->sendnrecv[i][0] == 0) {
-	// Receive
-	jproc = universe->sendnrecv[i][1];
-
-        MPI_Recv(&size_r, 1, MPI_INT, jproc, 0, MPI_COMM_WORLD,
-                 MPI_STATUS_IGNORE);
-
-	if (size_r > 0) {
-	  buf_recv_vect[jproc].resize(size_r);
-          MPI_Recv(&buf_recv_vect[jproc][0], size_r, MPI_DOUBLE, jproc, 0,
-                   MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        }
-      } else {
-	// Send
-	jproc = universe->sendnrecv[i][1];
-	size_s = buf_send_vect[jproc].size();
-        MPI_Send(&size_s, 1, MPI_INT, jproc, 0, MPI_COMM_WORLD);
-
-	if (size_s > 0) {
-          MPI_Send(buf_send_vect[jproc].data(), size_s, MPI_DOUBLE, jproc, 0,
-                   MPI_COMM_WORLD);
-        }
+  // Sizes are not exchanged beforehand: each message is probed before being received.
+  // Each neighbour is probed explicitly: since messages from the same CPU cannot overtake
+  // each other, this takes its message of this call even if it already sent the next one.
+  exchange_requests.resize(nneigh);
+  for (int k = 0; k < nneigh; k++)
+    MPI_Isend(exchange_send[k].data(), exchange_send[k].size(), MPI_DOUBLE,
+	      exchange_procs[k], 0, exchange_comm, &exchange_requests[k]);
+
+  for (int k = 0; k < nneigh; k++) {
+    MPI_Status status;
+    int size;
+    MPI_Probe(exchange_procs[k], 0, exchange_comm, &status);
+    MPI_Get_count(&status, MPI_DOUBLE, &size);
+
+    exchange_recv[k].resize(size);
+    MPI_Recv(exchange_recv[k].data(), size, MPI_DOUBLE, exchange_procs[k], 0,
+	     exchange_comm, MPI_STATUS_IGNORE);
+  }
+
+  MPI_Waitall(nneigh, exchange_requests.data(), MPI_STATUSES_IGNORE);
+
+  // Check what particles are within the subdomain, and unpack them solid
+  // after solid:
+  vector<size_t> pos(nneigh, 0);
+  vector<int> unpack_list;
+
+  for (int isolid = 0; isolid < nsolids; isolid++) {
+    Solid *s = domain->solids[isolid];
+
+    for (int k = 0; k < nneigh; k++) {
+      vector<double> &buf = exchange_recv[k];
+      if (pos[k] >= buf.size())
+	error->one(FLERR, "Error: particles of a solid missing in the message from CPU "
+		   + to_string(exchange_procs[k]) + ".\n");
+
+      int n = buf[pos[k]++];
+
+      unpack_list.clear();
+      for (int i = 0; i < n; i++) {
+	size_t ip = pos[k] + i * s->comm_n;
+	if (!domain->inside_subdomain(buf[ip + 1], buf[ip + 2], buf[ip + 3]))
+	  error->one(FLERR, "Particle received from CPU" + to_string(exchange_procs[k]) +
+		     " that did not belong in this CPU.\n ");
+	unpack_list.push_back(ip);
       }
-    }
+      pos[k] += (size_t) n * s->comm_n;
 
+      if (n > 0) {
+	s->grow(s->np_local + n);
 
-    // Check what particles are within the subdomain:
-    for (int sproc = 0; sproc < universe->nprocs; sproc++) {
-      if (sproc != universe->me) {
-        unpack_list.clear();
-        ip = 0;
-        while (ip < buf_recv_vect[sproc].size()) {
-          if (domain->inside_subdomain(buf_recv_vect[sproc][ip + 1],
-                                       buf_recv_vect[sproc][ip + 2],
-                                       buf_recv_vect[sproc][ip + 3])) {
-            unpack_list.push_back(ip);
-          } else {
-            error->one(FLERR, "Particle received from CPU" + to_string(sproc) +
-                                  " that did not belong in this CPU.\n ");
-          }
-          ip += domain->solids[isolid]->comm_n;
-        }
-
-        if (unpack_list.size() > 0) {
-          domain->solids[isolid]->grow(domain->solids[isolid]->np_local +
-                                       unpack_list.size());
-
-          // Unpack buffer:
-          domain->solids[isolid]->unpack_particle(
-              domain->solids[isolid]->np_local, unpack_list,
-              buf_recv_vect[sproc]);
-        }
+	// Unpack buffer:
+	s->unpack_particle(s->np_local, unpack_list, buf);
       }
     }
   }
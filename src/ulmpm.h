@@ -21,6 +21,8 @@ MethodStyle(ulmpm,ULMPM)
 #define LMP_ULMPM_H
 
 #include "method.h"
+#include "solid.h"
+#include <mpi.h>
 #include <vector>
 #include <Eigen/Eigen>
 
@@ -28,6 +30,7 @@ MethodStyle(ulmpm,ULMPM)
 class ULMPM : public Method {
  public:
   bool apic;
+  bool scatter;                ///< true if the P2G scatters from colour-sorted particles instead of gathering at the nodes
   
   ULMPM(class MPM *);
   ~ULMPM();
@@ -55,6 +58,16 @@ class ULMPM : public Method {
 private:
   int update_Di;
   int rigid_solids;
+
+  void compute_mass_nodes(Solid::NodeSet);          ///< P2G of the mass of all the solids on a set of nodes.
+  void compute_nodes(Solid::NodeSet, bool, bool);   ///< P2G of the velocities and/or forces (and thermal quantities) of all the solids on a set of nodes.
+
+  MPI_Comm exchange_comm;               ///< Communicator of exchange_particles(), so that its messages cannot match other ones
+  vector<int> exchange_procs;           ///< Neighbouring CPUs the particles can migrate to
+  vector<vector<double>> exchange_send; ///< Particles sent to each CPU of exchange_procs, solid after solid
+  vector<vector<double>> exchange_recv; ///< Particles received from each CPU of exchange_procs, solid after solid
+  vector<MPI_Request> exchange_requests;
+  vector<char> leaving;                 ///< Is each particle of a solid out of the sub-domain?
 };
 
 // double linear_basis_function(double, int);
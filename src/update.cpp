@@ -12,12 +12,15 @@
  * ----------------------------------------------------------------------- */
 
 #include "update.h"
+#include "domain.h"
 #include "error.h"
 #include "input.h"
 #include "method.h"
 #include "scheme.h"
+#include "solid.h"
 #include "style_method.h"
 #include "style_scheme.h"
+#include "timer.h"
 #include "universe.h"
 #include "var.h"
 #include <iostream>
@@ -38,6 +41,7 @@ Update::Update(MPM *mpm) : Pointers(mpm)
   dt = 1e-16;
   dt_constant = false;
   dt_factor = 0.9;
+  sort_every = 0;
 
   // Default scheme is MUSL:
   vector<string> scheme_args;
@@ -76,6 +80,33 @@ void Update::set_dt(vector<string> args){
 }
 
 
+/*! This function is the C++ equivalent to the sort_particles() user function.\n
+ * Syntax: sort_particles(N)\n
+ * The particles of every solid are reordered along a Morton curve every N steps (never if N is 0).
+ */
+void Update::set_sort_every(vector<string> args){
+  if (args.size()!=1) {
+    error->all(FLERR, "Illegal sort_particles command: not enough arguments or too many arguments.\n");
+  }
+  sort_every = (int) input->parsev(args[0]).result(mpm);
+  if (sort_every < 0) {
+    error->all(FLERR, "Error: the interval given to sort_particles() must be positive or 0.\n");
+  }
+}
+
+/*! Only updated Lagrangian methods are sorted: total Lagrangian methods compute
+ * their neighbour lists once, and their particles never move in the reference configuration.
+ * Must be called after the particles were exchanged and before the weight functions are computed.
+ */
+void Update::sort_particles(){
+  if (sort_every == 0 || ntimestep % sort_every != 0 || method->is_TL) return;
+
+  timer->start(Timer::SORT);
+  for (int isolid = 0; isolid < domain->solids.size(); isolid++)
+    domain->solids[isolid]->sort_particles();
+  timer->stop();
+}
+
 /*! This function is the C++ equivalent to the scheme() user function.\n
  * Syntax: scheme(type)\n
  * It points the pointer Update::scheme to the desired Scheme type selected from style_scheme.h
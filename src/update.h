@@ -47,11 +47,14 @@ class Update : protected Pointers {
   ShapeFunctions shape_function;      ///< Type of shape function used
   double PIC_FLIP;                    ///< PIC/FLIP mixing factor
   bool temp;                          ///< True for thermo-mechanical simulations
+  int sort_every;                     ///< Particles are spatially sorted every sort_every steps (never if 0)
 
   Update(class MPM *);
   ~Update();
   void set_dt_factor(vector<string>); ///< Sets the factor to be applied to the CFL timestep
   void set_dt(vector<string>);        ///< Sets the timestep
+  void set_sort_every(vector<string>); ///< Sets the interval between spatial sorts of the particles
+  void sort_particles();              ///< Spatially sorts the particles of all solids if due at this step
   void create_scheme(vector<string>); ///< Creates a scheme: USL, or MUSL.
   void create_method(vector<string>); ///< Creates a method: tlmpm, ulmpm, tlcpdi, ...
   void update_time();                 ///< Update elapsed time
@@ -15,10 +15,13 @@
 #include <iostream>
 #include <vector>
 #include "scheme.h"
+#include "domain.h"
 #include "method.h"
 #include "update.h"
+#include "writer.h"
 #include "output.h"
 #include "modify.h"
+#include "timer.h"
 #include "universe.h"
 
 using namespace std;
@@ -37,59 +40,102 @@ void USF::run(Var condition){
   
   // cout << "In USF::run" << endl;
 
+  timer->init();
+
+  timer->start(Timer::OUTPUT);
   output->write(ntimestep);
+  timer->stop();
 
   //for (int i=0; i<nsteps; i++){
   while ((bool) condition.result(mpm)) {
     ntimestep = update->update_timestep();
 
+    timer->start(Timer::WEIGHTS);
     update->method->compute_grid_weight_functions_and_gradients();
+    timer->stop();
 
+    timer->start(Timer::RESET);
     update->method->reset();
+    timer->stop();
     modify->initial_integrate();
 
+    timer->start(Timer::P2G);
     update->method->particles_to_grid_USF_1();
+    timer->stop();
 
     modify->post_update_grid_state();
 
+    timer->start(Timer::RATE_DEFORMATION);
     update->method->compute_rate_deformation_gradient(true);
+    timer->stop();
+    timer->start(Timer::STRESS);
     update->method->update_deformation_gradient();
     update->method->update_stress(true);
+    timer->stop();
 
+    timer->start(Timer::P2G);
     update->method->particles_to_grid_USF_2();
+    timer->stop();
 
     modify->post_particles_to_grid();
 
+    timer->start(Timer::GRID_UPDATE);
     update->method->update_grid_state();
+    timer->stop();
 
     modify->post_update_grid_state();
 
+    timer->start(Timer::G2P);
     update->method->grid_to_points();
+    timer->stop();
 
     modify->post_grid_to_point();
 
+    timer->start(Timer::ADVANCE);
     update->method->advance_particles();
+    timer->stop();
 
     modify->post_advance_particles();
 
+    timer->start(Timer::GRID_POSITIONS);
     update->method->update_grid_positions();
+    timer->stop();
 
+    timer->start(Timer::EXCHANGE);
     update->method->exchange_particles();
+    timer->stop();
+    domain->balance();
+    update->sort_particles();
 
+    timer->start(Timer::TIMESTEP);
     update->update_time();
     update->method->adjust_dt();
+    timer->stop();
 
     modify->final_integrate();
 
     if ((update->maxtime != -1) && (update->atime > update->maxtime)) {
       update->nsteps = ntimestep;
+      timer->start(Timer::OUTPUT);
       output->write(ntimestep);
+      timer->stop();
       break;
     }
 
     if (ntimestep == output->next || ntimestep == update->nsteps) {
+      timer->start(Timer::OUTPUT);
       output->write(ntimestep);
+      timer->stop();
     }
+
+    timer->step(ntimestep);
   }
+
+  // Wait for the last snapshots to be on disk:
+  timer->start(Timer::OUTPUT);
+  output->writer->flush();
+  timer->stop();
+
+  timer->report();
 }
 
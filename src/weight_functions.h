@@ -0,0 +1,156 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_WEIGHT_FUNCTIONS_H
+#define MPM_WEIGHT_FUNCTIONS_H
+
+#include "grid.h"
+#include "material.h"
+#include "mpmtype.h"
+#include "solid.h"
+#include <Eigen/Eigen>
+#include <vector>
+
+using namespace std;
+
+/*! Fixed-stencil computation of the particle-node weight functions and of their gradients.
+ *
+ * With tensor-product shape functions, the weight function between a particle and a node is the product
+ * of one 1D basis function per axis. The nodes a particle interacts with form a block of nstencil nodes
+ * per axis starting at node (i0, j0, k0), so only nstencil 1D evaluations of the basis function and of
+ * its derivative are needed per axis, instead of one per node and per axis.\n
+ * The dimension, the size of the stencil and the basis functions are template parameters so that the
+ * compiler can unroll the loops and inline the basis functions.
+ */
+namespace WeightFunctions {
+
+  /*! Builds the particle-node neighbour lists of solid s and the associated weight functions and gradients.
+   *
+   * The first node of the stencil along axis d is scale * (int) ((xp[ip][d] - lo[d]) / cellsize - shift).
+   * The lists of the solid have to be cleared beforehand with Solid::clear_neighbours().
+   */
+  template <int dim, int nstencil, double (*basis_function)(double, int),
+            double (*derivative_basis_function)(double, int, double)>
+  void compute(Solid *s, const ParticleVectors &xp, const double *lo,
+               int scale, int shift)
+  {
+    Grid *grid = s->grid;
+    const double inv_cellsize = 1.0 / grid->cellsize;
+    const bool rigid = s->mat->rigid;
+
+    const int nj = dim >= 2 ? nstencil : 1;
+    const int nk = dim == 3 ? nstencil : 1;
+
+    const vector<Eigen::Vector3d> &xn = grid->x0;
+    const vector<array<int, 3>> &ntype = grid->ntype;
+
+    int i0[3] = {0, 0, 0};
+    int nodes[nstencil * nstencil * nstencil];
+    double sf[3][nstencil], dsf[3][nstencil];
+    bool known[3][nstencil];
+    Eigen::Vector3d wfd;
+    double wf;
+
+    for (int ip = 0; ip < s->np_local; ip++) {
+      for (int d = 0; d < dim; d++)
+	i0[d] = scale * (int) ((xp[ip][d] - lo[d]) * inv_cellsize - shift);
+
+      // Find the local index of each node of the stencil (-1 if not on this CPU):
+      int l = 0;
+      for (int a = 0; a < nstencil; a++) {
+	int i = i0[0] + a;
+	for (int b = 0; b < nj; b++) {
+	  int j = i0[1] + b;
+	  for (int c = 0; c < nk; c++) {
+	    int k = i0[2] + c;
+	    nodes[l++] = grid->local_index(i, j, k);
+	  }
+	}
+      }
+
+      // 1D basis functions and derivatives along each axis. All the nodes sharing the same index
+      // along an axis share the same coordinate and type along that axis:
+      for (int d = 0; d < dim; d++)
+	for (int a = 0; a < nstencil; a++)
+	  known[d][a] = false;
+
+      l = 0;
+      for (int a = 0; a < nstencil; a++)
+	for (int b = 0; b < nj; b++)
+	  for (int c = 0; c < nk; c++) {
+	    int in = nodes[l++];
+	    if (in < 0) continue;
+	    const int abc[3] = {a, b, c};
+	    for (int d = 0; d < dim; d++) {
+	      int m = abc[d];
+	      if (known[d][m]) continue;
+	      double r = (xp[ip][d] - xn[in][d]) * inv_cellsize;
+	      sf[d][m] = basis_function(r, ntype[in][d]);
+	      dsf[d][m] = derivative_basis_function(r, ntype[in][d], inv_cellsize);
+	      known[d][m] = true;
+	    }
+	  }
+
+      // Tensor products:
+      l = 0;
+      for (int a = 0; a < nstencil; a++)
+	for (int b = 0; b < nj; b++)
+	  for (int c = 0; c < nk; c++) {
+	    int in = nodes[l++];
+	    if (in < 0) continue;
+
+	    if (dim == 1) {
+	      wf = sf[0][a];
+	      wfd[0] = dsf[0][a];
+	      wfd[1] = 0;
+	      wfd[2] = 0;
+	    } else if (dim == 2) {
+	      wf = sf[0][a] * sf[1][b];
+	      wfd[0] = dsf[0][a] * sf[1][b];
+	      wfd[1] = sf[0][a] * dsf[1][b];
+	      wfd[2] = 0;
+	    } else {
+	      wf = sf[0][a] * sf[1][b] * sf[2][c];
+	      wfd[0] = dsf[0][a] * sf[1][b] * sf[2][c];
+	      wfd[1] = sf[0][a] * dsf[1][b] * sf[2][c];
+	      wfd[2] = sf[0][a] * sf[1][b] * dsf[2][c];
+	    }
+
+	    if (wf != 0) {
+	      if (rigid) grid->rigid[in] = true;
+	      s->neigh_pn.push_back(in);
+	      s->wf_pn.push_back(wf);
+	      s->wfd_pn.push_back(wfd);
+	    }
+	  }
+      s->neigh_pn_offset[ip + 1] = s->neigh_pn.size();
+    }
+  }
+
+  /*! Calls compute() for the dimension of the domain.
+   */
+  template <int nstencil, double (*basis_function)(double, int),
+            double (*derivative_basis_function)(double, int, double)>
+  void compute(int dim, Solid *s, const ParticleVectors &xp,
+               const double *lo, int scale, int shift)
+  {
+    if (dim == 1)
+      compute<1, nstencil, basis_function, derivative_basis_function>(s, xp, lo, scale, shift);
+    else if (dim == 2)
+      compute<2, nstencil, basis_function, derivative_basis_function>(s, xp, lo, scale, shift);
+    else
+      compute<3, nstencil, basis_function, derivative_basis_function>(s, xp, lo, scale, shift);
+  }
+}
+
+#endif
@@ -17,14 +17,17 @@
 #include "group.h"
 #include "method.h"
 #include "modify.h"
+#include "output.h"
 #include "universe.h"
 #include "update.h"
 #include "var.h"
 #include "version.h"
+#include "writer.h"
 #include <iostream>
+#include <sstream>
 #include <vector>
 
-enum { VERSION, DIMENSION, NPROCS };
+enum { VERSION, DIMENSION, NPROCS, FORMAT };
 /* ---------------------------------------------------------------------- */
 
 WriteRestart::WriteRestart(MPM *mpm) : Pointers(mpm) {
@@ -66,25 +69,25 @@ void WriteRestart::write() {
 
   if (universe->me == 0)
     cout << "write " << frestart << endl;
-  of = new ofstream(frestart, ios_base::out | ios_base::binary);
-
-  if (of->is_open()) {
+  // The objects write into an ofstream whose buffer is replaced by one in memory, then
+  // the file is written by Output::writer:
+  delete of;
+  of = new ofstream();
+  staging.str(string());
+  of->std::ios::rdbuf(&staging);
 
-    // proc 0 writes out header:
-    if (universe->me == 0)
-      header();
+  // proc 0 writes out header:
+  if (universe->me == 0)
+    header();
 
-    // Everyone writes the method, scheme, timestep, dt:
-    update->write_restart(of);
-    domain->write_restart(of);
-    group->write_restart(of);
-    modify->write_restart(of);
+  // Everyone writes the method, scheme, timestep, dt:
+  update->write_restart(of);
+  domain->write_restart(of);
+  group->write_restart(of);
+  modify->write_restart(of);
 
 
-    of->close();
-  } else {
-    error->all(FLERR, "Error: cannot write in file: " + frestart + ".\n");
-  }
+  output->writer->submit(frestart, staging.str());
 }
 
 /*! Writes out problem description in restart file.
@@ -94,6 +97,7 @@ void WriteRestart::header() {
   write_string(VERSION, Version::GIT_SHA1);
   write_variable(DIMENSION, domain->dimension);
   write_variable(NPROCS, universe->nprocs);
+  write_variable(FORMAT, format);
 
   // -1 flag signals end of header
   int flag = -1;
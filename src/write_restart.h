@@ -23,6 +23,7 @@ CommandStyle(write_restart,WriteRestart)
 
 #include "pointers.h"
 #include <fstream>
+#include <sstream>
 #include <vector>
 
 class WriteRestart : protected Pointers {
@@ -32,10 +33,13 @@ class WriteRestart : protected Pointers {
   class Var command(vector<string>);
   void write();
 
+  static const int format = 2;   ///< Version of the layout of restart files, checked by ReadRestart
+
 private:
   string filename;
   size_t pos_asterisk;
   ofstream *of;
+  stringbuf staging;             ///< Content of the restart file, handed to Output::writer
   void header();
 
   template <typename T> void write_variable(int, T);
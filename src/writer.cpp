@@ -0,0 +1,155 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "writer.h"
+#include "error.h"
+#include "input.h"
+#include "var.h"
+#include <fstream>
+#include <gzstream.h>
+
+using namespace std;
+
+Writer::Writer(MPM *mpm) : Pointers(mpm)
+{
+  max_size = 256 << 20;
+  queued = 0;
+  done = false;
+}
+
+Writer::~Writer()
+{
+  {
+    lock_guard<mutex> lock(mtx);
+    done = true;
+  }
+  queue_filled.notify_all();
+  if (thread.joinable())
+    thread.join();
+}
+
+/*! A file larger than max_size is queued once the queue is empty, so that submit()
+ * never waits forever.
+ */
+void Writer::submit(string name, string data, bool gz)
+{
+  if (max_size == 0) {
+    flush();
+    if (!write_file({name, data, gz}))
+      error->one(FLERR, "Error: cannot write in file: " + name + ".\n");
+    return;
+  }
+
+  {
+    unique_lock<mutex> lock(mtx);
+    queue_drained.wait(lock, [&] {
+	return queue.empty() || queued + (bigint) data.size() <= max_size;
+      });
+
+    queued += data.size();
+    queue.push_back({name, move(data), gz});
+
+    if (!thread.joinable())
+      thread = std::thread(&Writer::run, this);
+  }
+  queue_filled.notify_one();
+
+  check();
+}
+
+void Writer::flush()
+{
+  {
+    unique_lock<mutex> lock(mtx);
+    queue_drained.wait(lock, [&] { return queue.empty(); });
+  }
+
+  check();
+}
+
+void Writer::check()
+{
+  string msg;
+  {
+    lock_guard<mutex> lock(mtx);
+    for (const string &name: failed)
+      msg += "Error: cannot write in file: " + name + ".\n";
+    failed.clear();
+  }
+
+  if (!msg.empty())
+    error->one(FLERR, msg);
+}
+
+/*! The file being written stays at the front of the queue until it is on disk, so that
+ * flush() also waits for it.
+ */
+void Writer::run()
+{
+  unique_lock<mutex> lock(mtx);
+
+  while (true) {
+    queue_filled.wait(lock, [&] { return done || !queue.empty(); });
+    if (queue.empty())
+      break;
+
+    // References to the elements of a deque remain valid when others are pushed back:
+    const File &f = queue.front();
+
+    lock.unlock();
+    bool ok = write_file(f);
+    lock.lock();
+
+    if (!ok)
+      failed.push_back(f.name);
+    queued -= f.data.size();
+    queue.pop_front();
+    queue_drained.notify_all();
+  }
+}
+
+bool Writer::write_file(const File &f)
+{
+  if (f.gz) {
+    ogzstream of(f.name.c_str());
+    if (!of.rdbuf()->is_open())
+      return false;
+    of.write(f.data.data(), f.data.size());
+    of.close();
+    return !of.fail();
+  } else {
+    ofstream of(f.name, ios_base::out | ios_base::binary);
+    if (!of.is_open())
+      return false;
+    of.write(f.data.data(), f.data.size());
+    of.close();
+    return !of.fail();
+  }
+}
+
+/*! This function is the C++ equivalent to the output_buffer() user function.\n
+ * Syntax: output_buffer(size)
+ */
+void Writer::set_max_size(vector<string> args)
+{
+  if (args.size() != 1) {
+    error->all(FLERR, "Illegal output_buffer command: not enough arguments or too many arguments.\n");
+  }
+  double size = input->parsev(args[0]).result(mpm);
+  if (size < 0) {
+    error->all(FLERR, "Error: the size given to output_buffer() must be positive or 0.\n");
+  }
+
+  flush();
+  max_size = (bigint) (size * (1 << 20));
+}
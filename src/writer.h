@@ -0,0 +1,93 @@
+/* -*- c++ -*- ----------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#ifndef MPM_WRITER_H
+#define MPM_WRITER_H
+
+#include "pointers.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*! Writes the dump and restart files in a background thread.
+ *
+ * The dumps and WriteRestart format each snapshot in memory and hand it to submit(),
+ * which queues it and returns, so that the time steps carry on while the writer thread
+ * compresses and writes the previous snapshots. The queue holds at most max_size bytes:
+ * when it is full, submit() waits for the writer thread to catch up.
+ *
+ * The writer thread makes no MPI calls. Files that could not be written are reported by
+ * the next call to submit() or flush().
+ */
+class Writer : protected Pointers {
+ public:
+  bigint max_size;                   ///< Maximum number of bytes waiting to be written, files are written synchronously if 0
+
+  Writer(class MPM *);
+  ~Writer();
+
+  void submit(string, string, bool gz = false); ///< Queue a file and its content, to be compressed with gzip if gz is true
+  void flush();                      ///< Wait until all the queued files are written
+  void set_max_size(vector<string>); ///< Called when user calls output_buffer()
+
+ private:
+  struct File {
+    string name;
+    string data;
+    bool gz;
+  };
+
+  deque<File> queue;                 ///< Files waiting to be written, the one being written first
+  bigint queued;                     ///< Number of bytes in queue
+  vector<string> failed;             ///< Names of the files that could not be written
+  bool done;                         ///< Set to stop the writer thread once the queue is empty
+
+  std::thread thread;
+  std::mutex mtx;
+  std::condition_variable queue_filled;  ///< Notified when a file is queued or done is set
+  std::condition_variable queue_drained; ///< Notified when a file is written
+
+  void run();                        ///< Loop of the writer thread
+  void check();                      ///< Abort if a file could not be written
+  static bool write_file(const File &);
+};
+
+#endif
+
+/*! \defgroup output_buffer output_buffer
+
+\section Syntax Syntax
+\code
+output_buffer(size)
+\endcode
+
+<ul>
+<li>size: number of megabytes of dump and restart files each CPU can hold in memory while they are written (0 to write them synchronously).</li>
+</ul>
+
+\section Examples Examples
+\code
+output_buffer(1000)
+\endcode
+Let each CPU queue up to 1 GB of snapshots.
+
+\section Description Description
+
+The particle and grid dumps (text and gzip) and the restart files are formatted in memory, then written (and compressed for the gzip dumps) in a background thread while the simulation carries on. When the snapshots waiting to be written exceed the given size, the simulation waits until enough of them are written. The default size is 256 MB. All the files are written before the end of each run.
+
+The particle/bin dumps are written collectively with MPI-IO and do not go through this buffer.
+
+*/
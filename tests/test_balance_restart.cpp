@@ -0,0 +1,136 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "domain.h"
+#include "grid.h"
+#include "input.h"
+#include "mpm.h"
+#include "solid.h"
+#include "universe.h"
+#include <fstream>
+#include <iostream>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*! Restart of a run whose sub-domains were moved by balance().
+ *
+ * A block of particles sits in one corner of the box, so that balance() moves the
+ * boundaries between the sub-domains. A restart file is written once they are moved,
+ * then read by a new MPM. The sub-domain boundaries, the neighbours of each CPU and its
+ * numbers of local, ghost and shared nodes must be the same as in the run that wrote it,
+ * and the restarted run must go on.
+ * Run on 4 CPUs, so that the sub-domains form a 2x2 grid.
+ */
+
+static const string deck_run = "test_balance_restart_run.mpm";
+static const string deck_restart = "test_balance_restart_read.mpm";
+
+struct State {
+  vector<double> subcuts[3];
+  double sublo[3], subhi[3];
+  vector<int> neighbours;
+  bigint nnodes_local, nnodes_ghost;
+  int nshared;
+  tagint np_total;
+
+  State(MPM *mpm) {
+    Domain *domain = mpm->domain;
+    for (int d = 0; d < 3; d++) {
+      subcuts[d] = domain->subcuts[d];
+      sublo[d] = domain->sublo[d];
+      subhi[d] = domain->subhi[d];
+    }
+    neighbours = domain->neighbour_procs(2 * domain->grid->cellsize);
+    nnodes_local = domain->grid->nnodes_local;
+    nnodes_ghost = domain->grid->nnodes_ghost;
+    nshared = domain->grid->nshared;
+    np_total = domain->np_total;
+  }
+};
+
+static bool check(int me, const string &name, bool pass) {
+  if (!pass) cout << "CPU " << me << ": " << name << " differs after restart" << endl;
+  return pass;
+}
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+
+  int me, nprocs;
+  MPI_Comm_rank(MPI_COMM_WORLD, &me);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  if (me == 0) {
+    ofstream run(deck_run);
+    run << "method(ulmpm, FLIP, linear, 0.99)\n"
+        << "dimension(2, 0, 16, 0, 16, 1)\n"
+        << "region(box, block, 1, 7, 1, 7)\n"
+        << "material(mat1, linear, 1000, 1e+6, 0.3)\n"
+        << "solid(s1, region, box, 2, mat1, 1, 0)\n"
+        << "balance(2, 1.1)\n"
+        << "restart(4, test_balance_restart.*)\n"
+        << "run(4)\n";
+
+    ofstream restart(deck_restart);
+    restart << "read_restart(test_balance_restart.%4)\n";
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  char *run_argv[] = {argv[0], (char *) "-i", (char *) deck_run.c_str(), nullptr};
+  MPM *mpm = new MPM(3, run_argv, MPI_COMM_WORLD);
+  mpm->input->file();
+  State before(mpm);
+  delete mpm;
+
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  char *restart_argv[] = {argv[0], (char *) "-i", (char *) deck_restart.c_str(), nullptr};
+  mpm = new MPM(3, restart_argv, MPI_COMM_WORLD);
+  mpm->input->file();
+  State after(mpm);
+
+  bool pass = true;
+  if (nprocs > 1 && before.subcuts[0].empty()) {
+    if (me == 0) cout << "balance() did not move the sub-domain boundaries" << endl;
+    pass = false;
+  }
+
+  for (int d = 0; d < 3; d++) {
+    pass &= check(me, "subcuts", before.subcuts[d] == after.subcuts[d]);
+    pass &= check(me, "sublo", before.sublo[d] == after.sublo[d]);
+    pass &= check(me, "subhi", before.subhi[d] == after.subhi[d]);
+  }
+  pass &= check(me, "neighbour_procs", before.neighbours == after.neighbours);
+  pass &= check(me, "nnodes_local", before.nnodes_local == after.nnodes_local);
+  pass &= check(me, "nnodes_ghost", before.nnodes_ghost == after.nnodes_ghost);
+  pass &= check(me, "nshared", before.nshared == after.nshared);
+
+  // The restarted run must go on, and keep all its particles:
+  mpm->input->parsev("run(4)");
+  tagint np_local = 0, np_total = 0;
+  for (Solid *s: mpm->domain->solids)
+    np_local += s->np_local;
+  MPI_Allreduce(&np_local, &np_total, 1, MPI_MPM_TAGINT, MPI_SUM, MPI_COMM_WORLD);
+  pass &= check(me, "number of particles", np_total == before.np_total);
+
+  delete mpm;
+
+  int all_pass, local_pass = pass;
+  MPI_Allreduce(&local_pass, &all_pass, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+  if (me == 0) cout << (all_pass ? "balanced restart: ok" : "balanced restart: FAILED") << endl;
+  MPI_Finalize();
+  return all_pass ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "expression.h"
+#include "input.h"
+#include "mpm.h"
+#include "var.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*! Compiled expressions against Input::parsev().
+ *
+ * Each equation is compiled by Expression from its raw string, and its value is compared
+ * with the one of Input::parsev() for the same values of the variables. The equations cover
+ * the precedences and associativity of the operators, unary minus, e-notation, comparisons,
+ * every supported function, the coordinates x, y, z, x0, y0, z0 and the time. The coordinates
+ * are given both through Input::vars and through the columns read by Expression::evaluate().\n
+ * Equations with unknown identifiers must not compile. Run as "test_expression unknown", the
+ * test evaluates such an equation, which must stop with the error of Input::parsev().
+ */
+
+static const string deck = "test_expression.mpm";
+
+static void write_deck() {
+  ofstream f(deck);
+  f << "a = 2.5\n"
+    << "b = -4\n"
+    << "c = 3*time + 1\n";
+}
+
+static const vector<string> equations = {
+  // Precedence and associativity:
+  "2+3*4", "2*3+4", "10-4-3", "8/4/2", "2*3^2", "2^3^2", "2**3**2", "2*3**2",
+  "(2+3)*4", "2^(1+1)", "1+2*3-4/5^2", "a*b-a/b",
+  // Unary minus:
+  "-2^2", "-x^2", "2*-3", "2^-1", "-(x+y)", "3-(-y)", "-a*b", "x*-y",
+  // e-notation:
+  "2.5e+3", "1e-2", "1.5E+2*x", "3E-1+y",
+  // Comparisons:
+  "x>0", "x<0", "x>=0.5", "y<=0.25", "a==2.5", "a!=2.5", "1+x>y*2", "(x>y)+(y>x)",
+  // Functions:
+  "exp(x)", "sqrt(y+1)", "cos(x*PI)", "sin(2*y)", "tan(z/4)", "log(a+x)",
+  "atan2(y,x)", "atan2(-y,x-1)", "evaluate(x+2*y)", "exp(-x^2)*cos(sin(y))",
+  // Coordinates, initial coordinates and time:
+  "x+2*y-3*z", "x0*y0/z0", "(x-x0)^2+(y-y0)^2+(z-z0)^2", "time*2+x", "c*y0", "time>0.1",
+};
+
+static const double coordinates[4][6] = {
+  // x, y, z, x0, y0, z0
+  {0.7, 0.3, -0.2, 0.5, 0.25, 1.5},
+  {-1.2, 2.0, 0.9, 0.1, -0.6, 2.5},
+  {0.0, -0.45, 3.1, -2.0, 1.25, -0.75},
+  {2.5, 1.0, -1.5, 0.3, 0.8, 0.4},
+};
+
+static const char *coordinate_names[6] = {"x", "y", "z", "x0", "y0", "z0"};
+
+static void set_coordinates(MPM *mpm, const double *c) {
+  for (int j = 0; j < 6; j++)
+    (*mpm->input->vars)[coordinate_names[j]] = Var(coordinate_names[j], c[j]);
+}
+
+static bool check(const string &name, double error, double tolerance) {
+  bool pass = error <= tolerance;
+  cout << left << setw(28) << name << right << setw(12) << scientific << setprecision(2)
+       << error << setw(12) << tolerance << (pass ? "  ok" : "  FAILED") << endl;
+  return pass;
+}
+
+static double relative_error(double value, double reference) {
+  return fabs(value - reference) / MAX(1.0, fabs(reference));
+}
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+
+  int me;
+  MPI_Comm_rank(MPI_COMM_WORLD, &me);
+  if (me == 0) write_deck();
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  char *mpm_argv[] = {argv[0], (char *) "-i", (char *) deck.c_str(), nullptr};
+  MPM *mpm = new MPM(3, mpm_argv, MPI_COMM_WORLD);
+  mpm->input->file();
+  (*mpm->input->vars)["time"] = Var("time", 0.125);
+
+  if (argc > 1 && string(argv[1]) == "unknown") {
+    // Falls back on Var::result(), where Input::parsev() stops with "Error: foo is unknown.":
+    Expression e(mpm, Var("2*foo+x", 0));
+    e.evaluate();
+    delete mpm;
+    MPI_Finalize();
+    return 0;
+  }
+
+  const int n = 4;
+  bool pass = true;
+
+  for (const string &eq: equations) {
+    Expression e(mpm, Var(eq, 0));
+    if (!e.is_compiled()) {
+      cout << left << setw(28) << eq << "  FAILED to compile" << endl;
+      pass = false;
+      continue;
+    }
+
+    // References given by Input::parsev() for each point:
+    double reference[n];
+    for (int k = 0; k < n; k++) {
+      set_coordinates(mpm, coordinates[k]);
+      reference[k] = mpm->input->parsev(eq).result();
+    }
+
+    // Coordinates read from Input::vars (those of the last point):
+    double error = relative_error(e.evaluate(), reference[n - 1]);
+
+    // Coordinates given to evaluate(), as vectors and as columns read through an index list:
+    vector<Eigen::Vector3d> x(n), x0(n);
+    double columns[6][n];
+    for (int k = 0; k < n; k++)
+      for (int j = 0; j < 6; j++) {
+        (j < 3 ? x[k][j] : x0[k][j - 3]) = coordinates[k][j];
+        columns[j][n - 1 - k] = coordinates[k][j];
+      }
+
+    const double *xc[3] = {columns[0], columns[1], columns[2]};
+    const double *x0c[3] = {columns[3], columns[4], columns[5]};
+    const int index[n] = {3, 2, 1, 0};
+    double values[n], gathered[n];
+
+    e.evaluate(n, nullptr, &x, &x0, values);
+    e.evaluate(n, index, xc, x0c, gathered);
+
+    for (int k = 0; k < n; k++) {
+      error = MAX(error, relative_error(e.evaluate(&x[k], &x0[k]), reference[k]));
+      error = MAX(error, relative_error(values[k], reference[k]));
+      error = MAX(error, relative_error(gathered[k], reference[k]));
+    }
+
+    pass &= check(eq, error, 1.0e-12);
+  }
+
+  // Unknown identifiers and functions are not compiled:
+  for (string eq: {"2*foo+x", "bar(x)", "x+", "(x+y"}) {
+    bool compiled = Expression(mpm, Var(eq, 0)).is_compiled();
+    cout << left << setw(28) << eq << (compiled ? "  FAILED: compiled" : "  not compiled, ok") << endl;
+    pass &= !compiled;
+  }
+
+  delete mpm;
+
+  int all_pass, local_pass = pass;
+  MPI_Allreduce(&local_pass, &all_pass, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+  MPI_Finalize();
+  return all_pass ? 0 : 1;
+}
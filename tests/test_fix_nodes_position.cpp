@@ -0,0 +1,113 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "domain.h"
+#include "fix.h"
+#include "grid.h"
+#include "input.h"
+#include "method.h"
+#include "modify.h"
+#include "mpm.h"
+#include "scheme.h"
+#include "solid.h"
+#include "update.h"
+#include "var.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <mpi.h>
+#include <string>
+
+using namespace std;
+
+/*! Nodal boundary conditions that depend on the position of the nodes.
+ *
+ * A velocity_nodes fix is given v = (x + 10*y0, y*y), with x and y the current position of
+ * each node and y0 its reference position. The current positions are moved away from the
+ * reference ones, and the global variables x and y are set to values that no node has, so
+ * that reading them instead of the node's position is caught. The velocities set by
+ * post_update_grid_state() and post_velocities_to_grid() are compared with the expected ones.
+ */
+
+static const string deck = "test_fix_nodes_position.mpm";
+
+static void write_deck() {
+  ofstream f(deck);
+  f << "method(ulmpm, FLIP, linear, 0.99)\n"
+    << "dimension(2, 0, 8, 0, 8, 1)\n"
+    << "region(box, block, 2, 6, 2, 6)\n"
+    << "material(mat1, linear, 1000, 1e+6, 0.3)\n"
+    << "solid(s1, region, box, 2, mat1, 1, 0)\n"
+    << "group(gall, nodes, region, box, solid, s1)\n"
+    << "fix(fv, velocity_nodes, gall, x + 10*y0, y*y)\n";
+}
+
+static double max_error(Grid *g, int groupbit, bool v_update) {
+  double e = 0;
+  for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
+    if (!(g->mask[in] & groupbit)) continue;
+    const Eigen::Vector3d &v = v_update ? g->v_update[in] : g->v[in];
+    e = MAX(e, fabs(v[0] - (g->x[in][0] + 10 * g->x0[in][1])));
+    e = MAX(e, fabs(v[1] - g->x[in][1] * g->x[in][1]));
+  }
+  return e;
+}
+
+static bool check(const string &name, double error, double tolerance) {
+  bool pass = error <= tolerance;
+  cout << left << setw(28) << name << right << setw(12) << scientific << setprecision(2)
+       << error << setw(12) << tolerance << (pass ? "  ok" : "  FAILED") << endl;
+  return pass;
+}
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+
+  int me;
+  MPI_Comm_rank(MPI_COMM_WORLD, &me);
+  if (me == 0) write_deck();
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  char *mpm_argv[] = {argv[0], (char *) "-i", (char *) deck.c_str(), nullptr};
+  MPM *mpm = new MPM(3, mpm_argv, MPI_COMM_WORLD);
+  mpm->input->file();
+
+  mpm->init();
+  mpm->update->scheme->setup();
+  mpm->update->dt = 1.0e-3;
+
+  Grid *g = mpm->domain->solids[0]->grid;
+  Fix *fix = mpm->modify->fix[mpm->modify->find_fix("fv")];
+
+  for (int in = 0; in < g->nnodes_local + g->nnodes_ghost; in++) {
+    g->x[in] = g->x0[in] + Eigen::Vector3d(0.25, 0.5, 0);
+    g->v_update[in].setZero();
+    g->v[in].setZero();
+  }
+  (*mpm->input->vars)["x"] = Var("x", 1.0e6);
+  (*mpm->input->vars)["y"] = Var("y", 1.0e6);
+
+  bool pass = true;
+  fix->post_update_grid_state();
+  pass &= check("post_update_grid_state", max_error(g, fix->groupbit, true), 1.0e-12);
+  fix->post_velocities_to_grid();
+  pass &= check("post_velocities_to_grid", max_error(g, fix->groupbit, false), 1.0e-12);
+
+  delete mpm;
+
+  int all_pass, local_pass = pass;
+  MPI_Allreduce(&local_pass, &all_pass, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+  MPI_Finalize();
+  return all_pass ? 0 : 1;
+}
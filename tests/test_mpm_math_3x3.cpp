@@ -0,0 +1,221 @@
+/* ----------------------------------------------------------------------
+ *
+ *                    ***       Karamelo       ***
+ *               Parallel Material Point Method Simulator
+ *
+ * Copyright (2019) Alban de Vaucorbeil, alban.devaucorbeil@monash.edu
+ * Materials Science and Engineering, Monash University
+ * Clayton VIC 3800, Australia
+
+ * This software is distributed under the GNU General Public License.
+ *
+ * ----------------------------------------------------------------------- */
+
+#include "mpm_math.h"
+#include <Eigen/Eigen>
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <math.h>
+#include <random>
+#include <string>
+
+using namespace Eigen;
+using namespace MPM_Math;
+using namespace std;
+
+/*! Accuracy of the closed-form kernels of mpm_math_3x3.h against the iterative Eigen routines.
+ *
+ * For each family of matrices, PolDec() is compared with PolDecSVD(), EigenvaluesRealParts()
+ * with EigenSolver, Inverse3x3() with Matrix3d::inverse(), SymmetricEigen() with
+ * SelfAdjointEigenSolver::compute() and SingularValues3x3() with JacobiSVD.
+ * The errors are relative to the norm of the reference (times the condition number of M
+ * for the inverse), and the largest one of each comparison is checked against its tolerance.
+ */
+
+static const int nsamples = 20000;
+
+static mt19937_64 rng(12345);
+static uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+static Matrix3d random_matrix() {
+  Matrix3d M;
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      M(i, j) = uniform(rng);
+  return M;
+}
+
+static Matrix3d random_rotation() {
+  Quaterniond q(uniform(rng), uniform(rng), uniform(rng), uniform(rng));
+  q.normalize();
+  return q.toRotationMatrix();
+}
+
+static Matrix3d stretch(double s0, double s1, double s2) {
+  Matrix3d V = random_rotation();
+  return V * Vector3d(s0, s1, s2).asDiagonal() * V.transpose();
+}
+
+/*! Random deformation gradient close to the identity, as met in the simulations.
+ */
+static Matrix3d gen_random() {
+  return Matrix3d::Identity() + 0.5 * random_matrix();
+}
+
+static Matrix3d gen_rotation() {
+  return random_rotation();
+}
+
+/*! Inverted deformation gradient: rotation times a stretch with one negative principal value.
+ */
+static Matrix3d gen_reflected() {
+  double s = 0.5 + 0.4 * uniform(rng);
+  return random_rotation() * stretch(-s, 1.5 + 0.4 * uniform(rng), 2.5 + 0.4 * uniform(rng));
+}
+
+/*! Symmetric stretch with two equal principal values, rotated.
+ */
+static Matrix3d gen_repeated() {
+  double a = 1.0 + 0.5 * uniform(rng);
+  double b = a + 0.5 + 0.4 * uniform(rng);
+  return random_rotation() * stretch(a, a, b);
+}
+
+/*! Symmetric stretch with two principal values closer than 1e-12 to 1e-1 in relative terms, rotated.
+ */
+static Matrix3d gen_close() {
+  double a = 1.0 + 0.5 * uniform(rng);
+  double b = a + 0.5 + 0.4 * uniform(rng);
+  double gap = pow(10.0, -6.5 + 5.5 * uniform(rng));
+  return random_rotation() * stretch(a, a * (1 + gap), b);
+}
+
+/*! Small perturbation of a rotation, as for the particles that barely deformed.
+ */
+static Matrix3d gen_near_identity() {
+  return random_rotation() * (Matrix3d::Identity() + 1.0e-5 * random_matrix());
+}
+
+/*! Stretch with a smallest principal value down to 1e-8.
+ */
+static Matrix3d gen_near_singular() {
+  double s = pow(10.0, -8.0 + 6.0 * (0.5 + 0.5 * uniform(rng)));
+  return random_rotation() * stretch(s, 1.0 + 0.4 * uniform(rng), 2.0 + 0.4 * uniform(rng));
+}
+
+struct Errors {
+  double poldec_R = 0;       ///< PolDec(M, R, T) with PolDecSVD(M, R, T)
+  double poldec_T = 0;
+  double poldec_R_only = 0;  ///< PolDec(M, R) with PolDecSVD(M, R)
+  int poldec_flags = 0;      ///< Number of differing return values
+  double eigenvalues = 0;    ///< EigenvaluesRealParts() with EigenSolver
+  double inverse = 0;        ///< Inverse3x3() with inverse(), divided by the condition number
+  double determinant = 0;    ///< Determinant returned by Inverse3x3() with determinant()
+  double symmetric = 0;      ///< SymmetricEigen() with SelfAdjointEigenSolver::compute()
+  double singular = 0;       ///< SingularValues3x3() with JacobiSVD, when it succeeds
+};
+
+static Errors measure(function<Matrix3d()> generate) {
+  Errors e;
+
+  for (int n = 0; n < nsamples; n++) {
+    Matrix3d M = generate();
+    double norm = M.norm();
+
+    // Polar decomposition:
+    Matrix3d R, T, Rsvd, Tsvd;
+    bool ok = PolDec(M, R, T, false);
+    bool ok_svd = PolDecSVD(M, Rsvd, Tsvd, false);
+    if (ok != ok_svd)
+      e.poldec_flags++;
+    e.poldec_R = max(e.poldec_R, (R - Rsvd).norm() / Rsvd.norm());
+    e.poldec_T = max(e.poldec_T, (T - Tsvd).norm() / Tsvd.norm());
+
+    PolDec(M, R);
+    PolDecSVD(M, Rsvd);
+    e.poldec_R_only = max(e.poldec_R_only, (R - Rsvd).norm() / Rsvd.norm());
+
+    // Real parts of the eigenvalues, sorted:
+    Vector3d re = EigenvaluesRealParts(M);
+    EigenSolver<Matrix3d> es(M, false);
+    Vector3d re_ref = es.eigenvalues().real();
+    sort(re.data(), re.data() + 3);
+    sort(re_ref.data(), re_ref.data() + 3);
+    e.eigenvalues = max(e.eigenvalues, (re - re_ref).norm() / norm);
+
+    // Inverse and determinant:
+    Matrix3d Minv;
+    double det = Inverse3x3(M, Minv);
+    Matrix3d Minv_ref = M.inverse();
+    JacobiSVD<Matrix3d> svd(M);
+    Vector3d s = svd.singularValues();
+    double cond = s(0) / s(2);
+    e.inverse = max(e.inverse, (Minv - Minv_ref).norm() / Minv_ref.norm() / cond);
+    e.determinant = max(e.determinant, fabs(det - M.determinant()) / (s(0) * s(0) * s(0)));
+
+    // Symmetric eigen decomposition of M^T M, compared through the matrix it rebuilds
+    // since the eigenvectors of repeated eigenvalues are not unique:
+    Matrix3d C = M.transpose() * M;
+    Vector3d lambda;
+    Matrix3d V;
+    SymmetricEigen(C, lambda, V);
+    SelfAdjointEigenSolver<Matrix3d> sa(C);
+    double err = (lambda - sa.eigenvalues()).norm() / C.norm();
+    err = max(err, (V * lambda.asDiagonal() * V.transpose() - C).norm() / C.norm());
+    e.symmetric = max(e.symmetric, err);
+
+    // Singular values, in increasing order:
+    Vector3d S;
+    if (SingularValues3x3(M, S, V))
+      e.singular = max(e.singular, (S - s.reverse()).norm() / s(0));
+  }
+
+  return e;
+}
+
+static bool check(const string &family, const string &name, double error, double tolerance) {
+  bool pass = error <= tolerance;
+  cout << left << setw(14) << family << setw(16) << name
+       << right << setw(12) << scientific << setprecision(2) << error
+       << setw(12) << tolerance << (pass ? "   ok" : "   FAILED") << endl;
+  return pass;
+}
+
+int main() {
+  struct Family {
+    string name;
+    function<Matrix3d()> generate;
+    double eigenvalues;      ///< Tolerance of EigenvaluesRealParts(), looser for repeated eigenvalues
+  };
+
+  vector<Family> families = {
+    {"random", gen_random, 1.0e-8},
+    {"rotation", gen_rotation, 1.0e-8},
+    {"near-identity", gen_near_identity, 1.0e-6},
+    {"reflected", gen_reflected, 1.0e-8},
+    {"repeated", gen_repeated, 1.0e-6},
+    {"close", gen_close, 1.0e-6},
+    {"near-singular", gen_near_singular, 1.0e-8},
+  };
+
+  cout << left << setw(14) << "matrices" << setw(16) << "kernel"
+       << right << setw(12) << "max error" << setw(12) << "tolerance" << endl;
+
+  bool pass = true;
+  for (auto &f: families) {
+    Errors e = measure(f.generate);
+    pass &= check(f.name, "PolDec R", e.poldec_R, 1.0e-12);
+    pass &= check(f.name, "PolDec T", e.poldec_T, 1.0e-12);
+    pass &= check(f.name, "PolDec R only", e.poldec_R_only, 1.0e-12);
+    pass &= check(f.name, "PolDec flags", e.poldec_flags, 0);
+    pass &= check(f.name, "eigenvalues", e.eigenvalues, f.eigenvalues);
+    pass &= check(f.name, "inverse", e.inverse, 1.0e-14);
+    pass &= check(f.name, "determinant", e.determinant, 1.0e-14);
+    pass &= check(f.name, "symmetric", e.symmetric, 1.0e-13);
+    pass &= check(f.name, "singular", e.singular, 1.0e-12);
+  }
+
+  return pass ? 0 : 1;
+}
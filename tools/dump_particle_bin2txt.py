@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Convert binary particle dumps (dump style particle/bin) to the text format of
+the particle dump style, which OVITO and the other post-processing scripts read.
+
+Usage: dump_particle_bin2txt.py dump.100.bin [dump.200.bin ...]
+
+Each file is converted into a file of the same name with the extension .bin
+replaced by .txt (or .txt appended).
+"""
+
+import array
+import struct
+import sys
+
+NAME_LENGTH = 16
+
+
+def read(filename):
+    """Return the header fields and the columns of a binary particle dump."""
+    with open(filename, "rb") as f:
+        data = f.read()
+
+    if data[:8] != b"KMPMPBIN":
+        raise ValueError(filename + " is not a binary particle dump")
+
+    version, ncolumns, ntimestep, time, np = struct.unpack_from("=iiqdq", data, 8)
+    if version != 1:
+        raise ValueError(filename + ": unknown version " + str(version))
+    box = struct.unpack_from("=6d", data, 40)
+    pos = 88
+
+    names = []
+    for c in range(ncolumns):
+        names.append(data[pos:pos + NAME_LENGTH].split(b"\0")[0].decode())
+        pos += NAME_LENGTH
+
+    columns = []
+    for c in range(ncolumns):
+        column = array.array("q" if c < 2 else "d")
+        column.frombytes(data[pos:pos + 8 * np])
+        columns.append(column)
+        pos += 8 * np
+
+    header = {"ntimestep": ntimestep, "time": time, "np": np,
+              "boxlo": box[:3], "boxhi": box[3:]}
+    return header, names, columns
+
+
+def write_text(filename, header, names, columns):
+    """Write the particles in the text format of the particle dump style."""
+    with open(filename, "w") as f:
+        f.write("ITEM: TIMESTEP\n0\nITEM: NUMBER OF ATOMS\n")
+        f.write("%d\n" % header["np"])
+        f.write("ITEM: BOX BOUNDS sm sm sm\n")
+        for lo, hi in zip(header["boxlo"], header["boxhi"]):
+            f.write("%g %g\n" % (lo, hi))
+        f.write("ITEM: ATOMS id type tag " + "".join(n + " " for n in names[2:]) + "\n")
+
+        ids, types, values = columns[0], columns[1], columns[2:]
+        for i in range(header["np"]):
+            f.write("%d %d %d " % (ids[i], types[i], ids[i])
+                    + "".join("%g " % v[i] for v in values) + "\n")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+
+    for name in sys.argv[1:]:
+        out = name[:-4] + ".txt" if name.endswith(".bin") else name + ".txt"
+        write_text(out, *read(name))